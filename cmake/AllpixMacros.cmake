@@ -87,6 +87,14 @@ MACRO(allpix_detector_module name)
     TARGET_COMPILE_DEFINITIONS(${${name}} PRIVATE ALLPIX_MODULE_UNIQUE=0)
 ENDMACRO()
 
+# Put this at the start of every multi-detector module, handling all its detectors in a single instantiation
+MACRO(allpix_multi_detector_module name)
+    _allpix_module_define_common(${name} ${ARGN})
+
+    # Set the unique flag to false and the multi-detector flag to true
+    TARGET_COMPILE_DEFINITIONS(${${name}} PRIVATE ALLPIX_MODULE_UNIQUE=0 ALLPIX_MODULE_MULTI_DETECTOR=1)
+ENDMACRO()
+
 # Add sources to the module
 MACRO(allpix_module_sources name)
     # Get the list of sources
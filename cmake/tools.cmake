@@ -114,6 +114,13 @@ FUNCTION(ADD_ALLPIX_TEST TEST)
         SET(CLIOPTIONS "${CLIOPTIONS} -g ${OPT}")
     ENDFOREACH()
 
+    # Tests of optional features are skipped if their output shows that the feature is not available:
+    FILE(STRINGS ${TEST} SKIPEXPRESSION REGEX "#SKIP ")
+    IF(SKIPEXPRESSION AND CMAKE_VERSION VERSION_LESS 3.16)
+        MESSAGE(STATUS "Unit tests: skipping ${TEST}, CMake 3.16 or newer required to detect unavailable features")
+        RETURN()
+    ENDIF()
+
     ADD_TEST(NAME ${TEST}
         WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
         COMMAND ${CMAKE_CURRENT_SOURCE_DIR}/run_directory.sh "output/${TEST}" "${CMAKE_INSTALL_PREFIX}/bin/allpix -c ${CMAKE_CURRENT_SOURCE_DIR}/${TEST} ${CLIOPTIONS}"
@@ -128,6 +135,12 @@ FUNCTION(ADD_ALLPIX_TEST TEST)
         SET_TESTS_PROPERTIES(${TEST} PROPERTIES FAIL_REGULAR_EXPRESSION "${EXPRESSIONS_FAIL}")
     ENDIF()
 
+    IF(SKIPEXPRESSION)
+        STRING(REPLACE "#SKIP " "" SKIPEXPRESSION "${SKIPEXPRESSION}")
+        ESCAPE_REGEX("${SKIPEXPRESSION}" SKIPEXPRESSION)
+        SET_TESTS_PROPERTIES(${TEST} PROPERTIES SKIP_REGULAR_EXPRESSION "${SKIPEXPRESSION}")
+    ENDIF()
+
     # Some tests might depend on others:
     FILE(STRINGS ${TEST} DEPENDENCY REGEX "#DEPENDS ")
     IF(DEPENDENCY)
@@ -135,6 +148,20 @@ FUNCTION(ADD_ALLPIX_TEST TEST)
         SET_TESTS_PROPERTIES(${TEST} PROPERTIES DEPENDS "${DEPENDENCY}")
     ENDIF()
 
+    # Allow to compare output files of tests, paths are relative to the output directory of all tests:
+    FILE(STRINGS ${TEST} COMPARISONS REGEX "#COMPARE ")
+    SET(COMPARISON_INDEX 0)
+    FOREACH(COMPARISON ${COMPARISONS})
+        STRING(REPLACE "#COMPARE " "" COMPARISON "${COMPARISON}")
+        SEPARATE_ARGUMENTS(COMPARISON)
+        MATH(EXPR COMPARISON_INDEX "${COMPARISON_INDEX} + 1")
+        ADD_TEST(NAME ${TEST}_compare_${COMPARISON_INDEX}
+            WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}/output
+            COMMAND ${CMAKE_COMMAND} -E compare_files ${COMPARISON}
+        )
+        SET_TESTS_PROPERTIES(${TEST}_compare_${COMPARISON_INDEX} PROPERTIES DEPENDS ${TEST})
+    ENDFOREACH()
+
     # Add individual timeout criteria:
     FILE(STRINGS ${TEST} TESTTIMEOUT REGEX "#TIMEOUT ")
     IF(TESTTIMEOUT)
@@ -164,7 +164,10 @@ void Allpix::load() {
     // Use existing output directory if it exists
     bool create_output_dir = true;
     if(allpix::path_is_directory(directory)) {
-        if(global_config.get<bool>("purge_output_directory", false)) {
+        if(global_config.get<bool>("purge_output_directory", false) && global_config.get<bool>("resume", false)) {
+            LOG(WARNING) << "Not purging output directory " << directory << " as the run is resumed from a checkpoint";
+            create_output_dir = false;
+        } else if(global_config.get<bool>("purge_output_directory", false)) {
             LOG(DEBUG) << "Deleting previous output directory " << directory;
             allpix::remove_path(directory);
         } else {
@@ -8,6 +8,9 @@
  * Intergovernmental Organization or submit itself to any jurisdiction.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -21,6 +24,11 @@
 
 using namespace allpix;
 
+namespace {
+    // Maximum number of pixels for which the pixel table of a detector is cached
+    constexpr size_t max_pixel_table_size = 262144;
+} // namespace
+
 /**
  * @throws InvalidModuleActionException If the detector model pointer is a null pointer
  *
@@ -31,15 +39,13 @@ Detector::Detector(std::string name,
                    ROOT::Math::XYZPoint position,
                    const ROOT::Math::Rotation3D& orientation)
     : Detector(std::move(name), std::move(position), orientation) {
-    model_ = std::move(model);
     // Check if valid model is supplied
-    if(model_ == nullptr) {
+    if(model == nullptr) {
         throw InvalidModuleActionException("Detector model cannot be a null pointer");
     }
 
-    magnetic_field_on_ = false;
-    // Build the transformation matrix
-    build_transform();
+    // Attach the model, which also builds the transformation matrix
+    set_model(std::move(model));
 }
 
 /**
@@ -57,9 +63,10 @@ void Detector::set_model(std::shared_ptr<DetectorModel> model) {
     // Initialize the detector fields with the model parameters:
     electric_field_.set_model_parameters(model_->getSensorCenter(), model_->getSensorSize(), model_->getPixelSize());
     weighting_potential_.set_model_parameters(model_->getSensorCenter(), model_->getSensorSize(), model_->getPixelSize());
-    magnetic_field_on_ = false;
+    magnetic_field_.set_model_parameters(model_->getSensorCenter(), model_->getSensorSize(), model_->getPixelSize());
 
     build_transform();
+    build_geometry_cache();
 }
 void Detector::build_transform() {
     // Transform from locally centered to global coordinates
@@ -74,6 +81,25 @@ void Detector::build_transform() {
     ROOT::Math::Transform3D transform_local(translation_local);
     // Compute total transform local to global by first transforming local to locally centered and then to global coordinates
     transform_ = transform_center * transform_local.Inverse();
+    transform_inverse_ = transform_.Inverse();
+}
+
+/**
+ * The values are taken from the model once, all hot-path methods of the detector only use the cached values afterwards.
+ * The pixel table itself is only filled on first access.
+ */
+void Detector::build_geometry_cache() {
+    sensor_center_ = model_->getSensorCenter();
+    sensor_half_size_ = model_->getSensorSize() / 2.0;
+
+    pixel_pitch_ = model_->getPixelSize();
+    pixel_pitch_inverse_ = {1.0 / pixel_pitch_.x(), 1.0 / pixel_pitch_.y()};
+    implant_half_size_ = {std::fabs(model_->getImplantSize().x() / 2.0), std::fabs(model_->getImplantSize().y() / 2.0)};
+
+    n_pixels_ = {model_->getNPixels().x(), model_->getNPixels().y()};
+
+    // Invalidate the pixel table, it is rebuilt for the new geometry on the next access
+    std::atomic_store(&pixels_, std::shared_ptr<const std::vector<Pixel>>());
 }
 
 std::string Detector::getName() const {
@@ -100,21 +126,36 @@ ROOT::Math::Rotation3D Detector::getOrientation() const {
  * The origin of the local frame is at the center of the first pixel in the middle of the sensor.
  */
 ROOT::Math::XYZPoint Detector::getLocalPosition(const ROOT::Math::XYZPoint& global_pos) const {
-    return transform_.Inverse()(global_pos);
+    return transform_inverse_(global_pos);
 }
 ROOT::Math::XYZPoint Detector::getGlobalPosition(const ROOT::Math::XYZPoint& local_pos) const {
     return transform_(local_pos);
 }
 
+const ROOT::Math::Transform3D& Detector::getLocalToGlobalTransform() const {
+    return transform_;
+}
+
+std::vector<ROOT::Math::XYZPoint> Detector::getLocalPositions(const std::vector<ROOT::Math::XYZPoint>& global_pos) const {
+    std::vector<ROOT::Math::XYZPoint> local_pos;
+    local_pos.reserve(global_pos.size());
+    std::transform(global_pos.begin(), global_pos.end(), std::back_inserter(local_pos), transform_inverse_);
+    return local_pos;
+}
+std::vector<ROOT::Math::XYZPoint> Detector::getGlobalPositions(const std::vector<ROOT::Math::XYZPoint>& local_pos) const {
+    std::vector<ROOT::Math::XYZPoint> global_pos;
+    global_pos.reserve(local_pos.size());
+    std::transform(local_pos.begin(), local_pos.end(), std::back_inserter(global_pos), transform_);
+    return global_pos;
+}
+
 /**
  * The definition of inside the sensor is determined by the detector model
  */
 bool Detector::isWithinSensor(const ROOT::Math::XYZPoint& local_pos) const {
-    auto sensor_center = model_->getSensorCenter();
-    auto sensor_size = model_->getSensorSize();
-    return (2 * std::fabs(local_pos.z() - sensor_center.z()) <= sensor_size.z()) &&
-           (2 * std::fabs(local_pos.y() - sensor_center.y()) <= sensor_size.y()) &&
-           (2 * std::fabs(local_pos.x() - sensor_center.x()) <= sensor_size.x());
+    return (std::fabs(local_pos.z() - sensor_center_.z()) <= sensor_half_size_.z()) &&
+           (std::fabs(local_pos.y() - sensor_center_.y()) <= sensor_half_size_.y()) &&
+           (std::fabs(local_pos.x() - sensor_center_.x()) <= sensor_half_size_.x());
 }
 
 /**
@@ -124,28 +165,32 @@ bool Detector::isWithinSensor(const ROOT::Math::XYZPoint& local_pos) const {
  */
 bool Detector::isWithinImplant(const ROOT::Math::XYZPoint& local_pos) const {
 
-    auto x_mod_pixel = std::fmod(local_pos.x() + model_->getPixelSize().x() / 2, model_->getPixelSize().x()) -
-                       model_->getPixelSize().x() / 2;
-    auto y_mod_pixel = std::fmod(local_pos.y() + model_->getPixelSize().y() / 2, model_->getPixelSize().y()) -
-                       model_->getPixelSize().y() / 2;
+    auto x_mod_pixel = std::fmod(local_pos.x() + pixel_pitch_.x() / 2, pixel_pitch_.x()) - pixel_pitch_.x() / 2;
+    auto y_mod_pixel = std::fmod(local_pos.y() + pixel_pitch_.y() / 2, pixel_pitch_.y()) - pixel_pitch_.y() / 2;
 
-    return (std::fabs(x_mod_pixel) <= std::fabs(model_->getImplantSize().x() / 2) &&
-            std::fabs(y_mod_pixel) <= std::fabs(model_->getImplantSize().y() / 2));
+    return (std::fabs(x_mod_pixel) <= implant_half_size_.x() && std::fabs(y_mod_pixel) <= implant_half_size_.y());
 }
 
 /**
  * The definition of the pixel grid size is determined by the detector model
  */
 bool Detector::isWithinPixelGrid(const Pixel::Index& pixel_index) const {
-    return !(pixel_index.x() >= model_->getNPixels().x() || pixel_index.y() >= model_->getNPixels().y());
+    return !(pixel_index.x() >= n_pixels_.first || pixel_index.y() >= n_pixels_.second);
 }
 
 /**
  * The definition of the pixel grid size is determined by the detector model
  */
 bool Detector::isWithinPixelGrid(const int x, const int y) const {
-    return !(x < 0 || x >= static_cast<int>(model_->getNPixels().x()) || y < 0 ||
-             y >= static_cast<int>(model_->getNPixels().y()));
+    return !(x < 0 || x >= static_cast<int>(n_pixels_.first) || y < 0 || y >= static_cast<int>(n_pixels_.second));
+}
+
+/**
+ * WARNING This relies on the origin of the local coordinate system being at the center of the first pixel
+ */
+std::pair<int, int> Detector::getPixelIndex(const ROOT::Math::XYZPoint& local_pos) const {
+    return {static_cast<int>(std::round(local_pos.x() * pixel_pitch_inverse_.x())),
+            static_cast<int>(std::round(local_pos.y() * pixel_pitch_inverse_.y()))};
 }
 
 /**
@@ -157,20 +202,41 @@ Pixel Detector::getPixel(unsigned int x, unsigned int y) const {
 }
 
 /**
- * The pixel has internal information about the size and location specific for this detector
+ * The pixel has internal information about the size and location specific for this detector. For pixel matrices up to a
+ * size of 512x512 pixels, all pixels are calculated on first access and returned from the table afterwards. Concurrent first
+ * accesses might build the table more than once, but all of them produce the same content and only one of them is kept.
  */
 Pixel Detector::getPixel(const Pixel::Index& index) const {
-    auto size = model_->getPixelSize();
+    auto table_size = static_cast<size_t>(n_pixels_.first) * n_pixels_.second;
+    if(table_size > max_pixel_table_size || !isWithinPixelGrid(index)) {
+        return calculate_pixel(index);
+    }
+
+    auto pixels = std::atomic_load(&pixels_);
+    if(pixels == nullptr) {
+        auto table = std::make_shared<std::vector<Pixel>>();
+        table->reserve(table_size);
+        for(unsigned int x = 0; x < n_pixels_.first; ++x) {
+            for(unsigned int y = 0; y < n_pixels_.second; ++y) {
+                table->push_back(calculate_pixel({x, y}));
+            }
+        }
+        pixels = std::move(table);
+        std::atomic_store(&pixels_, pixels);
+    }
+    return (*pixels)[static_cast<size_t>(index.x()) * n_pixels_.second + index.y()];
+}
 
+Pixel Detector::calculate_pixel(const Pixel::Index& index) const {
     // WARNING This relies on the origin of the local coordinate system
-    auto local_x = size.x() * index.x();
-    auto local_y = size.y() * index.y();
-    auto local_z = model_->getSensorCenter().z() - model_->getSensorSize().z() / 2.0;
+    auto local_x = pixel_pitch_.x() * index.x();
+    auto local_y = pixel_pitch_.y() * index.y();
+    auto local_z = sensor_center_.z() - sensor_half_size_.z();
 
     auto local_center = ROOT::Math::XYZPoint(local_x, local_y, local_z);
     auto global_center = getGlobalPosition(local_center);
 
-    return {index, local_center, global_center, size};
+    return {index, local_center, global_center, pixel_pitch_};
 }
 
 /**
@@ -203,8 +269,10 @@ void Detector::setElectricFieldGrid(const std::shared_ptr<std::vector<double>>&
                                     std::array<size_t, 3> dimensions,
                                     std::array<double, 2> scales,
                                     std::array<double, 2> offset,
-                                    std::pair<double, double> thickness_domain) {
-    electric_field_.setGrid(field, dimensions, scales, offset, thickness_domain);
+                                    std::pair<double, double> thickness_domain,
+                                    FieldSymmetry symmetry,
+                                    const FieldBlocks& blocks) {
+    electric_field_.setGrid(field, dimensions, scales, offset, thickness_domain, symmetry, blocks);
 }
 
 void Detector::setElectricFieldFunction(FieldFunction<ROOT::Math::XYZVector> function,
@@ -213,6 +281,15 @@ void Detector::setElectricFieldFunction(FieldFunction<ROOT::Math::XYZVector> fun
     electric_field_.setFunction(std::move(function), thickness_domain, type);
 }
 
+/**
+ * @throws std::invalid_argument If the profile has no nodes or the nodes are not ordered along z
+ */
+void Detector::setElectricFieldProfile(std::vector<std::pair<double, ROOT::Math::XYZVector>> profile,
+                                       std::pair<double, double> thickness_domain,
+                                       FieldType type) {
+    electric_field_.setProfile(std::move(profile), thickness_domain, type);
+}
+
 bool Detector::hasWeightingPotential() const {
     return weighting_potential_.isValid();
 }
@@ -222,17 +299,25 @@ bool Detector::hasWeightingPotential() const {
  * strictly zero by definition.
  */
 double Detector::getWeightingPotential(const ROOT::Math::XYZPoint& pos, const Pixel::Index& reference) const {
-    auto size = model_->getPixelSize();
-
     // WARNING This relies on the origin of the local coordinate system
-    auto local_x = size.x() * reference.x();
-    auto local_y = size.y() * reference.y();
+    auto local_x = pixel_pitch_.x() * reference.x();
+    auto local_y = pixel_pitch_.y() * reference.y();
 
     // Requiring to extrapolate the field along z because equilibrium means no change in weighting potential,
     // Without this, we would get large jumps close to the electrode once charge carriers cross the boundary.
     return weighting_potential_.getRelativeTo(pos, {local_x, local_y}, true);
 }
 
+/**
+ * The weighting potential of every pixel is tabulated relative to the center of the neighbourhood, z is extrapolated like
+ * for direct lookups of the weighting potential.
+ */
+NeighbourhoodField Detector::tabulateWeightingPotential(std::array<int, 2> matrix,
+                                                        std::array<size_t, 3> bins,
+                                                        unsigned int threads) const {
+    return weighting_potential_.tabulateNeighbourhood(matrix, bins, threads);
+}
+
 /**
  * The type of the weighting potential is set depending on the function used to apply it.
  */
@@ -248,8 +333,10 @@ void Detector::setWeightingPotentialGrid(const std::shared_ptr<std::vector<doubl
                                          std::array<size_t, 3> dimensions,
                                          std::array<double, 2> scales,
                                          std::array<double, 2> offset,
-                                         std::pair<double, double> thickness_domain) {
-    weighting_potential_.setGrid(potential, dimensions, scales, offset, thickness_domain);
+                                         std::pair<double, double> thickness_domain,
+                                         FieldSymmetry symmetry,
+                                         const FieldBlocks& blocks) {
+    weighting_potential_.setGrid(potential, dimensions, scales, offset, thickness_domain, symmetry, blocks);
 }
 
 void Detector::setWeightingPotentialFunction(FieldFunction<double> function,
@@ -259,19 +346,46 @@ void Detector::setWeightingPotentialFunction(FieldFunction<double> function,
 }
 
 bool Detector::hasMagneticField() const {
-    return magnetic_field_on_;
+    return magnetic_field_.isValid();
 }
 
-// TODO Currently the magnetic field in the detector is fixed to the field vector at it's center position. Change in case a
-// field gradient is needed inside the sensor.
+/**
+ * The constant magnetic field is stored as field profile with a single node covering the full sensor thickness.
+ */
 void Detector::setMagneticField(ROOT::Math::XYZVector b_field) {
-    magnetic_field_on_ = true;
-    magnetic_field_ = std::move(b_field);
+    auto sensor_center = model_->getSensorCenter();
+    auto sensor_size = model_->getSensorSize();
+    magnetic_field_.setProfile({{sensor_center.z(), b_field}},
+                               {sensor_center.z() - sensor_size.z() / 2.0, sensor_center.z() + sensor_size.z() / 2.0},
+                               FieldType::CONSTANT);
+}
+
+/**
+ * @throws std::invalid_argument If the magnetic field dimensions are incorrect
+ *
+ * The grid is centered on the sensor and its scales are set to the full sensor extent, such that the field is looked up
+ * relative to the sensor center without any replication or flipping at pixel boundaries.
+ */
+void Detector::setMagneticFieldGrid(const std::shared_ptr<std::vector<double>>& field, std::array<size_t, 3> dimensions) {
+    auto sensor_center = model_->getSensorCenter();
+    auto sensor_size = model_->getSensorSize();
+    magnetic_field_.setGrid(field,
+                            dimensions,
+                            {{sensor_size.x(), sensor_size.y()}},
+                            {{0., 0.}},
+                            {sensor_center.z() - sensor_size.z() / 2.0, sensor_center.z() + sensor_size.z() / 2.0});
+}
+
+/**
+ * The type of the magnetic field is set depending on the function used to apply it.
+ */
+FieldType Detector::getMagneticFieldType() const {
+    return magnetic_field_.getType();
 }
 
 /**
- * The magnetic field is evaluated for any sensor position.
+ * The magnetic field is evaluated relative to the sensor center, positions outside the sensor are extrapolated along z.
  */
-ROOT::Math::XYZVector Detector::getMagneticField() const {
-    return magnetic_field_;
+ROOT::Math::XYZVector Detector::getMagneticField(const ROOT::Math::XYZPoint& pos) const {
+    return magnetic_field_.getRelativeTo(pos, {sensor_center_.x(), sensor_center_.y()}, true);
 }
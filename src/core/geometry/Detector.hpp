@@ -90,6 +90,26 @@ namespace allpix {
          */
         ROOT::Math::XYZPoint getGlobalPosition(const ROOT::Math::XYZPoint& local_pos) const;
 
+        /**
+         * @brief Convert a set of global positions to positions in the detector frame
+         * @param global_pos Positions in the global frame
+         * @return Positions in the local frame, in the same order
+         */
+        std::vector<ROOT::Math::XYZPoint> getLocalPositions(const std::vector<ROOT::Math::XYZPoint>& global_pos) const;
+        /**
+         * @brief Convert a set of positions in the detector frame to global positions
+         * @param local_pos Positions in the local frame
+         * @return Positions in the global frame, in the same order
+         */
+        std::vector<ROOT::Math::XYZPoint> getGlobalPositions(const std::vector<ROOT::Math::XYZPoint>& local_pos) const;
+
+        /**
+         * @brief Get the transformation from the detector frame to the global frame
+         * @return Reference to the transformation, valid for the lifetime of the detector
+         * @note Can be passed to objects to only calculate their global positions on demand
+         */
+        const ROOT::Math::Transform3D& getLocalToGlobalTransform() const;
+
         /**
          * @brief Returns if a local position is within the sensitive device
          * @return True if a local position is within the sensor, false otherwise
@@ -114,6 +134,13 @@ namespace allpix {
          */
         bool isWithinPixelGrid(const int x, const int y) const;
 
+        /**
+         * @brief Return the indices of the pixel closest to a local position
+         * @param local_pos Position in the local frame
+         * @return Pair of x and y index of the pixel, which might be outside of the pixel grid
+         */
+        std::pair<int, int> getPixelIndex(const ROOT::Math::XYZPoint& local_pos) const;
+
         /**
          * @brief Return a pixel object from the x- and y-index values
          * @return Pixel object
@@ -142,6 +169,17 @@ namespace allpix {
          * @return Vector of the field at the queried point
          */
         ROOT::Math::XYZVector getElectricField(const ROOT::Math::XYZPoint& local_pos) const;
+        /**
+         * @brief Create a field derived from the electric field in the sensor, e.g. the drift velocity of charge carriers
+         * @param function Function converting the electric field vector into a value of the derived field
+         * @param threads Number of threads used to convert the bins of an electric field grid
+         * @return Field with the same type, binning and domain as the electric field
+         */
+        template <typename T, size_t N>
+        DetectorField<T, N> deriveElectricField(const std::function<T(const ROOT::Math::XYZVector&)>& function,
+                                                unsigned int threads = 1) const {
+            return electric_field_.template derive<T, N>(function, threads);
+        }
 
         /**
          * @brief Set the electric field in a single pixel in the detector using a grid
@@ -149,12 +187,16 @@ namespace allpix {
          * @param sizes The dimensions of the flat electric field array
          * @param scales Scaling factors for the field size, given in fractions of a pixel unit cell in x and y
          * @param thickness_domain Domain in local coordinates in the thickness direction where the field holds
+         * @param symmetry Symmetry of the field, defining which fraction of the field unit cell the grid holds
+         * @param blocks Block structure of adaptive field grids
          */
         void setElectricFieldGrid(const std::shared_ptr<std::vector<double>>& field,
                                   std::array<size_t, 3> sizes,
                                   std::array<double, 2> scales,
                                   std::array<double, 2> offset,
-                                  std::pair<double, double> thickness_domain);
+                                  std::pair<double, double> thickness_domain,
+                                  FieldSymmetry symmetry = FieldSymmetry::NONE,
+                                  const FieldBlocks& blocks = FieldBlocks());
         /**
          * @brief Set the electric field in a single pixel using a function
          * @param function Function used to retrieve the electric field
@@ -164,6 +206,15 @@ namespace allpix {
         void setElectricFieldFunction(FieldFunction<ROOT::Math::XYZVector> function,
                                       std::pair<double, double> thickness_domain,
                                       FieldType type = FieldType::CUSTOM);
+        /**
+         * @brief Set the electric field in a single pixel using a profile along the thickness direction
+         * @param profile Pairs of local z coordinate and electric field vector, with strictly increasing z coordinates
+         * @param thickness_domain Domain in local coordinates in the thickness direction where the field holds
+         * @param type Type of the electric field described by the profile
+         */
+        void setElectricFieldProfile(std::vector<std::pair<double, ROOT::Math::XYZVector>> profile,
+                                     std::pair<double, double> thickness_domain,
+                                     FieldType type = FieldType::LINEAR);
 
         /**
          * @brief Returns if the detector has a weighting potential in the sensor
@@ -184,18 +235,33 @@ namespace allpix {
          * @return Value of the potential at the queried point
          */
         double getWeightingPotential(const ROOT::Math::XYZPoint& local_pos, const Pixel::Index& reference) const;
+        /**
+         * @brief Tabulate the weighting potential for a neighbourhood of pixels to look up all pixels at once
+         * @param matrix Number of pixels of the neighbourhood in x and y, odd numbers
+         * @param bins Number of bins per pixel cell in x and y and along the thickness, only used if the weighting potential
+         * is not defined by a grid
+         * @param threads Number of threads used to tabulate the weighting potential
+         * @return Weighting potential of all pixels of the neighbourhood on a grid aligned to the pixel pitch
+         */
+        NeighbourhoodField tabulateWeightingPotential(std::array<int, 2> matrix,
+                                                      std::array<size_t, 3> bins,
+                                                      unsigned int threads = 1) const;
 
         /**
          * @brief Set the weighting potential in a single pixel in the detector using a grid
          * @param potential Flat array of the potential vectors (see detailed description)
          * @param sizes The dimensions of the flat weighting potential array
          * @param thickness_domain Domain in local coordinates in the thickness direction where the potential holds
+         * @param symmetry Symmetry of the potential, defining which fraction of the potential the grid holds
+         * @param blocks Block structure of adaptive potential grids
          */
         void setWeightingPotentialGrid(const std::shared_ptr<std::vector<double>>& potential,
                                        std::array<size_t, 3> sizes,
                                        std::array<double, 2> scales,
                                        std::array<double, 2> offset,
-                                       std::pair<double, double> thickness_domain);
+                                       std::pair<double, double> thickness_domain,
+                                       FieldSymmetry symmetry = FieldSymmetry::NONE,
+                                       const FieldBlocks& blocks = FieldBlocks());
         /**
          * @brief Set the weighting potential in a single pixel using a function
          * @param function Function used to retrieve the weighting potential
@@ -207,23 +273,37 @@ namespace allpix {
                                            FieldType type = FieldType::CUSTOM);
 
         /**
-         * @brief Set the magnetic field in the detector
-         * @param function Function used to retrieve the magnetic field
-         * @param type Type of the magnetic field function used
+         * @brief Set a constant magnetic field in the detector
+         * @param b_field Magnetic field vector in the local frame of the detector
          */
         void setMagneticField(ROOT::Math::XYZVector b_field);
 
+        /**
+         * @brief Set the magnetic field in the detector using a grid spanning the full sensor volume
+         * @param field Flat array of the field vectors in the local frame of the detector
+         * @param dimensions The dimensions of the flat magnetic field array
+         *
+         * In contrast to the electric field, the magnetic field grid is not replicated per pixel but covers the sensor once,
+         * i.e. the bins are spread equally over the full sensor extent in x, y and z.
+         */
+        void setMagneticFieldGrid(const std::shared_ptr<std::vector<double>>& field, std::array<size_t, 3> dimensions);
+
         /**
          * @brief Returns if the detector has a magnetic field in the sensor
          * @return True if the detector has an magnetic field, false otherwise
          */
         bool hasMagneticField() const;
+        /**
+         * @brief Return the type of magnetic field that is simulated.
+         * @return The type of the magnetic field
+         */
+        FieldType getMagneticFieldType() const;
         /**
          * @brief Get the magnetic field in the sensor at a local position
-         * @param pos Position in the local frame
+         * @param local_pos Position in the local frame
          * @return Vector of the field at the queried point
          */
-        ROOT::Math::XYZVector getMagneticField() const;
+        ROOT::Math::XYZVector getMagneticField(const ROOT::Math::XYZPoint& local_pos) const;
 
         /**
          * @brief Get the model of this detector
@@ -251,14 +331,42 @@ namespace allpix {
          */
         void build_transform();
 
+        /**
+         * @brief Cache the model parameters frequently used in position and pixel lookups
+         */
+        void build_geometry_cache();
+
+        /**
+         * @brief Calculate a pixel object without using the pixel table
+         * @param index Index of the pixel
+         * @return Pixel object
+         */
+        Pixel calculate_pixel(const Pixel::Index& index) const;
+
         std::string name_;
         std::shared_ptr<DetectorModel> model_;
 
         ROOT::Math::XYZPoint position_;
         ROOT::Math::Rotation3D orientation_;
 
-        // Transform matrix from global to local coordinates
+        // Transform matrix from local to global coordinates and its inverse
         ROOT::Math::Transform3D transform_;
+        ROOT::Math::Transform3D transform_inverse_;
+
+        /*
+         * Geometry cache, calculated once from the model when it is attached to avoid repeated lookups via the model
+         * * Sensor center and half of the sensor size
+         * * Pixel pitch and its reciprocal, half of the implant size and number of pixels
+         * * Table of all pixels of the detector, filled on first access if the pixel matrix is not too large. The table is
+         *   immutable once built, copies of the detector share it until the geometry is changed
+         */
+        ROOT::Math::XYZPoint sensor_center_;
+        ROOT::Math::XYZVector sensor_half_size_;
+        ROOT::Math::XYVector pixel_pitch_;
+        ROOT::Math::XYVector pixel_pitch_inverse_;
+        ROOT::Math::XYVector implant_half_size_;
+        std::pair<unsigned int, unsigned int> n_pixels_{};
+        mutable std::shared_ptr<const std::vector<Pixel>> pixels_;
 
         // Electric field
         DetectorField<ROOT::Math::XYZVector, 3> electric_field_;
@@ -266,9 +374,8 @@ namespace allpix {
         // Weighting potential
         DetectorField<double, 1> weighting_potential_;
 
-        // Magnetic field properties
-        ROOT::Math::XYZVector magnetic_field_;
-        bool magnetic_field_on_;
+        // Magnetic field
+        DetectorField<ROOT::Math::XYZVector, 3> magnetic_field_;
     };
 
 } // namespace allpix
@@ -29,4 +29,56 @@ namespace allpix {
      * Here, no inversion of the field components is required
      */
     template <> void flip_vector_components<double>(double&, bool, bool) {}
+
+    /*
+     * Vector field template specialization of helper function for exchanging the x and y components
+     */
+    template <> void swap_vector_components<ROOT::Math::XYZVector>(ROOT::Math::XYZVector& vec) {
+        vec.SetXYZ(vec.y(), vec.x(), vec.z());
+    }
+
+    /*
+     * Scalar field template specialization of helper function for exchanging the x and y components
+     * Here, no exchange of the field components is required
+     */
+    template <> void swap_vector_components<double>(double&) {}
+
+    /*
+     * Vector field template specialization of helper function for writing the components into a flat array
+     */
+    template <> void set_vector_components<ROOT::Math::XYZVector>(const ROOT::Math::XYZVector& vec, double* data) {
+        data[0] = vec.x();
+        data[1] = vec.y();
+        data[2] = vec.z();
+    }
+
+    /*
+     * Scalar field template specialization of helper function for writing the value into a flat array
+     */
+    template <> void set_vector_components<double>(const double& value, double* data) { data[0] = value; }
+
+    /**
+     * The position is converted into the frame of the central pixel, which relies on the origin of the local coordinate
+     * system being the center of the first pixel.
+     */
+    const double* NeighbourhoodField::get(const ROOT::Math::XYZPoint& pos, const std::pair<int, int>& center) const {
+        // Position within the cell of the central pixel in units of the pixel pitch, starting at the lower pixel edge
+        auto x = pos.x() / pixel_size_.x() - center.first + 0.5;
+        auto y = pos.y() / pixel_size_.y() - center.second + 0.5;
+        if(x < 0 || x > 1 || y < 0 || y > 1) {
+            return nullptr;
+        }
+
+        // Compute indices, extrapolating the field along the thickness direction
+        auto z = (pos.z() - thickness_domain_.first) / (thickness_domain_.second - thickness_domain_.first);
+        auto x_ind = std::min(static_cast<size_t>(x * static_cast<double>(bins_[0])), bins_[0] - 1);
+        auto y_ind = std::min(static_cast<size_t>(y * static_cast<double>(bins_[1])), bins_[1] - 1);
+        auto z_ind = static_cast<size_t>(std::max(0., std::min(z * static_cast<double>(bins_[2]),
+                                                               static_cast<double>(bins_[2] - 1))));
+
+        // Read from the copy local to the NUMA node of the calling thread if the table is replicated
+        const auto& values = (replicas_.empty() ? *values_ : *replicas_[NumaTopology::getCurrentNode()]);
+        auto pixels = static_cast<size_t>(matrix_[0] * matrix_[1]);
+        return values.data() + ((x_ind * bins_[1] + y_ind) * bins_[2] + z_ind) * pixels;
+    }
 } // namespace allpix
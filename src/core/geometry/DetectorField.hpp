@@ -11,8 +11,13 @@
 #ifndef ALLPIX_DETECTOR_FIELD_H
 #define ALLPIX_DETECTOR_FIELD_H
 
+#include <algorithm>
 #include <array>
 #include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include <Math/Point2D.h>
@@ -20,8 +25,11 @@
 #include <Math/Vector2D.h>
 #include <Math/Vector3D.h>
 
+#include "core/utils/numa.h"
 #include "objects/Pixel.hpp"
 #include "tools/ROOT.h"
+#include "tools/field_blocks.h"
+#include "tools/field_symmetry.h"
 
 namespace allpix {
 
@@ -42,6 +50,11 @@ namespace allpix {
      */
     template <typename T = ROOT::Math::XYZVector> using FieldFunction = std::function<T(const ROOT::Math::XYZPoint& pos)>;
 
+    /**
+     * @brief Copies of field grids placed on every NUMA node, indexed by node
+     */
+    using FieldReplicas = std::vector<std::shared_ptr<std::vector<double>>>;
+
     /**
      * @brief Helper function to invert the field vector when flipping the field direction at pixel/field boundaries
      * @param field Field value, templated to support vector fields and scalar fields
@@ -50,6 +63,60 @@ namespace allpix {
      */
     template <typename T> void flip_vector_components(T& field, bool x, bool y);
 
+    /**
+     * @brief Helper function to exchange the x and y components of the field vector when unfolding octant-symmetric fields
+     * @param field Field value, templated to support vector fields and scalar fields
+     */
+    template <typename T> void swap_vector_components(T& field);
+
+    /**
+     * @brief Helper function to write the components of a field value into a flat field array
+     * @param field Field value, templated to support vector fields and scalar fields
+     * @param data  Pointer to the first component in the flat field array
+     */
+    template <typename T> void set_vector_components(const T& field, double* data);
+
+    /**
+     * @brief Scalar field tabulated for a neighbourhood of pixels on a grid aligned to the pixel pitch
+     *
+     * The grid spans a single pixel cell in x and y and the thickness domain of the field along z. Every bin stores the
+     * values of the field assigned to all pixels of the neighbourhood around the pixel next to each other, such that a
+     * single lookup returns the values for the full neighbourhood. Along z, the field is extrapolated outside of the
+     * thickness domain.
+     */
+    class NeighbourhoodField {
+        template <typename T, size_t N> friend class DetectorField;
+
+    public:
+        /**
+         * @brief Constructs an empty neighbourhood field
+         */
+        NeighbourhoodField() = default;
+
+        /**
+         * @brief Check if the field has been tabulated
+         * @return Boolean indicating field validity
+         */
+        bool isValid() const { return values_ != nullptr; }
+
+        /**
+         * @brief Get the values of the field for all pixels in the neighbourhood of a central pixel
+         * @param local_pos Position in the local frame, within the cell of the central pixel
+         * @param center Index of the central pixel of the neighbourhood in x and y
+         * @return Pointer to the values of the pixels of the neighbourhood with the pixel index along y running fastest, or
+         * a null pointer if the position is outside the cell of the central pixel
+         */
+        const double* get(const ROOT::Math::XYZPoint& local_pos, const std::pair<int, int>& center) const;
+
+    private:
+        std::array<int, 2> matrix_{};
+        std::array<size_t, 3> bins_{};
+        ROOT::Math::XYVector pixel_size_{};
+        std::pair<double, double> thickness_domain_{};
+        std::shared_ptr<std::vector<double>> values_;
+        FieldReplicas replicas_;
+    };
+
     /**
      * @brief Field instance of a detector
      *
@@ -58,6 +125,7 @@ namespace allpix {
      */
     template <typename T, size_t N = 3> class DetectorField {
         friend class Detector;
+        template <typename U, size_t M> friend class DetectorField;
 
     public:
         /**
@@ -69,7 +137,9 @@ namespace allpix {
          * @brief Check if the field is valid and either a field grid or a field function is configured
          * @return Boolean indicating field validity
          */
-        bool isValid() const { return function_ || (dimensions_[0] != 0 && dimensions_[1] != 0 && dimensions_[2] != 0); };
+        bool isValid() const {
+            return function_ || !profile_.empty() || (dimensions_[0] != 0 && dimensions_[1] != 0 && dimensions_[2] != 0);
+        };
 
         /**
          * @brief Return the type of field
@@ -84,6 +154,12 @@ namespace allpix {
          */
         T get(const ROOT::Math::XYZPoint& local_pos) const;
 
+        /**
+         * @brief Return the symmetry of the field grid
+         * @return Symmetry of the field, defining which fraction of the field is stored
+         */
+        FieldSymmetry getSymmetry() const { return symmetry_; }
+
         /**
          * @brief Get the value of the field at a position provided in local coordinates with respect to the reference
          * @param pos       Position in the local frame
@@ -102,12 +178,19 @@ namespace allpix {
          * @param scales The actual physical extent of the field in each direction in x and y
          * @param offset Offset of the field in x and y, given in physical units
          * @param thickness_domain Domain in local coordinates in the thickness direction where the field holds
+         * @param symmetry Symmetry of the field, defining which fraction of the field the grid holds
+         * @param blocks Block structure of adaptive grids, defaults to a regular grid
+         *
+         * For folded fields, the dimensions and scales always refer to the full field, only the stored data is reduced. For
+         * adaptive grids, the dimensions refer to the finest resolution.
          */
         void setGrid(std::shared_ptr<std::vector<double>> field,
                      std::array<size_t, 3> dimensions,
                      std::array<double, 2> scales,
                      std::array<double, 2> offset,
-                     std::pair<double, double> thickness_domain);
+                     std::pair<double, double> thickness_domain,
+                     FieldSymmetry symmetry = FieldSymmetry::NONE,
+                     const FieldBlocks& blocks = FieldBlocks());
         /**
          * @brief Set the field in the detector using a function
          * @param function Function used to calculate the field
@@ -117,6 +200,55 @@ namespace allpix {
         void setFunction(FieldFunction<T> function,
                          std::pair<double, double> thickness_domain,
                          FieldType type = FieldType::CUSTOM);
+        /**
+         * @brief Set the field in the detector using a profile along the thickness direction
+         * @param profile Pairs of local z coordinate and field value, with strictly increasing z coordinates
+         * @param thickness_domain Domain in local coordinates in the thickness direction where the field holds
+         * @param type Type of the field described by the profile
+         *
+         * The field is interpolated linearly between the nodes of the profile and takes the value of the first or last
+         * node outside of them. A single node therefore describes a constant field. Contrary to field functions, profiles
+         * are evaluated inline without the indirection of a function call.
+         */
+        void setProfile(std::vector<std::pair<double, T>> profile,
+                        std::pair<double, double> thickness_domain,
+                        FieldType type = FieldType::LINEAR);
+
+        /**
+         * @brief Place a copy of the field grid in the local memory of every NUMA node
+         * @param cache Replicas of grids already distributed, used to share the copies of fields used by several detectors
+         * @param huge_pages Request transparent huge pages for the copies
+         *
+         * Lookups select the copy of the NUMA node assigned to the calling thread via \ref NumaTopology::setCurrentNode.
+         * The grid itself serves as the copy of the node it is located on. Fields derived from or tabulated for a replicated
+         * field are replicated as well. Nothing is done for fields not defined by a grid.
+         */
+        void replicate(std::map<const std::vector<double>*, FieldReplicas>& cache, bool huge_pages = false);
+
+        /**
+         * @brief Create a field by applying a function to every value of this field
+         * @param function Function converting a value of this field into a value of the derived field
+         * @param threads Number of threads used to convert the bins of a field grid
+         * @return Field with the same type, binning and domain as this field
+         *
+         * Field grids are converted bin by bin, such that a lookup in the derived field returns exactly the function applied
+         * to the same lookup in this field. This requires the function to commute with the flipping and swapping of vector
+         * components when unfolding symmetric fields and replicating them over the pixel matrix, which holds e.g. for
+         * functions scaling a vector by a function of its magnitude. Field functions are wrapped by the function instead.
+         */
+        template <typename U, size_t M>
+        DetectorField<U, M> derive(const std::function<U(const T&)>& function, unsigned int threads = 1) const;
+
+        /**
+         * @brief Tabulate this scalar field for a neighbourhood of pixels, with the field being assigned to every pixel
+         * @param matrix Number of pixels of the neighbourhood in x and y, odd numbers
+         * @param bins Number of bins per pixel cell in x and y and along the thickness, only used for fields not defined
+         * by a grid
+         * @param threads Number of threads used to tabulate the field
+         * @return Field values of all pixels of the neighbourhood on a grid aligned to the pixel pitch
+         */
+        NeighbourhoodField
+        tabulateNeighbourhood(std::array<int, 2> matrix, std::array<size_t, 3> bins, unsigned int threads = 1) const;
 
     private:
         /**
@@ -136,10 +268,12 @@ namespace allpix {
 
         /**
          * @brief Helper function to retrieve the return type from a calculated index of the field data vector
+         * @param field Field data vector to read from
          * @param offset The calculated global index to start from
          * @param index sequence expanded to the number of elements requested, depending on the template instance
          */
-        template <std::size_t... I> auto get_impl(size_t offset, std::index_sequence<I...>) const;
+        template <std::size_t... I>
+        auto get_impl(const std::vector<double>& field, size_t offset, std::index_sequence<I...>) const;
 
         /**
          * @brief Helper function to calculate the field index based on the distance from its center and to return the values
@@ -149,32 +283,64 @@ namespace allpix {
          */
         T get_field_from_grid(const ROOT::Math::XYZPoint& dist, const bool extrapolate_z = false) const;
 
+        /**
+         * @brief Helper function to evaluate the field profile or the field function, depending on the field definition
+         * @param pos Position within the thickness domain to evaluate the field at, in the frame of the field
+         * @return Value(s) of the field at the queried point
+         */
+        T get_field_from_function(const ROOT::Math::XYZPoint& pos) const;
+
         /**
          * Field properties
          * * Dimensions of the field map (bins in x, y, z)
          * * Scale of the field in x and y direction, defaults to 1, 1, i.e. to one full pixel cell
          * * Offset of the field from the pixel edge, e.g. when using fields centered at a pixel corner instead of the center
+         * * Symmetry of the field, the first stored bin and the number of stored bins along x and y for folded fields
          */
         std::array<size_t, 3> dimensions_{};
         std::array<double_t, 2> scales_{{1., 1.}};
         std::array<double_t, 2> offset_{{0., 0.}};
+        FieldSymmetry symmetry_{FieldSymmetry::NONE};
+        std::array<bool, 2> mirrored_{{false, false}};
+        std::array<int, 2> folded_start_{{0, 0}};
+        size_t folded_y_{};
 
         /**
          * Field definition
-         * The field is either specified through a field grid, which is stored in a flat vector, or as field function
-         * returning the value at each position given in local coordinates. The field is valid within the thickness domain
-         * specified, the configured type is stored to allow additional checks in the modules requesting the field.
+         * The field is either specified through a field grid, which is stored in a flat vector, as profile along the
+         * thickness direction or as field function returning the value at each position given in local coordinates. The
+         * field is valid within the thickness domain specified, the configured type is stored to allow additional checks in
+         * the modules requesting the field.
          *
          * In case of using a field grid, the field is stored as a large flat array. If the sizes are denoted as X_SIZE, Y_
          * SIZE and Z_SIZE, respectively, and each position (x, y, z) has N indices, the element position of the i-th field
          * component in the flat field vector can be calculated as:
          *
          *   field_i(x, y, z) =  x * Y_SIZE* Z_SIZE * N + y * Z_SIZE * + z * N + i
+         *
+         * Folded grids only store the bins from the field center onwards along mirrored axes, the indices x and y above then
+         * count from the first stored bin and Y_SIZE denotes the number of stored bins. Octant-folded grids only store the
+         * columns with x >= y, the element position is then given by
+         *
+         *   field_i(x, y, z) =  (x * (x + 1) / 2 + y) * Z_SIZE * N + z * N + i
+         *
+         * Grids replicated on several NUMA nodes additionally hold the flat vector local to every node, the settings of the
+         * replication are kept to replicate derived fields in the same way.
+         *
+         * Adaptive grids store the values block by block, the position of every block in the flat vector is cached in the
+         * block layout. A lookup first selects the block containing the bin from the bin indices and then the cell of the
+         * block, see \ref FieldBlocks.
          */
         std::shared_ptr<std::vector<double>> field_;
+        FieldReplicas replicas_;
+        bool huge_pages_{};
+        std::vector<FieldBlockLayout> blocks_;
+        std::array<size_t, 3> block_counts_{};
+        unsigned int block_shift_{};
         std::pair<double, double> thickness_domain_{};
         FieldType type_{FieldType::NONE};
         FieldFunction<T> function_;
+        std::vector<std::pair<double, T>> profile_;
 
         /*
          * Relevant parameters from the detector model for this field
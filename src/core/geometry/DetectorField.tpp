@@ -39,27 +39,45 @@ namespace allpix {
                 return {};
             }
 
-            // Calculate the field from the configured function:
-            ret_val = function_(ROOT::Math::XYZPoint(x, y, z));
+            // Calculate the field from the configured profile or function:
+            ret_val = get_field_from_function(ROOT::Math::XYZPoint(x, y, z));
         }
 
         return ret_val;
     }
 
     // Maps the field indices onto the range of -d/2 < x < d/2, where d is the scale of the field in coordinate x.
-    // This means, {x,y,z} = (0,0,0) is in the center of the field.
+    // This means, {x,y,z} = (0,0,0) is in the center of the field. Folded grids only store 0 < x < d/2 along mirrored axes.
     template <typename T, size_t N>
     T DetectorField<T, N>::get_field_from_grid(const ROOT::Math::XYZPoint& dist, const bool extrapolate_z) const {
+        auto x = dist.x();
+        auto y = dist.y();
+
+        // Fold the coordinates into the stored part of symmetric fields, remembering which components to invert
+        bool flip_x = false, flip_y = false;
+        if(mirrored_[0] && x < 0) {
+            x = -x;
+            flip_x = true;
+        }
+        if(mirrored_[1] && y < 0) {
+            y = -y;
+            flip_y = true;
+        }
+        bool swap_xy = (symmetry_ == FieldSymmetry::OCTANT && y > x);
+        if(swap_xy) {
+            std::swap(x, y);
+        }
+
         // Compute indices
         // If the number of bins in x or y is 1, the field is assumed to be 2-dimensional and the respective index
         // is forced to zero. This circumvents that the field size in the respective dimension would otherwise be zero
         // clang-format off
         auto x_ind = (dimensions_[0] == 1 ? 0
                                           : static_cast<int>(std::floor(static_cast<double>(dimensions_[0]) *
-                                                                        (dist.x() + scales_[0] / 2.0) / scales_[0])));
+                                                                        (x + scales_[0] / 2.0) / scales_[0])));
         auto y_ind = (dimensions_[1] == 1 ? 0
                                           : static_cast<int>(std::floor(static_cast<double>(dimensions_[1]) *
-                                                                        (dist.y() + scales_[1] / 2.0) / scales_[1])));
+                                                                        (y + scales_[1] / 2.0) / scales_[1])));
         auto z_ind = static_cast<int>(std::floor(static_cast<double>(dimensions_[2]) * (dist.z() - thickness_domain_.first) /
                                                  (thickness_domain_.second - thickness_domain_.first)));
         // clang-format on
@@ -78,11 +96,36 @@ namespace allpix {
             return {};
         }
 
-        // Compute total index
-        size_t tot_ind = static_cast<size_t>(x_ind) * dimensions_[1] * dimensions_[2] * N +
-                         static_cast<size_t>(y_ind) * dimensions_[2] * N + static_cast<size_t>(z_ind) * N;
+        // Compute total index, folded grids start at the central bin and octant-folded grids only store x_ind >= y_ind
+        x_ind -= folded_start_[0];
+        y_ind -= folded_start_[1];
+        size_t tot_ind = 0;
+        if(!blocks_.empty()) {
+            tot_ind = field_block_index(blocks_,
+                                        block_counts_,
+                                        block_shift_,
+                                        static_cast<size_t>(x_ind),
+                                        static_cast<size_t>(y_ind),
+                                        static_cast<size_t>(z_ind),
+                                        N);
+        } else if(symmetry_ == FieldSymmetry::OCTANT) {
+            auto column = static_cast<size_t>(x_ind) * static_cast<size_t>(x_ind + 1) / 2 + static_cast<size_t>(y_ind);
+            tot_ind = column * dimensions_[2] * N + static_cast<size_t>(z_ind) * N;
+        } else {
+            tot_ind = static_cast<size_t>(x_ind) * folded_y_ * dimensions_[2] * N +
+                      static_cast<size_t>(y_ind) * dimensions_[2] * N + static_cast<size_t>(z_ind) * N;
+        }
+
+        // Read from the copy local to the NUMA node of the calling thread if the grid is replicated
+        const auto& field = (replicas_.empty() ? *field_ : *replicas_[NumaTopology::getCurrentNode()]);
+        auto ret_val = get_impl(field, tot_ind, std::make_index_sequence<N>{});
 
-        return get_impl(tot_ind, std::make_index_sequence<N>{});
+        // Unfold the field value if the lookup position was mirrored
+        if(swap_xy) {
+            swap_vector_components(ret_val);
+        }
+        flip_vector_components(ret_val, flip_x, flip_y);
+        return ret_val;
     }
 
     /**
@@ -127,8 +170,8 @@ namespace allpix {
                 return {};
             }
 
-            // Calculate the field from the configured function:
-            ret_val = function_(ROOT::Math::XYZPoint(x, y, z));
+            // Calculate the field from the configured profile or function:
+            ret_val = get_field_from_function(ROOT::Math::XYZPoint(x, y, z));
         }
 
         // Flip vector if necessary
@@ -136,6 +179,35 @@ namespace allpix {
         return ret_val;
     }
 
+    /**
+     * Profiles only consist of a few nodes, such that a linear search for the enclosing segment is sufficient.
+     */
+    template <typename T, size_t N>
+    T DetectorField<T, N>::get_field_from_function(const ROOT::Math::XYZPoint& pos) const {
+        if(profile_.empty()) {
+            return function_(pos);
+        }
+
+        // Outside the nodes, the profile continues with the value of the outermost node
+        auto z = pos.z();
+        if(z <= profile_.front().first) {
+            return profile_.front().second;
+        }
+        if(z >= profile_.back().first) {
+            return profile_.back().second;
+        }
+
+        // Interpolate linearly within the enclosing segment
+        size_t upper = 1;
+        while(profile_[upper].first < z) {
+            ++upper;
+        }
+        const auto& low = profile_[upper - 1];
+        const auto& high = profile_[upper];
+        auto fraction = (z - low.first) / (high.first - low.first);
+        return low.second + fraction * (high.second - low.second);
+    }
+
     /**
      * Woohoo, template magic! Using an index_sequence to construct the templated return type with a variable number of
      * elements from the flat field vector, e.g. 3 for a vector field and 1 for a scalar field. Using a braced-init-list
@@ -143,8 +215,8 @@ namespace allpix {
      */
     template <typename T, size_t N>
     template <std::size_t... I>
-    auto DetectorField<T, N>::get_impl(size_t offset, std::index_sequence<I...>) const {
-        return T{(*field_)[offset + I]...};
+    auto DetectorField<T, N>::get_impl(const std::vector<double>& field, size_t offset, std::index_sequence<I...>) const {
+        return T{field[offset + I]...};
     }
 
     /**
@@ -154,19 +226,27 @@ namespace allpix {
 
     /**
      * @throws std::invalid_argument If the field dimensions are incorrect or the thickness domain is outside the sensor
+     * @throws std::invalid_argument If an octant-folded field is not square
+     * @throws std::invalid_argument If the block structure of an adaptive field is invalid
      */
     template <typename T, size_t N>
     void DetectorField<T, N>::setGrid(std::shared_ptr<std::vector<double>> field, // NOLINT
                                       std::array<size_t, 3> dimensions,
                                       std::array<double, 2> scales,
                                       std::array<double, 2> offset,
-                                      std::pair<double, double> thickness_domain) {
+                                      std::pair<double, double> thickness_domain,
+                                      FieldSymmetry symmetry,
+                                      const FieldBlocks& blocks) {
         if(!model_initialized_) {
             throw std::invalid_argument("field not initialized with detector model parameters");
         }
-        if(dimensions[0] * dimensions[1] * dimensions[2] * N != field->size()) {
+        if(field_grid_values(dimensions, symmetry, blocks, N) != field->size()) {
             throw std::invalid_argument("field does not match the given dimensions");
         }
+        if(symmetry == FieldSymmetry::OCTANT &&
+           (dimensions[0] != dimensions[1] || std::fabs(scales[0] - scales[1]) > 1e-9)) {
+            throw std::invalid_argument("octant-folded field requires identical binning and scale in x and y");
+        }
         if(thickness_domain.first + 1e-9 < sensor_center_.z() - sensor_size_.z() / 2.0 ||
            sensor_center_.z() + sensor_size_.z() / 2.0 < thickness_domain.second - 1e-9) {
             throw std::invalid_argument("thickness domain is outside sensor dimensions");
@@ -176,10 +256,27 @@ namespace allpix {
         }
 
         field_ = std::move(field);
+        replicas_.clear();
         dimensions_ = dimensions;
         scales_ = scales;
         offset_ = offset;
 
+        // Folded axes only store the bins from the field center onwards
+        symmetry_ = symmetry;
+        mirrored_ = {{symmetry_mirrors_x(symmetry), symmetry_mirrors_y(symmetry)}};
+        folded_start_ = {{mirrored_[0] ? static_cast<int>(dimensions[0] / 2) : 0,
+                          mirrored_[1] ? static_cast<int>(dimensions[1] / 2) : 0}};
+        folded_y_ = symmetry_folded_dimensions(dimensions, symmetry)[1];
+
+        // Cache the position of the blocks of adaptive grids
+        blocks_.clear();
+        if(blocks.isAdaptive()) {
+            auto folded = symmetry_folded_dimensions(dimensions, symmetry);
+            blocks_ = field_block_layout(folded, blocks, N);
+            block_counts_ = field_block_counts(folded, blocks.size);
+            block_shift_ = field_block_shift(blocks.size);
+        }
+
         thickness_domain_ = std::move(thickness_domain);
         type_ = FieldType::GRID;
     }
@@ -189,6 +286,189 @@ namespace allpix {
     DetectorField<T, N>::setFunction(FieldFunction<T> function, std::pair<double, double> thickness_domain, FieldType type) {
         thickness_domain_ = std::move(thickness_domain);
         function_ = std::move(function);
+        profile_.clear();
+        type_ = type;
+    }
+
+    /**
+     * @throws std::invalid_argument If the profile has no nodes or the nodes are not ordered along z
+     */
+    template <typename T, size_t N>
+    void DetectorField<T, N>::setProfile(std::vector<std::pair<double, T>> profile,
+                                         std::pair<double, double> thickness_domain,
+                                         FieldType type) {
+        if(profile.empty()) {
+            throw std::invalid_argument("field profile requires at least one node");
+        }
+        for(size_t i = 1; i < profile.size(); ++i) {
+            if(!(profile[i - 1].first < profile[i].first)) {
+                throw std::invalid_argument("nodes of field profile are not strictly increasing along z");
+            }
+        }
+
+        thickness_domain_ = std::move(thickness_domain);
+        profile_ = std::move(profile);
+        function_ = nullptr;
         type_ = type;
     }
+
+    /**
+     * The replicas are created once per distinct grid, detectors sharing the same grid also share its copies.
+     */
+    template <typename T, size_t N>
+    void DetectorField<T, N>::replicate(std::map<const std::vector<double>*, FieldReplicas>& cache, bool huge_pages) {
+        if(type_ != FieldType::GRID) {
+            return;
+        }
+
+        auto& replicas = cache[field_.get()];
+        if(replicas.empty()) {
+            replicas = NumaTopology::get().replicate(field_, huge_pages);
+        }
+        replicas_ = replicas;
+        huge_pages_ = huge_pages;
+    }
+
+    /**
+     * The bins of field grids are distributed over the threads in contiguous blocks. The derived grid is replicated on the
+     * NUMA nodes if this field is replicated.
+     */
+    template <typename T, size_t N>
+    template <typename U, size_t M>
+    DetectorField<U, M> DetectorField<T, N>::derive(const std::function<U(const T&)>& function,
+                                                    unsigned int threads) const {
+        DetectorField<U, M> derived;
+        derived.dimensions_ = dimensions_;
+        derived.scales_ = scales_;
+        derived.offset_ = offset_;
+        derived.symmetry_ = symmetry_;
+        derived.mirrored_ = mirrored_;
+        derived.folded_start_ = folded_start_;
+        derived.folded_y_ = folded_y_;
+        derived.block_counts_ = block_counts_;
+        derived.block_shift_ = block_shift_;
+        derived.thickness_domain_ = thickness_domain_;
+        derived.type_ = type_;
+        derived.set_model_parameters(sensor_center_, sensor_size_, pixel_size_);
+        derived.model_initialized_ = model_initialized_;
+
+        if(type_ == FieldType::GRID) {
+            auto bins = field_->size() / N;
+            auto data = std::make_shared<std::vector<double>>(bins * M);
+            auto convert = [&](size_t begin, size_t end) {
+                for(size_t bin = begin; bin < end; ++bin) {
+                    set_vector_components(function(get_impl(*field_, bin * N, std::make_index_sequence<N>{})),
+                                          data->data() + bin * M);
+                }
+            };
+
+            threads = std::max(threads, 1u);
+            auto block = (bins + threads - 1) / threads;
+            std::vector<std::thread> workers;
+            for(unsigned int i = 1; i < threads; ++i) {
+                workers.emplace_back(convert, std::min(bins, i * block), std::min(bins, (i + 1) * block));
+            }
+            convert(0, std::min(bins, block));
+            for(auto& worker : workers) {
+                worker.join();
+            }
+            derived.field_ = std::move(data);
+            if(!replicas_.empty()) {
+                derived.replicas_ = NumaTopology::get().replicate(derived.field_, huge_pages_);
+                derived.huge_pages_ = huge_pages_;
+            }
+
+            // Adaptive grids store the same number of cells per block, only the number of components changes
+            for(const auto& layout : blocks_) {
+                derived.blocks_.push_back(layout);
+                derived.blocks_.back().offset = layout.offset / N * M;
+            }
+        } else if(type_ != FieldType::NONE) {
+            derived.function_ = [field = *this, function](const ROOT::Math::XYZPoint& pos) {
+                return function(field.get_field_from_function(pos));
+            };
+        }
+        return derived;
+    }
+
+    /**
+     * The field is sampled at the center of every bin. Field grids are tabulated with the bin size of the grid, such that
+     * the tabulated values are identical to direct lookups if the grid bins are aligned with the pixel edges. The bins along
+     * x are distributed over the threads in contiguous blocks. The table is replicated on the NUMA nodes if this field is
+     * replicated.
+     *
+     * @throws std::invalid_argument If the neighbourhood does not consist of an odd number of pixels in x and y or no bins
+     * are requested
+     */
+    template <typename T, size_t N>
+    NeighbourhoodField DetectorField<T, N>::tabulateNeighbourhood(std::array<int, 2> matrix,
+                                                                  std::array<size_t, 3> bins,
+                                                                  unsigned int threads) const {
+        static_assert(N == 1, "only scalar fields can be tabulated for a neighbourhood of pixels");
+        if(matrix[0] < 1 || matrix[1] < 1 || matrix[0] % 2 == 0 || matrix[1] % 2 == 0) {
+            throw std::invalid_argument("neighbourhood requires an odd number of pixels in x and y");
+        }
+
+        NeighbourhoodField table;
+        if(type_ == FieldType::NONE) {
+            return table;
+        }
+
+        // Use the binning of field grids within a single pixel cell
+        std::array<double, 2> pitch{{pixel_size_.x(), pixel_size_.y()}};
+        if(type_ == FieldType::GRID) {
+            for(size_t i = 0; i < 2; ++i) {
+                auto bins_per_pixel = std::lround(static_cast<double>(dimensions_[i]) * pitch[i] / scales_[i]);
+                bins[i] = (dimensions_[i] == 1 ? 1 : std::max(static_cast<size_t>(1), static_cast<size_t>(bins_per_pixel)));
+            }
+            bins[2] = dimensions_[2];
+        }
+        if(bins[0] == 0 || bins[1] == 0 || bins[2] == 0) {
+            throw std::invalid_argument("neighbourhood field requires a non-zero number of bins");
+        }
+
+        table.matrix_ = matrix;
+        table.bins_ = bins;
+        table.pixel_size_ = pixel_size_;
+        table.thickness_domain_ = thickness_domain_;
+        auto pixels = static_cast<size_t>(matrix[0] * matrix[1]);
+        table.values_ = std::make_shared<std::vector<double>>(bins[0] * bins[1] * bins[2] * pixels);
+
+        auto thickness = thickness_domain_.second - thickness_domain_.first;
+        auto tabulate = [&](size_t begin, size_t end) {
+            auto value = table.values_->begin() + static_cast<std::ptrdiff_t>(begin * bins[1] * bins[2] * pixels);
+            for(size_t x = begin; x < end; ++x) {
+                auto pos_x = ((static_cast<double>(x) + 0.5) / static_cast<double>(bins[0]) - 0.5) * pitch[0];
+                for(size_t y = 0; y < bins[1]; ++y) {
+                    auto pos_y = ((static_cast<double>(y) + 0.5) / static_cast<double>(bins[1]) - 0.5) * pitch[1];
+                    for(size_t z = 0; z < bins[2]; ++z) {
+                        auto pos_z = thickness_domain_.first + (static_cast<double>(z) + 0.5) /
+                                                                   static_cast<double>(bins[2]) * thickness;
+                        ROOT::Math::XYZPoint pos(pos_x, pos_y, pos_z);
+                        for(int dx = -matrix[0] / 2; dx <= matrix[0] / 2; ++dx) {
+                            for(int dy = -matrix[1] / 2; dy <= matrix[1] / 2; ++dy) {
+                                *value++ = getRelativeTo(pos, {dx * pitch[0], dy * pitch[1]}, true);
+                            }
+                        }
+                    }
+                }
+            }
+        };
+
+        threads = std::max(threads, 1u);
+        auto block = (bins[0] + threads - 1) / threads;
+        std::vector<std::thread> workers;
+        for(unsigned int i = 1; i < threads; ++i) {
+            workers.emplace_back(tabulate, std::min(bins[0], i * block), std::min(bins[0], (i + 1) * block));
+        }
+        tabulate(0, std::min(bins[0], block));
+        for(auto& worker : workers) {
+            worker.join();
+        }
+
+        if(!replicas_.empty()) {
+            table.replicas_ = NumaTopology::get().replicate(table.values_, huge_pages_);
+        }
+        return table;
+    }
 } // namespace allpix
@@ -9,6 +9,7 @@
  */
 
 #include <fstream>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -309,7 +310,7 @@ void GeometryManager::addDetector(std::shared_ptr<Detector> detector) {
         throw DetectorExistsError(detector->getName());
     }
 
-    detector_names_.insert(detector->getName());
+    detector_names_.emplace(detector->getName(), detector);
     detectors_.push_back(std::move(detector));
 }
 
@@ -324,6 +325,23 @@ std::vector<std::shared_ptr<Detector>> GeometryManager::getDetectors() {
 
     return detectors_;
 }
+
+/**
+ * Grids shared between detectors are only copied once. Fields defined by functions are not affected.
+ */
+void GeometryManager::replicateFields(bool huge_pages) {
+    auto replicated = field_replicas_.size();
+    for(auto& detector : getDetectors()) {
+        detector->electric_field_.replicate(field_replicas_, huge_pages);
+        detector->weighting_potential_.replicate(field_replicas_, huge_pages);
+        detector->magnetic_field_.replicate(field_replicas_, huge_pages);
+    }
+    if(field_replicas_.size() > replicated) {
+        LOG(DEBUG) << "Replicated " << (field_replicas_.size() - replicated) << " field grids on "
+                   << NumaTopology::get().getNodeCount() << " NUMA nodes";
+    }
+}
+
 /**
  * @throws InvalidDetectorError If a detector with this name does not exist
  */
@@ -332,13 +350,11 @@ std::shared_ptr<Detector> GeometryManager::getDetector(const std::string& name)
         close_geometry();
     }
 
-    // FIXME: this is not a very nice way to implement this
-    for(auto& detector : detectors_) {
-        if(detector->getName() == name) {
-            return detector;
-        }
+    auto detector = detector_names_.find(name);
+    if(detector == detector_names_.end()) {
+        throw allpix::InvalidDetectorError(name);
     }
-    throw allpix::InvalidDetectorError(name);
+    return detector->second;
 }
 
 /**
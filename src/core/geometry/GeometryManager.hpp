@@ -31,6 +31,7 @@ namespace allpix {
     enum class MagneticFieldType {
         NONE = 0, ///< No magnetic field is simulated
         CONSTANT, ///< Constant magnetic field (mostly for testing)
+        GRID,     ///< Magnetic field supplied through a regularized grid
         CUSTOM,   ///< Custom magnetic field function
     };
 
@@ -189,6 +190,13 @@ namespace allpix {
          */
         std::vector<std::shared_ptr<Detector>> getDetectorsByType(const std::string& type);
 
+        /**
+         * @brief Place copies of the field grids of all detectors in the local memory of every NUMA node
+         * @param huge_pages Request transparent huge pages for the copies
+         * @note Can be called repeatedly while fields are set, grids which have been replicated before are not copied again
+         */
+        void replicateFields(bool huge_pages);
+
         /**
          * @brief Set the magnetic field in the volume
          * @param function Function used to retrieve the magnetic field
@@ -278,7 +286,7 @@ namespace allpix {
 
         std::map<std::string, std::vector<std::pair<Configuration, Detector*>>> nonresolved_models_;
         std::vector<std::shared_ptr<Detector>> detectors_;
-        std::set<std::string> detector_names_;
+        std::map<std::string, std::shared_ptr<Detector>> detector_names_;
 
         std::list<Configuration> passive_elements_;
         std::map<std::string, std::pair<ROOT::Math::XYZPoint, ROOT::Math::Rotation3D>> passive_orientations_;
@@ -286,6 +294,8 @@ namespace allpix {
         MagneticFieldType magnetic_field_type_{MagneticFieldType::NONE};
         MagneticFieldFunction magnetic_field_function_;
 
+        std::map<const std::vector<double>*, FieldReplicas> field_replicas_;
+
         std::map<std::type_index, std::map<std::pair<std::string, std::string>, std::shared_ptr<void>>> external_objects_;
         std::set<std::string> external_object_names_;
     };
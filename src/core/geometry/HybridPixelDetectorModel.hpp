@@ -11,6 +11,8 @@
 #ifndef ALLPIX_HYBRID_PIXEL_DETECTOR_H
 #define ALLPIX_HYBRID_PIXEL_DETECTOR_H
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <utility>
 
@@ -30,6 +32,14 @@ namespace allpix {
      */
     class HybridPixelDetectorModel : public DetectorModel {
     public:
+        /**
+         * @brief Representation of the bump bonds in the geometry
+         */
+        enum class BumpGeometry {
+            EXACT = 0,   ///< Individual bump bond for every pixel
+            HOMOGENEOUS, ///< Single slab of the bump bond layer with the average density of solder and surrounding material
+        };
+
         /**
          * @brief Constructs the hybrid pixel detector model
          * @param type Name of the model type
@@ -51,6 +61,17 @@ namespace allpix {
             setBumpHeight(config.get<double>("bump_height"));
             setBumpSphereRadius(config.get<double>("bump_sphere_radius", 0));
             setBumpOffset(config.get<ROOT::Math::XYVector>("bump_offset", {0, 0}));
+
+            auto bump_geometry = config.get<std::string>("bump_geometry", "exact");
+            std::transform(bump_geometry.begin(), bump_geometry.end(), bump_geometry.begin(), ::tolower);
+            if(bump_geometry == "exact") {
+                bump_geometry_ = BumpGeometry::EXACT;
+            } else if(bump_geometry == "homogeneous") {
+                bump_geometry_ = BumpGeometry::HOMOGENEOUS;
+            } else {
+                throw InvalidValueError(
+                    config, "bump_geometry", "bump geometry should be either 'exact' or 'homogeneous'");
+            }
         }
 
         /**
@@ -164,6 +185,38 @@ namespace allpix {
          */
         void setBumpOffset(ROOT::Math::XYVector val) { bump_offset_ = std::move(val); }
 
+        /**
+         * @brief Get the representation of the bump bonds in the geometry
+         * @return Bump bond geometry
+         */
+        BumpGeometry getBumpGeometry() const { return bump_geometry_; }
+        /**
+         * @brief Set the representation of the bump bonds in the geometry
+         * @param val Bump bond geometry
+         */
+        void setBumpGeometry(BumpGeometry val) { bump_geometry_ = val; }
+
+        /**
+         * @brief Get the fraction of the bump bond layer filled with solder
+         * @return Volume of a single bump bond inside the bump layer divided by the volume of one pixel cell of the layer
+         *
+         * The bump bond is the union of a cylinder spanning the full height of the layer and a sphere centered in the layer,
+         * only the part of the sphere inside the layer is taken into account.
+         */
+        double getBumpFillFraction() const {
+            auto half_height = bump_height_ / 2.0;
+            auto cylinder_radius2 = bump_cylinder_radius_ * bump_cylinder_radius_;
+            auto sphere_radius2 = bump_sphere_radius_ * bump_sphere_radius_;
+
+            // The cross section at height z is a disk with the larger radius of sphere and cylinder
+            auto sphere_extent = std::min(std::sqrt(std::max(sphere_radius2 - cylinder_radius2, 0.0)), half_height);
+            auto volume = 2 * M_PI *
+                          (cylinder_radius2 * (half_height - sphere_extent) + sphere_radius2 * sphere_extent -
+                           sphere_extent * sphere_extent * sphere_extent / 3);
+            auto cell_volume = getPixelSize().x() * getPixelSize().y() * bump_height_;
+            return (cell_volume > 0 ? std::min(volume / cell_volume, 1.0) : 0.0);
+        }
+
     private:
         std::array<double, 4> chip_excess_{};
 
@@ -171,6 +224,7 @@ namespace allpix {
         double bump_height_{};
         ROOT::Math::XYVector bump_offset_;
         double bump_cylinder_radius_{};
+        BumpGeometry bump_geometry_{BumpGeometry::EXACT};
     };
 } // namespace allpix
 
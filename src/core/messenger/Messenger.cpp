@@ -10,6 +10,7 @@
 
 #include "Messenger.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -38,6 +39,15 @@ static bool check_send(BaseMessage* message, BaseDelegate* delegate) {
        (message->getDetector() == nullptr || delegate->getDetector()->getName() != message->getDetector()->getName())) {
         return false;
     }
+
+    // Multi-detector modules only receive messages of their detectors or messages not bound to any detector
+    auto& detectors = delegate->getDetectors();
+    if(delegate->getDetector() == nullptr && !detectors.empty() && message->getDetector() != nullptr &&
+       std::none_of(detectors.begin(), detectors.end(), [&](const std::shared_ptr<Detector>& detector) {
+           return detector->getName() == message->getDetector()->getName();
+       })) {
+        return false;
+    }
     return true;
 }
 
@@ -124,12 +134,21 @@ bool Messenger::dispatch_message(Module* source,
     const BaseMessage* inst = message.get();
     std::type_index type_idx = typeid(*inst);
 
+    // Messages dispatched during batches of events are held back until the receiver runs the event they belong to
+    auto deliver_or_hold = [&](BaseDelegate* delegate) {
+        if(source->batched_) {
+            pending_messages_[std::make_pair(delegate, source->batch_index_)].emplace_back(message, name);
+        } else {
+            delegate->process(message, name);
+        }
+    };
+
     // Send messages only to their specific listeners
     for(auto& delegate : delegates_[type_idx][id]) {
         if(check_send(message.get(), delegate.get())) {
             LOG(TRACE) << "Sending message " << allpix::demangle(type_idx.name()) << " from " << source->getUniqueName()
                        << " to " << delegate->getUniqueName();
-            delegate->process(message, name);
+            deliver_or_hold(delegate.get());
             send = true;
         }
     }
@@ -140,7 +159,7 @@ bool Messenger::dispatch_message(Module* source,
         if(check_send(message.get(), delegate.get())) {
             LOG(TRACE) << "Sending message " << allpix::demangle(type_idx.name()) << " from " << source->getUniqueName()
                        << " to generic listener " << delegate->getUniqueName();
-            delegate->process(message, name);
+            deliver_or_hold(delegate.get());
             send = true;
         }
     }
@@ -148,6 +167,19 @@ bool Messenger::dispatch_message(Module* source,
     return send;
 }
 
+void Messenger::deliver_messages(BaseDelegate* delegate, unsigned int index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto pending = pending_messages_.find(std::make_pair(delegate, index));
+    if(pending == pending_messages_.end()) {
+        return;
+    }
+    for(auto& message : pending->second) {
+        delegate->process(message.first, message.second);
+    }
+    pending_messages_.erase(pending);
+}
+
 void Messenger::add_delegate(const std::type_info& message_type, Module* module, std::unique_ptr<BaseDelegate> delegate) {
     std::lock_guard<std::mutex> lock(mutex_);
 
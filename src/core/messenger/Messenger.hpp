@@ -121,7 +121,10 @@ namespace allpix {
         /**
          * @brief Removes the list of sent messages, clearing them from memory if not otherwise used
          */
-        inline void clearMessages() { sent_messages_.clear(); }
+        inline void clearMessages() {
+            sent_messages_.clear();
+            pending_messages_.clear();
+        }
 
     private:
         /**
@@ -139,6 +142,13 @@ namespace allpix {
          */
         void remove_delegate(BaseDelegate* delegate);
 
+        /**
+         * @brief Hand the held back messages of an event of the current batch to a delegate
+         * @param delegate Delegate to receive the messages
+         * @param index Index of the event within the batch
+         */
+        void deliver_messages(BaseDelegate* delegate, unsigned int index);
+
         /**
          * @brief Dispatch base message to the specific and general delegates
          * @param source Dispatching module
@@ -168,6 +178,10 @@ namespace allpix {
         DelegateIteratorMap delegate_to_iterator_;
         std::vector<std::shared_ptr<BaseMessage>> sent_messages_;
 
+        // Messages dispatched during batches of events, held back per delegate and event until the receiver runs the event
+        using PendingMessages = std::vector<std::pair<std::shared_ptr<BaseMessage>, std::string>>;
+        std::map<std::pair<BaseDelegate*, unsigned int>, PendingMessages> pending_messages_;
+
         mutable std::mutex mutex_;
     };
 } // namespace allpix
@@ -19,6 +19,7 @@
 #include <cassert>
 #include <memory>
 #include <typeinfo>
+#include <vector>
 
 #include "Message.hpp"
 #include "core/geometry/Detector.hpp"
@@ -124,6 +125,12 @@ namespace allpix {
          */
         virtual std::shared_ptr<Detector> getDetector() const = 0;
 
+        /**
+         * @brief Get all detectors handled by the object bound to a delegate
+         * @return List of detectors, empty if the delegate receives messages of all detectors
+         */
+        virtual const std::vector<std::shared_ptr<Detector>>& getDetectors() const = 0;
+
         /**
          * @brief Get the unique identifier for the bound object
          * @return Unique identifier
@@ -181,6 +188,14 @@ namespace allpix {
          */
         std::shared_ptr<Detector> getDetector() const override { return obj_->getDetector(); }
 
+        /**
+         * @brief Get all detectors handled by this module
+         *
+         * Returns the list of detectors for multi-detector modules, the bound detector for detector modules and an empty
+         * list for unique modules
+         */
+        const std::vector<std::shared_ptr<Detector>>& getDetectors() const override { return obj_->getDetectors(); }
+
     protected:
         T* obj_;
     };
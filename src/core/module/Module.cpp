@@ -10,9 +10,11 @@
 
 #include "Module.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
 #include <stdexcept>
+#include <thread>
 #include <utility>
 
 #include "core/messenger/Messenger.hpp"
@@ -24,7 +26,13 @@ using namespace allpix;
 
 Module::Module(Configuration& config) : Module(config, nullptr) {}
 Module::Module(Configuration& config, std::shared_ptr<Detector> detector)
-    : config_(config), detector_(std::move(detector)) {}
+    : config_(config), detector_(std::move(detector)) {
+    if(detector_ != nullptr) {
+        detectors_.push_back(detector_);
+    }
+}
+Module::Module(Configuration& config, std::vector<std::shared_ptr<Detector>> detectors)
+    : config_(config), detectors_(std::move(detectors)) {}
 /**
  * @note The remove_delegate can throw in theory, but this should never happen in practice
  */
@@ -60,6 +68,14 @@ std::shared_ptr<Detector> Module::getDetector() const {
     return detector_;
 }
 
+/**
+ * Multi-detector modules are not linked to a single detector, they handle all detectors in this list within one
+ * instantiation
+ */
+const std::vector<std::shared_ptr<Detector>>& Module::getDetectors() const {
+    return detectors_;
+}
+
 /**
  * @throws ModuleError If the file cannot be accessed (or created if it did not yet exist)
  * @throws InvalidModuleActionException If this method is called from the constructor with the global flag false
@@ -137,6 +153,20 @@ uint64_t Module::getRandomSeed() {
     return random_generator_();
 }
 
+/**
+ * The level is the same for all modules and is set by the framework from the global configuration
+ */
+MCTruthLevel Module::getMCTruthLevel() const {
+    auto level = config_.get<std::string>("_mc_truth", "full");
+    if(level == "none") {
+        return MCTruthLevel::NONE;
+    }
+    if(level == "primary") {
+        return MCTruthLevel::PRIMARY;
+    }
+    return MCTruthLevel::FULL;
+}
+
 /**
  * @throws InvalidModuleActionException If the thread pool is accessed outside the run-method
  * @warning Any multithreaded task should be carefully checked to ensure it is thread-safe
@@ -152,6 +182,16 @@ ThreadPool& Module::getThreadPool() {
 
     return *thread_pool_;
 }
+/**
+ * The number of workers is determined in the same way as by the module manager when creating the thread pool.
+ */
+unsigned int Module::getWorkerCount() {
+    auto& global_config = getConfigManager()->getGlobalConfiguration();
+    if(!global_config.get<bool>("experimental_multithreading", false)) {
+        return 1;
+    }
+    return std::max(global_config.get<unsigned int>("workers", std::max(std::thread::hardware_concurrency(), 1u)), 1u);
+}
 void Module::set_thread_pool(std::shared_ptr<ThreadPool> thread_pool) {
     thread_pool_ = std::move(thread_pool);
 }
@@ -195,6 +235,13 @@ void Module::enable_parallelization() {
     parallelize_ = true;
 }
 
+bool Module::canCheckpoint() {
+    return checkpoints_;
+}
+void Module::enable_checkpoints() {
+    checkpoints_ = true;
+}
+
 Configuration& Module::get_configuration() {
     return config_;
 }
@@ -215,6 +262,40 @@ void Module::reset_delegates() {
         delegate.second->reset();
     }
 }
+
+/**
+ * Messages dispatched by other modules during a batch are held back by the messenger and only handed to the delegates of
+ * this module when the event they belong to is received, such that the delegates always contain the messages of one event.
+ */
+bool Module::receive_batch_event(unsigned int index) {
+    select_batch_event(index);
+    for(auto& delegate : delegates_) {
+        delegate.first->deliver_messages(delegate.second, index);
+    }
+    return check_delegates();
+}
+void Module::release_batch_event() {
+    // Messages of the full batch are only cleared from the messenger after all modules have been executed
+    for(auto& delegate : delegates_) {
+        delegate.second->reset();
+    }
+}
+void Module::select_batch_event(unsigned int index) {
+    batch_index_ = index;
+}
+
+void Module::runBatch(unsigned int first_event, unsigned int events) {
+    for(unsigned int i = 0; i < events; ++i) {
+        if(receive_batch_event(i)) {
+            run(first_event + i);
+        } else {
+            LOG(TRACE) << "Not all required messages are received for " << get_identifier().getUniqueName()
+                       << " in event " << (first_event + i) << ", skipping module!";
+        }
+        release_batch_event();
+    }
+}
+
 bool Module::check_delegates() {
     for(auto& delegate : delegates_) {
         // Return false if any delegate is not satisfied
@@ -10,7 +10,9 @@
 #ifndef ALLPIX_MODULE_H
 #define ALLPIX_MODULE_H
 
+#include <istream>
 #include <memory>
+#include <ostream>
 #include <random>
 #include <string>
 #include <vector>
@@ -27,6 +29,22 @@
 
 namespace allpix {
     class Messenger;
+
+    /**
+     * @brief Depth of the Monte-Carlo truth history stored with the objects
+     *
+     * Set for all modules by the global \a mc_truth parameter:
+     * - FULL: all objects are linked to the objects they were created from and to their Monte-Carlo particles
+     * - PRIMARY: objects are only linked to the Monte-Carlo particles of primary tracks, the history of the individual
+     *   charge carriers is not stored
+     * - NONE: no history is stored, objects are not linked to other objects
+     */
+    enum class MCTruthLevel {
+        NONE,    ///< No history
+        PRIMARY, ///< Only links to primary Monte-Carlo particles
+        FULL,    ///< Full object history
+    };
+
     /**
      * @defgroup Modules Modules
      * @brief Collection of modules included in the framework
@@ -61,6 +79,14 @@ namespace allpix {
          *          \ref InvalidModuleStateException will be raised if the module failed to so.
          */
         explicit Module(Configuration& config, std::shared_ptr<Detector> detector);
+        /**
+         * @brief Base constructor for multi-detector modules
+         * @param config Configuration for this module
+         * @param detectors Detectors handled by this module
+         * @warning Multi-detector modules should not forget to forward their detectors to the base constructor. An
+         *          \ref InvalidModuleStateException will be raised if the module failed to so.
+         */
+        explicit Module(Configuration& config, std::vector<std::shared_ptr<Detector>> detectors);
         /**
          * @brief Essential virtual destructor.
          *
@@ -86,10 +112,17 @@ namespace allpix {
 
         /**
          * @brief Get the detector linked to this module
-         * @return Linked detector or a null pointer if this is an unique module
+         * @return Linked detector or a null pointer if this is an unique or multi-detector module
          */
         std::shared_ptr<Detector> getDetector() const;
 
+        /**
+         * @brief Get all detectors handled by this module
+         * @return List of detectors for multi-detector modules, the linked detector for detector modules and an empty list
+         *         for unique modules
+         */
+        const std::vector<std::shared_ptr<Detector>>& getDetectors() const;
+
         /**
          * @brief Get the unique name of this module
          * @return Unique name
@@ -112,11 +145,26 @@ namespace allpix {
          */
         uint64_t getRandomSeed();
 
+        /**
+         * @brief Get the depth of the Monte-Carlo truth history the module should store with its objects
+         * @return Level of the Monte-Carlo truth
+         */
+        MCTruthLevel getMCTruthLevel() const;
+
         /**
          * @brief Get thread pool to submit asynchronous tasks to
          */
         ThreadPool& getThreadPool();
 
+        /**
+         * @brief Get the number of workers configured for the event processing
+         * @return Number of workers, one if multithreading is disabled
+         *
+         * Allows to parallelize expensive steps of the initialization, where the thread pool is not available yet, without
+         * exceeding the number of threads the run has been configured for.
+         */
+        unsigned int getWorkerCount();
+
         /**
          * @brief Get ROOT directory which should be used to output histograms et cetera
          * @return ROOT directory for storage
@@ -135,6 +183,12 @@ namespace allpix {
          */
         bool canParallelize();
 
+        /**
+         * @brief Returns if this module supports checkpoints
+         * @return True if the module can continue a run from a checkpoint, false otherwise (the default)
+         */
+        bool canCheckpoint();
+
         /**
          * @brief Initialize the module before the event sequence
          *
@@ -150,6 +204,36 @@ namespace allpix {
          */
         // TODO [doc] Start the sequence at 0 instead of 1?
         virtual void run(unsigned int event_num) { (void)event_num; }
+
+        /**
+         * @brief Execute the function of the module for a batch of consecutive events
+         * @param first_event Number of the first event of the batch (starts at 1)
+         * @param events Number of events in the batch
+         *
+         * Only called if events are executed in batches. The default implementation receives the messages of every event
+         * of the batch in turn and calls \ref run() for it if all delegates are satisfied. Modules can overload this method
+         * to share their own per-event setup between the events of a batch, using \ref receive_batch_event() and
+         * \ref release_batch_event() to access the messages of the individual events.
+         */
+        virtual void runBatch(unsigned int first_event, unsigned int events);
+
+        /**
+         * @brief Store the state of the module required to continue the event sequence in a checkpoint
+         * @param state Stream to write the state to
+         *
+         * Called after an event if checkpoints are enabled. Modules should store the state of their random number
+         * generators, their statistics and the position of their output files. Only modules which enabled checkpoints via
+         * \ref enable_checkpoints() can be used in runs with checkpoints. Does nothing if not overloaded.
+         */
+        virtual void storeState(std::ostream& state) { (void)state; }
+
+        /**
+         * @brief Restore the state of the module from a checkpoint
+         * @param state Stream to read the state written by \ref storeState() from
+         *
+         * Called before \ref init() when a run is resumed from a checkpoint. Does nothing if not overloaded.
+         */
+        virtual void restoreState(std::istream& state) { (void)state; }
         //
         /**
          * @brief Finalize the module after the event sequence
@@ -165,6 +249,14 @@ namespace allpix {
          */
         void enable_parallelization();
 
+        /**
+         * @brief Enable checkpoints for this module
+         *
+         * Should only be called by modules which either store everything needed to continue their event sequence and
+         * output via \ref storeState(), or which do not keep any state or output across events.
+         */
+        void enable_checkpoints();
+
         /**
          * @brief Get the module configuration for internal use
          * @return Configuration of the module
@@ -172,6 +264,29 @@ namespace allpix {
         Configuration& get_configuration();
         Configuration& config_;
 
+        /**
+         * @brief Receive the messages of a single event of the current batch
+         * @param index Index of the event within the batch
+         * @return True if all delegates are satisfied for this event, false otherwise
+         * @note The messages have to be released with \ref release_batch_event() before receiving the next event
+         *
+         * Messages dispatched afterwards belong to this event, unless another event is selected with
+         * \ref select_batch_event().
+         */
+        bool receive_batch_event(unsigned int index);
+        /**
+         * @brief Release the messages of the event of the current batch received last
+         */
+        void release_batch_event();
+        /**
+         * @brief Select the event of the current batch that subsequently dispatched messages belong to
+         * @param index Index of the event within the batch
+         *
+         * Allows to dispatch the results of all events after processing the full batch. Messages must not be dispatched
+         * from tasks running in parallel for different events.
+         */
+        void select_batch_event(unsigned int index);
+
     private:
         /**
          * @brief Set the module identifier for internal use
@@ -222,12 +337,18 @@ namespace allpix {
         bool check_delegates();
         std::vector<std::pair<Messenger*, BaseDelegate*>> delegates_;
 
+        // Execution of events in batches, messages dispatched by this module are assigned to the current event of the batch
+        bool batched_{false};
+        unsigned int batch_index_{0};
+
         bool initialized_random_generator_{false};
         std::mt19937_64 random_generator_;
 
         std::shared_ptr<Detector> detector_;
+        std::vector<std::shared_ptr<Detector>> detectors_;
 
         bool parallelize_{false};
+        bool checkpoints_{false};
     };
 
 } // namespace allpix
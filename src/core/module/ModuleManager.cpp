@@ -15,17 +15,24 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstdio>
 #include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <limits>
 #include <random>
 #include <set>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 
 #include <TProcessID.h>
 #include <TSystem.h>
 
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
 #include "core/config/ConfigManager.hpp"
 #include "core/config/Configuration.hpp"
 #include "core/config/exceptions.h"
@@ -33,6 +40,7 @@
 #include "core/messenger/Messenger.hpp"
 #include "core/utils/file.h"
 #include "core/utils/log.h"
+#include "core/utils/numa.h"
 
 // Common prefix for all modules
 // TODO [doc] Should be provided by the build system
@@ -41,9 +49,31 @@
 // These should point to the function defined in dynamic_module_impl.cpp
 #define ALLPIX_GENERATOR_FUNCTION "allpix_module_generator"
 #define ALLPIX_UNIQUE_FUNCTION "allpix_module_is_unique"
+#define ALLPIX_MULTI_DETECTOR_FUNCTION "allpix_module_is_multi_detector"
 
 using namespace allpix;
 
+namespace {
+    // Version of the checkpoint format, increased for incompatible changes
+    constexpr std::uint32_t checkpoint_version = 1;
+
+    /**
+     * @brief State of a run stored in a checkpoint file
+     */
+    struct Checkpoint {
+        std::uint32_t version{checkpoint_version};
+        std::uint64_t random_seed{};
+        std::uint64_t random_seed_core{};
+        std::uint32_t events{};
+        std::vector<std::string> modules;
+        std::vector<std::string> states;
+
+        template <class Archive> void serialize(Archive& archive) {
+            archive(version, random_seed, random_seed_core, events, modules, states);
+        }
+    };
+} // namespace
+
 ModuleManager::ModuleManager() : terminate_(false) {}
 
 /**
@@ -54,8 +84,9 @@ void ModuleManager::load(Messenger* messenger,
                          ConfigManager* conf_manager,
                          GeometryManager* geo_manager,
                          std::mt19937_64& seeder) {
-    // Store config manager and get configurations
+    // Store config and geometry manager and get configurations
     conf_manager_ = conf_manager;
+    geo_manager_ = geo_manager;
     auto& configs = conf_manager_->getModuleConfigurations();
     Configuration& global_config = conf_manager_->getGlobalConfiguration();
 
@@ -76,6 +107,16 @@ void ModuleManager::load(Messenger* messenger,
     }
     modules_file_->cd();
 
+    // Depth of the Monte-Carlo truth history stored by all modules
+    auto mc_truth = global_config.get<std::string>("mc_truth", "full");
+    std::transform(mc_truth.begin(), mc_truth.end(), mc_truth.begin(), ::tolower);
+    if(mc_truth != "full" && mc_truth != "primary" && mc_truth != "none") {
+        throw InvalidValueError(global_config, "mc_truth", "level should be 'full', 'primary' or 'none'");
+    }
+    if(mc_truth != "full") {
+        LOG(INFO) << "Storing Monte-Carlo truth history at level '" << mc_truth << "'";
+    }
+
     // Loop through all non-global configurations
     for(auto& config : configs) {
         // Load library for each module. Libraries are named (by convention + CMAKE) libAllpixModule Name.suffix
@@ -183,9 +224,18 @@ void ModuleManager::load(Messenger* messenger,
             unique = reinterpret_cast<bool (*)()>(uniqueFunction)(); // NOLINT
         }
 
+        // Check if this detector module handles all its detectors in a single instance. Libraries built before
+        // multi-detector modules existed do not provide this function and are never multi-detector modules.
+        bool multi_detector = false;
+        void* multiDetectorFunction = dlsym(loaded_libraries_[lib_name], ALLPIX_MULTI_DETECTOR_FUNCTION);
+        if(multiDetectorFunction != nullptr) {
+            multi_detector = reinterpret_cast<bool (*)()>(multiDetectorFunction)(); // NOLINT
+        }
+
         // Add the global internal parameters to the configuration
         std::string global_dir = gSystem->pwd();
         config.set<std::string>("_global_dir", global_dir);
+        config.set<std::string>("_mc_truth", mc_truth);
 
         // Set default input and output name
         config.setDefault<std::string>("input", "");
@@ -196,6 +246,9 @@ void ModuleManager::load(Messenger* messenger,
         if(unique) {
             mod_list.emplace_back(
                 create_unique_modules(loaded_libraries_[lib_name], config, messenger, geo_manager, seeder));
+        } else if(multi_detector) {
+            mod_list.emplace_back(
+                create_multi_detector_modules(loaded_libraries_[lib_name], config, messenger, geo_manager, seeder));
         } else {
             mod_list = create_detector_modules(loaded_libraries_[lib_name], config, messenger, geo_manager, seeder);
         }
@@ -351,49 +404,11 @@ std::vector<std::pair<ModuleIdentifier, Module*>> ModuleManager::create_detector
     auto module_generator =
         reinterpret_cast<Module* (*)(Configuration&, Messenger*, std::shared_ptr<Detector>)>(generator); // NOLINT
 
-    // Handle empty type and name arrays:
-    bool instances_created = false;
+    // Create the instantiations for all selected detectors
     std::vector<std::pair<std::shared_ptr<Detector>, ModuleIdentifier>> instantiations;
-
-    // Create all names first with highest priority
-    std::set<std::string> module_names;
-    if(config.has("name")) {
-        std::vector<std::string> names = config.getArray<std::string>("name");
-        for(auto& name : names) {
-            auto det = geo_manager->getDetector(name);
-            instantiations.emplace_back(det, ModuleIdentifier(module_name, det->getName() + identifier, 0));
-
-            // Save the name (to not instantiate it again later)
-            module_names.insert(name);
-        }
-        instances_created = !names.empty();
-    }
-
-    // Then create all types that are not yet name instantiated
-    if(config.has("type")) {
-        std::vector<std::string> types = config.getArray<std::string>("type");
-        for(auto& type : types) {
-            auto detectors = geo_manager->getDetectorsByType(type);
-
-            for(auto& det : detectors) {
-                // Skip all that were already added by name
-                if(module_names.find(det->getName()) != module_names.end()) {
-                    continue;
-                }
-
-                instantiations.emplace_back(det, ModuleIdentifier(module_name, det->getName() + identifier, 1));
-            }
-        }
-        instances_created = !types.empty();
-    }
-
-    // Create for all detectors if no name / type provided
-    if(!instances_created) {
-        auto detectors = geo_manager->getDetectors();
-
-        for(auto& det : detectors) {
-            instantiations.emplace_back(det, ModuleIdentifier(module_name, det->getName() + identifier, 2));
-        }
+    for(auto& selection : select_detectors(config, geo_manager)) {
+        instantiations.emplace_back(
+            selection.first, ModuleIdentifier(module_name, selection.first->getName() + identifier, selection.second));
     }
 
     // Construct instantiations from the list of requests
@@ -448,6 +463,146 @@ std::vector<std::pair<ModuleIdentifier, Module*>> ModuleManager::create_detector
     return module_list;
 }
 
+/**
+ * @throws InvalidModuleStateException If the module fails to forward the detectors to the base class
+ *
+ * Multi-detector modules are detector modules which process all their detectors in a single instantiation. The detectors are
+ * selected with the same \c name and \c type parameters as for detector modules, but only one instance is created per
+ * section. Its name and priority are determined as for unique modules.
+ */
+std::pair<ModuleIdentifier, Module*> ModuleManager::create_multi_detector_modules(
+    void* library, Configuration& config, Messenger* messenger, GeometryManager* geo_manager, std::mt19937_64& seeder) {
+    std::string module_name = config.getName();
+    LOG(DEBUG) << "Creating multi-detector instantiation for detector module " << module_name;
+
+    // Create the identifier
+    std::string identifier_str;
+    if(!config.get<std::string>("input").empty()) {
+        identifier_str += config.get<std::string>("input");
+    }
+    if(!config.get<std::string>("output").empty()) {
+        if(!identifier_str.empty()) {
+            identifier_str += "_";
+        }
+        identifier_str += config.get<std::string>("output");
+    }
+    ModuleIdentifier identifier(module_name, identifier_str, 0);
+
+    // Get the generator function for this module
+    void* generator = dlsym(library, ALLPIX_GENERATOR_FUNCTION);
+    // If the generator function was not found, throw an error
+    if(generator == nullptr) {
+        LOG(ERROR) << "Module library is invalid or outdated: required interface function not found!";
+        throw allpix::DynamicLibraryError(module_name);
+    }
+    // Convert to correct generator function
+    using MultiDetectorGenerator = Module* (*)(Configuration&, Messenger*, std::vector<std::shared_ptr<Detector>>);
+    auto module_generator = reinterpret_cast<MultiDetectorGenerator>(generator); // NOLINT
+
+    // Collect all selected detectors
+    std::vector<std::shared_ptr<Detector>> detectors;
+    for(auto& selection : select_detectors(config, geo_manager)) {
+        detectors.push_back(selection.first);
+    }
+
+    // Create and add module instance config
+    Configuration& instance_config = conf_manager_->addInstanceConfiguration(identifier, config);
+
+    // Specialize instance configuration
+    instance_config.set<uint64_t>("_seed", seeder());
+    std::string output_dir;
+    output_dir = instance_config.get<std::string>("_global_dir");
+    output_dir += "/";
+    std::string path_mod_name = identifier.getUniqueName();
+    std::replace(path_mod_name.begin(), path_mod_name.end(), ':', '_');
+    output_dir += path_mod_name;
+
+    LOG(DEBUG) << "Creating multi-detector instantiation " << identifier.getUniqueName() << " for " << detectors.size()
+               << " detectors";
+
+    // Get current time
+    auto start = std::chrono::steady_clock::now();
+    // Set the log section header
+    std::string old_section_name = Log::getSection();
+    std::string section_name = "C:";
+    section_name += identifier.getUniqueName();
+    Log::setSection(section_name);
+    // Set module specific log settings
+    auto old_settings = set_module_before(identifier.getUniqueName(), instance_config);
+    // Build module
+    Module* module = module_generator(instance_config, messenger, detectors);
+    // Reset log
+    Log::setSection(old_section_name);
+    set_module_after(old_settings);
+    // Update execution time
+    auto end = std::chrono::steady_clock::now();
+    module_execution_time_[module] += static_cast<std::chrono::duration<long double>>(end - start).count();
+
+    // Set the module directory afterwards to catch invalid access in constructor
+    module->get_configuration().set<std::string>("_output_dir", output_dir);
+
+    // Check if the module called the correct base class constructor
+    if(module->getDetectors() != detectors) {
+        throw InvalidModuleStateException(
+            "Module " + module_name +
+            " does not call the correct base Module constructor: the provided detectors should be forwarded");
+    }
+
+    // Store the module and return it to the Module Manager
+    return std::make_pair(identifier, module);
+}
+
+/**
+ * Detectors selected by their \c name parameter have the highest priority (0), followed by detectors selected by their
+ * \c type parameter (1). All detectors are selected with the lowest priority (2) if neither of them is provided.
+ */
+std::vector<std::pair<std::shared_ptr<Detector>, int>> ModuleManager::select_detectors(Configuration& config,
+                                                                                       GeometryManager* geo_manager) {
+    // Handle empty type and name arrays:
+    bool instances_created = false;
+    std::vector<std::pair<std::shared_ptr<Detector>, int>> selection;
+
+    // Create all names first with highest priority
+    std::set<std::string> module_names;
+    if(config.has("name")) {
+        std::vector<std::string> names = config.getArray<std::string>("name");
+        for(auto& name : names) {
+            selection.emplace_back(geo_manager->getDetector(name), 0);
+
+            // Save the name (to not instantiate it again later)
+            module_names.insert(name);
+        }
+        instances_created = !names.empty();
+    }
+
+    // Then create all types that are not yet name instantiated
+    if(config.has("type")) {
+        std::vector<std::string> types = config.getArray<std::string>("type");
+        for(auto& type : types) {
+            auto detectors = geo_manager->getDetectorsByType(type);
+
+            for(auto& det : detectors) {
+                // Skip all that were already added by name
+                if(module_names.find(det->getName()) != module_names.end()) {
+                    continue;
+                }
+
+                selection.emplace_back(det, 1);
+            }
+        }
+        instances_created = !types.empty();
+    }
+
+    // Create for all detectors if no name / type provided
+    if(!instances_created) {
+        for(auto& det : geo_manager->getDetectors()) {
+            selection.emplace_back(det, 2);
+        }
+    }
+
+    return selection;
+}
+
 // Helper functions to set the module specific log settings if necessary
 std::tuple<LogLevel, LogFormat> ModuleManager::set_module_before(const std::string&, const Configuration& config) {
     // Set new log level if necessary
@@ -508,6 +663,58 @@ void ModuleManager::set_module_after(std::tuple<LogLevel, LogFormat> prev) {
  */
 void ModuleManager::init() {
     auto start_time = std::chrono::steady_clock::now();
+
+    // Set up the accounting of memory allocations per module instantiation if requested
+    Configuration& global_config = conf_manager_->getGlobalConfiguration();
+    memory_tracking_ = global_config.get<bool>("memory_tracking", false);
+    if(memory_tracking_ && !MemoryTracker::isAvailable()) {
+        LOG(WARNING) << "Memory tracking requested but not supported by this build, enable ALLPIX_MEMORY_TRACKING to use it";
+        memory_tracking_ = false;
+    }
+    if(memory_tracking_) {
+        for(auto& module : modules_) {
+            module_memory_[module.get()] = MemoryTracker::createCounters();
+        }
+    }
+
+    // Set up the hardware performance counters if requested
+    performance_counters_ = global_config.get<bool>("performance_counters", false);
+    if(performance_counters_ && !PerformanceCounters::isAvailable()) {
+        LOG(WARNING) << "Hardware performance counters requested but not available on this system, disabling them";
+        performance_counters_ = false;
+    }
+    if(performance_counters_) {
+        for(auto& module : modules_) {
+            module_performance_[module.get()];
+        }
+    }
+
+    // Set up the checkpoints and read the state to resume from if requested
+    checkpoint_interval_ = global_config.get<unsigned int>("checkpoint_interval", 0u);
+    checkpoint_path_ = std::string(gSystem->pwd()) + "/" + global_config.get<std::string>("checkpoint_file", "checkpoint");
+    checkpoint_path_ = allpix::add_file_extension(checkpoint_path_, "ckpt");
+    resume_ = global_config.get<bool>("resume", false);
+    if(checkpoint_interval_ > 0 || resume_) {
+        // Modules without checkpoint support would lose their output and state of the events before the checkpoint
+        for(auto& module : modules_) {
+            if(!module->canCheckpoint()) {
+                throw InvalidValueError(global_config,
+                                        (resume_ ? "resume" : "checkpoint_interval"),
+                                        "module " + module->getUniqueName() + " does not support checkpoints");
+            }
+        }
+    }
+    if(resume_) {
+        read_checkpoint();
+    }
+
+    // Place copies of the read-only field grids on all NUMA nodes, such that pinned workers read from local memory
+    replicate_fields_ = global_config.get<bool>("numa_replicate_fields", false);
+    huge_pages_ = global_config.get<bool>("numa_huge_pages", false);
+    if(replicate_fields_) {
+        LOG(STATUS) << "Replicating field grids on " << NumaTopology::get().getNodeCount() << " NUMA node(s)";
+    }
+
     LOG_PROGRESS(STATUS, "INIT_LOOP") << "Initializing " << modules_.size() << " module instantiations";
     for(auto& module : modules_) {
         LOG_PROGRESS(TRACE, "INIT_LOOP") << "Initializing " << module->get_identifier().getUniqueName();
@@ -551,13 +758,36 @@ void ModuleManager::init() {
         Log::setSection(section_name);
         // Set module specific settings
         auto old_settings = set_module_before(module->get_identifier().getUniqueName(), module->get_configuration());
+        // Attribute allocations to this module
+        auto old_counters = MemoryTracker::getCurrent();
+        MemoryTracker::setCurrent(get_memory_counters(module.get()));
+        auto performance_start = read_performance_counters();
         // Change to our ROOT directory
         module->getROOTDirectory()->cd();
+        // Restore the state of the module if the run is resumed from a checkpoint
+        if(resume_) {
+            auto state = resume_states_.find(module->getUniqueName());
+            if(state == resume_states_.end()) {
+                throw RuntimeError("Checkpoint does not contain the state of module " + module->getUniqueName());
+            }
+            std::istringstream state_stream(state->second);
+            module->restoreState(state_stream);
+            if(state_stream.fail()) {
+                throw RuntimeError("Cannot restore the state of module " + module->getUniqueName() + " from checkpoint");
+            }
+        }
         // Init module
         module->init();
+        // Replicate the fields set by the module, such that fields derived from them by later modules are replicated as well
+        if(replicate_fields_) {
+            geo_manager_->replicateFields(huge_pages_);
+        }
         // Reset delegates
         LOG(TRACE) << "Resetting messages";
         module->reset_delegates();
+        // Reset memory accounting and account performance counters
+        add_performance_counters(module.get(), performance_start);
+        MemoryTracker::setCurrent(old_counters);
         // Reset logging
         Log::setSection(old_section_name);
         set_module_after(old_settings);
@@ -575,11 +805,15 @@ void ModuleManager::init() {
  * if its delegates are not \ref Module::check_delegates() "satisfied". Sets the section header and logging settings before
  * executing the \ref Module::run() function. \ref Module::reset_delegates() "Resets" the delegates and the logging after
  * initialization
+ *
+ * If events are executed in batches, the setup is done once per batch and module, and \ref Module::runBatch() is called
+ * with all events of the batch. The messages of the batch are kept until all modules have been executed.
  */
 void ModuleManager::run() {
     Configuration& global_config = conf_manager_->getGlobalConfiguration();
 
     global_config.setDefault("experimental_multithreading", false);
+    global_config.setDefault<std::string>("worker_affinity", "none");
     unsigned int threads_num;
 
     if(global_config.get<bool>("experimental_multithreading")) {
@@ -595,6 +829,24 @@ void ModuleManager::run() {
         threads_num = 0;
     }
 
+    // Determine the placement of the workers
+    auto affinity_name = global_config.get<std::string>("worker_affinity");
+    std::transform(affinity_name.begin(), affinity_name.end(), affinity_name.begin(), ::tolower);
+    ThreadPool::Affinity affinity;
+    if(affinity_name == "none") {
+        affinity = ThreadPool::Affinity::NONE;
+    } else if(affinity_name == "core") {
+        affinity = ThreadPool::Affinity::CORE;
+    } else if(affinity_name == "numa") {
+        affinity = ThreadPool::Affinity::NUMA;
+    } else {
+        throw InvalidValueError(global_config, "worker_affinity", "affinity should be 'none', 'core' or 'numa'");
+    }
+
+    if(replicate_fields_ && NumaTopology::get().getNodeCount() > 1 && affinity == ThreadPool::Affinity::NONE) {
+        LOG(WARNING) << "Field grids are replicated but workers are not pinned, all lookups use the first copy";
+    }
+
     // Creates the thread pool
     LOG(DEBUG) << "Initializing thread pool with " << threads_num << " additional thread(s)";
     std::vector<Module*> module_list;
@@ -606,29 +858,78 @@ void ModuleManager::run() {
         Log::setReportingLevel(log_level);
         Log::setFormat(log_format);
     };
-    std::shared_ptr<ThreadPool> thread_pool = std::make_shared<ThreadPool>(threads_num, module_list, init_function);
+    std::shared_ptr<ThreadPool> thread_pool =
+        std::make_shared<ThreadPool>(threads_num, module_list, init_function, affinity);
     for(auto& module : modules_) {
         module->set_thread_pool(thread_pool);
     }
 
+    // Create the tree for the memory usage of every event if requested
+    if(memory_tracking_ && global_config.get<bool>("memory_tracking_per_event", false)) {
+        modules_file_->cd();
+        memory_tree_ = new TTree("memory", "Memory usage of module instantiations per event");
+        for(auto& module : modules_) {
+            auto name = module->getUniqueName();
+            std::replace(name.begin(), name.end(), ':', '_');
+            auto& values = memory_tree_values_[module.get()];
+            memory_tree_->Branch((name + "_live").c_str(), &values[0]);
+            memory_tree_->Branch((name + "_peak").c_str(), &values[1]);
+            memory_tree_->Branch((name + "_allocations").c_str(), &values[2]);
+        }
+    }
+
+    // Execute the events in batches if requested, every module then runs all events of a batch in a single call
+    auto events_per_batch = global_config.get<unsigned int>("events_per_batch", 1u);
+    if(events_per_batch == 0) {
+        throw InvalidValueError(global_config, "events_per_batch", "number of events per batch should be larger than zero");
+    }
+    // The memory usage can only be stored per event if the events are executed one after the other
+    if(events_per_batch > 1 && memory_tree_ != nullptr) {
+        LOG(WARNING) << "Memory usage is stored per event, executing events separately instead of in batches";
+        events_per_batch = 1;
+    }
+    if(events_per_batch > 1) {
+        LOG(INFO) << "Executing events in batches of " << events_per_batch << " events";
+    }
+    for(auto& module : modules_) {
+        module->batched_ = (events_per_batch > 1);
+    }
+
     // Loop over all the events
     auto start_time = std::chrono::steady_clock::now();
     global_config.setDefault<unsigned int>("number_of_events", 1u);
     auto number_of_events = global_config.get<unsigned int>("number_of_events");
-    for(unsigned int i = 0; i < number_of_events; ++i) {
-        // Check for termination
+    if(checkpoint_interval_ > 0) {
+        LOG(INFO) << "Storing checkpoints every " << checkpoint_interval_ << " events in " << checkpoint_path_;
+    }
+    for(unsigned int i = first_event_; i < number_of_events; i += events_per_batch) {
+        // Check for termination, the state of a run interrupted by a signal is stored to resume it later
         if(terminate_) {
             LOG(INFO) << "Interrupting event loop after " << i << " events because of request to terminate";
+            if(checkpoint_interval_ > 0 && i > first_event_) {
+                write_checkpoint(i);
+            }
             number_of_events = i;
             global_config.set<unsigned int>("number_of_events", i);
             break;
         }
 
-        LOG_PROGRESS(STATUS, "EVENT_LOOP") << "Running event " << (i + 1) << " of " << number_of_events;
+        auto batch_events = std::min(events_per_batch, number_of_events - i);
+        if(events_per_batch > 1) {
+            LOG_PROGRESS(STATUS, "EVENT_LOOP")
+                << "Running events " << (i + 1) << " to " << (i + batch_events) << " of " << number_of_events;
+        } else {
+            LOG_PROGRESS(STATUS, "EVENT_LOOP") << "Running event " << (i + 1) << " of " << number_of_events;
+        }
 
-        // Get object count for linking objects in current event
+        // Get object count for linking objects in current event or batch
         auto save_id = TProcessID::GetObjectCount();
 
+        // Start the memory accounting of the event
+        for(auto& module_memory : module_memory_) {
+            module_memory.second->resetEvent();
+        }
+
         std::string module_name;
         if(!modules_.empty()) {
             module_name = modules_.front()->get_identifier().getName();
@@ -640,11 +941,11 @@ void ModuleManager::run() {
                 thread_pool->execute_all();
             }
 
-            auto execute_module = [module = module.get(), event_num = i + 1, this, number_of_events]() {
+            auto execute_module = [module = module.get(), event_num = i + 1, batch_events, this, number_of_events]() {
                 LOG_PROGRESS(TRACE, "EVENT_LOOP") << "Running event " << event_num << " of " << number_of_events << " ["
                                                   << module->get_identifier().getUniqueName() << "]";
-                // Check if module is satisfied to run
-                if(!module->check_delegates()) {
+                // Check if module is satisfied to run, batched modules check every event of the batch separately
+                if(!module->batched_ && !module->check_delegates()) {
                     LOG(TRACE) << "Not all required messages are received for " << module->get_identifier().getUniqueName()
                                << ", skipping module!";
                     return;
@@ -659,6 +960,10 @@ void ModuleManager::run() {
                 Log::setSection(section_name);
                 // Set module specific settings
                 auto old_settings = set_module_before(module->get_identifier().getUniqueName(), module->get_configuration());
+                // Attribute allocations to this module
+                auto old_counters = MemoryTracker::getCurrent();
+                MemoryTracker::setCurrent(get_memory_counters(module));
+                auto performance_start = read_performance_counters();
                 // Change to ROOT directory is not thread safe, only do this for module without parallelization support
                 if(!module->canParallelize()) {
                     // DEPRECATED: Switching to the directory should be removed, but can break current modules
@@ -666,12 +971,19 @@ void ModuleManager::run() {
                 }
                 // Run module
                 try {
-                    module->run(event_num);
+                    if(module->batched_) {
+                        module->runBatch(event_num, batch_events);
+                    } else {
+                        module->run(event_num);
+                    }
                 } catch(EndOfRunException& e) {
                     // Terminate if the module threw the EndOfRun request exception:
                     LOG(WARNING) << "Request to terminate:" << std::endl << e.what();
                     terminate_ = true;
                 }
+                // Reset memory accounting and account performance counters
+                add_performance_counters(module, performance_start);
+                MemoryTracker::setCurrent(old_counters);
                 // Reset logging
                 Log::setSection(old_section_name);
                 set_module_after(old_settings);
@@ -700,8 +1012,29 @@ void ModuleManager::run() {
             module->reset_delegates();
         }
 
-        // Reset object count for next event
+        // Store the memory usage of the event, messages have been released already
+        if(memory_tree_ != nullptr) {
+            for(auto& module_memory : module_memory_) {
+                auto& values = memory_tree_values_[module_memory.first];
+                values[0] = module_memory.second->getLiveBytes();
+                values[1] = module_memory.second->getEventPeakBytes();
+                values[2] = static_cast<Long64_t>(module_memory.second->getEventAllocations());
+            }
+            memory_tree_->Fill();
+        }
+
+        // Reset object count for next event or batch
         TProcessID::SetObjectCount(save_id);
+
+        // Store a checkpoint whenever a multiple of the interval is passed, the last event does not require one
+        auto events_done = i + batch_events;
+        if(checkpoint_interval_ > 0 && events_done < number_of_events && !terminate_ &&
+           events_done / checkpoint_interval_ > i / checkpoint_interval_) {
+            write_checkpoint(events_done);
+        }
+    }
+    for(auto& module : modules_) {
+        module->batched_ = false;
     }
     LOG_PROGRESS(STATUS, "EVENT_LOOP") << "Finished run of " << number_of_events << " events";
     auto end_time = std::chrono::steady_clock::now();
@@ -716,6 +1049,109 @@ void ModuleManager::run() {
     assert(thread_pool.use_count() == 0);
 }
 
+MemoryTracker::Counters* ModuleManager::get_memory_counters(Module* module) const {
+    auto counters = module_memory_.find(module);
+    return (counters == module_memory_.end() ? nullptr : counters->second);
+}
+
+PerformanceCounters::Values ModuleManager::read_performance_counters() const {
+    return (performance_counters_ ? PerformanceCounters::read() : PerformanceCounters::Values());
+}
+
+void ModuleManager::add_performance_counters(Module* module, const PerformanceCounters::Values& start) {
+    if(!performance_counters_) {
+        return;
+    }
+    auto difference = PerformanceCounters::read() - start;
+    std::lock_guard<std::mutex> lock{module_performance_mutex_};
+    module_performance_[module][std::this_thread::get_id()] += difference;
+}
+
+/**
+ * The checkpoint can only be resumed with the same seeds as the run that stored it, since the modules derive the seeds of
+ * their random number generators from them. The states of the modules are restored later, right before initializing them.
+ */
+void ModuleManager::read_checkpoint() {
+    Configuration& global_config = conf_manager_->getGlobalConfiguration();
+
+    Checkpoint checkpoint;
+    std::ifstream file(checkpoint_path_, std::ios::binary);
+    if(!file.good()) {
+        throw InvalidValueError(global_config, "resume", "cannot open checkpoint file " + checkpoint_path_);
+    }
+    try {
+        cereal::PortableBinaryInputArchive archive(file);
+        archive(checkpoint);
+    } catch(cereal::Exception& e) {
+        throw InvalidValueError(
+            global_config, "resume", "cannot read checkpoint file " + checkpoint_path_ + ": " + e.what());
+    }
+    if(checkpoint.version != checkpoint_version) {
+        throw InvalidValueError(global_config,
+                                "resume",
+                                "checkpoint file " + checkpoint_path_ + " has unsupported version " +
+                                    std::to_string(checkpoint.version));
+    }
+
+    // Seeds have to match, otherwise the modules would continue with different random number sequences
+    if(checkpoint.random_seed != global_config.get<uint64_t>("random_seed")) {
+        throw InvalidValueError(global_config,
+                                "random_seed",
+                                "seed differs from the seed " + std::to_string(checkpoint.random_seed) +
+                                    " of the run stored in the checkpoint");
+    }
+    if(checkpoint.random_seed_core != global_config.get<uint64_t>("random_seed_core")) {
+        throw InvalidValueError(global_config,
+                                "random_seed_core",
+                                "seed differs from the seed " + std::to_string(checkpoint.random_seed_core) +
+                                    " of the run stored in the checkpoint");
+    }
+    if(checkpoint.modules.size() != checkpoint.states.size()) {
+        throw InvalidValueError(global_config, "resume", "checkpoint file " + checkpoint_path_ + " is corrupted");
+    }
+
+    first_event_ = checkpoint.events;
+    for(size_t i = 0; i < checkpoint.modules.size(); ++i) {
+        resume_states_[checkpoint.modules[i]] = checkpoint.states[i];
+    }
+    LOG(STATUS) << "Resuming run from checkpoint after " << first_event_ << " events";
+}
+
+/**
+ * The checkpoint is written to a temporary file first and renamed afterwards, such that an interruption while writing it
+ * leaves the previous checkpoint intact.
+ */
+void ModuleManager::write_checkpoint(unsigned int events) {
+    Configuration& global_config = conf_manager_->getGlobalConfiguration();
+
+    Checkpoint checkpoint;
+    checkpoint.random_seed = global_config.get<uint64_t>("random_seed");
+    checkpoint.random_seed_core = global_config.get<uint64_t>("random_seed_core");
+    checkpoint.events = events;
+    for(auto& module : modules_) {
+        LOG(TRACE) << "Storing state of " << module->getUniqueName();
+        std::ostringstream state;
+        module->storeState(state);
+        checkpoint.modules.push_back(module->getUniqueName());
+        checkpoint.states.push_back(state.str());
+    }
+
+    auto tmp_path = checkpoint_path_ + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        cereal::PortableBinaryOutputArchive archive(file);
+        archive(checkpoint);
+        file.flush();
+        if(!file.good()) {
+            throw RuntimeError("Cannot write checkpoint file " + tmp_path);
+        }
+    }
+    if(std::rename(tmp_path.c_str(), checkpoint_path_.c_str()) != 0) {
+        throw RuntimeError("Cannot replace checkpoint file " + checkpoint_path_);
+    }
+    LOG(INFO) << "Stored checkpoint after " << events << " events";
+}
+
 static std::string seconds_to_time(long double seconds) {
     auto duration = std::chrono::duration<long long>(static_cast<long long>(std::round(seconds)));
 
@@ -757,10 +1193,17 @@ void ModuleManager::finalize() {
         Log::setSection(section_name);
         // Set module specific settings
         auto old_settings = set_module_before(module->get_identifier().getUniqueName(), module->get_configuration());
+        // Attribute allocations to this module
+        auto old_counters = MemoryTracker::getCurrent();
+        MemoryTracker::setCurrent(get_memory_counters(module.get()));
+        auto performance_start = read_performance_counters();
         // Change to our ROOT directory
         module->getROOTDirectory()->cd();
         // Finalize module
         module->finalize();
+        // Reset memory accounting and account performance counters
+        add_performance_counters(module.get(), performance_start);
+        MemoryTracker::setCurrent(old_counters);
         // Remove the pointer to the ROOT directory after finalizing
         module->set_ROOT_directory(nullptr);
         // Remove the config manager
@@ -772,6 +1215,13 @@ void ModuleManager::finalize() {
         auto end = std::chrono::steady_clock::now();
         module_execution_time_[module.get()] += static_cast<std::chrono::duration<long double>>(end - start).count();
     }
+    // Write the memory usage per event
+    if(memory_tree_ != nullptr) {
+        modules_file_->cd();
+        memory_tree_->Write();
+        LOG(INFO) << "Stored memory usage of module instantiations for " << memory_tree_->GetEntries() << " events";
+    }
+
     // Close module ROOT file
     modules_file_->Close();
     LOG_PROGRESS(STATUS, "FINALIZE_LOOP") << "Finalization completed";
@@ -793,14 +1243,48 @@ void ModuleManager::finalize() {
         LOG(INFO) << " Module " << module->getUniqueName() << " took " << module_execution_time_[module.get()] << " seconds";
     }
 
+    // Report the memory usage
+    LOG(STATUS) << "Peak resident memory of the process was "
+                << MemoryTracker::formatBytes(static_cast<int64_t>(MemoryTracker::getPeakResidentMemory()));
+    for(auto& module : modules_) {
+        auto* counters = get_memory_counters(module.get());
+        if(counters == nullptr) {
+            continue;
+        }
+        LOG(INFO) << " Module " << module->getUniqueName() << " made " << counters->getAllocations()
+                  << " allocations with a peak of " << MemoryTracker::formatBytes(counters->getPeakBytes()) << ", "
+                  << MemoryTracker::formatBytes(counters->getLiveBytes()) << " still allocated";
+    }
+
+    // Only the events after a resumed checkpoint have been processed by this run
     Configuration& global_config = conf_manager_->getGlobalConfiguration();
+    auto number_of_events = global_config.get<unsigned int>("number_of_events");
+    auto processed_events = number_of_events - std::min(first_event_, number_of_events);
+
+    // Report the hardware performance counters
+    if(performance_counters_) {
+        auto events = std::max(static_cast<double>(processed_events), 1.0);
+        LOG(STATUS) << "Hardware performance counters per instantiation:";
+        for(auto& module : modules_) {
+            PerformanceCounters::Values total;
+            for(auto& thread_values : module_performance_[module.get()]) {
+                total += thread_values.second;
+                LOG(DEBUG) << "  Thread " << thread_values.first << ": " << thread_values.second.cycles << " cycles, IPC "
+                           << thread_values.second.getIPC();
+            }
+            LOG(INFO) << " Module " << module->getUniqueName() << ": IPC " << std::setprecision(3) << total.getIPC() << ", "
+                      << std::round(static_cast<double>(total.cache_misses) / events) << " LLC misses/event, "
+                      << std::round(static_cast<double>(total.branch_misses) / events) << " branch misses/event";
+        }
+    }
+
     long double processing_time = 0;
-    if(global_config.get<unsigned int>("number_of_events") > 0) {
-        processing_time = std::round((1000 * total_time_) / global_config.get<unsigned int>("number_of_events"));
+    if(processed_events > 0) {
+        processing_time = std::round((1000 * total_time_) / processed_events);
     }
 
     LOG(STATUS) << "Average processing time is \x1B[1m" << processing_time << " ms/event\x1B[0m, event generation at \x1B[1m"
-                << std::round(global_config.get<double>("number_of_events") / total_time_) << " Hz\x1B[0m";
+                << std::round(processed_events / total_time_) << " Hz\x1B[0m";
 }
 
 /**
@@ -10,20 +10,27 @@
 #ifndef ALLPIX_MODULE_MANAGER_H
 #define ALLPIX_MODULE_MANAGER_H
 
+#include <array>
 #include <atomic>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <random>
+#include <string>
+#include <thread>
 
 #include <TDirectory.h>
 #include <TFile.h>
+#include <TTree.h>
 
 #include "Module.hpp"
 #include "ThreadPool.hpp"
 #include "core/config/Configuration.hpp"
 #include "core/utils/log.h"
+#include "core/utils/memory.h"
+#include "core/utils/perf.h"
 
 namespace allpix {
 
@@ -127,6 +134,27 @@ namespace allpix {
         std::vector<std::pair<ModuleIdentifier, Module*>>
         create_detector_modules(void*, Configuration&, Messenger*, GeometryManager*, std::mt19937_64& seeder);
 
+        /**
+         * @brief Create multi-detector modules
+         * @param library Void pointer to the loaded library
+         * @param config Configuration of the module
+         * @param messenger Pointer to the messenger
+         * @param geo_manager Pointer to the geometry manager
+         * @param seeder Seeder used to construct the PRNG of the modules
+         * @return A single module handling all selected detectors together with its identifier
+         */
+        std::pair<ModuleIdentifier, Module*>
+        create_multi_detector_modules(void*, Configuration&, Messenger*, GeometryManager*, std::mt19937_64& seeder);
+
+        /**
+         * @brief Select the detectors a module section applies to
+         * @param config Configuration of the module
+         * @param geo_manager Pointer to the geometry manager
+         * @return List of selected detectors together with the priority of their selection
+         */
+        static std::vector<std::pair<std::shared_ptr<Detector>, int>> select_detectors(Configuration& config,
+                                                                                        GeometryManager* geo_manager);
+
         /**
          * @brief Set module specific log setting before running init/run/finalize
          */
@@ -136,6 +164,39 @@ namespace allpix {
          */
         void set_module_after(std::tuple<LogLevel, LogFormat> prev);
 
+        /**
+         * @brief Get the memory counters of a module instantiation
+         * @param module Module instantiation
+         * @return Pointer to the counters or a null pointer if memory tracking is disabled
+         */
+        MemoryTracker::Counters* get_memory_counters(Module* module) const;
+
+        /**
+         * @brief Read the hardware performance counters of the calling thread if enabled
+         * @return Current counter values, zero if performance counters are disabled
+         */
+        PerformanceCounters::Values read_performance_counters() const;
+
+        /**
+         * @brief Account the hardware performance counters since an earlier reading to a module and the calling thread
+         * @param module Module instantiation to account the counters to
+         * @param start Reading of the counters before executing the module
+         */
+        void add_performance_counters(Module* module, const PerformanceCounters::Values& start);
+
+        /**
+         * @brief Read the checkpoint of an earlier run to resume the event sequence from
+         * @throws InvalidValueError If the checkpoint cannot be read or does not belong to a run with the same seeds
+         */
+        void read_checkpoint();
+
+        /**
+         * @brief Store the state of all modules in the checkpoint file
+         * @param events Number of events finished so far
+         * @throws RuntimeError If the checkpoint file cannot be written
+         */
+        void write_checkpoint(unsigned int events);
+
         using ModuleList = std::list<std::unique_ptr<Module>>;
         using IdentifierToModuleMap = std::map<ModuleIdentifier, ModuleList::iterator>;
 
@@ -143,12 +204,35 @@ namespace allpix {
         IdentifierToModuleMap id_to_module_;
 
         ConfigManager* conf_manager_;
+        GeometryManager* geo_manager_{};
 
         std::unique_ptr<TFile> modules_file_;
 
         std::map<Module*, long double> module_execution_time_;
         long double total_time_{};
 
+        // Memory accounting per module instantiation and optional tree with the usage per event
+        bool memory_tracking_{};
+        std::map<Module*, MemoryTracker::Counters*> module_memory_;
+        TTree* memory_tree_{};
+        std::map<Module*, std::array<Long64_t, 3>> memory_tree_values_;
+
+        // Hardware performance counters per module instantiation and thread
+        bool performance_counters_{};
+        std::map<Module*, std::map<std::thread::id, PerformanceCounters::Values>> module_performance_;
+        std::mutex module_performance_mutex_;
+
+        // Checkpoints of the run state and the state of all modules to resume from
+        unsigned int checkpoint_interval_{};
+        std::string checkpoint_path_;
+        bool resume_{};
+        unsigned int first_event_{};
+        std::map<std::string, std::string> resume_states_;
+
+        // Replication of the field grids and the tables derived from them on all NUMA nodes
+        bool replicate_fields_{};
+        bool huge_pages_{};
+
         std::map<std::string, void*> loaded_libraries_;
 
         std::atomic<bool> terminate_;
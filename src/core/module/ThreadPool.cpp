@@ -11,6 +11,8 @@
 #include "ThreadPool.hpp"
 
 #include "Module.hpp"
+#include "core/utils/log.h"
+#include "core/utils/numa.h"
 
 using namespace allpix;
 
@@ -19,11 +21,13 @@ using namespace allpix;
  */
 ThreadPool::ThreadPool(unsigned int num_threads,
                        const std::vector<Module*>& modules,
-                       const std::function<void()>& worker_init_function) {
+                       const std::function<void()>& worker_init_function,
+                       Affinity affinity)
+    : affinity_(affinity) {
     // Create threads
     try {
         for(unsigned int i = 0u; i < num_threads; ++i) {
-            threads_.emplace_back(&ThreadPool::worker, this, worker_init_function);
+            threads_.emplace_back(&ThreadPool::worker, this, worker_init_function, i);
         }
     } catch(...) {
         destroy();
@@ -119,9 +123,10 @@ bool ThreadPool::execute_all() {
 /**
  * If an exception is thrown by a module, the first exception is saved to propagate in the main thread
  */
-void ThreadPool::worker(const std::function<void()>& init_function) {
+void ThreadPool::worker(const std::function<void()>& init_function, unsigned int index) {
     // Initialize the worker
     init_function();
+    pin_worker(index);
 
     // Safe lambda to increase the atomic run count
     auto increase_run_cnt_func = [this]() { ++run_cnt_; };
@@ -157,6 +162,36 @@ void ThreadPool::worker(const std::function<void()>& init_function) {
     }
 }
 
+/**
+ * The main thread is not pinned and keeps the first NUMA node assigned. The workers are therefore placed starting from the
+ * second CPU or node, such that the load is balanced over the system including the main thread.
+ */
+void ThreadPool::pin_worker(unsigned int index) const {
+    if(affinity_ == Affinity::NONE) {
+        return;
+    }
+
+    const auto& topology = NumaTopology::get();
+    std::vector<unsigned int> cpus;
+    size_t node = 0;
+    if(affinity_ == Affinity::CORE) {
+        auto all_cpus = topology.getAllCPUs();
+        auto cpu = all_cpus[(index + 1) % all_cpus.size()];
+        node = topology.getNodeOfCPU(cpu);
+        cpus.push_back(cpu);
+    } else {
+        node = (index + 1) % topology.getNodeCount();
+        cpus = topology.getCPUs(node);
+    }
+
+    if(NumaTopology::pinThread(cpus)) {
+        NumaTopology::setCurrentNode(node);
+        LOG(TRACE) << "Pinned worker " << index << " to NUMA node " << node;
+    } else {
+        LOG(WARNING) << "Could not pin worker " << index << " to NUMA node " << node;
+    }
+}
+
 void ThreadPool::destroy() {
     done_ = true;
 
@@ -27,6 +27,8 @@
 
 #include <iostream>
 
+#include "core/utils/memory.h"
+
 namespace allpix {
     class Module;
 
@@ -91,16 +93,27 @@ namespace allpix {
             std::condition_variable condition_;
         };
 
+        /**
+         * @brief Placement of the worker threads on the CPUs of the system
+         */
+        enum class Affinity {
+            NONE = 0, ///< Workers are not pinned and may be moved by the scheduler
+            CORE,     ///< Every worker is pinned to a single CPU, filling one NUMA node after the other
+            NUMA,     ///< Workers are distributed round-robin over the NUMA nodes and pinned to all CPUs of their node
+        };
+
         /**
          * @brief Construct thread pool with provided number of threads
          * @param num_threads Number of threads in the pool
          * @param modules List of module instantiations to create a task queue for
          * @param worker_init_function Function run by all the workers to initialize
+         * @param affinity Placement of the worker threads, defaults to no pinning
          * @warning Only module instantiations that are registered in this constructor can spawn tasks
          */
         explicit ThreadPool(unsigned int num_threads,
                             const std::vector<Module*>& modules,
-                            const std::function<void()>& worker_init_function);
+                            const std::function<void()>& worker_init_function,
+                            Affinity affinity = Affinity::NONE);
 
         /// @{
         /**
@@ -150,8 +163,15 @@ namespace allpix {
         /**
          * @brief Constantly running internal function each thread uses to acquire work items from the queue.
          * @param init_function Function to initialize the relevant thread_local variables
+         * @param index Index of the worker, used to determine its placement
+         */
+        void worker(const std::function<void()>& init_function, unsigned int index);
+
+        /**
+         * @brief Pin the calling worker thread according to the configured affinity and assign its NUMA node
+         * @param index Index of the worker
          */
-        void worker(const std::function<void()>& init_function);
+        void pin_worker(unsigned int index) const;
 
         /**
          * @brief Invalidate all queues and joins all running threads when the pool is destroyed.
@@ -161,6 +181,7 @@ namespace allpix {
         using Task = std::unique_ptr<std::packaged_task<void()>>;
 
         std::atomic_bool done_{false};
+        Affinity affinity_{Affinity::NONE};
 
         SafeQueue<SafeQueue<Task>*> all_queue_;
         SafeQueue<Task> module_queue_;
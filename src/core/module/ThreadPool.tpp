@@ -17,9 +17,14 @@ namespace allpix {
         using PackagedTask = std::packaged_task<decltype(bound_task())()>;
         PackagedTask task(bound_task);
 
-        // Get future and wrapper to add to vector
+        // Get future and wrapper to add to vector, attributing allocations of the task to the submitting module
         auto future = task.get_future();
-        auto task_function = [task = std::move(task)]() mutable { task(); };
+        auto task_function = [task = std::move(task), counters = MemoryTracker::getCurrent()]() mutable {
+            auto previous_counters = MemoryTracker::getCurrent();
+            MemoryTracker::setCurrent(counters);
+            task();
+            MemoryTracker::setCurrent(previous_counters);
+        };
         task_queues_.at(module).push(std::make_unique<std::packaged_task<void()>>(std::move(task_function)));
         all_queue_.push(&task_queues_.at(module));
         return future;
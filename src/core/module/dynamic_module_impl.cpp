@@ -6,6 +6,7 @@
  * - ALLPIX_MODULE_NAME: name of the module
  * - ALLPIX_MODULE_HEADER: name of the header defining the module
  * - ALLPIX_MODULE_UNIQUE: true if the module is unique, false otherwise
+ * - ALLPIX_MODULE_MULTI_DETECTOR: true if the detector module handles all its detectors in one instantiation (optional)
  *
  * @copyright Copyright (c) 2017-2020 CERN and the Allpix Squared authors.
  * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
@@ -19,6 +20,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "core/config/Configuration.hpp"
 #include "core/geometry/Detector.hpp"
@@ -26,6 +28,10 @@
 
 #include ALLPIX_MODULE_HEADER
 
+#ifndef ALLPIX_MODULE_MULTI_DETECTOR
+#define ALLPIX_MODULE_MULTI_DETECTOR 0
+#endif
+
 namespace allpix {
     class Messenger;
     class GeometryManager;
@@ -59,7 +65,7 @@ namespace allpix {
     bool allpix_module_is_unique() { return true; }
 #endif
 
-#if !ALLPIX_MODULE_UNIQUE || defined(DOXYGEN)
+#if(!ALLPIX_MODULE_UNIQUE && !ALLPIX_MODULE_MULTI_DETECTOR) || defined(DOXYGEN)
     /**
      * @brief Instantiates a detector module
      * @param config Configuration for this module
@@ -80,5 +86,39 @@ namespace allpix {
     // Returns that is a detector module
     bool allpix_module_is_unique() { return false; }
 #endif
+
+#if(!ALLPIX_MODULE_UNIQUE && ALLPIX_MODULE_MULTI_DETECTOR) || defined(DOXYGEN)
+    /**
+     * @brief Instantiates a multi-detector module
+     * @param config Configuration for this module
+     * @param messenger Pointer to the Messenger (guaranteed to be valid until the module is destructed)
+     * @param detectors List of all Detector objects this module is handling
+     * @return Instantiation of the module
+     *
+     * Internal method for the dynamic loading in the ModuleManager. Forwards the supplied arguments to the constructor and
+     * returns an instantiation
+     */
+    Module* allpix_module_generator(Configuration& config,
+                                    Messenger* messenger,
+                                    std::vector<std::shared_ptr<Detector>> detectors);
+    Module* allpix_module_generator(Configuration& config,
+                                    Messenger* messenger,
+                                    std::vector<std::shared_ptr<Detector>> detectors) { // NOLINT
+        auto module = new ALLPIX_MODULE_NAME(config, messenger, std::move(detectors));  // NOLINT
+        return static_cast<Module*>(module);
+    }
+
+    // Returns that is a detector module
+    bool allpix_module_is_unique() { return false; }
+#endif
+
+    /**
+     * @brief Returns if the detector module handles all its detectors in a single instantiation
+     *
+     * Used by the ModuleManager to determine if it should instantiate a single multi-detector module instead of one module
+     * per detector.
+     */
+    bool allpix_module_is_multi_detector();
+    bool allpix_module_is_multi_detector() { return ALLPIX_MODULE_MULTI_DETECTOR != 0; }
     }
 } // namespace allpix
@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief Implementation of memory accounting utilities
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "memory.h"
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include <sys/resource.h>
+
+using namespace allpix;
+
+std::atomic<bool> MemoryTracker::available_{false};
+thread_local MemoryTracker::Counters* MemoryTracker::current_ = nullptr;
+
+namespace {
+    /**
+     * @brief Raise an atomic maximum to the given value
+     * @param maximum Atomic maximum to update
+     * @param value Value to compare with
+     */
+    void update_maximum(std::atomic<int64_t>& maximum, int64_t value) {
+        auto previous = maximum.load(std::memory_order_relaxed);
+        while(previous < value && !maximum.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {
+        }
+    }
+} // namespace
+
+void MemoryTracker::Counters::allocate(size_t size) {
+    auto live = live_.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+    update_maximum(peak_, live);
+    update_maximum(event_peak_, live);
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    event_allocations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryTracker::Counters::deallocate(size_t size) {
+    live_.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+}
+
+/**
+ * The peak of the event starts from the memory still held from previous events
+ */
+void MemoryTracker::Counters::resetEvent() {
+    event_peak_ = live_.load();
+    event_allocations_ = 0;
+}
+
+MemoryTracker::Counters* MemoryTracker::createCounters() {
+    return new Counters(); // NOLINT
+}
+
+uint64_t MemoryTracker::getPeakResidentMemory() {
+    struct rusage usage {};
+    if(getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    // Reported in bytes on macOS
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    // Reported in kilobytes on Linux
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+std::string MemoryTracker::formatBytes(int64_t bytes) {
+    const char* units[] = {"B", "kiB", "MiB", "GiB", "TiB"};
+    auto value = static_cast<double>(bytes);
+    size_t unit = 0;
+    while(std::fabs(value) >= 1024. && unit < 4) {
+        value /= 1024.;
+        unit++;
+    }
+
+    std::stringstream stream;
+    stream << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << value << units[unit];
+    return stream.str();
+}
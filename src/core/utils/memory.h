@@ -0,0 +1,165 @@
+/**
+ * @file
+ * @brief Utilities for accounting memory allocations to module instantiations
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ *
+ * The accounting relies on replacements of the global allocation functions, which are only compiled into the executable if
+ * the framework is built with the ALLPIX_MEMORY_TRACKING option.
+ */
+
+#ifndef ALLPIX_MEMORY_H
+#define ALLPIX_MEMORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace allpix {
+    /**
+     * @brief Accounting of allocations made through the global allocation functions
+     *
+     * Every allocation is attributed to the counters assigned to the allocating thread and released from the same counters
+     * when it is freed, independent of the thread freeing it. The module manager assigns the counters of a module
+     * instantiation to the thread while running it, in the same places where the log section of the module is set.
+     */
+    class MemoryTracker {
+    public:
+        /**
+         * @brief Allocation counters of a single module instantiation
+         */
+        class Counters {
+        public:
+            /**
+             * @brief Account an allocation
+             * @param size Number of bytes allocated
+             */
+            void allocate(size_t size);
+
+            /**
+             * @brief Account a deallocation
+             * @param size Number of bytes freed
+             */
+            void deallocate(size_t size);
+
+            /**
+             * @brief Reset the peak and allocation count of the current event
+             */
+            void resetEvent();
+
+            /**
+             * @brief Get the number of bytes currently allocated and not yet freed
+             * @return Live bytes
+             */
+            int64_t getLiveBytes() const { return live_; }
+
+            /**
+             * @brief Get the maximum number of live bytes during the run
+             * @return Peak bytes
+             */
+            int64_t getPeakBytes() const { return peak_; }
+
+            /**
+             * @brief Get the maximum number of live bytes since the last call to \ref resetEvent
+             * @return Peak bytes of the current event
+             */
+            int64_t getEventPeakBytes() const { return event_peak_; }
+
+            /**
+             * @brief Get the total number of allocations during the run
+             * @return Number of allocations
+             */
+            uint64_t getAllocations() const { return allocations_; }
+
+            /**
+             * @brief Get the number of allocations since the last call to \ref resetEvent
+             * @return Number of allocations of the current event
+             */
+            uint64_t getEventAllocations() const { return event_allocations_; }
+
+        private:
+            std::atomic<int64_t> live_{0};
+            std::atomic<int64_t> peak_{0};
+            std::atomic<int64_t> event_peak_{0};
+            std::atomic<uint64_t> allocations_{0};
+            std::atomic<uint64_t> event_allocations_{0};
+        };
+
+        /**
+         * @brief Create a new set of counters
+         * @return Pointer to the counters
+         * @note The counters are never destroyed, as allocations attributed to them may be freed at any time until the
+         *       process exits
+         */
+        static Counters* createCounters();
+
+        /**
+         * @brief Check if the allocation functions of the executable report to the tracker
+         * @return True if allocations are accounted, false otherwise
+         */
+        static bool isAvailable() { return available_; }
+
+        /**
+         * @brief Register that the allocation functions of the executable report to the tracker
+         */
+        static void setAvailable() { available_ = true; }
+
+        /**
+         * @brief Get the counters assigned to the calling thread
+         * @return Pointer to the counters or a null pointer if allocations of the thread are not accounted
+         */
+        static Counters* getCurrent() { return current_; }
+
+        /**
+         * @brief Assign counters to the calling thread
+         * @param counters Pointer to the counters or a null pointer to stop accounting allocations of the thread
+         */
+        static void setCurrent(Counters* counters) { current_ = counters; }
+
+        /**
+         * @brief Account an allocation of the calling thread, called by the global allocation functions
+         * @param size Number of bytes allocated
+         * @return Counters the allocation has been attributed to, to be passed to \ref deallocate when it is freed
+         */
+        static Counters* allocate(size_t size) {
+            auto* counters = current_;
+            if(counters != nullptr) {
+                counters->allocate(size);
+            }
+            return counters;
+        }
+
+        /**
+         * @brief Account a deallocation, called by the global deallocation functions
+         * @param counters Counters the allocation has been attributed to
+         * @param size Number of bytes freed
+         */
+        static void deallocate(Counters* counters, size_t size) {
+            if(counters != nullptr) {
+                counters->deallocate(size);
+            }
+        }
+
+        /**
+         * @brief Get the peak resident set size of the process
+         * @return Peak resident memory in bytes, zero if it cannot be determined
+         */
+        static uint64_t getPeakResidentMemory();
+
+        /**
+         * @brief Convert a number of bytes to a human readable string
+         * @param bytes Number of bytes
+         * @return String with the size in the most appropriate binary unit
+         */
+        static std::string formatBytes(int64_t bytes);
+
+    private:
+        static std::atomic<bool> available_;
+        static thread_local Counters* current_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MEMORY_H */
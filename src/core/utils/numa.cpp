@@ -0,0 +1,215 @@
+/**
+ * @file
+ * @brief Implementation of NUMA utilities
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "numa.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace allpix;
+
+thread_local size_t NumaTopology::current_node_ = 0;
+
+namespace {
+    /**
+     * @brief Parse a list in the sysfs list format, e.g. "0-3,8,10-11"
+     * @param list String representation of the list
+     * @return Expanded list of indices
+     */
+    std::vector<unsigned int> parse_list(const std::string& list) {
+        std::vector<unsigned int> indices;
+        std::stringstream stream(list);
+        std::string range;
+        while(std::getline(stream, range, ',')) {
+            auto dash = range.find('-');
+            try {
+                auto first = static_cast<unsigned int>(std::stoul(range.substr(0, dash)));
+                auto last = first;
+                if(dash != std::string::npos) {
+                    last = static_cast<unsigned int>(std::stoul(range.substr(dash + 1)));
+                }
+                for(auto index = first; index <= last; ++index) {
+                    indices.push_back(index);
+                }
+            } catch(std::logic_error&) {
+                // Ignore malformed entries such as trailing newlines
+                continue;
+            }
+        }
+        return indices;
+    }
+
+    /**
+     * @brief Read the first line of a file
+     * @param path Path to the file
+     * @return First line, empty if the file cannot be read
+     */
+    std::string read_line(const std::string& path) {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+} // namespace
+
+const NumaTopology& NumaTopology::get() {
+    static NumaTopology topology;
+    return topology;
+}
+
+/**
+ * Only CPUs the process is allowed to run on are taken into account, such that restrictions by e.g. batch systems are
+ * respected. Nodes without any available CPU are omitted.
+ */
+NumaTopology::NumaTopology() {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool has_mask = (sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+
+    for(auto node : parse_list(read_line("/sys/devices/system/node/online"))) {
+        auto cpus = parse_list(read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+        cpus.erase(std::remove_if(cpus.begin(),
+                                  cpus.end(),
+                                  [&](unsigned int cpu) {
+                                      return has_mask && (cpu >= CPU_SETSIZE || CPU_ISSET(cpu, &allowed) == 0);
+                                  }),
+                   cpus.end());
+        if(!cpus.empty()) {
+            node_cpus_.push_back(std::move(cpus));
+            node_ids_.push_back(node);
+        }
+    }
+#endif
+
+    // Fall back to a single node with all hardware threads
+    if(node_cpus_.empty()) {
+        std::vector<unsigned int> cpus(std::max(std::thread::hardware_concurrency(), 1u));
+        for(size_t i = 0; i < cpus.size(); ++i) {
+            cpus[i] = static_cast<unsigned int>(i);
+        }
+        node_cpus_.push_back(std::move(cpus));
+    }
+}
+
+size_t NumaTopology::getNodeOfCPU(unsigned int cpu) const {
+    for(size_t node = 0; node < node_cpus_.size(); ++node) {
+        if(std::find(node_cpus_[node].begin(), node_cpus_[node].end(), cpu) != node_cpus_[node].end()) {
+            return node;
+        }
+    }
+    return 0;
+}
+
+/**
+ * The node holding the page is queried from the kernel without moving it. If the page has not been touched yet or the query
+ * is not supported, the node of the CPU the calling thread runs on is assumed.
+ */
+size_t NumaTopology::getNodeOfMemory(const void* address) const {
+#if defined(__linux__) && defined(SYS_move_pages)
+    auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    void* page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(address) / page_size * page_size); // NOLINT
+    int status = -1;
+    if(syscall(SYS_move_pages, 0, 1, &page, nullptr, &status, 0) == 0 && status >= 0) {
+        auto id = std::find(node_ids_.begin(), node_ids_.end(), static_cast<unsigned int>(status));
+        if(id != node_ids_.end()) {
+            return static_cast<size_t>(id - node_ids_.begin());
+        }
+    }
+    auto cpu = sched_getcpu();
+    return (cpu < 0 ? 0 : getNodeOfCPU(static_cast<unsigned int>(cpu)));
+#else
+    (void)address;
+    return 0;
+#endif
+}
+
+std::vector<unsigned int> NumaTopology::getAllCPUs() const {
+    std::vector<unsigned int> cpus;
+    for(auto& node : node_cpus_) {
+        cpus.insert(cpus.end(), node.begin(), node.end());
+    }
+    return cpus;
+}
+
+bool NumaTopology::pinThread(const std::vector<unsigned int>& cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(auto cpu : cpus) {
+        if(cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return CPU_COUNT(&set) > 0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+std::shared_ptr<std::vector<double>>
+NumaTopology::replicate(const std::vector<double>& data, size_t node, bool huge_pages) const {
+    auto replica = std::make_shared<std::vector<double>>();
+    std::exception_ptr exception;
+    auto copy = [&]() {
+        try {
+            pinThread(getCPUs(node));
+            replica->reserve(data.size());
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+            // Advise huge pages for the page-aligned part of the buffer before it is touched for the first time
+            if(huge_pages) {
+                auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+                auto begin = (reinterpret_cast<uintptr_t>(replica->data()) + page_size - 1) / page_size * page_size;
+                auto end = reinterpret_cast<uintptr_t>(replica->data() + data.size()) / page_size * page_size;
+                if(end > begin) {
+                    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE); // NOLINT
+                }
+            }
+#else
+            (void)huge_pages;
+#endif
+            replica->assign(data.begin(), data.end());
+        } catch(...) {
+            exception = std::current_exception();
+        }
+    };
+
+    // Perform the first touch from a separate thread to not alter the affinity of the calling thread
+    std::thread thread(copy);
+    thread.join();
+    if(exception) {
+        std::rethrow_exception(exception);
+    }
+    return replica;
+}
+
+std::vector<std::shared_ptr<std::vector<double>>>
+NumaTopology::replicate(const std::shared_ptr<std::vector<double>>& data, bool huge_pages) const {
+    std::vector<std::shared_ptr<std::vector<double>>> replicas;
+    auto home = (data->empty() ? 0 : getNodeOfMemory(data->data()));
+    for(size_t node = 0; node < getNodeCount(); ++node) {
+        replicas.push_back(node == home ? data : replicate(*data, node, huge_pages));
+    }
+    return replicas;
+}
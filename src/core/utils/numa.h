@@ -0,0 +1,120 @@
+/**
+ * @file
+ * @brief Utilities for NUMA-aware thread placement and memory allocation
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ *
+ * The topology is read from the Linux sysfs, no additional library is required. On other systems a single node holding all
+ * hardware threads is assumed and pinning of threads is not supported.
+ */
+
+#ifndef ALLPIX_NUMA_H
+#define ALLPIX_NUMA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace allpix {
+    /**
+     * @brief Description of the NUMA nodes of the system and helpers to place threads and memory on them
+     */
+    class NumaTopology {
+    public:
+        /**
+         * @brief Get the topology of the system, detected on first access
+         * @return Reference to the topology
+         */
+        static const NumaTopology& get();
+
+        /**
+         * @brief Get the number of NUMA nodes with at least one available CPU
+         * @return Number of nodes
+         */
+        size_t getNodeCount() const { return node_cpus_.size(); }
+
+        /**
+         * @brief Get the CPUs of a NUMA node
+         * @param node Index of the node
+         * @return List of CPU indices belonging to the node
+         */
+        const std::vector<unsigned int>& getCPUs(size_t node) const { return node_cpus_.at(node); }
+
+        /**
+         * @brief Get the NUMA node a CPU belongs to
+         * @param cpu Index of the CPU
+         * @return Index of the node, zero for unknown CPUs
+         */
+        size_t getNodeOfCPU(unsigned int cpu) const;
+
+        /**
+         * @brief Get all CPUs ordered by node
+         * @return List of CPU indices of all nodes
+         */
+        std::vector<unsigned int> getAllCPUs() const;
+
+        /**
+         * @brief Pin the calling thread to a set of CPUs
+         * @param cpus List of CPU indices the thread is allowed to run on
+         * @return True if the affinity was set, false if pinning is not supported or failed
+         */
+        static bool pinThread(const std::vector<unsigned int>& cpus);
+
+        /**
+         * @brief Get the NUMA node assigned to the calling thread
+         * @return Index of the node, zero if no node has been assigned
+         */
+        static size_t getCurrentNode() { return current_node_; }
+
+        /**
+         * @brief Assign a NUMA node to the calling thread, used to select local replicas of shared data
+         * @param node Index of the node
+         */
+        static void setCurrentNode(size_t node) { current_node_ = node; }
+
+        /**
+         * @brief Copy data into memory local to a NUMA node
+         * @param data Data to copy
+         * @param node Index of the node the copy should be placed on
+         * @param huge_pages Request transparent huge pages for the copy if supported
+         * @return Copy of the data
+         *
+         * The copy is allocated and first touched by a thread pinned to the node, such that the default first-touch policy
+         * of the kernel places its pages in the local memory of the node.
+         */
+        std::shared_ptr<std::vector<double>> replicate(const std::vector<double>& data, size_t node, bool huge_pages) const;
+
+        /**
+         * @brief Place data in the local memory of every NUMA node
+         * @param data Data to distribute
+         * @param huge_pages Request transparent huge pages for the copies if supported
+         * @return Data local to every node, indexed by node
+         *
+         * The data itself is used for the node its memory is located on, copies are only created for all other nodes.
+         */
+        std::vector<std::shared_ptr<std::vector<double>>> replicate(const std::shared_ptr<std::vector<double>>& data,
+                                                                    bool huge_pages) const;
+
+        /**
+         * @brief Get the NUMA node the memory at an address is located on
+         * @param address Address within the memory to locate
+         * @return Index of the node, zero if the node cannot be determined
+         */
+        size_t getNodeOfMemory(const void* address) const;
+
+    private:
+        /**
+         * @brief Detect the topology of the system
+         */
+        NumaTopology();
+
+        std::vector<std::vector<unsigned int>> node_cpus_;
+        std::vector<unsigned int> node_ids_;
+
+        static thread_local size_t current_node_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_NUMA_H */
@@ -0,0 +1,151 @@
+/**
+ * @file
+ * @brief Implementation of hardware performance counter utilities
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "perf.h"
+
+#include <array>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace allpix;
+
+namespace {
+    /**
+     * @brief Group of counters opened for a single thread, closed when the thread exits
+     */
+    class CounterGroup {
+    public:
+        CounterGroup() { open(); }
+        ~CounterGroup() {
+#ifdef __linux__
+            for(auto fd : fds_) {
+                if(fd >= 0) {
+                    close(fd);
+                }
+            }
+#endif
+        }
+        CounterGroup(const CounterGroup&) = delete;
+        CounterGroup& operator=(const CounterGroup&) = delete;
+
+        bool isValid() const { return fds_[0] >= 0; }
+
+        PerformanceCounters::Values read() const {
+            PerformanceCounters::Values values;
+#ifdef __linux__
+            if(!isValid()) {
+                return values;
+            }
+
+            // Group read format: number of counters, time enabled, time running and the values in order of opening
+            std::array<uint64_t, 3 + 4> buffer{};
+            if(::read(fds_[0], buffer.data(), sizeof(buffer)) <= 0 || buffer[2] == 0) {
+                return values;
+            }
+
+            // Scale to the full time if the counters had to share the hardware with other groups
+            auto scale = static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]);
+            std::array<uint64_t, 4> counts{};
+            size_t position = 3;
+            for(size_t i = 0; i < counts.size(); ++i) {
+                if(fds_[i] >= 0 && position < 3 + buffer[0]) {
+                    counts[i] = static_cast<uint64_t>(static_cast<double>(buffer[position++]) * scale);
+                }
+            }
+            values.cycles = counts[0];
+            values.instructions = counts[1];
+            values.cache_misses = counts[2];
+            values.branch_misses = counts[3];
+#endif
+            return values;
+        }
+
+    private:
+        void open() {
+            fds_.fill(-1);
+#ifdef __linux__
+            const std::array<uint64_t, 4> configs{{PERF_COUNT_HW_CPU_CYCLES,
+                                                   PERF_COUNT_HW_INSTRUCTIONS,
+                                                   PERF_COUNT_HW_CACHE_MISSES,
+                                                   PERF_COUNT_HW_BRANCH_MISSES}};
+            for(size_t i = 0; i < configs.size(); ++i) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.size = sizeof(attr);
+                attr.config = configs[i];
+                attr.disabled = (i == 0 ? 1 : 0);
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                // Count the calling thread on any CPU, all counters are attached to the group of the first one
+                auto fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, fds_[0], 0));
+                if(i == 0 && fd < 0) {
+                    // Without the cycle counter as group leader no counters are available
+                    return;
+                }
+                fds_[i] = fd;
+            }
+            ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);   // NOLINT
+            ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);  // NOLINT
+#endif
+        }
+
+        std::array<int, 4> fds_{};
+    };
+
+    /**
+     * @brief Get the counter group of the calling thread, opening it on first access
+     * @return Reference to the counter group
+     */
+    const CounterGroup& thread_group() {
+        static thread_local CounterGroup group;
+        return group;
+    }
+} // namespace
+
+PerformanceCounters::Values& PerformanceCounters::Values::operator+=(const Values& other) {
+    cycles += other.cycles;
+    instructions += other.instructions;
+    cache_misses += other.cache_misses;
+    branch_misses += other.branch_misses;
+    return *this;
+}
+
+/**
+ * Differences are clamped at zero, as the scaling of multiplexed counters is only an estimate
+ */
+PerformanceCounters::Values PerformanceCounters::Values::operator-(const Values& other) const {
+    auto difference = [](uint64_t lhs, uint64_t rhs) { return (lhs > rhs ? lhs - rhs : 0); };
+    Values values;
+    values.cycles = difference(cycles, other.cycles);
+    values.instructions = difference(instructions, other.instructions);
+    values.cache_misses = difference(cache_misses, other.cache_misses);
+    values.branch_misses = difference(branch_misses, other.branch_misses);
+    return values;
+}
+
+double PerformanceCounters::Values::getIPC() const {
+    return (cycles == 0 ? 0. : static_cast<double>(instructions) / static_cast<double>(cycles));
+}
+
+bool PerformanceCounters::isAvailable() {
+    return thread_group().isValid();
+}
+
+PerformanceCounters::Values PerformanceCounters::read() {
+    return thread_group().read();
+}
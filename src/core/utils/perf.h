@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @brief Utilities for reading hardware performance counters of the calling thread
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ *
+ * The counters are read through the Linux perf_event interface. On other systems, or if access to the counters is not
+ * permitted, no counters are available and all readings are zero.
+ */
+
+#ifndef ALLPIX_PERF_H
+#define ALLPIX_PERF_H
+
+#include <cstdint>
+
+namespace allpix {
+    /**
+     * @brief Hardware performance counters of the calling thread
+     *
+     * Every thread opens its own group of counters on the first reading, which only counts events in user space of this
+     * thread. Differences of readings taken before and after a section of code give the events caused by this section.
+     */
+    class PerformanceCounters {
+    public:
+        /**
+         * @brief Values of all counters
+         */
+        struct Values {
+            uint64_t cycles{};        ///< CPU cycles
+            uint64_t instructions{};  ///< Retired instructions
+            uint64_t cache_misses{};  ///< Last level cache misses
+            uint64_t branch_misses{}; ///< Mispredicted branches
+
+            /**
+             * @brief Add the values of other readings
+             * @param other Values to add
+             * @return Reference to the sum
+             */
+            Values& operator+=(const Values& other);
+
+            /**
+             * @brief Calculate the difference to an earlier reading
+             * @param other Earlier reading
+             * @return Values counted in between the readings
+             */
+            Values operator-(const Values& other) const;
+
+            /**
+             * @brief Calculate the number of instructions per cycle
+             * @return Instructions per cycle, zero if no cycles have been counted
+             */
+            double getIPC() const;
+        };
+
+        /**
+         * @brief Check if the counters can be opened for the calling thread
+         * @return True if counters are available, false otherwise
+         */
+        static bool isAvailable();
+
+        /**
+         * @brief Read the counters of the calling thread
+         * @return Current values of the counters, scaled to the full running time if the counters have been multiplexed
+         */
+        static Values read();
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_PERF_H */
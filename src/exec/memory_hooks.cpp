@@ -0,0 +1,103 @@
+/**
+ * @file
+ * @brief Replacements of the global allocation functions reporting to the memory tracker
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ *
+ * Only compiled into the executable if the ALLPIX_MEMORY_TRACKING option is enabled. Every allocation is preceded by a
+ * header holding its size and the counters it has been attributed to, such that it can be released from the same counters
+ * when freed by another module or thread. Allocations with extended alignment are not accounted.
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "core/utils/memory.h"
+
+using allpix::MemoryTracker;
+
+namespace {
+    /**
+     * @brief Header stored in front of every allocation, padded to keep the fundamental alignment
+     */
+    struct alignas(alignof(std::max_align_t)) AllocationHeader {
+        MemoryTracker::Counters* counters;
+        size_t size;
+    };
+
+    void* tracked_allocate(size_t size) noexcept {
+        auto* header = static_cast<AllocationHeader*>(std::malloc(sizeof(AllocationHeader) + size)); // NOLINT
+        if(header == nullptr) {
+            return nullptr;
+        }
+        header->counters = MemoryTracker::allocate(size);
+        header->size = size;
+        return header + 1;
+    }
+
+    void tracked_free(void* ptr) noexcept {
+        if(ptr == nullptr) {
+            return;
+        }
+        auto* header = static_cast<AllocationHeader*>(ptr) - 1;
+        MemoryTracker::deallocate(header->counters, header->size);
+        std::free(header); // NOLINT
+    }
+
+    void* allocate_or_throw(size_t size) {
+        while(true) {
+            auto* ptr = tracked_allocate(size);
+            if(ptr != nullptr) {
+                return ptr;
+            }
+            // Follow the standard behavior of calling the new handler until the allocation succeeds
+            auto handler = std::get_new_handler();
+            if(handler == nullptr) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    /**
+     * @brief Inform the tracker on startup that allocations are accounted
+     */
+    struct Registration {
+        Registration() { MemoryTracker::setAvailable(); }
+    } registration;
+} // namespace
+
+void* operator new(size_t size) {
+    return allocate_or_throw(size);
+}
+void* operator new[](size_t size) {
+    return allocate_or_throw(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return tracked_allocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return tracked_allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    tracked_free(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+    tracked_free(ptr);
+}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    tracked_free(ptr);
+}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    tracked_free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    tracked_free(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept {
+    tracked_free(ptr);
+}
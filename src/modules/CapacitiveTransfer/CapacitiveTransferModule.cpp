@@ -39,6 +39,7 @@ CapacitiveTransferModule::CapacitiveTransferModule(Configuration& config,
     config_.setDefault("cross_coupling", 1);
     config_.setDefault("nominal_gap", 0.0);
     config_.setDefault("minimum_gap", config_.get<double>("nominal_gap"));
+    mc_truth_ = getMCTruthLevel();
 
     // Require propagated deposits for single detector
     messenger->bindSingle(this, &CapacitiveTransferModule::propagated_message_, MsgFlags::REQUIRED);
@@ -268,8 +269,9 @@ void CapacitiveTransferModule::run(unsigned int) {
         }
 
         // Find the nearest pixel
-        auto xpixel = static_cast<int>(std::round(position.x() / model_->getPixelSize().x()));
-        auto ypixel = static_cast<int>(std::round(position.y() / model_->getPixelSize().y()));
+        auto nearest_pixel = detector_->getPixelIndex(position);
+        auto xpixel = nearest_pixel.first;
+        auto ypixel = nearest_pixel.second;
         LOG(DEBUG) << "Hit at pixel " << xpixel << ", " << ypixel;
 
         Pixel::Index pixel_index;
@@ -343,7 +345,12 @@ void CapacitiveTransferModule::run(unsigned int) {
 
         // Get pixel object from detector
         auto pixel = detector_->getPixel(pixel_index_charge.first.x(), pixel_index_charge.first.y());
-        pixel_charges.emplace_back(pixel, charge, pixel_index_charge.second.second);
+        // Link the propagated charges or only their Monte-Carlo particles, depending on the requested history
+        if(mc_truth_ == MCTruthLevel::NONE) {
+            pixel_charges.emplace_back(pixel, charge);
+        } else {
+            pixel_charges.emplace_back(pixel, charge, pixel_index_charge.second.second, mc_truth_ == MCTruthLevel::FULL);
+        }
         LOG(DEBUG) << "Set of " << charge << " charges combined at " << pixel.getIndex();
     }
 
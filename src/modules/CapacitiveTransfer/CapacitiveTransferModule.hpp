@@ -73,6 +73,9 @@ namespace allpix {
         // Message containing the propagated charges
         std::shared_ptr<PropagatedChargeMessage> propagated_message_;
 
+        // Depth of the stored history
+        MCTruthLevel mc_truth_{};
+
         // Statistical information
         unsigned int total_transferred_charges_{};
         std::set<Pixel::Index> unique_pixels_;
@@ -32,6 +32,7 @@ DefaultDigitizerModule::DefaultDigitizerModule(Configuration& config,
 
     // Seed the random generator with the global seed
     random_generator_.seed(getRandomSeed());
+    mc_truth_ = getMCTruthLevel();
 
     // Set defaults for config variables
     config_.setDefault<int>("electronics_noise", Units::get(110, "e"));
@@ -49,6 +50,11 @@ DefaultDigitizerModule::DefaultDigitizerModule(Configuration& config,
     config_.setDefault<bool>("output_plots", false);
     config_.setDefault<int>("output_plots_scale", Units::get(30, "ke"));
     config_.setDefault<int>("output_plots_bins", 100);
+
+    // Histograms accumulate over the whole run and are not stored in checkpoints
+    if(!config_.get<bool>("output_plots")) {
+        enable_checkpoints();
+    }
 }
 
 void DefaultDigitizerModule::init() {
@@ -185,8 +191,12 @@ void DefaultDigitizerModule::run(unsigned int) {
             }
         }
 
-        // Add the hit to the hitmap
-        hits.emplace_back(pixel, 0, charge, &pixel_charge);
+        // Add the hit to the hitmap, linking the pixel charge or only its Monte-Carlo particles depending on the history
+        hits.emplace_back(pixel,
+                          0,
+                          charge,
+                          (mc_truth_ != MCTruthLevel::NONE ? &pixel_charge : nullptr),
+                          mc_truth_ == MCTruthLevel::FULL);
     }
 
     // Output summary and update statistics
@@ -220,3 +230,11 @@ void DefaultDigitizerModule::finalize() {
 
     LOG(INFO) << "Digitized " << total_hits_ << " pixel hits in total";
 }
+
+void DefaultDigitizerModule::storeState(std::ostream& state) {
+    state << random_generator_ << " " << total_hits_;
+}
+
+void DefaultDigitizerModule::restoreState(std::istream& state) {
+    state >> random_generator_ >> total_hits_;
+}
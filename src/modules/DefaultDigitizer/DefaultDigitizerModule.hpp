@@ -58,6 +58,16 @@ namespace allpix {
          */
         void finalize() override;
 
+        /**
+         * @brief Store the state of the random number generator and the hit statistics in a checkpoint
+         */
+        void storeState(std::ostream& state) override;
+
+        /**
+         * @brief Restore the state of the random number generator and the hit statistics from a checkpoint
+         */
+        void restoreState(std::istream& state) override;
+
     private:
         std::mt19937_64 random_generator_;
 
@@ -66,6 +76,9 @@ namespace allpix {
         // Input message with the charges on the pixels
         std::shared_ptr<PixelChargeMessage> pixel_message_;
 
+        // Depth of the stored history
+        MCTruthLevel mc_truth_{};
+
         // Statistics
         unsigned long long total_hits_{};
 
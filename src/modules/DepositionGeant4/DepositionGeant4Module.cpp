@@ -11,6 +11,10 @@
 #include "DepositionGeant4Module.hpp"
 
 #include <limits>
+#include <map>
+#include <iterator>
+#include <set>
+#include <sstream>
 #include <string>
 #include <utility>
 
@@ -18,11 +22,14 @@
 #include <G4HadronicProcessStore.hh>
 #include <G4LogicalVolume.hh>
 #include <G4PhysListFactory.hh>
+#include <G4ProductionCuts.hh>
 #include <G4RadioactiveDecayPhysics.hh>
+#include <G4Region.hh>
 #include <G4RunManager.hh>
 #include <G4StepLimiterPhysics.hh>
 #include <G4UImanager.hh>
 #include <G4UserLimits.hh>
+#include <Randomize.hh>
 
 #include "G4FieldManager.hh"
 #include "G4TransportationManager.hh"
@@ -85,6 +92,11 @@ DepositionGeant4Module::DepositionGeant4Module(Configuration& config, Messenger*
 
     // Add the particle source position to the geometry
     geo_manager_->addPoint(config_.get<ROOT::Math::XYZPoint>("source_position", ROOT::Math::XYZPoint()));
+
+    // Histograms accumulate over the whole run and are not stored in checkpoints
+    if(!config_.get<bool>("output_plots")) {
+        enable_checkpoints();
+    }
 }
 
 /**
@@ -103,20 +115,29 @@ void DepositionGeant4Module::init() {
     // Get UI manager for sending commands
     G4UImanager* ui_g4 = G4UImanager::GetUIpointer();
 
+    // Regions of the sensors for region-specific physics settings, only created when required
+    std::map<std::string, G4Region*> sensor_regions;
+    auto get_sensor_region = [&](const std::shared_ptr<Detector>& detector) {
+        auto& region = sensor_regions[detector->getName()];
+        if(region == nullptr) {
+            auto logical_volume = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
+            if(logical_volume == nullptr) {
+                throw ModuleError("Detector " + detector->getName() + " has no sensitive device (broken Geant4 geometry)");
+            }
+            region = new G4Region(detector->getName() + "_sensor_region");
+            region->AddRootLogicalVolume(logical_volume.get());
+        }
+        return region;
+    };
+
     // Apply optional PAI model
     if(config_.get<bool>("enable_pai", false)) {
         LOG(TRACE) << "Enabling PAI model on all detectors";
         G4EmParameters::Instance();
 
         for(auto& detector : geo_manager_->getDetectors()) {
-            // Get logical volume
-            auto logical_volume = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
-            if(logical_volume == nullptr) {
-                throw ModuleError("Detector " + detector->getName() + " has no sensitive device (broken Geant4 geometry)");
-            }
-            // Create region
-            G4Region* region = new G4Region(detector->getName() + "_sensor_region");
-            region->AddRootLogicalVolume(logical_volume.get());
+            // Get region of the sensor
+            auto region = get_sensor_region(detector);
 
             auto pai_model = config_.get<std::string>("pai_model", "pai");
             auto lcase_model = pai_model;
@@ -189,7 +210,21 @@ void DepositionGeant4Module::init() {
         LOG(INFO) << "Setting G4 production cut to " << Units::display(production_cut, {"mm", "um"})
                   << ", derived from properties of detector \"" << min_detector << "\"";
     }
-    ui_g4->ApplyCommand("/run/setCut " + std::to_string(production_cut));
+
+    // Apply the production cut only in the sensors and a looser cut everywhere else if requested
+    if(config_.has("range_cut_world")) {
+        auto world_cut = config_.get<double>("range_cut_world");
+        LOG(INFO) << "Setting G4 production cut outside of the sensors to " << Units::display(world_cut, {"mm", "um"});
+        ui_g4->ApplyCommand("/run/setCut " + std::to_string(world_cut));
+
+        for(auto& detector : geo_manager_->getDetectors()) {
+            auto cuts = new G4ProductionCuts();
+            cuts->SetProductionCut(production_cut);
+            get_sensor_region(detector)->SetProductionCuts(cuts);
+        }
+    } else {
+        ui_g4->ApplyCommand("/run/setCut " + std::to_string(production_cut));
+    }
 
     // Initialize the physics list
     LOG(TRACE) << "Initializing physics processes";
@@ -204,7 +239,12 @@ void DepositionGeant4Module::init() {
     auto generator = new GeneratorActionG4(config_);
     run_manager_g4_->SetUserAction(generator);
 
-    track_info_manager_ = std::make_unique<TrackInfoManager>();
+    // Secondary tracks below the energy threshold are not stored as MCTrack
+    auto track_energy_threshold = config_.get<double>("track_energy_threshold", 0.);
+    if(track_energy_threshold > 0) {
+        LOG(INFO) << "Only storing secondary tracks above " << Units::display(track_energy_threshold, {"MeV", "keV"});
+    }
+    track_info_manager_ = std::make_unique<TrackInfoManager>(track_energy_threshold);
 
     // Default value chosen to ensure proper gamma generation for Cs137 decay
     auto decay_cutoff_time = config_.get<double>("decay_cutoff_time", 2.21e+11);
@@ -213,6 +253,27 @@ void DepositionGeant4Module::init() {
     auto userTrackIDHook = new SetTrackInfoUserHookG4(track_info_manager_.get(), decay_cutoff_time);
     run_manager_g4_->SetUserAction(userTrackIDHook);
 
+    // Kill secondaries outside of the sensors which are not of interest if requested
+    auto charged_threshold = config_.get<double>("kill_threshold_charged", 0.);
+    auto neutral_threshold = config_.get<double>("kill_threshold_neutral", 0.);
+    if(config_.get<bool>("sensor_only_tracking", false)) {
+        charged_threshold = std::numeric_limits<double>::max();
+        neutral_threshold = std::numeric_limits<double>::max();
+        LOG(INFO) << "Only tracking secondaries created in the sensors";
+    } else if(charged_threshold > 0 || neutral_threshold > 0) {
+        LOG(INFO) << "Killing secondaries outside of the sensors below "
+                  << Units::display(charged_threshold, {"MeV", "keV"}) << " for charged and "
+                  << Units::display(neutral_threshold, {"MeV", "keV"}) << " for neutral particles";
+    }
+    if(charged_threshold > 0 || neutral_threshold > 0) {
+        std::set<const G4Region*> regions;
+        for(auto& detector : geo_manager_->getDetectors()) {
+            regions.insert(get_sensor_region(detector));
+        }
+        stacking_action_ = new StackingActionG4(regions, charged_threshold, neutral_threshold);
+        run_manager_g4_->SetUserAction(stacking_action_);
+    }
+
     if(geo_manager_->hasMagneticField()) {
         MagneticFieldType magnetic_field_type_ = geo_manager_->getMagneticFieldType();
 
@@ -231,6 +292,15 @@ void DepositionGeant4Module::init() {
     auto charge_creation_energy = config_.get<double>("charge_creation_energy", Units::get(3.64, "eV"));
     auto fano_factor = config_.get<double>("fano_factor", 0.115);
 
+    // Subdivide the natural Geant4 steps into sub-deposits instead of limiting the step length if requested, the charge of
+    // every step is shared among its sub-deposits following the energy loss fluctuations along the step
+    auto subdivide_steps = config_.get<bool>("subdivide_steps", false);
+    auto subdivision_length = (subdivide_steps ? config_.get<double>("max_step_length") : 0.);
+    if(subdivide_steps) {
+        LOG(INFO) << "Sharing the charge of every step among deposits of at most "
+                  << Units::display(subdivision_length, {"mm", "um", "nm"}) << " instead of limiting the step length";
+    }
+
     // Prepare seeds for Geant4:
     // NOTE Assumes this is the only Geant4 module using random numbers
     std::string seed_command = "/random/setSeeds ";
@@ -254,16 +324,28 @@ void DepositionGeant4Module::init() {
         }
         useful_deposition = true;
 
-        // Get model of the sensitive device
-        auto sensitive_detector_action = new SensitiveDetectorActionG4(
-            this, detector, messenger_, track_info_manager_.get(), charge_creation_energy, fano_factor, getRandomSeed());
+        // Get model of the sensitive device, the seed for the subdivision of steps is only drawn if needed to keep the seeds
+        // of all other detectors unchanged
+        auto random_seed = getRandomSeed();
+        auto subdivision_seed = (subdivide_steps ? getRandomSeed() : 0);
+        auto sensitive_detector_action = new SensitiveDetectorActionG4(this,
+                                                                       detector,
+                                                                       messenger_,
+                                                                       track_info_manager_.get(),
+                                                                       charge_creation_energy,
+                                                                       fano_factor,
+                                                                       random_seed,
+                                                                       subdivision_length,
+                                                                       subdivision_seed);
         auto logical_volume = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
         if(logical_volume == nullptr) {
             throw ModuleError("Detector " + detector->getName() + " has no sensitive device (broken Geant4 geometry)");
         }
 
-        // Apply the user limits to this element
-        logical_volume->SetUserLimits(user_limits_.get());
+        // Apply the user limits to this element unless the steps are subdivided afterwards
+        if(!subdivide_steps) {
+            logical_volume->SetUserLimits(user_limits_.get());
+        }
 
         // Add the sensitive detector action
         logical_volume->SetSensitiveDetector(sensitive_detector_action);
@@ -297,6 +379,23 @@ void DepositionGeant4Module::init() {
     // Set the random seed for Geant4 generation
     ui_g4->ApplyCommand(seed_command);
 
+    // Continue the random number sequences of a resumed run, which replaces the state set up from the seeds
+    if(!resume_engine_state_.empty()) {
+        if(resume_sensor_states_.size() != sensors_.size()) {
+            throw ModuleError("Checkpoint contains the state of " + std::to_string(resume_sensor_states_.size()) +
+                              " sensors but " + std::to_string(sensors_.size()) + " are simulated");
+        }
+        for(size_t i = 0; i < sensors_.size(); ++i) {
+            std::istringstream sensor_state(resume_sensor_states_[i]);
+            sensors_[i]->restoreState(sensor_state);
+        }
+        if(stacking_action_ != nullptr) {
+            stacking_action_->setKilledTracks(resume_killed_tracks_);
+        }
+        std::istringstream engine_state(resume_engine_state_);
+        CLHEP::HepRandom::getTheEngine()->get(engine_state);
+    }
+
     // Release the output stream
     RELEASE_STREAM(G4cout);
 }
@@ -316,10 +415,16 @@ void DepositionGeant4Module::run(unsigned int event_num) {
     // Release the stream (if it was suspended)
     RELEASE_STREAM(G4cout);
 
-    track_info_manager_->createMCTracks();
+    if(stacking_action_ != nullptr) {
+        LOG(DEBUG) << "Killed " << stacking_action_->getEventKilledTracks()
+                   << " secondaries outside of the sensors in this event";
+    }
 
-    // Dispatch the necessary messages
-    track_info_manager_->dispatchMessage(this, messenger_);
+    // Dispatch the necessary messages, the Monte-Carlo tracks are only part of the stored history
+    if(getMCTruthLevel() != MCTruthLevel::NONE) {
+        track_info_manager_->createMCTracks();
+        track_info_manager_->dispatchMessage(this, messenger_);
+    }
 
     for(auto& sensor : sensors_) {
         sensor->dispatchMessages();
@@ -348,6 +453,10 @@ void DepositionGeant4Module::finalize() {
         }
     }
 
+    if(stacking_action_ != nullptr) {
+        LOG(INFO) << "Killed " << stacking_action_->getKilledTracks() << " secondaries outside of the sensors";
+    }
+
     // Print summary or warns if module did not output any charges
     if(!sensors_.empty() && total_charges > 0 && last_event_num_ > 0) {
         size_t average_charge = total_charges / sensors_.size() / last_event_num_;
@@ -357,3 +466,29 @@ void DepositionGeant4Module::finalize() {
         LOG(WARNING) << "No charges deposited";
     }
 }
+
+/**
+ * The sensitive detectors, the stacking action and the state of the Geant4 engine only exist after initialization. Their
+ * states are therefore kept by \ref restoreState() and applied at the end of \ref init().
+ */
+void DepositionGeant4Module::storeState(std::ostream& state) {
+    state << last_event_num_ << " " << (stacking_action_ != nullptr ? stacking_action_->getKilledTracks() : 0) << " "
+          << sensors_.size() << "\n";
+    for(auto& sensor : sensors_) {
+        sensor->storeState(state);
+        state << "\n";
+    }
+    CLHEP::HepRandom::getTheEngine()->put(state);
+}
+
+void DepositionGeant4Module::restoreState(std::istream& state) {
+    size_t sensors = 0;
+    state >> last_event_num_ >> resume_killed_tracks_ >> sensors;
+    state.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    for(size_t i = 0; i < sensors; ++i) {
+        std::string sensor_state;
+        std::getline(state, sensor_state);
+        resume_sensor_states_.push_back(sensor_state);
+    }
+    resume_engine_state_.assign(std::istreambuf_iterator<char>(state), std::istreambuf_iterator<char>());
+}
@@ -19,6 +19,7 @@
 #include "core/module/Module.hpp"
 
 #include "SensitiveDetectorActionG4.hpp"
+#include "StackingActionG4.hpp"
 #include "TrackInfoManager.hpp"
 
 #include <TH1D.h>
@@ -61,6 +62,16 @@ namespace allpix {
          */
         void finalize() override;
 
+        /**
+         * @brief Store the state of the Geant4 random number engine and of the sensitive detectors in a checkpoint
+         */
+        void storeState(std::ostream& state) override;
+
+        /**
+         * @brief Keep the state from a checkpoint to restore it after Geant4 has been initialized
+         */
+        void restoreState(std::istream& state) override;
+
     private:
         Messenger* messenger_;
         GeometryManager* geo_manager_;
@@ -77,9 +88,18 @@ namespace allpix {
         // Class holding the limits for the step size
         std::unique_ptr<G4UserLimits> user_limits_;
 
+        // Stacking action killing secondaries outside of the sensors (owned by the Geant4 run manager)
+        StackingActionG4* stacking_action_{};
+
         // Pointer to the Geant4 manager (owned by GeometryBuilderGeant4)
         G4RunManager* run_manager_g4_;
 
+        // State of the sensitive detectors, the stacking action and the Geant4 random number engine when resuming from a
+        // checkpoint
+        std::vector<std::string> resume_sensor_states_;
+        unsigned long long resume_killed_tracks_{};
+        std::string resume_engine_state_;
+
         // Vector of histogram pointers for debugging plots
         std::map<std::string, TH1D*> charge_per_event_;
     };
@@ -11,18 +11,29 @@
 #include "SensitiveDetectorActionG4.hpp"
 #include "TrackInfoG4.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <numeric>
+#include <random>
+#include <string>
 
 #include "G4DecayTable.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Electron.hh"
 #include "G4HCofThisEvent.hh"
 #include "G4LogicalVolume.hh"
+#include "G4Positron.hh"
+#include "G4ProductionCutsTable.hh"
 #include "G4RunManager.hh"
 #include "G4SDManager.hh"
 #include "G4Step.hh"
 #include "G4ThreeVector.hh"
 #include "G4Track.hh"
 #include "G4VProcess.hh"
+#include "G4Version.hh"
 #include "G4ios.hh"
+#include "Randomize.hh"
 
 #include "TMath.h"
 #include "TString.h"
@@ -39,10 +50,13 @@ SensitiveDetectorActionG4::SensitiveDetectorActionG4(Module* module,
                                                      TrackInfoManager* track_info_manager,
                                                      double charge_creation_energy,
                                                      double fano_factor,
-                                                     uint64_t random_seed)
+                                                     uint64_t random_seed,
+                                                     double subdivision_length,
+                                                     uint64_t subdivision_seed)
     : G4VSensitiveDetector("SensitiveDetector_" + detector->getName()), module_(module), detector_(detector),
       messenger_(msg), track_info_manager_(track_info_manager), charge_creation_energy_(charge_creation_energy),
-      fano_factor_(fano_factor) {
+      fano_factor_(fano_factor), subdivision_length_(subdivision_length),
+      fluctuation_model_(new G4UniversalFluctuation()) {
 
     // Add the sensor to the internal sensitive detector manager
     G4SDManager* sd_man_g4 = G4SDManager::GetSDMpointer();
@@ -50,6 +64,10 @@ SensitiveDetectorActionG4::SensitiveDetectorActionG4(Module* module,
 
     // Seed the random generator for Fano fluctuations with the seed received
     random_generator_.seed(random_seed);
+
+    // Seed the random generators for the subdivision of steps
+    segment_random_generator_.seed(subdivision_seed);
+    straggling_engine_.setSeed(static_cast<long>(segment_random_generator_() >> 1), 0);
 }
 
 G4bool SensitiveDetectorActionG4::ProcessHits(G4Step* step, G4TouchableHistory*) {
@@ -106,19 +124,48 @@ G4bool SensitiveDetectorActionG4::ProcessHits(G4Step* step, G4TouchableHistory*)
         return false;
     }
 
-    auto global_deposit_position = detector_->getGlobalPosition(deposit_position);
-
-    // Deposit electron
-    deposits_.emplace_back(deposit_position, global_deposit_position, CarrierType::ELECTRON, charge, mid_time);
-    deposit_to_id_.push_back(trackID);
+    // Subdivide the step into segments along the straight line between its end points if requested
+    auto step_start = detector_->getLocalPosition(static_cast<ROOT::Math::XYZPoint>(preStepPoint->GetPosition()));
+    auto segments = 1u;
+    if(subdivision_length_ > 0) {
+        segments = std::max(1u, static_cast<unsigned int>(std::ceil(step->GetStepLength() / subdivision_length_)));
+    }
 
-    // Deposit hole
-    deposits_.emplace_back(deposit_position, global_deposit_position, CarrierType::HOLE, charge, mid_time);
-    deposit_to_id_.push_back(trackID);
+    if(segments == 1) {
+        add_deposit(deposit_position, mid_time, static_cast<unsigned int>(charge), trackID);
+    } else {
+        // Share the charge of the step among the equally long segments by multinomial sampling, weighted with the energy
+        // loss sampled for every segment. This preserves the charge of the step including its Fano fluctuations, while the
+        // segments reproduce the straggling of the energy loss along the step
+        auto losses = sample_segment_losses(step, segments);
+        auto remaining_loss = std::accumulate(losses.begin(), losses.end(), 0.);
+        auto remaining = static_cast<unsigned int>(std::max(charge, 0.));
+        auto pre_time = preStepPoint->GetGlobalTime();
+        auto post_time = postStepPoint->GetGlobalTime();
+        for(unsigned int segment = 0; segment < segments && remaining > 0; ++segment) {
+            auto segment_charge = remaining;
+            if(segment + 1 < segments) {
+                auto probability = (remaining_loss > 0 ? std::min(losses[segment] / remaining_loss, 1.)
+                                                       : 1. / static_cast<double>(segments - segment));
+                std::binomial_distribution<unsigned int> sharing(remaining, probability);
+                segment_charge = sharing(segment_random_generator_);
+                remaining_loss -= losses[segment];
+            }
+            remaining -= segment_charge;
+            if(segment_charge == 0) {
+                continue;
+            }
+
+            auto fraction = (segment + 0.5) / static_cast<double>(segments);
+            auto segment_position = step_start + (end_position - step_start) * fraction;
+            add_deposit(segment_position, pre_time + (post_time - pre_time) * fraction, segment_charge, trackID);
+        }
+    }
 
     LOG(DEBUG) << "Created deposit of " << charge << " charges at " << Units::display(mid_pos, {"mm", "um"})
                << " locally on " << Units::display(deposit_position, {"mm", "um"}) << " in " << detector_->getName()
-               << " after " << Units::display(mid_time, {"ns", "ps"});
+               << " after " << Units::display(mid_time, {"ns", "ps"})
+               << (segments > 1 ? " in " + std::to_string(segments) + " segments" : "");
 
     LOG(DEBUG) << "Geant4 transformation to local: " << Units::display(deposit_position_g4loc, {"mm", "um"});
     if((deposit_position_g4loc - deposit_position).mag2() > 0.001) {
@@ -128,6 +175,78 @@ G4bool SensitiveDetectorActionG4::ProcessHits(G4Step* step, G4TouchableHistory*)
     return true;
 }
 
+void SensitiveDetectorActionG4::add_deposit(const ROOT::Math::XYZPoint& local_position,
+                                            double time,
+                                            unsigned int charge,
+                                            int track_id) {
+    // Global positions are only calculated on demand
+    const auto& local_to_global = detector_->getLocalToGlobalTransform();
+
+    // Deposit electron
+    deposits_.emplace_back(local_position, local_to_global, CarrierType::ELECTRON, charge, time);
+    deposit_to_id_.push_back(track_id);
+
+    // Deposit hole
+    deposits_.emplace_back(local_position, local_to_global, CarrierType::HOLE, charge, time);
+    deposit_to_id_.push_back(track_id);
+}
+
+/**
+ * The energy loss of every segment is sampled with the mean energy loss of the step shared equally among the segments,
+ * using the maximum energy transfer to a free electron at the kinetic energy of the particle at the beginning of the step
+ * and the production threshold for delta electrons in the sensor. The Geant4 random engine is replaced by a separate engine
+ * during the sampling in order not to alter the random number sequence of the tracking.
+ */
+std::vector<double> SensitiveDetectorActionG4::sample_segment_losses(const G4Step* step, unsigned int segments) {
+    std::vector<double> losses(segments, 1.);
+
+    // Neutral particles do not lose energy continuously along the step, share their charge equally
+    const auto* definition = step->GetTrack()->GetDefinition();
+    const auto* pre_step_point = step->GetPreStepPoint();
+    auto kinetic_energy = pre_step_point->GetKineticEnergy();
+    if(definition->GetPDGCharge() == 0 || kinetic_energy <= 0) {
+        return losses;
+    }
+
+    if(definition != fluctuation_particle_) {
+        fluctuation_model_->InitialiseMe(definition);
+        fluctuation_particle_ = definition;
+    }
+
+    // Maximum kinetic energy transferred to a free electron, for electrons and positrons following Moller and Bhabha
+    double tmax = kinetic_energy;
+    if(definition == G4Electron::Definition()) {
+        tmax = kinetic_energy / 2;
+    } else if(definition != G4Positron::Definition()) {
+        auto ratio = CLHEP::electron_mass_c2 / definition->GetPDGMass();
+        auto tau = kinetic_energy / definition->GetPDGMass();
+        auto gamma = tau + 1;
+        tmax = 2 * CLHEP::electron_mass_c2 * tau * (tau + 2) / (1 + 2 * gamma * ratio + ratio * ratio);
+    }
+
+    // Production threshold for delta electrons, energy transfers above it are simulated as secondaries by Geant4
+    const auto* couple = pre_step_point->GetMaterialCutsCouple();
+    const auto* cuts = G4ProductionCutsTable::GetProductionCutsTable()->GetEnergyCutsVector(idxG4ElectronCut);
+    auto tcut = std::min(cuts->at(static_cast<size_t>(couple->GetIndex())), tmax);
+
+    G4DynamicParticle particle(definition, pre_step_point->GetMomentumDirection(), kinetic_energy);
+    auto length = step->GetStepLength() / static_cast<double>(segments);
+    auto mean_loss = step->GetTotalEnergyDeposit() / static_cast<double>(segments);
+
+    auto* tracking_engine = G4Random::getTheEngine();
+    G4Random::setTheEngine(&straggling_engine_);
+    for(auto& loss : losses) {
+#if G4VERSION_NUMBER >= 1100
+        loss = fluctuation_model_->SampleFluctuations(couple, &particle, tcut, tmax, length, mean_loss);
+#else
+        loss = fluctuation_model_->SampleFluctuations(couple, &particle, tcut, length, mean_loss);
+#endif
+    }
+    G4Random::setTheEngine(tracking_engine);
+
+    return losses;
+}
+
 std::string SensitiveDetectorActionG4::getName() {
     return detector_->getName();
 }
@@ -140,6 +259,16 @@ unsigned int SensitiveDetectorActionG4::getDepositedCharge() {
     return deposited_charge_;
 }
 
+void SensitiveDetectorActionG4::storeState(std::ostream& state) const {
+    state << random_generator_ << " " << segment_random_generator_ << " " << total_deposited_charge_ << " ";
+    straggling_engine_.put(state);
+}
+
+void SensitiveDetectorActionG4::restoreState(std::istream& state) {
+    state >> random_generator_ >> segment_random_generator_ >> total_deposited_charge_;
+    straggling_engine_.get(state);
+}
+
 void SensitiveDetectorActionG4::dispatchMessages() {
     // Create the mc particles
     std::vector<MCParticle> mc_particles;
@@ -152,9 +281,7 @@ void SensitiveDetectorActionG4::dispatchMessages() {
         auto pdg_code = track_pdg_.at(track_id);
         auto track_time = track_time_.at(track_id);
 
-        auto global_begin = detector_->getGlobalPosition(local_begin);
-        auto global_end = detector_->getGlobalPosition(local_end);
-        mc_particles.emplace_back(local_begin, global_begin, local_end, global_end, pdg_code, track_time);
+        mc_particles.emplace_back(local_begin, local_end, detector_->getLocalToGlobalTransform(), pdg_code, track_time);
         mc_particles.back().setTrack(track_info_manager_->findMCTrack(track_id));
         id_to_particle_[track_id] = mc_particles.size() - 1;
 
@@ -176,9 +303,11 @@ void SensitiveDetectorActionG4::dispatchMessages() {
         mc_particles.at(track_idx).setParent(&mc_particles.at(parent_idx));
     }
 
-    // Send the mc particle information
+    // Send the mc particle information unless no history is stored
     auto mc_particle_message = std::make_shared<MCParticleMessage>(std::move(mc_particles), detector_);
-    messenger_->dispatchMessage(module_, mc_particle_message);
+    if(module_->getMCTruthLevel() != MCTruthLevel::NONE) {
+        messenger_->dispatchMessage(module_, mc_particle_message);
+    }
 
     // Clear track data for the next event
     track_parents_.clear();
@@ -196,10 +325,16 @@ void SensitiveDetectorActionG4::dispatchMessages() {
         }
         LOG(INFO) << "Deposited " << charges << " charges in sensor of detector " << detector_->getName();
 
-        // Match deposit with mc particle if possible
-        for(size_t i = 0; i < deposits_.size(); ++i) {
-            auto track_id = deposit_to_id_.at(i);
-            deposits_.at(i).setMCParticle(&mc_particle_message->getData().at(id_to_particle_.at(track_id)));
+        // Match deposit with mc particle if possible, only linking primary particles if the full history is not stored
+        auto mc_truth = module_->getMCTruthLevel();
+        if(mc_truth != MCTruthLevel::NONE) {
+            for(size_t i = 0; i < deposits_.size(); ++i) {
+                auto track_id = deposit_to_id_.at(i);
+                const auto& mc_particle = mc_particle_message->getData().at(id_to_particle_.at(track_id));
+                if(mc_truth == MCTruthLevel::FULL || mc_particle.getParent() == nullptr) {
+                    deposits_.at(i).setMCParticle(&mc_particle);
+                }
+            }
         }
 
         // Create a new charge deposit message
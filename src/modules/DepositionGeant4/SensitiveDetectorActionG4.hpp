@@ -10,8 +10,13 @@
 #ifndef ALLPIX_SIMPLE_DEPOSITION_MODULE_SENSITIVE_DETECTOR_ACTION_H
 #define ALLPIX_SIMPLE_DEPOSITION_MODULE_SENSITIVE_DETECTOR_ACTION_H
 
+#include <istream>
 #include <memory>
+#include <ostream>
+#include <vector>
 
+#include <CLHEP/Random/MTwistEngine.h>
+#include <G4UniversalFluctuation.hh>
 #include <G4VSensitiveDetector.hh>
 #include <G4WrapperProcess.hh>
 
@@ -37,6 +42,8 @@ namespace allpix {
          * @param charge_creation_energy Energy needed per deposited charge
          * @param fano_factor Fano factor for fluctuations in the energy fraction going into e/h pair creation
          * @param random_seed Seed for the random number generator for Fano fluctuations
+         * @param subdivision_length Length of the sub-deposits each step is divided into, zero to deposit at the step center
+         * @param subdivision_seed Seed for the random number generators sharing the charge of a step among its sub-deposits
          */
         SensitiveDetectorActionG4(Module* module,
                                   const std::shared_ptr<Detector>& detector,
@@ -44,7 +51,9 @@ namespace allpix {
                                   TrackInfoManager* track_info_manager,
                                   double charge_creation_energy,
                                   double fano_factor,
-                                  uint64_t random_seed);
+                                  uint64_t random_seed,
+                                  double subdivision_length = 0,
+                                  uint64_t subdivision_seed = 0);
 
         /**
          * @brief Get total number of charges deposited in the sensitive device bound to this action
@@ -75,7 +84,36 @@ namespace allpix {
          */
         void dispatchMessages();
 
+        /**
+         * @brief Store the state of the random number generators and the total deposited charge
+         * @param state Stream to write the state to
+         */
+        void storeState(std::ostream& state) const;
+
+        /**
+         * @brief Restore the state of the random number generators and the total deposited charge
+         * @param state Stream to read the state from
+         */
+        void restoreState(std::istream& state);
+
     private:
+        /**
+         * @brief Add an electron and a hole deposit at a local position
+         * @param local_position Position of the deposit in local coordinates
+         * @param time Time of the deposit
+         * @param charge Number of electron/hole pairs deposited
+         * @param track_id Identifier of the track causing the deposit
+         */
+        void add_deposit(const ROOT::Math::XYZPoint& local_position, double time, unsigned int charge, int track_id);
+
+        /**
+         * @brief Sample the energy loss of equally long segments of a step from the energy loss fluctuations in Geant4
+         * @param step Step to subdivide
+         * @param segments Number of segments
+         * @return Energy loss sampled for every segment, equal for all segments if the particle is neutral
+         */
+        std::vector<double> sample_segment_losses(const G4Step* step, unsigned int segments);
+
         // Instantatiation of the deposition module
         Module* module_;
         std::shared_ptr<Detector> detector_;
@@ -85,10 +123,21 @@ namespace allpix {
 
         double charge_creation_energy_;
         double fano_factor_;
+        double subdivision_length_;
 
         // Random number generator for e/h pair creation fluctuation
         std::mt19937_64 random_generator_;
 
+        // Random number generators for sharing the charge of a step among its sub-deposits, separate from the ones for the
+        // Fano fluctuations and the Geant4 tracking such that the subdivision does not alter the charge of the steps
+        std::mt19937_64 segment_random_generator_;
+        CLHEP::MTwistEngine straggling_engine_;
+
+        // Energy loss fluctuation model for the segments of a step, owned by Geant4, and the particle type it is initialised
+        // for
+        G4UniversalFluctuation* fluctuation_model_;
+        const G4ParticleDefinition* fluctuation_particle_{};
+
         // Statistics of total and per-event deposited charge
         unsigned int total_deposited_charge_{};
         unsigned int deposited_charge_{};
@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @brief Implements the stacking action killing secondary particles outside of the sensors
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "StackingActionG4.hpp"
+
+#include <utility>
+
+#include <G4LogicalVolume.hh>
+#include <G4TransportationManager.hh>
+#include <G4VProcess.hh>
+#include <G4VPhysicalVolume.hh>
+
+using namespace allpix;
+
+StackingActionG4::StackingActionG4(std::set<const G4Region*> sensor_regions,
+                                   double charged_threshold,
+                                   double neutral_threshold)
+    : sensor_regions_(std::move(sensor_regions)), charged_threshold_(charged_threshold),
+      neutral_threshold_(neutral_threshold), navigator_(std::make_unique<G4Navigator>()) {
+    navigator_->SetWorldVolume(
+        G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume());
+}
+
+/**
+ * The volume a new secondary has been created in is located from its position, the creation vertex. The volume attached to
+ * the track at stacking time cannot be used, since it is the volume the parent track has entered at the end of the step
+ * when the secondary is created on a volume boundary. Products of decays are always tracked, since they constitute the
+ * actual particles emitted by radioactive sources.
+ */
+G4ClassificationOfNewTrack StackingActionG4::ClassifyNewTrack(const G4Track* track) {
+    if(track->GetParentID() == 0) {
+        return fUrgent;
+    }
+
+    auto creator = track->GetCreatorProcess();
+    if(creator != nullptr && creator->GetProcessType() == fDecay) {
+        return fUrgent;
+    }
+
+    auto volume = navigator_->LocateGlobalPointAndSetup(track->GetPosition(), nullptr, false, true);
+    if(volume == nullptr || sensor_regions_.count(volume->GetLogicalVolume()->GetRegion()) != 0) {
+        return fUrgent;
+    }
+
+    auto threshold = (track->GetDefinition()->GetPDGCharge() == 0 ? neutral_threshold_ : charged_threshold_);
+    if(track->GetKineticEnergy() < threshold) {
+        killed_tracks_++;
+        event_killed_tracks_++;
+        return fKill;
+    }
+    return fUrgent;
+}
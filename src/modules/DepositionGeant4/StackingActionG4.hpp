@@ -0,0 +1,82 @@
+/**
+ * @file
+ * @brief Defines the stacking action killing secondary particles outside of the sensors
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_SIMPLE_DEPOSITION_MODULE_STACKING_ACTION_H
+#define ALLPIX_SIMPLE_DEPOSITION_MODULE_STACKING_ACTION_H
+
+#include <memory>
+#include <set>
+
+#include <G4Navigator.hh>
+#include <G4Region.hh>
+#include <G4Track.hh>
+#include <G4UserStackingAction.hh>
+
+namespace allpix {
+    /**
+     * @brief Kills secondary particles created outside of the sensors which are of no interest for the simulation
+     *
+     * Secondary particles created in volumes which do not belong to any of the sensor regions are killed before they are
+     * tracked if their kinetic energy is below the threshold for their charge. Primary particles are always tracked. The
+     * number of killed secondaries is counted per event and for the full run.
+     */
+    class StackingActionG4 : public G4UserStackingAction {
+    public:
+        /**
+         * @brief Constructs the stacking action
+         * @param sensor_regions Regions of all sensors, secondaries created within them are always tracked
+         * @param charged_threshold Kinetic energy below which charged secondaries outside the sensors are killed
+         * @param neutral_threshold Kinetic energy below which neutral secondaries outside the sensors are killed
+         */
+        StackingActionG4(std::set<const G4Region*> sensor_regions, double charged_threshold, double neutral_threshold);
+
+        /**
+         * @brief Decide whether a new track is tracked or killed
+         * @param track The new track
+         * @return Classification of the track, either urgent tracking or killing
+         */
+        G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track) override;
+
+        /**
+         * @brief Reset the number of secondaries killed in the event at the start of a new event
+         */
+        void PrepareNewEvent() override { event_killed_tracks_ = 0; }
+
+        /**
+         * @brief Get the number of secondaries killed in the run
+         * @return Number of killed tracks
+         */
+        unsigned long long getKilledTracks() const { return killed_tracks_; }
+
+        /**
+         * @brief Set the number of secondaries killed in the run, used to continue the count of a resumed run
+         * @param killed_tracks Number of killed tracks
+         */
+        void setKilledTracks(unsigned long long killed_tracks) { killed_tracks_ = killed_tracks; }
+
+        /**
+         * @brief Get the number of secondaries killed in the current event
+         * @return Number of killed tracks
+         */
+        unsigned long long getEventKilledTracks() const { return event_killed_tracks_; }
+
+    private:
+        std::set<const G4Region*> sensor_regions_;
+        double charged_threshold_;
+        double neutral_threshold_;
+
+        // Navigator to locate the creation vertex of new tracks without disturbing the navigator used for tracking
+        std::unique_ptr<G4Navigator> navigator_;
+
+        unsigned long long killed_tracks_{};
+        unsigned long long event_killed_tracks_{};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_SIMPLE_DEPOSITION_MODULE_STACKING_ACTION_H */
@@ -11,40 +11,51 @@
 
 using namespace allpix;
 
-TrackInfoManager::TrackInfoManager() : counter_(1) {}
+/**
+ * Custom track ids are assigned consecutively starting at one, such that all per-track bookkeeping is stored in vectors
+ * indexed by the custom id. The element at index zero represents the absent parent of primary tracks.
+ */
+TrackInfoManager::TrackInfoManager(double energy_threshold) : energy_threshold_(energy_threshold) {
+    resetTrackInfoManager();
+}
 
 std::unique_ptr<TrackInfoG4> TrackInfoManager::makeTrackInfo(const G4Track* const track) {
     auto custom_id = counter_++;
     auto G4ParentID = track->GetParentID();
     auto parent_track_id = G4ParentID == 0 ? G4ParentID : g4_to_custom_id_.at(G4ParentID);
     g4_to_custom_id_[track->GetTrackID()] = custom_id;
-    track_id_to_parent_id_[custom_id] = parent_track_id;
+    track_id_to_parent_id_.push_back(parent_track_id);
+    to_store_track_ids_.push_back(false);
+    below_threshold_track_ids_.push_back(false);
     return std::make_unique<TrackInfoG4>(custom_id, parent_track_id, track);
 }
 
 void TrackInfoManager::setTrackInfoToBeStored(int track_id) {
-    auto element = std::find(to_store_track_ids_.begin(), to_store_track_ids_.end(), track_id);
-    // If track id is not present we add it, otherwise skip as we only need each track once
-    if(element == to_store_track_ids_.end()) {
-        to_store_track_ids_.emplace_back(track_id);
-    }
+    to_store_track_ids_.at(static_cast<size_t>(track_id)) = true;
 }
 
 void TrackInfoManager::storeTrackInfo(std::unique_ptr<TrackInfoG4> the_track_info) {
-    auto track_id = the_track_info->getID();
-    auto element = std::find(to_store_track_ids_.begin(), to_store_track_ids_.end(), track_id);
-    if(element != to_store_track_ids_.end()) {
+    auto track_id = static_cast<size_t>(the_track_info->getID());
+    if(!to_store_track_ids_.at(track_id)) {
+        return;
+    }
+    to_store_track_ids_[track_id] = false;
+
+    // Primary tracks are always stored, secondary tracks only above the energy threshold
+    if(the_track_info->getParentID() == 0 || the_track_info->getKineticEnergyInitial() >= energy_threshold_) {
         stored_track_infos_.push_back(std::move(the_track_info));
-        to_store_track_ids_.erase(element);
+    } else {
+        below_threshold_track_ids_[track_id] = true;
     }
 }
 
 void TrackInfoManager::resetTrackInfoManager() {
     counter_ = 1;
     stored_tracks_.clear();
-    to_store_track_ids_.clear();
+    to_store_track_ids_.assign(1, false);
+    below_threshold_track_ids_.assign(1, false);
     g4_to_custom_id_.clear();
-    track_id_to_parent_id_.clear();
+    track_id_to_parent_id_.assign(1, 0);
     stored_track_infos_.clear();
     stored_track_ids_.clear();
     id_to_track_.clear();
@@ -64,13 +75,14 @@ void TrackInfoManager::dispatchMessage(Module* module, Messenger* messenger) {
 }
 
 MCTrack const* TrackInfoManager::findMCTrack(int track_id) const {
-    auto it = id_to_track_.find(track_id);
-    return (it == id_to_track_.end()) ? nullptr : it->second;
+    auto index = static_cast<size_t>(track_id);
+    return (track_id < 0 || index >= id_to_track_.size()) ? nullptr : id_to_track_[index];
 }
 
 void TrackInfoManager::createMCTracks() {
     // Reserve size so we don't move the vector around and change addresses:
     stored_tracks_.reserve(stored_track_infos_.size());
+    id_to_track_.assign(static_cast<size_t>(counter_), nullptr);
 
     for(auto& track_info : stored_track_infos_) {
         stored_tracks_.emplace_back(track_info->getStartPoint(),
@@ -84,15 +96,20 @@ void TrackInfoManager::createMCTracks() {
                                     track_info->getTotalEnergyInitial(),
                                     track_info->getTotalEnergyFinal());
 
-        id_to_track_[track_info->getID()] = &stored_tracks_.back();
+        id_to_track_[static_cast<size_t>(track_info->getID())] = &stored_tracks_.back();
         stored_track_ids_.emplace_back(track_info->getID());
     }
 }
 
 void TrackInfoManager::set_all_track_parents() {
+    // All tracks are created, the parents are resolved through the dense id lookup. Parents which have not been stored
+    // because of the energy threshold are skipped, linking the track to its nearest stored ancestor instead.
     for(size_t ix = 0; ix < stored_track_ids_.size(); ++ix) {
-        auto track_id = stored_track_ids_[ix];
+        auto track_id = static_cast<size_t>(stored_track_ids_[ix]);
         auto parent_id = track_id_to_parent_id_[track_id];
+        while(parent_id != 0 && below_threshold_track_ids_[static_cast<size_t>(parent_id)]) {
+            parent_id = track_id_to_parent_id_[static_cast<size_t>(parent_id)];
+        }
         stored_tracks_[ix].setParent(findMCTrack(parent_id));
     }
 }
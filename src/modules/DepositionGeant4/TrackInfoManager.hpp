@@ -11,7 +11,8 @@
 #ifndef TrackInfoManager_H
 #define TrackInfoManager_H 1
 
-#include <map>
+#include <unordered_map>
+#include <vector>
 
 #include "G4Track.hh"
 #include "TrackInfoG4.hpp"
@@ -26,9 +27,10 @@ namespace allpix {
     class TrackInfoManager {
     public:
         /**
-         * @brief Default constructor
+         * @brief Constructor of the track manager
+         * @param energy_threshold Minimum initial kinetic energy of secondary tracks to be stored as MCTrack
          */
-        TrackInfoManager();
+        explicit TrackInfoManager(double energy_threshold = 0);
 
         /**
          * @brief Factory method for TrackInfoG4 instances
@@ -44,7 +46,8 @@ namespace allpix {
          * @brief Will take a MCTrack and attempt to store it
          * @param the_track_info The MCTrack to be (possibly) stored
          *
-         * It will be stored if it was registered to be stored (@see #setTrackInfoToBeStored), otherwise deleted
+         * It will be stored if it was registered to be stored (@see #setTrackInfoToBeStored) and it is either a primary
+         * track or its initial kinetic energy is above the threshold, otherwise deleted
          */
         void storeTrackInfo(std::unique_ptr<TrackInfoG4> the_track_info);
 
@@ -83,7 +86,7 @@ namespace allpix {
          * @brief Returns a pointer to the MCTrack object in the #stored_tracks_ or a nullptr if not found
          * @param track_id The id of the track for which to retrieve the pointer
          * @return Const pointer to the MCTrack object or a nullptr if track_id is not found
-         * @warning Results are invalidated by any reallocation iof the internal #stored_tracks_ vector
+         * @warning Results are invalidated by any reallocation of the internal #stored_tracks_ vector
          */
         MCTrack const* findMCTrack(int track_id) const;
 
@@ -97,20 +100,24 @@ namespace allpix {
 
         // Counter to store highest assigned track id
         int counter_{};
+        // Minimum initial kinetic energy of secondary tracks to be stored
+        double energy_threshold_{};
         // Geant4 id to custom id translation
-        std::map<int, int> g4_to_custom_id_{};
-        // Custom id to custom parent id tracking
-        std::map<int, int> track_id_to_parent_id_{};
-        // List of track ids to be stored if they are provided via #storeTrackInfo
-        std::vector<int> to_store_track_ids_;
+        std::unordered_map<int, int> g4_to_custom_id_{};
+        // Custom parent id of every track, indexed by the custom id which is assigned consecutively
+        std::vector<int> track_id_to_parent_id_{};
+        // Flag for every custom id if the track is to be stored once it is provided via #storeTrackInfo
+        std::vector<bool> to_store_track_ids_;
+        // Flag for every custom id if the track has not been stored because it is below the energy threshold
+        std::vector<bool> below_threshold_track_ids_;
         // The TrackInfoG4 instances which are handed over to this track manager
         std::vector<std::unique_ptr<TrackInfoG4>> stored_track_infos_;
         // The MCTrack vector which is dispatched via #dispatchMessage
         std::vector<MCTrack> stored_tracks_;
         // Ids ins same order as tracks stored in #stored_tracks_
         std::vector<int> stored_track_ids_;
-        // Id to index in #stored_tracks_ for easier handling
-        std::map<int, MCTrack const*> id_to_track_;
+        // Pointer to the track in #stored_tracks_ for every custom id, nullptr if the track is not stored
+        std::vector<MCTrack const*> id_to_track_;
     };
 } // namespace allpix
 #endif /* TrackInfoManager_H */
@@ -0,0 +1,377 @@
+/**
+ * @file
+ * @brief Implementation of a module to deposit charges by resampling a library of pre-simulated deposition patterns
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "DepositionLibraryModule.hpp"
+
+#include <cmath>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <Math/RotationZ.h>
+#include <TBranch.h>
+#include <TFile.h>
+#include <TObjArray.h>
+#include <TTree.h>
+
+#include "core/utils/log.h"
+#include "objects/DepositedCharge.hpp"
+#include "objects/MCParticle.hpp"
+#include "objects/MCTrack.hpp"
+
+using namespace allpix;
+
+namespace {
+    /**
+     * @brief Find the bin closest to a given bin index
+     * @param bins Non-empty map of bins
+     * @param index Index of the requested bin
+     * @return Iterator to the closest available bin
+     */
+    template <typename T>
+    typename std::map<long, T>::const_iterator find_closest(const std::map<long, T>& bins, long index) {
+        auto upper = bins.lower_bound(index);
+        if(upper == bins.begin()) {
+            return upper;
+        }
+        auto lower = std::prev(upper);
+        if(upper == bins.end() || index - lower->first <= upper->first - index) {
+            return lower;
+        }
+        return upper;
+    }
+} // namespace
+
+DepositionLibraryModule::DepositionLibraryModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager)
+    : Module(config), geo_manager_(geo_manager), messenger_(messenger) {
+
+    // Seed the random generator for the selection of patterns with the seed received
+    random_generator_.seed(getRandomSeed());
+    // The state of the random generator and the statistics are stored in checkpoints
+    enable_checkpoints();
+
+    config_.setDefault<double>("energy_bin_width", Units::get(1, "keV"));
+    config_.setDefault<double>("angle_bin_width", Units::get(1, "deg"));
+    config_.setDefault<double>("beam_size", 0);
+
+    energy_bin_width_ = config_.get<double>("energy_bin_width");
+    if(energy_bin_width_ <= 0) {
+        throw InvalidValueError(config_, "energy_bin_width", "bin width has to be positive");
+    }
+    angle_bin_width_ = config_.get<double>("angle_bin_width");
+    if(angle_bin_width_ <= 0) {
+        throw InvalidValueError(config_, "angle_bin_width", "bin width has to be positive");
+    }
+
+    source_position_ = config_.get<ROOT::Math::XYZPoint>("source_position");
+    beam_direction_ = config_.get<ROOT::Math::XYZVector>("beam_direction");
+    if(beam_direction_.Mag2() == 0) {
+        throw InvalidValueError(config_, "beam_direction", "beam direction cannot be a null vector");
+    }
+    beam_direction_ = beam_direction_.Unit();
+    beam_size_ = config_.get<double>("beam_size");
+    mc_truth_ = getMCTruthLevel();
+}
+
+void DepositionLibraryModule::init() {
+    // Build the library from all input files
+    auto files = config_.getPathArray("library_files", true);
+    size_t patterns = 0;
+    for(auto& file : files) {
+        auto added = read_library(file);
+        LOG(DEBUG) << "Added " << added << " deposition patterns from file " << file;
+        patterns += added;
+    }
+    if(patterns == 0) {
+        throw InvalidValueError(config_, "library_files", "files do not contain any deposition pattern");
+    }
+    LOG(INFO) << "Built library of " << patterns << " deposition patterns for " << library_.size()
+              << " particle types from " << files.size() << " files";
+
+    // Select the particle type of the source, no need to configure it if the library only holds one type
+    if(library_.size() == 1) {
+        config_.setDefault<int>("particle_code", library_.begin()->first);
+    }
+    particle_code_ = config_.get<int>("particle_code");
+    auto particle = library_.find(particle_code_);
+    if(particle == library_.end()) {
+        throw InvalidValueError(config_, "particle_code", "library does not contain patterns for this particle type");
+    }
+
+    // Select the energy bin of the source, falling back to the closest energy available in the library
+    if(particle->second.size() == 1) {
+        config_.setDefault<double>("source_energy",
+                                   static_cast<double>(particle->second.begin()->first) * energy_bin_width_);
+    }
+    auto energy = config_.get<double>("source_energy");
+    auto energy_bin = std::lround(energy / energy_bin_width_);
+    auto closest = find_closest(particle->second, energy_bin);
+    if(closest->first != energy_bin) {
+        LOG(WARNING) << "Library does not contain patterns for energy " << Units::display(energy, {"keV", "MeV", "GeV"})
+                     << ", using closest energy "
+                     << Units::display(static_cast<double>(closest->first) * energy_bin_width_, {"keV", "MeV", "GeV"});
+    }
+    source_patterns_ = &closest->second;
+
+    size_t source_count = 0;
+    for(auto& bin : *source_patterns_) {
+        source_count += bin.second.size();
+    }
+    LOG(INFO) << "Selected " << source_count << " patterns in " << source_patterns_->size()
+              << " incidence angle bins for particle " << particle_code_;
+}
+
+/**
+ * The deposits of every detector branch are stored relative to the entry point of the primary particle of the event in this
+ * sensor. The patterns are mirrored such that the track always points towards positive local z and rotated around the
+ * sensor normal such that it points along the local x axis. Secondary particles created inside the sensor, such as delta
+ * rays, are part of the pattern.
+ */
+size_t DepositionLibraryModule::read_library(const std::string& file_name) {
+    auto input_file = std::make_unique<TFile>(file_name.c_str(), "READ");
+    if(!input_file->IsOpen()) {
+        throw InvalidValueError(config_, "library_files", "could not open library file " + file_name);
+    }
+
+    TTree* deposit_tree = nullptr;
+    TTree* particle_tree = nullptr;
+    TTree* track_tree = nullptr;
+    input_file->GetObject("DepositedCharge", deposit_tree);
+    input_file->GetObject("MCParticle", particle_tree);
+    input_file->GetObject("MCTrack", track_tree);
+    if(deposit_tree == nullptr || particle_tree == nullptr) {
+        throw InvalidValueError(config_,
+                                "library_files",
+                                "library file " + file_name + " does not contain DepositedCharge and MCParticle objects");
+    }
+    if(track_tree == nullptr) {
+        LOG(WARNING) << "Library file " << file_name
+                     << " does not contain MCTrack objects, all patterns are assigned to zero kinetic energy";
+    }
+
+    // Bind branches to object vectors, the deque keeps the addresses passed to ROOT stable
+    std::deque<std::vector<Object*>*> buffers;
+    auto bind = [&](TBranch* branch) {
+        buffers.push_back(new std::vector<Object*>());
+        branch->SetAddress(&buffers.back());
+        return &buffers.back();
+    };
+
+    // Pair the branches of the same detector, tracks are only read to resolve the references of the particles
+    std::vector<std::pair<std::vector<Object*>**, std::vector<Object*>**>> sensors;
+    TObjArray* branches = particle_tree->GetListOfBranches();
+    for(int i = 0; i < branches->GetEntries(); i++) {
+        auto* particle_branch = static_cast<TBranch*>(branches->At(i));
+        auto* deposit_branch = deposit_tree->GetBranch(particle_branch->GetName());
+        if(deposit_branch == nullptr) {
+            LOG(TRACE) << "Ignoring branch " << particle_branch->GetName() << " without deposits";
+            continue;
+        }
+        sensors.emplace_back(bind(particle_branch), bind(deposit_branch));
+    }
+    if(track_tree != nullptr) {
+        TObjArray* track_branches = track_tree->GetListOfBranches();
+        for(int i = 0; i < track_branches->GetEntries(); i++) {
+            bind(static_cast<TBranch*>(track_branches->At(i)));
+        }
+    }
+
+    size_t patterns = 0;
+    for(Long64_t entry = 0; entry < particle_tree->GetEntries(); ++entry) {
+        if(track_tree != nullptr) {
+            track_tree->GetEntry(entry);
+        }
+        particle_tree->GetEntry(entry);
+        deposit_tree->GetEntry(entry);
+
+        for(auto& sensor : sensors) {
+            // Select the primary particle, preferring particles of primary tracks and long paths through the sensor
+            auto rank = [](const MCParticle* candidate) {
+                auto track = candidate->getTrack();
+                return std::make_pair(track != nullptr && track->getParent() == nullptr,
+                                      (candidate->getLocalEndPoint() - candidate->getLocalStartPoint()).Mag2());
+            };
+            const MCParticle* primary = nullptr;
+            for(auto* object : **sensor.first) {
+                auto* particle = static_cast<MCParticle*>(object);
+                if(particle->getParent() == nullptr && (primary == nullptr || rank(particle) > rank(primary))) {
+                    primary = particle;
+                }
+            }
+            if(primary == nullptr) {
+                continue;
+            }
+
+            auto start = primary->getLocalStartPoint();
+            auto direction = primary->getLocalEndPoint() - start;
+            if(direction.Mag2() == 0) {
+                LOG(TRACE) << "Ignoring pattern of event " << (entry + 1) << " without primary track direction";
+                continue;
+            }
+            direction = direction.Unit();
+            auto theta = std::acos(std::fabs(direction.z()));
+            ROOT::Math::RotationZ rotation(-std::atan2(direction.y(), direction.x()));
+
+            Pattern pattern;
+            pattern.reserve((*sensor.second)->size());
+            for(auto* object : **sensor.second) {
+                auto* deposit = static_cast<DepositedCharge*>(object);
+                auto offset = deposit->getLocalPosition() - start;
+                if(direction.z() < 0) {
+                    offset.SetZ(-offset.z());
+                }
+                pattern.push_back({rotation(offset),
+                                   deposit->getType(),
+                                   deposit->getCharge(),
+                                   deposit->getEventTime() - primary->getTime()});
+            }
+
+            auto track = primary->getTrack();
+            auto energy = (track != nullptr ? track->getKineticEnergyInitial() : 0.);
+            auto& energy_bins = library_[primary->getParticleID()];
+            auto& angle_bins = energy_bins[std::lround(energy / energy_bin_width_)];
+            angle_bins[std::lround(theta / angle_bin_width_)].push_back(std::move(pattern));
+            ++patterns;
+        }
+    }
+
+    // Release the buffers before the trees are closed together with the file
+    deposit_tree->ResetBranchAddresses();
+    particle_tree->ResetBranchAddresses();
+    if(track_tree != nullptr) {
+        track_tree->ResetBranchAddresses();
+    }
+    for(auto* buffer : buffers) {
+        delete buffer;
+    }
+    input_file->Close();
+
+    return patterns;
+}
+
+const DepositionLibraryModule::Pattern& DepositionLibraryModule::draw_pattern(double theta) {
+    auto& patterns = find_closest(*source_patterns_, std::lround(theta / angle_bin_width_))->second;
+    std::uniform_int_distribution<size_t> index(0, patterns.size() - 1);
+    return patterns[index(random_generator_)];
+}
+
+/**
+ * The track is approximated as a straight line through all detectors, scattering between the sensors is neglected. Its entry
+ * point into every sensor is calculated from the intersection with the sensor surface facing the source, and deposits of the
+ * drawn pattern falling outside the sensor are discarded.
+ */
+void DepositionLibraryModule::run(unsigned int) {
+    // Smear the source position transverse to the beam direction
+    auto position = source_position_;
+    if(beam_size_ > 0) {
+        auto axis = (std::fabs(beam_direction_.x()) < 0.9 ? ROOT::Math::XYZVector(1, 0, 0) : ROOT::Math::XYZVector(0, 1, 0));
+        auto first = beam_direction_.Cross(axis).Unit();
+        auto second = beam_direction_.Cross(first);
+        std::normal_distribution<double> smearing(0, beam_size_);
+        position += smearing(random_generator_) * first + smearing(random_generator_) * second;
+    }
+
+    auto speed_of_light = Units::get(299.792458, "mm/ns");
+    for(auto& detector : geo_manager_->getDetectors()) {
+        auto model = detector->getModel();
+
+        // Track in local coordinates of the detector
+        auto origin = detector->getLocalPosition(position);
+        auto direction = (detector->getLocalPosition(position + beam_direction_) - origin).Unit();
+        if(std::fabs(direction.z()) < std::numeric_limits<double>::epsilon()) {
+            continue;
+        }
+
+        // Intersections with the sensor surfaces facing towards and away from the source
+        auto sign = (direction.z() > 0 ? 1. : -1.);
+        auto sensor_z = model->getSensorCenter().z();
+        auto half_thickness = model->getSensorSize().z() / 2;
+        auto distance_entry = (sensor_z - sign * half_thickness - origin.z()) / direction.z();
+        auto distance_exit = (sensor_z + sign * half_thickness - origin.z()) / direction.z();
+        if(distance_exit < 0) {
+            continue;
+        }
+        auto entry = origin + distance_entry * direction;
+        auto exit = origin + distance_exit * direction;
+        if(!detector->isWithinSensor(entry + (exit - entry) / 2)) {
+            LOG(TRACE) << "Track does not cross the sensor of detector " << detector->getName();
+            continue;
+        }
+
+        auto theta = std::acos(std::fabs(direction.z()));
+        auto time = distance_entry / speed_of_light;
+        const auto& pattern = draw_pattern(theta);
+        ++patterns_used_;
+
+        // Transform the pattern into the sensor
+        ROOT::Math::RotationZ rotation(std::atan2(direction.y(), direction.x()));
+        std::vector<ROOT::Math::XYZPoint> positions_local;
+        std::vector<const Deposit*> deposits;
+        positions_local.reserve(pattern.size());
+        deposits.reserve(pattern.size());
+        for(const auto& deposit : pattern) {
+            auto offset = rotation(deposit.offset);
+            offset.SetZ(sign * offset.z());
+            auto position_local = entry + offset;
+            if(!detector->isWithinSensor(position_local)) {
+                ++deposits_outside_;
+                continue;
+            }
+            positions_local.push_back(position_local);
+            deposits.push_back(&deposit);
+        }
+        // Global positions are only calculated on demand
+        const auto& local_to_global = detector->getLocalToGlobalTransform();
+
+        // Dispatch the particle first, such that the deposits can refer to the object held by the message. The particle is
+        // primary and therefore linked and dispatched unless no history is stored.
+        const MCParticle* mcparticle = nullptr;
+        if(mc_truth_ != MCTruthLevel::NONE) {
+            std::vector<MCParticle> mcparticles;
+            mcparticles.emplace_back(entry, exit, local_to_global, particle_code_, time);
+            auto mcparticle_message = std::make_shared<MCParticleMessage>(std::move(mcparticles), detector);
+            messenger_->dispatchMessage(this, mcparticle_message);
+            mcparticle = &mcparticle_message->getData().front();
+        }
+
+        std::vector<DepositedCharge> charges;
+        charges.reserve(deposits.size());
+        for(size_t i = 0; i < deposits.size(); ++i) {
+            charges.emplace_back(positions_local[i],
+                                 local_to_global,
+                                 deposits[i]->type,
+                                 deposits[i]->charge,
+                                 time + deposits[i]->time,
+                                 mcparticle);
+        }
+        deposits_created_ += charges.size();
+
+        LOG(DEBUG) << "Resampled pattern with " << charges.size() << " deposits for track entering detector "
+                   << detector->getName() << " at " << Units::display(entry, {"mm", "um"}) << " under "
+                   << Units::display(theta, "deg");
+        auto deposit_message = std::make_shared<DepositedChargeMessage>(std::move(charges), detector);
+        messenger_->dispatchMessage(this, deposit_message);
+    }
+}
+
+void DepositionLibraryModule::finalize() {
+    LOG(INFO) << "Resampled " << patterns_used_ << " patterns with " << deposits_created_ << " deposits, discarded "
+              << deposits_outside_ << " deposits outside the sensors";
+}
+
+void DepositionLibraryModule::storeState(std::ostream& state) {
+    state << random_generator_ << " " << patterns_used_ << " " << deposits_created_ << " " << deposits_outside_;
+}
+
+void DepositionLibraryModule::restoreState(std::istream& state) {
+    state >> random_generator_ >> patterns_used_ >> deposits_created_ >> deposits_outside_;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file
+ * @brief Definition of a module to deposit charges by resampling a library of pre-simulated deposition patterns
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Math/Point3D.h>
+#include <Math/Vector3D.h>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Module.hpp"
+#include "objects/SensorCharge.hpp"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to deposit charges by resampling a library of pre-simulated deposition patterns
+     *
+     * The library is built from data files written by the ROOTObjectWriter module for simulations with the
+     * DepositionGeant4 module. The deposits of every event are stored relative to the entry point of the primary particle,
+     * binned by particle type, kinetic energy and incidence angle. During the run, a pattern of the matching bin is drawn
+     * for every detector crossed by the straight track of the configured source, rotated to the azimuth of the track and
+     * translated to its entry point.
+     */
+    class DepositionLibraryModule : public Module {
+        /**
+         * @brief Charge deposit of a pattern, relative to the entry point and arrival time of the primary particle
+         */
+        struct Deposit {
+            ROOT::Math::XYZVector offset;
+            CarrierType type;
+            unsigned int charge;
+            double time;
+        };
+
+        /**
+         * @brief Deposits of a single pre-simulated event in one sensor
+         */
+        using Pattern = std::vector<Deposit>;
+
+        /**
+         * @brief Patterns of one particle type and energy, indexed by the incidence angle bin
+         */
+        using AngleBins = std::map<long, std::vector<Pattern>>;
+
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_manager Pointer to the geometry manager, containing the detectors
+         */
+        DepositionLibraryModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
+
+        /**
+         * @brief Build the library from the input files and select the patterns of the configured source
+         */
+        void init() override;
+
+        /**
+         * @brief Resample deposition patterns for all detectors crossed by the track of this event
+         */
+        void run(unsigned int) override;
+
+        /**
+         * @brief Print statistics of the resampled patterns
+         */
+        void finalize() override;
+
+        /**
+         * @brief Store the state of the random number generator and the resampling statistics in a checkpoint
+         */
+        void storeState(std::ostream& state) override;
+
+        /**
+         * @brief Restore the state of the random number generator and the resampling statistics from a checkpoint
+         */
+        void restoreState(std::istream& state) override;
+
+    private:
+        /**
+         * @brief Add the patterns of all events stored in a data file to the library
+         * @param file_name Path to the data file
+         * @return Number of patterns added
+         */
+        size_t read_library(const std::string& file_name);
+
+        /**
+         * @brief Draw a random pattern from the angle bin of the source closest to a given incidence angle
+         * @param theta Incidence angle with respect to the sensor normal
+         * @return Reference to the pattern
+         */
+        const Pattern& draw_pattern(double theta);
+
+        GeometryManager* geo_manager_;
+        Messenger* messenger_;
+
+        std::mt19937_64 random_generator_;
+
+        // Library binned by particle code, kinetic energy bin and incidence angle bin
+        std::map<int, std::map<long, AngleBins>> library_;
+        double energy_bin_width_{};
+        double angle_bin_width_{};
+
+        // Source configuration and selected part of the library
+        int particle_code_{};
+        ROOT::Math::XYZPoint source_position_;
+        ROOT::Math::XYZVector beam_direction_;
+        double beam_size_{};
+        const AngleBins* source_patterns_{nullptr};
+        MCTruthLevel mc_truth_{};
+
+        // Statistics
+        unsigned long patterns_used_{};
+        unsigned long deposits_created_{};
+        unsigned long deposits_outside_{};
+    };
+} // namespace allpix
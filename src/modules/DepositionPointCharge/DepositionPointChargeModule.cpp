@@ -27,6 +27,9 @@ DepositionPointChargeModule::DepositionPointChargeModule(Configuration& config,
 
     // Seed the random generator with the global seed
     random_generator_.seed(getRandomSeed());
+    mc_truth_ = getMCTruthLevel();
+    // The state of the random generator is stored in checkpoints
+    enable_checkpoints();
 
     // Set default value for the number of charges deposited
     config_.setDefault("number_of_charges", 1);
@@ -171,23 +174,30 @@ void DepositionPointChargeModule::DepositPoint(const ROOT::Math::XYZPoint& posit
         return;
     }
 
-    auto position_global = detector_->getGlobalPosition(position);
+    // Global positions are only calculated on demand
+    const auto& local_to_global = detector_->getLocalToGlobalTransform();
 
     // Start and stop position is the same for the MCParticle
-    mcparticles.emplace_back(position, position_global, position, position_global, -1, 0.);
-    LOG(DEBUG) << "Generated MCParticle at global position " << Units::display(position_global, {"um", "mm"})
-               << " in detector " << detector_->getName();
-
-    charges.emplace_back(position, position_global, CarrierType::ELECTRON, carriers_, 0., &(mcparticles.back()));
-    charges.emplace_back(position, position_global, CarrierType::HOLE, carriers_, 0., &(mcparticles.back()));
+    mcparticles.emplace_back(position, position, local_to_global, -1, 0.);
+    LOG(DEBUG) << "Generated MCParticle at global position "
+               << Units::display(mcparticles.back().getGlobalStartPoint(), {"um", "mm"}) << " in detector "
+               << detector_->getName();
+
+    // The particle is primary and therefore linked unless no history is stored
+    const MCParticle* mcparticle = (mc_truth_ != MCTruthLevel::NONE ? &(mcparticles.back()) : nullptr);
+    charges.emplace_back(position, local_to_global, CarrierType::ELECTRON, carriers_, 0., mcparticle);
+    charges.emplace_back(position, local_to_global, CarrierType::HOLE, carriers_, 0., mcparticle);
     LOG(DEBUG) << "Deposited " << carriers_ << " charge carriers of both types at global position "
-               << Units::display(position_global, {"um", "mm"}) << " in detector " << detector_->getName();
+               << Units::display(charges.back().getGlobalPosition(), {"um", "mm"}) << " in detector "
+               << detector_->getName();
 
-    // Dispatch the messages to the framework
+    // Dispatch the messages to the framework, the MCParticle is only part of the stored history
     auto deposit_message = std::make_shared<DepositedChargeMessage>(std::move(charges), detector_);
-    auto mcparticle_message = std::make_shared<MCParticleMessage>(std::move(mcparticles), detector_);
     messenger_->dispatchMessage(this, deposit_message);
-    messenger_->dispatchMessage(this, mcparticle_message);
+    if(mc_truth_ != MCTruthLevel::NONE) {
+        auto mcparticle_message = std::make_shared<MCParticleMessage>(std::move(mcparticles), detector_);
+        messenger_->dispatchMessage(this, mcparticle_message);
+    }
 }
 
 void DepositionPointChargeModule::DepositLine(const ROOT::Math::XYZPoint& position) {
@@ -206,29 +216,44 @@ void DepositionPointChargeModule::DepositLine(const ROOT::Math::XYZPoint& positi
     // Start and end position of MCParticle:
     auto start_local = ROOT::Math::XYZPoint(position.x(), position.y(), -model->getSensorSize().z() / 2.0);
     auto end_local = ROOT::Math::XYZPoint(position.x(), position.y(), model->getSensorSize().z() / 2.0);
-    auto start_global = detector_->getGlobalPosition(start_local);
-    auto end_global = detector_->getGlobalPosition(end_local);
+    // Global positions are only calculated on demand
+    const auto& local_to_global = detector_->getLocalToGlobalTransform();
 
     // Create MCParticle:
-    mcparticles.emplace_back(start_local, start_global, end_local, end_global, -1, 0.);
-    LOG(DEBUG) << "Generated MCParticle with start " << Units::display(start_global, {"um", "mm"}) << " and end "
-               << Units::display(end_global, {"um", "mm"}) << " in detector " << detector_->getName();
+    mcparticles.emplace_back(start_local, end_local, local_to_global, -1, 0.);
+    LOG(DEBUG) << "Generated MCParticle with start "
+               << Units::display(mcparticles.back().getGlobalStartPoint(), {"um", "mm"}) << " and end "
+               << Units::display(mcparticles.back().getGlobalEndPoint(), {"um", "mm"}) << " in detector "
+               << detector_->getName();
 
-    // Deposit the charge carriers:
+    // The particle is primary and therefore linked unless no history is stored
+    const MCParticle* mcparticle = (mc_truth_ != MCTruthLevel::NONE ? &(mcparticles.back()) : nullptr);
+
+    // Deposit the charge carriers at all points along the line:
     auto position_local = start_local;
     while(position_local.z() < model->getSensorSize().z() / 2.0) {
         position_local += ROOT::Math::XYZVector(0, 0, step_size_z_);
-        auto position_global = detector_->getGlobalPosition(position_local);
 
-        charges.emplace_back(position_local, position_global, CarrierType::ELECTRON, carriers_, 0., &(mcparticles.back()));
-        charges.emplace_back(position_local, position_global, CarrierType::HOLE, carriers_, 0., &(mcparticles.back()));
+        charges.emplace_back(position_local, local_to_global, CarrierType::ELECTRON, carriers_, 0., mcparticle);
+        charges.emplace_back(position_local, local_to_global, CarrierType::HOLE, carriers_, 0., mcparticle);
         LOG(TRACE) << "Deposited " << carriers_ << " charge carriers of both types at global position "
-                   << Units::display(position_global, {"um", "mm"}) << " in detector " << detector_->getName();
+                   << Units::display(charges.back().getGlobalPosition(), {"um", "mm"}) << " in detector "
+                   << detector_->getName();
     }
 
-    // Dispatch the messages to the framework
+    // Dispatch the messages to the framework, the MCParticle is only part of the stored history
     auto deposit_message = std::make_shared<DepositedChargeMessage>(std::move(charges), detector_);
-    auto mcparticle_message = std::make_shared<MCParticleMessage>(std::move(mcparticles), detector_);
     messenger_->dispatchMessage(this, deposit_message);
-    messenger_->dispatchMessage(this, mcparticle_message);
+    if(mc_truth_ != MCTruthLevel::NONE) {
+        auto mcparticle_message = std::make_shared<MCParticleMessage>(std::move(mcparticles), detector_);
+        messenger_->dispatchMessage(this, mcparticle_message);
+    }
+}
+
+void DepositionPointChargeModule::storeState(std::ostream& state) {
+    state << random_generator_;
+}
+
+void DepositionPointChargeModule::restoreState(std::istream& state) {
+    state >> random_generator_;
 }
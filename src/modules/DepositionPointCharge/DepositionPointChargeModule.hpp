@@ -57,6 +57,16 @@ namespace allpix {
          */
         void init() override;
 
+        /**
+         * @brief Store the state of the random number generator in a checkpoint
+         */
+        void storeState(std::ostream& state) override;
+
+        /**
+         * @brief Restore the state of the random number generator from a checkpoint
+         */
+        void restoreState(std::istream& state) override;
+
     private:
         /**
          * @brief Helper function to deposit charges at a single point
@@ -81,5 +91,6 @@ namespace allpix {
         ROOT::Math::XYZVector voxel_;
         double step_size_z_{};
         unsigned int root_, carriers_;
+        MCTruthLevel mc_truth_;
     };
 } // namespace allpix
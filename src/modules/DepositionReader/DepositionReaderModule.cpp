@@ -48,11 +48,17 @@ DepositionReaderModule::DepositionReaderModule(Configuration& config, Messenger*
     // Get the creation energy for charge (default is silicon electron hole pair energy)
     charge_creation_energy_ = config_.get<double>("charge_creation_energy");
     fano_factor_ = config_.get<double>("fano_factor");
+    mc_truth_ = getMCTruthLevel();
     volume_chars_ = config_.get<size_t>("detector_name_chars");
 
     unit_length_ = config_.get<std::string>("unit_length");
     unit_time_ = config_.get<std::string>("unit_time");
     unit_energy_ = config_.get<std::string>("unit_energy");
+
+    // Histograms accumulate over the whole run and are not stored in checkpoints
+    if(!config_.get<bool>("output_plots")) {
+        enable_checkpoints();
+    }
 }
 
 void DepositionReaderModule::init() {
@@ -67,6 +73,9 @@ void DepositionReaderModule::init() {
         if(!input_file_->is_open()) {
             throw InvalidValueError(config_, "file_name", "could not open input file");
         }
+        if(resume_position_ >= 0) {
+            input_file_->seekg(resume_position_);
+        }
     } else if(file_model_ == "root") {
         auto file_path = config_.getPathWithExtension("file_name", "root", true);
         input_file_root_ = std::make_unique<TFile>(file_path.c_str(), "READ");
@@ -115,6 +124,11 @@ void DepositionReaderModule::init() {
         check_tree_reader(pdg_code_);
         check_tree_reader(track_id_);
         check_tree_reader(parent_id_);
+
+        // Continue with the entry following the events of the resumed run
+        if(resume_position_ >= 0) {
+            tree_reader_->SetEntry(resume_position_);
+        }
     } else {
         throw InvalidValueError(config_, "model", "only models 'root' and 'csv' are currently supported");
     }
@@ -155,6 +169,7 @@ void DepositionReaderModule::run(unsigned int event) {
     std::map<std::shared_ptr<Detector>, std::vector<MCParticle>> mc_particles;
     std::map<std::shared_ptr<Detector>, std::vector<int>> particles_to_deposits;
     std::map<std::shared_ptr<Detector>, std::map<int, size_t>> track_id_to_mcparticle;
+    std::map<std::shared_ptr<Detector>, std::vector<std::pair<size_t, size_t>>> mcparticle_parents;
 
     LOG(DEBUG) << "Start reading event " << event;
     bool end_of_run = false;
@@ -219,11 +234,11 @@ void DepositionReaderModule::run(unsigned int event) {
                 deposit_position, global_deposit_position, deposit_position, global_deposit_position, pdg_code, time);
             track_id_to_mcparticle[detector][track_id] = (mc_particles[detector].size() - 1);
 
-            // Check if we know the parent - and set it:
+            // Check if we know the parent - and remember it to set it once all particles are known:
             auto parent = track_id_to_mcparticle[detector].find(parent_id);
             if(parent != track_id_to_mcparticle[detector].end()) {
                 LOG(DEBUG) << "Adding parent relation to MCParticle with track id " << parent_id;
-                mc_particles[detector].back().setParent(&mc_particles[detector].at(parent->second));
+                mcparticle_parents[detector].emplace_back(mc_particles[detector].size() - 1, parent->second);
             } else {
                 LOG(DEBUG) << "Parent MCParticle is unknown, parent id " << parent_id;
             }
@@ -246,18 +261,31 @@ void DepositionReaderModule::run(unsigned int event) {
     for(const auto& detector : geo_manager_->getDetectors()) {
         LOG(DEBUG) << "Detector " << detector->getName() << " has " << mc_particles[detector].size() << " MC particles";
 
-        // Send the mc particle information
+        // Link the particles to their parents, the particles are not moved in memory anymore from here on
+        for(auto& relation : mcparticle_parents[detector]) {
+            mc_particles[detector].at(relation.first).setParent(&mc_particles[detector].at(relation.second));
+        }
+
+        // Send the mc particle information unless no history is stored
         auto mc_particle_message = std::make_shared<MCParticleMessage>(std::move(mc_particles[detector]), detector);
-        messenger_->dispatchMessage(this, mc_particle_message);
+        if(mc_truth_ != MCTruthLevel::NONE) {
+            messenger_->dispatchMessage(this, mc_particle_message);
+        }
 
         if(!deposits[detector].empty()) {
             double total_deposits = 0;
 
-            // Assign MCParticles:
+            // Assign MCParticles, only linking primary particles if the full history is not stored:
             for(size_t i = 0; i < deposits[detector].size(); ++i) {
                 total_deposits += deposits[detector].at(i).getCharge();
-                deposits[detector].at(i).setMCParticle(&mc_particle_message->getData().at(
-                    track_id_to_mcparticle[detector].at(particles_to_deposits[detector].at(i))));
+                if(mc_truth_ == MCTruthLevel::NONE) {
+                    continue;
+                }
+                const auto& mc_particle = mc_particle_message->getData().at(
+                    track_id_to_mcparticle[detector].at(particles_to_deposits[detector].at(i)));
+                if(mc_truth_ == MCTruthLevel::FULL || mc_particle.getParent() == nullptr) {
+                    deposits[detector].at(i).setMCParticle(&mc_particle);
+                }
             }
 
             // Create a new charge deposit message
@@ -408,3 +436,21 @@ bool DepositionReaderModule::read_csv(unsigned int event_num,
 
     return true;
 }
+
+/**
+ * The position is the offset of the next line in CSV files and the index of the next entry in ROOT trees. Both already
+ * point to the first deposit of the next event, since the end of an event is only recognized after reading past it.
+ */
+void DepositionReaderModule::storeState(std::ostream& state) {
+    long long position = 0;
+    if(file_model_ == "csv") {
+        position = static_cast<long long>(input_file_->tellg());
+    } else {
+        position = tree_reader_->GetCurrentEntry();
+    }
+    state << random_generator_ << " " << position;
+}
+
+void DepositionReaderModule::restoreState(std::istream& state) {
+    state >> random_generator_ >> resume_position_;
+}
@@ -61,6 +61,16 @@ namespace allpix {
          */
         void finalize() override;
 
+        /**
+         * @brief Store the state of the random number generator and the position in the input file in a checkpoint
+         */
+        void storeState(std::ostream& state) override;
+
+        /**
+         * @brief Restore the state of the random number generator and the position to continue reading the input from
+         */
+        void restoreState(std::istream& state) override;
+
     private:
         // General module members
         GeometryManager* geo_manager_;
@@ -86,8 +96,12 @@ namespace allpix {
         std::shared_ptr<TTreeReaderValue<int>> pdg_code_;
         std::shared_ptr<TTreeReaderValue<int>> track_id_;
         std::shared_ptr<TTreeReaderValue<int>> parent_id_;
+
+        // Position in the input file to continue reading from when resuming a run, negative if not resuming
+        long long resume_position_{-1};
         double charge_creation_energy_;
         double fano_factor_;
+        MCTruthLevel mc_truth_;
 
         std::string file_model_;
         size_t volume_chars_{};
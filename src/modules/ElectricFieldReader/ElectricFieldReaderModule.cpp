@@ -37,6 +37,9 @@ ElectricFieldReaderModule::ElectricFieldReaderModule(Configuration& config, Mess
     if(model == "init" || model == "apf") {
         config_.set("model", "mesh");
     }
+
+    // The field is set up again when a run is continued from a checkpoint
+    enable_checkpoints();
 }
 
 void ElectricFieldReaderModule::init() {
@@ -89,18 +92,21 @@ void ElectricFieldReaderModule::init() {
 
         auto field_data = read_field(thickness_domain, field_scale);
 
-        detector_->setElectricFieldGrid(
-            field_data.getData(), field_data.getDimensions(), field_scale, field_offset, thickness_domain);
+        detector_->setElectricFieldGrid(field_data.getData(),
+                                        field_data.getDimensions(),
+                                        field_scale,
+                                        field_offset,
+                                        thickness_domain,
+                                        field_data.getSymmetry(),
+                                        field_data.getBlocks());
     } else if(field_model == "constant") {
         LOG(TRACE) << "Adding constant electric field";
         type = FieldType::CONSTANT;
 
         auto field_z = config_.get<double>("bias_voltage") / getDetector()->getModel()->getSensorSize().z();
         LOG(INFO) << "Set constant electric field with magnitude " << Units::display(field_z, {"V/um", "V/mm"});
-        FieldFunction<ROOT::Math::XYZVector> function = [field_z](const ROOT::Math::XYZPoint&) {
-            return ROOT::Math::XYZVector(0, 0, -field_z);
-        };
-        detector_->setElectricFieldFunction(function, thickness_domain, type);
+        detector_->setElectricFieldProfile(
+            {{thickness_domain.first, ROOT::Math::XYZVector(0, 0, -field_z)}}, thickness_domain, type);
     } else if(field_model == "linear") {
         LOG(TRACE) << "Adding linear electric field";
         type = FieldType::LINEAR;
@@ -110,8 +116,8 @@ void ElectricFieldReaderModule::init() {
 
         LOG(INFO) << "Setting linear electric field from " << Units::display(config_.get<double>("bias_voltage"), "V")
                   << " bias voltage and " << Units::display(depletion_voltage, "V") << " depletion voltage";
-        FieldFunction<ROOT::Math::XYZVector> function = get_linear_field_function(depletion_voltage, thickness_domain);
-        detector_->setElectricFieldFunction(function, thickness_domain, type);
+        detector_->setElectricFieldProfile(
+            get_linear_field_profile(depletion_voltage, thickness_domain), thickness_domain, type);
     } else {
         throw InvalidValueError(config_, "model", "model should be 'linear', 'constant' or 'init'");
     }
@@ -122,9 +128,13 @@ void ElectricFieldReaderModule::init() {
     }
 }
 
-FieldFunction<ROOT::Math::XYZVector>
-ElectricFieldReaderModule::get_linear_field_function(double depletion_voltage, std::pair<double, double> thickness_domain) {
-    LOG(TRACE) << "Calculating function for the linear electric field.";
+/**
+ * The linear field is clamped at zero outside the depleted region, such that the profile consists of two nodes at the
+ * borders of the thickness domain and an additional node where the field vanishes, if this is within the domain.
+ */
+std::vector<std::pair<double, ROOT::Math::XYZVector>>
+ElectricFieldReaderModule::get_linear_field_profile(double depletion_voltage, std::pair<double, double> thickness_domain) {
+    LOG(TRACE) << "Calculating profile of the linear electric field.";
     // We always deplete from the implants:
     auto bias_voltage = std::fabs(config_.get<double>("bias_voltage"));
     depletion_voltage = std::fabs(depletion_voltage);
@@ -139,15 +149,31 @@ ElectricFieldReaderModule::get_linear_field_function(double depletion_voltage, s
     }
     LOG(TRACE) << "Effective thickness of the electric field: " << Units::display(eff_thickness, {"um", "mm"});
     LOG(DEBUG) << "Depleting the sensor from the " << (deplete_from_implants ? "implant side." : "back side.");
-    return [bias_voltage, depletion_voltage, direction, eff_thickness, thickness_domain, deplete_from_implants](
-               const ROOT::Math::XYZPoint& pos) {
-        double z_rel = thickness_domain.second - pos.z();
-        double field_z = std::max(0.0,
-                                  (bias_voltage - depletion_voltage) / eff_thickness +
-                                      2 * (depletion_voltage / eff_thickness) *
-                                          (deplete_from_implants ? (1 - z_rel / eff_thickness) : z_rel / eff_thickness));
-        return ROOT::Math::XYZVector(0, 0, (direction ? -1 : 1) * field_z);
+
+    // Field magnitude without clamping at zero and field vector for a given magnitude
+    auto field_magnitude = [&](double z) {
+        double z_rel = thickness_domain.second - z;
+        return (bias_voltage - depletion_voltage) / eff_thickness +
+               2 * (depletion_voltage / eff_thickness) *
+                   (deplete_from_implants ? (1 - z_rel / eff_thickness) : z_rel / eff_thickness);
+    };
+    auto field_vector = [direction](double field_z) {
+        return ROOT::Math::XYZVector(0, 0, (direction ? -1 : 1) * std::max(0.0, field_z));
     };
+
+    auto field_low = field_magnitude(thickness_domain.first);
+    auto field_high = field_magnitude(thickness_domain.second);
+    std::vector<std::pair<double, ROOT::Math::XYZVector>> profile;
+    profile.emplace_back(thickness_domain.first, field_vector(field_low));
+    if((field_low < 0) != (field_high < 0)) {
+        auto z_zero = thickness_domain.first +
+                      (thickness_domain.second - thickness_domain.first) * field_low / (field_low - field_high);
+        if(thickness_domain.first < z_zero && z_zero < thickness_domain.second) {
+            profile.emplace_back(z_zero, field_vector(0));
+        }
+    }
+    profile.emplace_back(thickness_domain.second, field_vector(field_high));
+    return profile;
 }
 
 /**
@@ -162,13 +188,21 @@ FieldData<double> ElectricFieldReaderModule::read_field(std::pair<double, double
         LOG(TRACE) << "Fetching electric field from mesh file";
 
         // Get field from file
-        auto field_data = field_parser_.getByFileName(config_.getPath("file_name", true), "V/cm");
+        auto field_data = field_parser_.getByFileName(config_.getPath("file_name", true), "V/cm", getWorkerCount());
 
         // Check if electric field matches chip
         check_detector_match(field_data.getSize(), thickness_domain, field_scale);
 
         LOG(INFO) << "Set electric field with " << field_data.getDimensions().at(0) << "x"
                   << field_data.getDimensions().at(1) << "x" << field_data.getDimensions().at(2) << " cells";
+        if(field_data.getSymmetry() != FieldSymmetry::NONE) {
+            LOG(INFO) << "Electric field is stored folded with " << symmetry_to_string(field_data.getSymmetry())
+                      << " symmetry";
+        }
+        if(field_data.getBlocks().isAdaptive()) {
+            LOG(INFO) << "Electric field is stored with adaptive resolution in blocks of " << field_data.getBlocks().size
+                      << " cells";
+        }
 
         // Return the field data
         return field_data;
@@ -47,11 +47,13 @@ namespace allpix {
         std::shared_ptr<Detector> detector_;
 
         /**
-         * @brief Create and apply a linear field
+         * @brief Create the profile of a linear field along the thickness direction
+         * @param depletion_voltage Voltage at which the sensor is fully depleted
          * @param thickness_domain Domain of the thickness where the field is defined
+         * @return Nodes of the field profile
          */
-        FieldFunction<ROOT::Math::XYZVector> get_linear_field_function(double depletion_voltage,
-                                                                       std::pair<double, double> thickness_domain);
+        std::vector<std::pair<double, ROOT::Math::XYZVector>>
+        get_linear_field_profile(double depletion_voltage, std::pair<double, double> thickness_domain);
 
         /**
          * @brief Read field from a file in init or apf format and apply it
@@ -10,13 +10,16 @@
 
 #include "GenericPropagationModule.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <iomanip>
 #include <limits>
 #include <map>
 #include <memory>
 #include <random>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 
 #include <Eigen/Core>
@@ -94,6 +97,7 @@ GenericPropagationModule::GenericPropagationModule(Configuration& config,
     }
 
     config_.setDefault<bool>("ignore_magnetic_field", false);
+    config_.setDefault<bool>("precompute_velocities", false);
 
     // Copy some variables from configuration to avoid lookups:
     temperature_ = config_.get<double>("temperature");
@@ -107,6 +111,8 @@ GenericPropagationModule::GenericPropagationModule(Configuration& config,
     output_animations_ = config_.get<bool>("output_animations");
     output_plots_step_ = config_.get<double>("output_plots_step");
     output_plots_lines_at_implants_ = config_.get<bool>("output_plots_lines_at_implants");
+    precompute_velocities_ = config_.get<bool>("precompute_velocities");
+    mc_truth_ = getMCTruthLevel();
 
     // Enable parallelization of this module if multithreading is enabled and no per-event output plots are requested:
     if(!(output_animations_ || output_linegraphs_)) {
@@ -128,6 +134,11 @@ GenericPropagationModule::GenericPropagationModule(Configuration& config,
     // http://www.ioffe.ru/SVA/NSM/Semicond/Si/electric.html) FIXME
     electron_Hall_ = 1.15;
     hole_Hall_ = 0.9;
+
+    // Histograms accumulate over the whole run and are not stored in checkpoints
+    if(!output_plots_) {
+        enable_checkpoints();
+    }
 }
 
 void GenericPropagationModule::create_output_plots(unsigned int event_num) {
@@ -509,7 +520,46 @@ void GenericPropagationModule::init() {
             LOG(WARNING) << "A magnetic field is switched on, but is set to be ignored for this module.";
         } else {
             LOG(DEBUG) << "This detector sees a magnetic field.";
-            magnetic_field_ = detector_->getMagneticField();
+            // Constant fields are cached, field grids are looked up at the current position in every integration step
+            magnetic_field_grid_ = (detector_->getMagneticFieldType() == FieldType::GRID);
+            magnetic_field_ = detector_->getMagneticField(model_->getSensorCenter());
+        }
+    }
+
+    // Precompute drift velocity and mobility of the propagated charge carriers from the electric field
+    if(precompute_velocities_) {
+        if(!detector->hasElectricField()) {
+            LOG(WARNING) << "No electric field available, drift velocities are not precomputed";
+            precompute_velocities_ = false;
+        } else if(has_magnetic_field_ && magnetic_field_grid_) {
+            LOG(WARNING) << "Drift velocities cannot be precomputed for magnetic field grids";
+            precompute_velocities_ = false;
+        } else {
+            auto threads = getWorkerCount();
+            auto bfield_mag2 = (has_magnetic_field_ ? magnetic_field_.Mag2() : 0.);
+            for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+                if(!config_.get<bool>(type == CarrierType::ELECTRON ? "propagate_electrons" : "propagate_holes")) {
+                    continue;
+                }
+
+                // In magnetic fields, only the drift along the electric field is stored, the Lorentz terms are added during
+                // propagation from the mobility since they do not commute with the unfolding of symmetric field grids
+                auto hall = (type == CarrierType::ELECTRON ? electron_Hall_ : hole_Hall_);
+                std::function<ROOT::Math::XYZVector(const ROOT::Math::XYZVector&)> velocity =
+                    [this, type, hall, bfield_mag2](const ROOT::Math::XYZVector& efield) {
+                        auto mob = carrier_mobility(type, std::sqrt(efield.Mag2()));
+                        return static_cast<int>(type) * mob * efield / (1 + mob * mob * hall * hall * bfield_mag2);
+                    };
+                std::function<double(const ROOT::Math::XYZVector&)> mobility =
+                    [this, type](const ROOT::Math::XYZVector& efield) {
+                        return carrier_mobility(type, std::sqrt(efield.Mag2()));
+                    };
+
+                velocity_fields_[type] = detector->deriveElectricField<ROOT::Math::XYZVector, 3>(velocity, threads);
+                mobility_fields_[type] = detector->deriveElectricField<double, 1>(mobility, threads);
+                LOG(INFO) << "Precomputed drift velocity and mobility of "
+                          << (type == CarrierType::ELECTRON ? "electrons" : "holes");
+            }
         }
     }
 
@@ -579,10 +629,12 @@ void GenericPropagationModule::run(unsigned int event_num) {
 
             // Add point of deposition to the output plots if requested
             if(output_linegraphs_) {
-                auto global_position = detector_->getGlobalPosition(position);
-                output_plot_points_.emplace_back(
-                    PropagatedCharge(position, global_position, deposit.getType(), charge_per_step, deposit.getEventTime()),
-                    std::vector<ROOT::Math::XYZPoint>());
+                output_plot_points_.emplace_back(PropagatedCharge(position,
+                                                                  detector_->getLocalToGlobalTransform(),
+                                                                  deposit.getType(),
+                                                                  charge_per_step,
+                                                                  deposit.getEventTime()),
+                                                 std::vector<ROOT::Math::XYZPoint>());
             }
 
             // Propagate a single charge deposit
@@ -592,14 +644,14 @@ void GenericPropagationModule::run(unsigned int event_num) {
             LOG(DEBUG) << " Propagated " << charge_per_step << " to " << Units::display(position, {"mm", "um"}) << " in "
                        << Units::display(prop_pair.second, "ns") << " time";
 
-            // Create a new propagated charge and add it to the list
-            auto global_position = detector_->getGlobalPosition(position);
+            // Create a new propagated charge and add it to the list, the global position is only calculated on demand
             PropagatedCharge propagated_charge(position,
-                                               global_position,
+                                               detector_->getLocalToGlobalTransform(),
                                                deposit.getType(),
                                                charge_per_step,
                                                deposit.getEventTime() + prop_pair.second,
-                                               &deposit);
+                                               &deposit,
+                                               mc_truth_ == MCTruthLevel::FULL);
 
             propagated_charges.push_back(std::move(propagated_charge));
 
@@ -634,6 +686,23 @@ void GenericPropagationModule::run(unsigned int event_num) {
     messenger_->dispatchMessage(this, propagated_charge_message);
 }
 
+/**
+ * The mobility is computed from the parameterization of https://doi.org/10.1016/0038-1101(77)90054-5.
+ * NOTE This function is typically the most frequently executed part of the framework and therefore the bottleneck
+ */
+double GenericPropagationModule::carrier_mobility(const CarrierType& type, double efield_mag) const {
+    // Compute carrier mobility from constants and electric field magnitude
+    double numerator, denominator;
+    if(type == CarrierType::ELECTRON) {
+        numerator = electron_Vm_ / electron_Ec_;
+        denominator = std::pow(1. + std::pow(efield_mag / electron_Ec_, electron_Beta_), 1.0 / electron_Beta_);
+    } else {
+        numerator = hole_Vm_ / hole_Ec_;
+        denominator = std::pow(1. + std::pow(efield_mag / hole_Ec_, hole_Beta_), 1.0 / hole_Beta_);
+    }
+    return numerator / denominator;
+}
+
 /**
  * Propagation is simulated using a parameterization for the electron mobility. This is used to calculate the electron
  * velocity at every point with help of the electric field map of the detector. An Runge-Kutta integration is applied in
@@ -644,24 +713,17 @@ std::pair<ROOT::Math::XYZPoint, double> GenericPropagationModule::propagate(cons
     // Create a runge kutta solver using the electric field as step function
     Eigen::Vector3d position(pos.x(), pos.y(), pos.z());
 
-    // Define a lambda function to compute the carrier mobility
-    // NOTE This function is typically the most frequently executed part of the framework and therefore the bottleneck
-    auto carrier_mobility = [&](double efield_mag) {
-        // Compute carrier mobility from constants and electric field magnitude
-        double numerator, denominator;
-        if(type == CarrierType::ELECTRON) {
-            numerator = electron_Vm_ / electron_Ec_;
-            denominator = std::pow(1. + std::pow(efield_mag / electron_Ec_, electron_Beta_), 1.0 / electron_Beta_);
-        } else {
-            numerator = hole_Vm_ / hole_Ec_;
-            denominator = std::pow(1. + std::pow(efield_mag / hole_Ec_, hole_Beta_), 1.0 / hole_Beta_);
-        }
-        return numerator / denominator;
-    };
+    // Precomputed drift velocity and mobility of this carrier type, if available
+    const DetectorField<ROOT::Math::XYZVector, 3>* velocity_field = nullptr;
+    const DetectorField<double, 1>* mobility_field = nullptr;
+    if(precompute_velocities_) {
+        velocity_field = &velocity_fields_.at(type);
+        mobility_field = &mobility_fields_.at(type);
+    }
 
     // Define a function to compute the diffusion
-    auto carrier_diffusion = [&](double efield_mag, double timestep) -> Eigen::Vector3d {
-        double diffusion_constant = boltzmann_kT_ * carrier_mobility(efield_mag);
+    auto carrier_diffusion = [&](double mobility, double timestep) -> Eigen::Vector3d {
+        double diffusion_constant = boltzmann_kT_ * mobility;
         double diffusion_std_dev = std::sqrt(2. * diffusion_constant * timestep);
 
         // Compute the independent diffusion in three
@@ -679,7 +741,7 @@ std::pair<ROOT::Math::XYZPoint, double> GenericPropagationModule::propagate(cons
         auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
         Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
 
-        return static_cast<int>(type) * carrier_mobility(efield.norm()) * efield;
+        return static_cast<int>(type) * carrier_mobility(type, efield.norm()) * efield;
     };
 
     std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_withB =
@@ -687,10 +749,11 @@ std::pair<ROOT::Math::XYZPoint, double> GenericPropagationModule::propagate(cons
         auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
         Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
 
-        Eigen::Vector3d velocity;
-        Eigen::Vector3d bfield(magnetic_field_.x(), magnetic_field_.y(), magnetic_field_.z());
+        auto raw_bfield = (magnetic_field_grid_ ? detector_->getMagneticField(static_cast<ROOT::Math::XYZPoint>(cur_pos))
+                                                : magnetic_field_);
+        Eigen::Vector3d bfield(raw_bfield.x(), raw_bfield.y(), raw_bfield.z());
 
-        auto mob = carrier_mobility(efield.norm());
+        auto mob = carrier_mobility(type, efield.norm());
         auto exb = efield.cross(bfield);
 
         Eigen::Vector3d term1;
@@ -703,10 +766,32 @@ std::pair<ROOT::Math::XYZPoint, double> GenericPropagationModule::propagate(cons
         return static_cast<int>(type) * mob * (efield + term1 + term2) / rnorm;
     };
 
+    // Define lambda functions to read the precomputed velocity, adding the Lorentz terms for a constant magnetic field
+    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_precomputed_noB =
+        [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        auto raw_velocity = velocity_field->get(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        return Eigen::Vector3d(raw_velocity.x(), raw_velocity.y(), raw_velocity.z());
+    };
+
+    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_precomputed_withB =
+        [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        auto raw_velocity = velocity_field->get(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        Eigen::Vector3d drift(raw_velocity.x(), raw_velocity.y(), raw_velocity.z());
+        Eigen::Vector3d bfield(magnetic_field_.x(), magnetic_field_.y(), magnetic_field_.z());
+
+        double hallFactor = (type == CarrierType::ELECTRON ? electron_Hall_ : hole_Hall_);
+        auto hall_mob = hallFactor * mobility_field->get(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        return drift + static_cast<int>(type) * hall_mob * drift.cross(bfield) +
+               hall_mob * hall_mob * drift.dot(bfield) * bfield;
+    };
+
     // Create the runge kutta solver with an RKF5 tableau, using different velocity calculators depending on the magnetic
-    // field
-    auto runge_kutta = make_runge_kutta(
-        tableau::RK5, (has_magnetic_field_ ? carrier_velocity_withB : carrier_velocity_noB), timestep_start_, position);
+    // field and the availability of precomputed velocities
+    auto& carrier_velocity_precomputed =
+        (has_magnetic_field_ ? carrier_velocity_precomputed_withB : carrier_velocity_precomputed_noB);
+    auto& carrier_velocity_direct = (has_magnetic_field_ ? carrier_velocity_withB : carrier_velocity_noB);
+    auto& carrier_velocity = (velocity_field != nullptr ? carrier_velocity_precomputed : carrier_velocity_direct);
+    auto runge_kutta = make_runge_kutta(tableau::RK5, carrier_velocity, timestep_start_, position);
 
     // Continue propagation until the deposit is outside the sensor
     Eigen::Vector3d last_position = position;
@@ -734,11 +819,22 @@ std::pair<ROOT::Math::XYZPoint, double> GenericPropagationModule::propagate(cons
         auto timestep = runge_kutta.getTimeStep();
         position = runge_kutta.getValue();
 
-        // Get electric field at current position and fall back to empty field if it does not exist
-        auto efield = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(position));
+        // Get mobility at current position, either precomputed or from the electric field
+        double mobility = 0;
+        if(mobility_field != nullptr) {
+            // Outside the domain of the field the grid returns zero, where the zero-field mobility applies
+            mobility = mobility_field->get(static_cast<ROOT::Math::XYZPoint>(position));
+            if(mobility <= 0) {
+                mobility = carrier_mobility(type, 0);
+            }
+        } else {
+            // Get electric field at current position and fall back to empty field if it does not exist
+            auto efield = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(position));
+            mobility = carrier_mobility(type, std::sqrt(efield.Mag2()));
+        }
 
         // Apply diffusion step
-        auto diffusion = carrier_diffusion(std::sqrt(efield.Mag2()), timestep);
+        auto diffusion = carrier_diffusion(mobility, timestep);
         position += diffusion;
         runge_kutta.setValue(position);
 
@@ -813,3 +909,13 @@ void GenericPropagationModule::finalize() {
     LOG(INFO) << "Propagated total of " << total_propagated_charges_ << " charges in " << total_steps_
               << " steps in average time of " << Units::display(average_time, "ns");
 }
+
+void GenericPropagationModule::storeState(std::ostream& state) {
+    // Store the accumulated time at full precision to reproduce the statistics of an uninterrupted run
+    state << std::setprecision(std::numeric_limits<long double>::max_digits10);
+    state << random_generator_ << " " << total_propagated_charges_ << " " << total_steps_ << " " << total_time_;
+}
+
+void GenericPropagationModule::restoreState(std::istream& state) {
+    state >> random_generator_ >> total_propagated_charges_ >> total_steps_ >> total_time_;
+}
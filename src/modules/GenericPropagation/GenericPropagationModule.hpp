@@ -7,6 +7,7 @@
  * Intergovernmental Organization or submit itself to any jurisdiction.
  */
 
+#include <map>
 #include <memory>
 #include <random>
 #include <string>
@@ -17,6 +18,7 @@
 #include <TH1D.h>
 
 #include "core/config/Configuration.hpp"
+#include "core/geometry/DetectorField.hpp"
 #include "core/geometry/DetectorModel.hpp"
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Module.hpp"
@@ -60,6 +62,16 @@ namespace allpix {
          */
         void finalize() override;
 
+        /**
+         * @brief Store the state of the random number generator and the propagation statistics in a checkpoint
+         */
+        void storeState(std::ostream& state) override;
+
+        /**
+         * @brief Restore the state of the random number generator and the propagation statistics from a checkpoint
+         */
+        void restoreState(std::istream& state) override;
+
     private:
         Messenger* messenger_;
         std::shared_ptr<const Detector> detector_;
@@ -79,6 +91,14 @@ namespace allpix {
          */
         std::pair<ROOT::Math::XYZPoint, double> propagate(const ROOT::Math::XYZPoint& pos, const CarrierType& type);
 
+        /**
+         * @brief Compute the mobility of a charge carrier from the magnitude of the electric field
+         * @param type Type of the charge carrier
+         * @param efield_mag Magnitude of the electric field
+         * @return Mobility of the charge carrier
+         */
+        double carrier_mobility(const CarrierType& type, double efield_mag) const;
+
         // Random generator for this module
         std::mt19937_64 random_generator_;
 
@@ -86,6 +106,7 @@ namespace allpix {
         double temperature_{}, timestep_min_{}, timestep_max_{}, timestep_start_{}, integration_time_{},
             target_spatial_precision_{}, output_plots_step_{};
         bool output_plots_{}, output_linegraphs_{}, output_animations_{}, output_plots_lines_at_implants_{};
+        MCTruthLevel mc_truth_{};
 
         // Precalculated values for electron and hole mobility
         double electron_Vm_;
@@ -104,8 +125,14 @@ namespace allpix {
 
         // Magnetic field
         bool has_magnetic_field_;
+        bool magnetic_field_grid_{};
         ROOT::Math::XYZVector magnetic_field_;
 
+        // Drift velocity and mobility of the propagated charge carriers precomputed from the electric field
+        bool precompute_velocities_{};
+        std::map<CarrierType, DetectorField<ROOT::Math::XYZVector, 3>> velocity_fields_;
+        std::map<CarrierType, DetectorField<double, 1>> mobility_fields_;
+
         // Deposits for the bound detector in this event
         std::shared_ptr<DepositedChargeMessage> deposits_message_;
 
@@ -265,9 +265,23 @@ void DetectorConstructionG4::build(std::map<std::string, G4Material*> materials_
                                                          bump_height / 2.);
             solids_.push_back(bump_box);
 
+            // Fill the bump layer with the average material of bumps and surroundings if no individual bumps are placed
+            auto exact_bumps = (hybrid_model->getBumpGeometry() == HybridPixelDetectorModel::BumpGeometry::EXACT);
+            G4Material* bumps_material = materials_["world_material"];
+            if(!exact_bumps) {
+                auto fill_fraction = hybrid_model->getBumpFillFraction();
+                auto solder_density = fill_fraction * materials_["solder"]->GetDensity();
+                auto density = solder_density + (1 - fill_fraction) * materials_["world_material"]->GetDensity();
+                bumps_material = new G4Material("bumps_" + name + "_material", density, 2);
+                bumps_material->AddMaterial(materials_["solder"], solder_density / density);
+                bumps_material->AddMaterial(materials_["world_material"], 1 - solder_density / density);
+                LOG(DEBUG) << "  Homogeneous bump layer with " << (100 * fill_fraction) << "% solder, density "
+                           << density / (CLHEP::g / CLHEP::cm3) << "g/cm3";
+            }
+
             // Create the logical wrapper volume
             auto bumps_wrapper_log = make_shared_no_delete<G4LogicalVolume>(
-                bump_box.get(), materials_["world_material"], "bumps_wrapper_" + name + "_log");
+                bump_box.get(), bumps_material, "bumps_wrapper_" + name + "_log");
             geo_manager_->setExternalObject(name, "bumps_wrapper_log", bumps_wrapper_log);
 
             // Place the general bumps volume
@@ -283,42 +297,44 @@ void DetectorConstructionG4::build(std::map<std::string, G4Material*> materials_
                                                                            true);
             geo_manager_->setExternalObject(name, "bumps_wrapper_phys", bumps_wrapper_phys);
 
-            // Create the individual bump solid
-            auto bump_sphere = make_shared_no_delete<G4Sphere>(
-                "bumps_" + name + "_sphere", 0, bump_sphere_radius, 0, 360 * CLHEP::deg, 0, 360 * CLHEP::deg);
-            solids_.push_back(bump_sphere);
-            auto bump_tube = make_shared_no_delete<G4Tubs>(
-                "bumps_" + name + "_tube", 0., bump_cylinder_radius, bump_height / 2., 0., 360 * CLHEP::deg);
-            solids_.push_back(bump_tube);
-            auto bump = make_shared_no_delete<G4UnionSolid>("bumps_" + name, bump_sphere.get(), bump_tube.get());
-            solids_.push_back(bump);
-
-            // Create the logical volume for the individual bumps
-            auto bumps_cell_log =
-                make_shared_no_delete<G4LogicalVolume>(bump.get(), materials_["solder"], "bumps_" + name + "_log");
-            geo_manager_->setExternalObject(name, "bumps_cell_log", bumps_cell_log);
-
-            // Place the bump bonds grid
-            std::shared_ptr<G4VPVParameterisation> bumps_param = std::make_shared<Parameterization2DG4>(
-                hybrid_model->getNPixels().x(),
-                hybrid_model->getPixelSize().x(),
-                hybrid_model->getPixelSize().y(),
-                -(hybrid_model->getNPixels().x() * hybrid_model->getPixelSize().x()) / 2.0 +
-                    (hybrid_model->getBumpsCenter().x() - hybrid_model->getCenter().x()),
-                -(hybrid_model->getNPixels().y() * hybrid_model->getPixelSize().y()) / 2.0 +
-                    (hybrid_model->getBumpsCenter().y() - hybrid_model->getCenter().y()),
-                0);
-            geo_manager_->setExternalObject(name, "bumps_param", bumps_param);
-
-            std::shared_ptr<G4PVParameterised> bumps_param_phys =
-                std::make_shared<ParameterisedG4>("bumps_" + name + "_phys",
-                                                  bumps_cell_log.get(),
-                                                  bumps_wrapper_log.get(),
-                                                  kUndefined,
-                                                  hybrid_model->getNPixels().x() * hybrid_model->getNPixels().y(),
-                                                  bumps_param.get(),
-                                                  false);
-            geo_manager_->setExternalObject(name, "bumps_param_phys", bumps_param_phys);
+            if(exact_bumps) {
+                // Create the individual bump solid
+                auto bump_sphere = make_shared_no_delete<G4Sphere>(
+                    "bumps_" + name + "_sphere", 0, bump_sphere_radius, 0, 360 * CLHEP::deg, 0, 360 * CLHEP::deg);
+                solids_.push_back(bump_sphere);
+                auto bump_tube = make_shared_no_delete<G4Tubs>(
+                    "bumps_" + name + "_tube", 0., bump_cylinder_radius, bump_height / 2., 0., 360 * CLHEP::deg);
+                solids_.push_back(bump_tube);
+                auto bump = make_shared_no_delete<G4UnionSolid>("bumps_" + name, bump_sphere.get(), bump_tube.get());
+                solids_.push_back(bump);
+
+                // Create the logical volume for the individual bumps
+                auto bumps_cell_log =
+                    make_shared_no_delete<G4LogicalVolume>(bump.get(), materials_["solder"], "bumps_" + name + "_log");
+                geo_manager_->setExternalObject(name, "bumps_cell_log", bumps_cell_log);
+
+                // Place the bump bonds grid
+                std::shared_ptr<G4VPVParameterisation> bumps_param = std::make_shared<Parameterization2DG4>(
+                    hybrid_model->getNPixels().x(),
+                    hybrid_model->getPixelSize().x(),
+                    hybrid_model->getPixelSize().y(),
+                    -(hybrid_model->getNPixels().x() * hybrid_model->getPixelSize().x()) / 2.0 +
+                        (hybrid_model->getBumpsCenter().x() - hybrid_model->getCenter().x()),
+                    -(hybrid_model->getNPixels().y() * hybrid_model->getPixelSize().y()) / 2.0 +
+                        (hybrid_model->getBumpsCenter().y() - hybrid_model->getCenter().y()),
+                    0);
+                geo_manager_->setExternalObject(name, "bumps_param", bumps_param);
+
+                std::shared_ptr<G4PVParameterised> bumps_param_phys =
+                    std::make_shared<ParameterisedG4>("bumps_" + name + "_phys",
+                                                      bumps_cell_log.get(),
+                                                      bumps_wrapper_log.get(),
+                                                      kUndefined,
+                                                      hybrid_model->getNPixels().x() * hybrid_model->getNPixels().y(),
+                                                      bumps_param.get(),
+                                                      false);
+                geo_manager_->setExternalObject(name, "bumps_param_phys", bumps_param_phys);
+            }
         }
 
         // ALERT: NO COVER LAYER YET
@@ -39,6 +39,9 @@ using namespace ROOT;
 GeometryBuilderGeant4Module::GeometryBuilderGeant4Module(Configuration& config, Messenger*, GeometryManager* geo_manager)
     : Module(config), geo_manager_(geo_manager), run_manager_g4_(nullptr) {
     geometry_construction_ = new GeometryConstructionG4(geo_manager_, config_);
+
+    // The geometry is constructed again when a run is continued from a checkpoint
+    enable_checkpoints();
 }
 
 /**
@@ -9,6 +9,7 @@
 
 #include "InducedTransferModule.hpp"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
@@ -25,14 +26,24 @@ InducedTransferModule::InducedTransferModule(Configuration& config,
     using XYVectorInt = DisplacementVector2D<Cartesian2D<int>>;
     // Enable parallelization of this module if multithreading is enabled
     enable_parallelization();
+    // No state is kept across events, such that runs can be continued from checkpoints
+    enable_checkpoints();
 
     // Save detector model
     model_ = detector_->getModel();
 
     // Set default value for config variables and store value
     config_.setDefault<XYVectorInt>("induction_matrix", XYVectorInt(3, 3));
+    config_.setDefault<bool>("precompute_weighting_potential", false);
+    config_.setDefaultArray<size_t>("weighting_potential_bins", {50, 50, 100});
     matrix_ = config_.get<XYVectorInt>("induction_matrix");
 
+    // The start position of every charge carrier is taken from the deposited charge it originates from
+    if(getMCTruthLevel() != MCTruthLevel::FULL) {
+        throw ModuleError("Module requires the link of propagated charges to their deposited charges, which is only "
+                          "available if the Monte-Carlo truth is stored at level 'full'");
+    }
+
     // Require propagated deposits for single detector
     messenger_->bindSingle(this, &InducedTransferModule::propagated_message_, MsgFlags::REQUIRED);
 }
@@ -43,6 +54,24 @@ void InducedTransferModule::init() {
     if(!detector_->hasWeightingPotential()) {
         throw ModuleError("This module requires a weighting potential.");
     }
+
+    // Tabulate the weighting potential of the induction matrix to look up all pixels at once
+    if(config_.get<bool>("precompute_weighting_potential")) {
+        auto bins = config_.getArray<size_t>("weighting_potential_bins");
+        if(bins.size() != 3 || std::find(bins.begin(), bins.end(), static_cast<size_t>(0)) != bins.end()) {
+            throw InvalidValueError(
+                config_, "weighting_potential_bins", "three non-zero numbers of bins in x, y and z required");
+        }
+        auto threads = getWorkerCount();
+        try {
+            weighting_potential_ = detector_->tabulateWeightingPotential(
+                {{matrix_.x(), matrix_.y()}}, {{bins[0], bins[1], bins[2]}}, threads);
+        } catch(std::invalid_argument& e) {
+            throw InvalidValueError(config_, "induction_matrix", e.what());
+        }
+        LOG(INFO) << "Precomputed weighting potential for induction matrix of " << matrix_.x() << "x" << matrix_.y()
+                  << " pixels";
+    }
 }
 
 void InducedTransferModule::run(unsigned int) {
@@ -67,13 +96,23 @@ void InducedTransferModule::run(unsigned int) {
         auto position_start = deposited_charge->getLocalPosition();
 
         // Find the nearest pixel
-        auto xpixel = static_cast<int>(std::round(position_end.x() / model_->getPixelSize().x()));
-        auto ypixel = static_cast<int>(std::round(position_end.y() / model_->getPixelSize().y()));
+        auto nearest_pixel = detector_->getPixelIndex(position_end);
+        auto xpixel = nearest_pixel.first;
+        auto ypixel = nearest_pixel.second;
         LOG(TRACE) << "Calculating induced charge from carriers below pixel "
                    << Pixel::Index(static_cast<unsigned int>(xpixel), static_cast<unsigned int>(ypixel)) << ", moved from "
                    << Units::display(position_start, {"um", "mm"}) << " to " << Units::display(position_end, {"um", "mm"})
                    << ", " << Units::display(propagated_charge.getEventTime() - deposited_charge->getEventTime(), "ns");
 
+        // Look up the precomputed weighting potential of all pixels at once, if available. The start position can be in the
+        // cell of a different pixel, then the weighting potential is looked up for every pixel individually.
+        const double* ramo_end_matrix = nullptr;
+        const double* ramo_start_matrix = nullptr;
+        if(weighting_potential_.isValid()) {
+            ramo_end_matrix = weighting_potential_.get(position_end, nearest_pixel);
+            ramo_start_matrix = weighting_potential_.get(position_start, nearest_pixel);
+        }
+
         // Loop over NxN pixels:
         for(int x = xpixel - matrix_.x() / 2; x <= xpixel + matrix_.x() / 2; x++) {
             for(int y = ypixel - matrix_.y() / 2; y <= ypixel + matrix_.y() / 2; y++) {
@@ -84,8 +123,13 @@ void InducedTransferModule::run(unsigned int) {
                 }
 
                 Pixel::Index pixel_index(static_cast<unsigned int>(x), static_cast<unsigned int>(y));
-                auto ramo_end = detector_->getWeightingPotential(position_end, pixel_index);
-                auto ramo_start = detector_->getWeightingPotential(position_start, pixel_index);
+                auto matrix_index =
+                    static_cast<size_t>((x - xpixel + matrix_.x() / 2) * matrix_.y() + (y - ypixel + matrix_.y() / 2));
+                auto ramo_end = (ramo_end_matrix != nullptr ? ramo_end_matrix[matrix_index]
+                                                            : detector_->getWeightingPotential(position_end, pixel_index));
+                auto ramo_start =
+                    (ramo_start_matrix != nullptr ? ramo_start_matrix[matrix_index]
+                                                  : detector_->getWeightingPotential(position_start, pixel_index));
 
                 // Induced charge on electrode is q_int = q * (phi(x1) - phi(x0))
                 auto induced = propagated_charge.getCharge() * (ramo_end - ramo_start) *
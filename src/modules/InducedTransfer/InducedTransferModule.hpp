@@ -40,7 +40,7 @@ namespace allpix {
         InducedTransferModule(Configuration& config, Messenger* messenger, const std::shared_ptr<Detector>& detector);
 
         /**
-         * @brief Initial check for the presence of a weighting potential
+         * @brief Initial check for the presence of a weighting potential and tabulation of the weighting potential
          */
         void init() override;
 
@@ -59,5 +59,8 @@ namespace allpix {
 
         // Induction matrix size in number of pixels along x and y
         ROOT::Math::DisplacementVector2D<ROOT::Math::Cartesian2D<int>> matrix_;
+
+        // Weighting potential of the induction matrix tabulated on a grid aligned to the pixel pitch
+        NeighbourhoodField weighting_potential_;
     };
 } // namespace allpix
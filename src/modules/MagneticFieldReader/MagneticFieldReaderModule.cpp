@@ -9,6 +9,8 @@
 
 #include "MagneticFieldReaderModule.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <limits>
 #include <memory>
@@ -29,7 +31,10 @@
 using namespace allpix;
 
 MagneticFieldReaderModule::MagneticFieldReaderModule(Configuration& config, Messenger*, GeometryManager* geoManager)
-    : Module(config), geometryManager_(geoManager) {}
+    : Module(config), geometryManager_(geoManager) {
+    // The field is set up again when a run is continued from a checkpoint
+    enable_checkpoints();
+}
 
 void MagneticFieldReaderModule::init() {
     MagneticFieldType type = MagneticFieldType::NONE;
@@ -49,15 +54,195 @@ void MagneticFieldReaderModule::init() {
         geometryManager_->setMagneticFieldFunction(function, type);
         auto detectors = geometryManager_->getDetectors();
         for(auto& detector : detectors) {
-            // TODO the magnetic field is calculated once for the center position of the detector. This could be extended to
-            // a function enabling a gradient in the magnetic field inside the sensor
             detector->setMagneticField(detector->getOrientation().Inverse() *
                                        geometryManager_->getMagneticField(detector->getPosition()));
             LOG(DEBUG) << "Magnetic field in detector " << detector->getName() << ": "
-                       << Units::display(detector->getMagneticField(), {"T", "mT"});
+                       << Units::display(detector->getMagneticField(detector->getModel()->getSensorCenter()),
+                                         {"T", "mT"});
         }
         LOG(INFO) << "Set constant magnetic field: " << Units::display(b_field, {"T", "mT"});
+    } else if(field_model == "mesh") {
+        LOG(TRACE) << "Adding magnetic field from field map";
+        type = MagneticFieldType::GRID;
+
+        // Read the field map once, it is shared between the global field function and all detectors:
+        FieldData<double> field_data;
+        try {
+            field_data = field_parser_.getByFileName(config_.getPath("file_name", true), "T", getWorkerCount());
+        } catch(std::runtime_error& e) {
+            throw InvalidValueError(config_, "file_name", e.what());
+        } catch(std::bad_alloc& e) {
+            throw InvalidValueError(config_, "file_name", "file too large");
+        }
+
+        // The magnetic field map covers the full setup and is interpolated directly, folded maps are not supported:
+        if(field_data.getSymmetry() != FieldSymmetry::NONE) {
+            throw InvalidValueError(config_,
+                                    "file_name",
+                                    "magnetic field maps stored with " + symmetry_to_string(field_data.getSymmetry()) +
+                                        " symmetry are not supported, unfold the map first");
+        }
+
+        // The map is interpolated between neighboring bins, adaptive maps are expanded to their finest resolution:
+        field_data = refine_field_data(field_data, 3);
+
+        auto field_center = config_.get<ROOT::Math::XYZPoint>("field_center", ROOT::Math::XYZPoint());
+        LOG(INFO) << "Read magnetic field map with " << field_data.getDimensions().at(0) << "x"
+                  << field_data.getDimensions().at(1) << "x" << field_data.getDimensions().at(2) << " cells, centered at "
+                  << Units::display(field_center, {"mm", "cm"});
+
+        MagneticFieldFunction function = [field_data, field_center](const ROOT::Math::XYZPoint& pos) {
+            ROOT::Math::XYZVector field;
+            interpolate_field(field_data, field_center, pos, field);
+            return field;
+        };
+        geometryManager_->setMagneticFieldFunction(function, type);
+
+        // Resample the field map into the local frame of every detector to avoid global lookups during propagation:
+        auto detectors = geometryManager_->getDetectors();
+        for(auto& detector : detectors) {
+            set_detector_field_grid(detector, field_data, field_center);
+        }
     } else {
-        throw InvalidValueError(config_, "model", "model can currently only be 'constant'");
+        throw InvalidValueError(config_, "model", "model can currently only be 'constant' or 'mesh'");
     }
 }
+
+/**
+ * @throws InvalidValueError If the number of local field bins is not configured correctly
+ *
+ * The local grid spans the full sensor. Unless configured explicitly, the number of bins is chosen such that the bin size
+ * matches the finest pitch of the field map. The field vectors are rotated into the local frame of the detector.
+ */
+void MagneticFieldReaderModule::set_detector_field_grid(const std::shared_ptr<Detector>& detector,
+                                                        const FieldData<double>& field_data,
+                                                        const ROOT::Math::XYZPoint& field_center) {
+    auto model = detector->getModel();
+    auto sensor_center = model->getSensorCenter();
+    auto sensor_size = model->getSensorSize();
+    std::array<double, 3> size{{sensor_size.x(), sensor_size.y(), sensor_size.z()}};
+
+    std::array<size_t, 3> bins{};
+    if(config_.has("local_field_bins")) {
+        auto local_bins = config_.getArray<size_t>("local_field_bins");
+        if(local_bins.size() != 3 ||
+           std::find(local_bins.begin(), local_bins.end(), static_cast<size_t>(0)) != local_bins.end()) {
+            throw InvalidValueError(config_, "local_field_bins", "three non-zero numbers of bins in x, y and z required");
+        }
+        std::copy(local_bins.begin(), local_bins.end(), bins.begin());
+    } else {
+        auto map_dimensions = field_data.getDimensions();
+        auto map_size = field_data.getSize();
+        auto pitch = std::numeric_limits<double>::max();
+        for(size_t i = 0; i < 3; ++i) {
+            if(map_dimensions[i] > 1) {
+                pitch = std::min(pitch, map_size[i] / static_cast<double>(map_dimensions[i]));
+            }
+        }
+        for(size_t i = 0; i < 3; ++i) {
+            bins[i] = std::max(static_cast<size_t>(1), static_cast<size_t>(std::ceil(size[i] / pitch)));
+        }
+    }
+
+    auto orientation_inverse = detector->getOrientation().Inverse();
+    auto field = std::make_shared<std::vector<double>>(bins[0] * bins[1] * bins[2] * 3);
+    size_t outside = 0;
+
+    // Position of a bin center relative to the sensor center along the given axis
+    auto bin_center = [&](size_t axis, size_t idx) {
+        return (static_cast<double>(idx) + 0.5) * size[axis] / static_cast<double>(bins[axis]) - size[axis] / 2.0;
+    };
+
+    for(size_t x = 0; x < bins[0]; ++x) {
+        for(size_t y = 0; y < bins[1]; ++y) {
+            for(size_t z = 0; z < bins[2]; ++z) {
+                // Evaluate the field map at the center of the local bin:
+                ROOT::Math::XYZPoint local_pos(sensor_center.x() + bin_center(0, x),
+                                               sensor_center.y() + bin_center(1, y),
+                                               sensor_center.z() + bin_center(2, z));
+
+                ROOT::Math::XYZVector global_field;
+                if(!interpolate_field(field_data, field_center, detector->getGlobalPosition(local_pos), global_field)) {
+                    outside++;
+                }
+                auto local_field = orientation_inverse * global_field;
+
+                auto index = x * bins[1] * bins[2] * 3 + y * bins[2] * 3 + z * 3;
+                (*field)[index] = local_field.x();
+                (*field)[index + 1] = local_field.y();
+                (*field)[index + 2] = local_field.z();
+            }
+        }
+    }
+
+    if(outside > 0) {
+        LOG(WARNING) << "Detector " << detector->getName() << " extends beyond the magnetic field map, " << outside
+                     << " of " << field->size() / 3 << " local field bins are set to zero";
+    }
+
+    detector->setMagneticFieldGrid(field, bins);
+    LOG(DEBUG) << "Magnetic field in detector " << detector->getName() << " resampled to " << bins[0] << "x" << bins[1]
+               << "x" << bins[2] << " local bins, field at sensor center "
+               << Units::display(detector->getMagneticField(sensor_center), {"T", "mT"});
+}
+
+/**
+ * The field values of the map are assigned to the centers of the bins. Between bin centers the field is interpolated
+ * trilinearly, between the outermost bin centers and the map boundaries the field is extrapolated as constant. Dimensions
+ * with a single bin are treated as infinitely extended.
+ */
+bool MagneticFieldReaderModule::interpolate_field(const FieldData<double>& field_data,
+                                                  const ROOT::Math::XYZPoint& field_center,
+                                                  const ROOT::Math::XYZPoint& pos,
+                                                  ROOT::Math::XYZVector& field) {
+    auto dimensions = field_data.getDimensions();
+    auto size = field_data.getSize();
+    auto& data = *field_data.getData();
+
+    // Position relative to the lower corner of the field map:
+    std::array<double, 3> rel{{pos.x() - field_center.x() + size[0] / 2.0,
+                               pos.y() - field_center.y() + size[1] / 2.0,
+                               pos.z() - field_center.z() + size[2] / 2.0}};
+
+    std::array<size_t, 3> low{}, high{};
+    std::array<double, 3> frac{};
+    for(size_t i = 0; i < 3; ++i) {
+        if(dimensions[i] == 1) {
+            continue;
+        }
+        if(rel[i] < 0 || rel[i] > size[i]) {
+            field = ROOT::Math::XYZVector();
+            return false;
+        }
+
+        // Fractional bin index with integer values at the bin centers:
+        auto max_index = static_cast<double>(dimensions[i] - 1);
+        auto bin = std::max(0.0, std::min(rel[i] / size[i] * static_cast<double>(dimensions[i]) - 0.5, max_index));
+        low[i] = static_cast<size_t>(std::floor(bin));
+        high[i] = std::min(low[i] + 1, dimensions[i] - 1);
+        frac[i] = bin - static_cast<double>(low[i]);
+    }
+
+    // Trilinear interpolation from the eight surrounding bin centers:
+    std::array<double, 3> value{};
+    for(unsigned int corner = 0; corner < 8; ++corner) {
+        auto ix = ((corner & 1u) != 0 ? high[0] : low[0]);
+        auto iy = ((corner & 2u) != 0 ? high[1] : low[1]);
+        auto iz = ((corner & 4u) != 0 ? high[2] : low[2]);
+        auto weight = ((corner & 1u) != 0 ? frac[0] : 1 - frac[0]) * ((corner & 2u) != 0 ? frac[1] : 1 - frac[1]) *
+                      ((corner & 4u) != 0 ? frac[2] : 1 - frac[2]);
+
+        auto offset = ix * dimensions[1] * dimensions[2] * 3 + iy * dimensions[2] * 3 + iz * 3;
+        for(size_t j = 0; j < 3; ++j) {
+            value[j] += weight * data[offset + j];
+        }
+    }
+
+    field = ROOT::Math::XYZVector(value[0], value[1], value[2]);
+    return true;
+}
+
+/**
+ * The field data read from files are cached using the static FieldParser's getByFileName method.
+ */
+FieldParser<double> MagneticFieldReaderModule::field_parser_(FieldQuantity::VECTOR);
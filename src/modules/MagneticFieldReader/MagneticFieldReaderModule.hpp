@@ -18,13 +18,16 @@
 
 #include "core/module/Module.hpp"
 
+#include "tools/field_parser.h"
+
 namespace allpix {
     /**
      * @ingroup Modules
      * @brief Module to define magnetic fields
      *
-     * Read the model of the magnetic field from the config during initialization and apply a constant field throughout the
-     * whole volume
+     * Read the model of the magnetic field from the config during initialization and apply it to the whole volume. Either a
+     * constant field is used throughout the world, or a field map is read from file and resampled once into a grid in the
+     * local coordinates of every detector.
      */
     class MagneticFieldReaderModule : public Module {
     public:
@@ -42,6 +45,30 @@ namespace allpix {
         void init() override;
 
     private:
+        /**
+         * @brief Resample the global field map into a grid spanning the sensor of the given detector
+         * @param detector Detector to calculate the local field grid for
+         * @param field_data Field map read from file
+         * @param field_center Position of the field map center in global coordinates
+         */
+        void set_detector_field_grid(const std::shared_ptr<Detector>& detector,
+                                     const FieldData<double>& field_data,
+                                     const ROOT::Math::XYZPoint& field_center);
+
+        /**
+         * @brief Interpolate the field map at a given position
+         * @param field_data Field map to interpolate
+         * @param field_center Position of the field map center in global coordinates
+         * @param pos Position in global coordinates to obtain the field at
+         * @param field Interpolated field vector, set to zero outside the field map
+         * @return True if the position is inside the field map, false otherwise
+         */
+        static bool interpolate_field(const FieldData<double>& field_data,
+                                      const ROOT::Math::XYZPoint& field_center,
+                                      const ROOT::Math::XYZPoint& pos,
+                                      ROOT::Math::XYZVector& field);
+
         GeometryManager* geometryManager_;
+        static FieldParser<double> field_parser_;
     };
 } // namespace allpix
@@ -40,6 +40,7 @@ ProjectionPropagationModule::ProjectionPropagationModule(Configuration& config,
     integration_time_ = config_.get<double>("integration_time");
     output_plots_ = config_.get<bool>("output_plots");
     diffuse_deposit_ = config_.get<bool>("diffuse_deposit");
+    mc_truth_ = getMCTruthLevel();
 
     // Set default for charge carrier propagation:
     config_.setDefault<bool>("propagate_holes", false);
@@ -63,6 +64,11 @@ ProjectionPropagationModule::ProjectionPropagationModule(Configuration& config,
     boltzmann_kT_ = Units::get(8.6173e-5, "eV/K") * temperature;
 
     config_.setDefault<bool>("ignore_magnetic_field", false);
+
+    // Histograms accumulate over the whole run and are not stored in checkpoints
+    if(!output_plots_) {
+        enable_checkpoints();
+    }
 }
 
 void ProjectionPropagationModule::init() {
@@ -295,11 +301,14 @@ void ProjectionPropagationModule::run(unsigned int) {
                 initial_position_histo_->Fill(initial_position.z(), charge_per_step);
             }
 
-            auto global_position = detector_->getGlobalPosition(local_position);
-
-            // Produce charge carrier at this position
-            propagated_charges.emplace_back(
-                local_position, global_position, deposit.getType(), charge_per_step, event_time, &deposit);
+            // Produce charge carrier at this position, the global position is only calculated on demand
+            propagated_charges.emplace_back(local_position,
+                                            detector_->getLocalToGlobalTransform(),
+                                            deposit.getType(),
+                                            charge_per_step,
+                                            event_time,
+                                            &deposit,
+                                            mc_truth_ == MCTruthLevel::FULL);
 
             LOG(DEBUG) << "Propagated " << charge_per_step << " " << type << " to "
                        << Units::display(local_position, {"mm", "um"}) << " in " << Units::display(event_time, "ns")
@@ -333,3 +342,11 @@ void ProjectionPropagationModule::finalize() {
         }
     }
 }
+
+void ProjectionPropagationModule::storeState(std::ostream& state) {
+    state << random_generator_;
+}
+
+void ProjectionPropagationModule::restoreState(std::istream& state) {
+    state >> random_generator_;
+}
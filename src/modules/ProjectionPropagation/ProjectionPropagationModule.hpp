@@ -55,6 +55,16 @@ namespace allpix {
          */
         void finalize() override;
 
+        /**
+         * @brief Store the state of the random number generator in a checkpoint
+         */
+        void storeState(std::ostream& state) override;
+
+        /**
+         * @brief Restore the state of the random number generator from a checkpoint
+         */
+        void restoreState(std::istream& state) override;
+
     private:
         Messenger* messenger_;
         std::shared_ptr<const Detector> detector_;
@@ -67,6 +77,7 @@ namespace allpix {
         bool output_plots_;
         double integration_time_{};
         bool diffuse_deposit_;
+        MCTruthLevel mc_truth_;
 
         // Carrier type to be propagated
         CarrierType propagate_type_;
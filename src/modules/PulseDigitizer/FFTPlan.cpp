@@ -0,0 +1,78 @@
+/**
+ * @file
+ * @brief Implementation of a reusable radix-2 fast Fourier transform plan
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "FFTPlan.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace allpix;
+
+FFTPlan::FFTPlan(size_t size) : size_(size) {
+    if(size_ == 0 || (size_ & (size_ - 1)) != 0) {
+        throw std::invalid_argument("FFT length " + std::to_string(size_) + " is not a power of two");
+    }
+
+    // Precompute the bit-reversed index of every position
+    size_t bits = 0;
+    while((size_t(1) << bits) < size_) {
+        bits++;
+    }
+    bit_reversal_.resize(size_);
+    for(size_t i = 0; i < size_; i++) {
+        size_t reversed = 0;
+        for(size_t bit = 0; bit < bits; bit++) {
+            reversed |= ((i >> bit) & 1u) << (bits - 1 - bit);
+        }
+        bit_reversal_[i] = reversed;
+    }
+
+    // Precompute the twiddle factors exp(-2 pi i k / N) for the first half of the unit circle
+    twiddles_.resize(size_ / 2);
+    for(size_t k = 0; k < size_ / 2; k++) {
+        twiddles_[k] = std::polar(1., -2. * M_PI * static_cast<double>(k) / static_cast<double>(size_));
+    }
+}
+
+void FFTPlan::transform(std::vector<std::complex<double>>& data, bool inverse) const {
+    if(data.size() != size_) {
+        throw std::invalid_argument("data length does not match the FFT plan");
+    }
+
+    // Reorder the input into bit-reversed order
+    for(size_t i = 0; i < size_; i++) {
+        if(i < bit_reversal_[i]) {
+            std::swap(data[i], data[bit_reversal_[i]]);
+        }
+    }
+
+    // Iterative butterfly passes, the twiddle factors of pass with length len are every (N / len)-th precomputed factor
+    for(size_t len = 2; len <= size_; len <<= 1) {
+        auto half = len / 2;
+        auto stride = size_ / len;
+        for(size_t start = 0; start < size_; start += len) {
+            for(size_t k = 0; k < half; k++) {
+                auto twiddle = (inverse ? std::conj(twiddles_[k * stride]) : twiddles_[k * stride]);
+                auto odd = data[start + k + half] * twiddle;
+                data[start + k + half] = data[start + k] - odd;
+                data[start + k] += odd;
+            }
+        }
+    }
+}
+
+size_t FFTPlan::fitting_size(size_t size) {
+    size_t fitting = 1;
+    while(fitting < size) {
+        fitting <<= 1;
+    }
+    return fitting;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file
+ * @brief Definition of a reusable radix-2 fast Fourier transform plan
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_PULSE_DIGITIZER_FFT_PLAN_H
+#define ALLPIX_PULSE_DIGITIZER_FFT_PLAN_H
+
+#include <complex>
+#include <vector>
+
+namespace allpix {
+    /**
+     * @brief Plan for complex fast Fourier transforms of a fixed power-of-two length
+     *
+     * The bit-reversal permutation and the twiddle factors are computed once on construction, such that repeated transforms
+     * of the same length only perform the butterfly passes. The transforms are unnormalized, the inverse transform has to
+     * be divided by the length to recover the input.
+     */
+    class FFTPlan {
+    public:
+        /**
+         * @brief Construct a plan for transforms of the given length
+         * @param size Length of the transforms, has to be a power of two
+         * @throws std::invalid_argument If the size is not a power of two
+         */
+        explicit FFTPlan(size_t size);
+
+        /**
+         * @brief Get the length of the transforms
+         * @return Number of points of the transforms
+         */
+        size_t size() const { return size_; }
+
+        /**
+         * @brief Transform the data in place
+         * @param data Data to transform, has to be of the length of the plan
+         * @param inverse True to calculate the inverse transform, false for the forward transform
+         */
+        void transform(std::vector<std::complex<double>>& data, bool inverse = false) const;
+
+        /**
+         * @brief Get the smallest power of two not smaller than the requested length
+         * @param size Requested length
+         * @return Length usable for a plan
+         */
+        static size_t fitting_size(size_t size);
+
+    private:
+        size_t size_;
+        std::vector<size_t> bit_reversal_;
+        std::vector<std::complex<double>> twiddles_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_PULSE_DIGITIZER_FFT_PLAN_H */
@@ -0,0 +1,415 @@
+/**
+ * @file
+ * @brief Implementation of pulse digitization module applying a front-end transfer function
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "PulseDigitizerModule.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <utility>
+
+#include "core/utils/log.h"
+#include "core/utils/unit.h"
+#include "tools/ROOT.h"
+
+using namespace allpix;
+
+PulseDigitizerModule::PulseDigitizerModule(Configuration& config,
+                                           Messenger* messenger,
+                                           std::shared_ptr<Detector> detector)
+    : Module(config, std::move(detector)), messenger_(messenger), pixel_message_(nullptr) {
+    // Enable parallelization of this module if multithreading is enabled
+    enable_parallelization();
+
+    // Require PixelCharge message for single detector
+    messenger_->bindSingle(this, &PulseDigitizerModule::pixel_message_, MsgFlags::REQUIRED);
+
+    // Seed the random generator with the global seed
+    random_generator_.seed(getRandomSeed());
+
+    // Set defaults for config variables
+    config_.setDefault<std::string>("model", "csa");
+    config_.setDefault<double>("amplification", Units::get(10.0, "mV/ke"));
+    config_.setDefault<double>("rise_time_constant", Units::get(1.0, "ns"));
+    config_.setDefault<double>("feedback_time_constant", Units::get(10.0, "ns"));
+    config_.setDefault<unsigned int>("shaper_order", 0);
+    config_.setDefault<double>("shaping_time", Units::get(10.0, "ns"));
+    config_.setDefault<double>("integration_time", Units::get(500.0, "ns"));
+    config_.setDefault<double>("threshold", Units::get(10.0, "mV"));
+    config_.setDefault<std::string>("polarity", "auto");
+    config_.setDefault<double>("sigma_noise", 0);
+    config_.setDefault<double>("clock_bin_toa", 0);
+    config_.setDefault<double>("clock_bin_tot", 0);
+
+    config_.setDefault<bool>("output_plots", false);
+    config_.setDefault<double>("output_plots_scale", Units::get(100.0, "mV"));
+    config_.setDefault<int>("output_plots_bins", 100);
+
+    // Cache configuration parameters used for every pixel
+    model_ = config_.get<std::string>("model");
+    std::transform(model_.begin(), model_.end(), model_.begin(), ::tolower);
+    amplification_ = config_.get<double>("amplification");
+    integration_time_ = config_.get<double>("integration_time");
+    threshold_ = config_.get<double>("threshold");
+    sigma_noise_ = config_.get<double>("sigma_noise");
+    clock_bin_toa_ = config_.get<double>("clock_bin_toa");
+    clock_bin_tot_ = config_.get<double>("clock_bin_tot");
+    output_plots_ = config_.get<bool>("output_plots");
+    mc_truth_ = getMCTruthLevel();
+
+    // Histograms accumulate over the whole run and are not stored in checkpoints
+    if(!output_plots_) {
+        enable_checkpoints();
+    }
+}
+
+void PulseDigitizerModule::init() {
+    if(model_ == "csa") {
+        LOG(INFO) << "Using charge-sensitive amplifier with rise time constant "
+                  << Units::display(config_.get<double>("rise_time_constant"), {"ns", "ps"})
+                  << " and feedback time constant "
+                  << Units::display(config_.get<double>("feedback_time_constant"), {"ns", "us"});
+        if(config_.get<double>("feedback_time_constant") <= 0) {
+            throw InvalidValueError(config_, "feedback_time_constant", "time constant should be positive");
+        }
+        if(config_.get<double>("rise_time_constant") < 0) {
+            throw InvalidValueError(config_, "rise_time_constant", "time constant should not be negative");
+        }
+        if(config_.get<unsigned int>("shaper_order") > 0) {
+            LOG(INFO) << "Adding CR-RC^" << config_.get<unsigned int>("shaper_order") << " shaper with shaping time "
+                      << Units::display(config_.get<double>("shaping_time"), {"ns", "us"});
+            if(config_.get<double>("shaping_time") <= 0) {
+                throw InvalidValueError(config_, "shaping_time", "shaping time should be positive");
+            }
+        }
+    } else if(model_ == "file") {
+        // Read the impulse response as pairs of time and amplitude
+        auto file_name = config_.getPath("response_file", true);
+        std::ifstream file(file_name);
+        std::string line;
+        while(std::getline(file, line)) {
+            line.erase(0, line.find_first_not_of(" \t"));
+            if(line.empty() || line.front() == '#') {
+                continue;
+            }
+            std::istringstream stream(line);
+            double time = 0, amplitude = 0;
+            if(!(stream >> time >> amplitude)) {
+                throw InvalidValueError(config_, "response_file", "invalid line \"" + line + "\" in impulse response");
+            }
+            response_table_.emplace_back(Units::get(time, "ns"), amplitude);
+        }
+        if(response_table_.size() < 2) {
+            throw InvalidValueError(config_, "response_file", "impulse response requires at least two points");
+        }
+        std::sort(response_table_.begin(), response_table_.end());
+        LOG(INFO) << "Read impulse response with " << response_table_.size() << " points from " << file_name;
+    } else {
+        throw InvalidValueError(config_, "model", "model should be 'csa' or 'file'");
+    }
+
+    if(integration_time_ <= 0) {
+        throw InvalidValueError(config_, "integration_time", "integration time should be positive");
+    }
+    if(threshold_ <= 0) {
+        throw InvalidValueError(config_, "threshold", "threshold should be positive, the polarity is set separately");
+    }
+
+    // A polarity of zero takes the sign from the shaped signal of every pixel
+    auto polarity = config_.get<std::string>("polarity");
+    std::transform(polarity.begin(), polarity.end(), polarity.begin(), ::tolower);
+    if(polarity == "positive") {
+        polarity_ = 1.;
+    } else if(polarity == "negative") {
+        polarity_ = -1.;
+    } else if(polarity != "auto") {
+        throw InvalidValueError(config_, "polarity", "polarity should be 'auto', 'positive' or 'negative'");
+    }
+
+    if(output_plots_) {
+        LOG(TRACE) << "Creating output plots";
+        auto nbins = config_.get<int>("output_plots_bins");
+        auto maximum = static_cast<double>(Units::convert(config_.get<double>("output_plots_scale"), "mV"));
+        auto time = static_cast<double>(Units::convert(integration_time_, "ns"));
+
+        h_amplitude = new TH1D("amplitude", "pulse amplitude;amplitude [mV];pixels", nbins, 0, maximum);
+        h_toa = new TH1D("toa", "time of arrival;ToA [ns];pixels", nbins, 0, time);
+        h_tot = new TH1D("tot", "time over threshold;ToT [ns];pixels", nbins, 0, time);
+    }
+}
+
+/**
+ * The response is normalized to a maximum absolute amplitude of one, such that the amplification parameter sets the peak
+ * output for a unit charge. The charge-sensitive amplifier is described by a rise and a feedback time constant. An
+ * optional CR-RC^n shaper is applied by convolving with the difference of its step response between neighboring bins.
+ */
+std::vector<double> PulseDigitizerModule::impulse_response(double binning, size_t bins) const {
+    std::vector<double> response(bins);
+    if(model_ == "csa") {
+        auto tau_f = config_.get<double>("feedback_time_constant");
+        auto tau_r = config_.get<double>("rise_time_constant");
+        for(size_t k = 0; k < bins; k++) {
+            auto t = static_cast<double>(k) * binning;
+            if(tau_r <= 0) {
+                response[k] = std::exp(-t / tau_f);
+            } else if(std::fabs(tau_f - tau_r) < 1e-9 * tau_f) {
+                response[k] = t / (tau_f * tau_f) * std::exp(-t / tau_f);
+            } else {
+                response[k] = (std::exp(-t / tau_f) - std::exp(-t / tau_r)) / (tau_f - tau_r);
+            }
+        }
+
+        auto order = config_.get<unsigned int>("shaper_order");
+        if(order > 0) {
+            auto tau_s = config_.get<double>("shaping_time");
+            auto step = [&](double t) { return std::pow(t / tau_s, order) * std::exp(-t / tau_s); };
+
+            // Convolve with the shaper response in the frequency domain
+            FFTPlan plan(FFTPlan::fitting_size(2 * bins));
+            std::vector<std::complex<double>> csa(plan.size()), shaper(plan.size());
+            for(size_t k = 0; k < bins; k++) {
+                auto t = static_cast<double>(k) * binning;
+                csa[k] = response[k];
+                shaper[k] = step(t + binning) - step(t);
+            }
+            plan.transform(csa);
+            plan.transform(shaper);
+            for(size_t k = 0; k < plan.size(); k++) {
+                csa[k] *= shaper[k];
+            }
+            plan.transform(csa, true);
+            for(size_t k = 0; k < bins; k++) {
+                response[k] = csa[k].real() / static_cast<double>(plan.size());
+            }
+        }
+    } else {
+        // Linear interpolation of the tabulated response, zero outside its range
+        for(size_t k = 0; k < bins; k++) {
+            auto t = static_cast<double>(k) * binning;
+            auto upper = std::upper_bound(response_table_.begin(),
+                                          response_table_.end(),
+                                          std::make_pair(t, std::numeric_limits<double>::lowest()));
+            if(upper == response_table_.begin() || upper == response_table_.end()) {
+                continue;
+            }
+            auto lower = std::prev(upper);
+            auto fraction = (t - lower->first) / (upper->first - lower->first);
+            response[k] = lower->second + fraction * (upper->second - lower->second);
+        }
+    }
+
+    auto maximum = std::accumulate(
+        response.begin(), response.end(), 0., [](double max, double value) { return std::max(max, std::fabs(value)); });
+    if(maximum <= 0) {
+        throw ModuleError("Impulse response of the front-end vanishes within the integration time");
+    }
+    for(auto& value : response) {
+        value /= maximum;
+    }
+    return response;
+}
+
+/**
+ * The transform length is chosen to hold twice the integration window, such that the circular convolution equals the
+ * linear convolution within the window.
+ */
+void PulseDigitizerModule::prepare_plan(double binning) {
+    if(plan_ != nullptr && binning == plan_binning_) {
+        return;
+    }
+
+    integration_bins_ = static_cast<size_t>(std::ceil(integration_time_ / binning));
+    plan_ = std::make_unique<FFTPlan>(FFTPlan::fitting_size(2 * integration_bins_));
+    plan_binning_ = binning;
+    LOG(DEBUG) << "Preparing FFT plan of length " << plan_->size() << " for pulse binning "
+               << Units::display(binning, {"ps", "ns"});
+
+    auto response = impulse_response(binning, integration_bins_);
+    response_spectrum_.assign(plan_->size(), 0.);
+    for(size_t k = 0; k < integration_bins_; k++) {
+        // Include the normalization of the inverse transform in the response spectrum
+        response_spectrum_[k] = amplification_ * response[k] / static_cast<double>(plan_->size());
+    }
+    plan_->transform(response_spectrum_);
+    buffer_.resize(plan_->size());
+}
+
+void PulseDigitizerModule::run(unsigned int) {
+    // Collect all pixels with pulses
+    std::vector<const PixelCharge*> pixel_charges;
+    for(auto& pixel_charge : pixel_message_->getData()) {
+        if(pixel_charge.getPulse().getPulse().empty()) {
+            throw ModuleError("No pulse information available for pixel charges - the PulseTransfer module should be used");
+        }
+        pixel_charges.push_back(&pixel_charge);
+    }
+
+    std::vector<PixelHit> hits;
+    std::vector<double> waveform;
+    for(size_t i = 0; i < pixel_charges.size(); i += 2) {
+        // Transform two pixel pulses at once as real and imaginary part of the input
+        auto first = pixel_charges[i];
+        auto second = (i + 1 < pixel_charges.size() ? pixel_charges[i + 1] : nullptr);
+        prepare_plan(first->getPulse().getBinning());
+        if(second != nullptr && second->getPulse().getBinning() != plan_binning_) {
+            throw ModuleError("Pulses of different pixels have different time binning");
+        }
+
+        std::fill(buffer_.begin(), buffer_.end(), 0.);
+        auto& first_pulse = first->getPulse().getPulse();
+        for(size_t k = 0; k < std::min(first_pulse.size(), integration_bins_); k++) {
+            buffer_[k].real(first_pulse[k]);
+        }
+        if(second != nullptr) {
+            auto& second_pulse = second->getPulse().getPulse();
+            for(size_t k = 0; k < std::min(second_pulse.size(), integration_bins_); k++) {
+                buffer_[k].imag(second_pulse[k]);
+            }
+        }
+
+        // Convolve with the real impulse response, which keeps the real and imaginary parts separated
+        plan_->transform(buffer_);
+        for(size_t k = 0; k < buffer_.size(); k++) {
+            buffer_[k] *= response_spectrum_[k];
+        }
+        plan_->transform(buffer_, true);
+
+        waveform.resize(integration_bins_);
+        std::transform(buffer_.begin(),
+                       buffer_.begin() + static_cast<std::ptrdiff_t>(integration_bins_),
+                       waveform.begin(),
+                       [](const std::complex<double>& value) { return value.real(); });
+        digitize(*first, waveform, hits);
+        if(second != nullptr) {
+            std::transform(buffer_.begin(),
+                           buffer_.begin() + static_cast<std::ptrdiff_t>(integration_bins_),
+                           waveform.begin(),
+                           [](const std::complex<double>& value) { return value.imag(); });
+            digitize(*second, waveform, hits);
+        }
+    }
+
+    // Output summary and update statistics
+    LOG(INFO) << "Digitized " << hits.size() << " pixel hits";
+    total_hits_ += hits.size();
+
+    if(!hits.empty()) {
+        // Create and dispatch hit message
+        auto hits_message = std::make_shared<PixelHitMessage>(std::move(hits), getDetector());
+        messenger_->dispatchMessage(this, hits_message);
+    }
+}
+
+/**
+ * The time of arrival is the first crossing of the threshold, linearly interpolated between bins. The time over threshold
+ * lasts until the waveform falls below the threshold again or until the end of the integration time. Unless configured,
+ * the polarity of the signal is taken from the largest excursion of the shaped waveform before adding noise, and negative
+ * signals have to fall below the negative threshold. If clock bins are configured, both times are converted to clock
+ * cycles.
+ */
+void PulseDigitizerModule::digitize(const PixelCharge& pixel_charge,
+                                    std::vector<double>& waveform,
+                                    std::vector<PixelHit>& hits) {
+    auto binning = plan_binning_;
+
+    auto sign = polarity_;
+    if(sign == 0) {
+        auto extremum = std::max_element(
+            waveform.begin(), waveform.end(), [](double a, double b) { return std::fabs(a) < std::fabs(b); });
+        sign = (extremum != waveform.end() && *extremum < 0 ? -1. : 1.);
+    }
+    auto threshold = sign * threshold_;
+
+    // Add noise to every sample
+    if(sigma_noise_ > 0) {
+        std::normal_distribution<double> noise(0, sigma_noise_);
+        for(auto& sample : waveform) {
+            sample += noise(random_generator_);
+        }
+    }
+
+    // Find the amplitude and the threshold crossings
+    double amplitude = 0;
+    double toa = -1, tot = -1;
+    for(size_t k = 0; k < waveform.size(); k++) {
+        amplitude = std::max(amplitude, sign * waveform[k]);
+
+        // Interpolate the position of the threshold crossing between this and the previous sample
+        auto above = (sign * waveform[k] >= threshold_);
+        auto crossing = [&]() {
+            auto previous = (k > 0 ? waveform[k - 1] : 0.);
+            auto step = waveform[k] - previous;
+            return static_cast<double>(k) - (step != 0. ? (waveform[k] - threshold) / step : 0.);
+        };
+        if(toa < 0 && above) {
+            toa = std::max(crossing(), 0.) * binning;
+        } else if(toa >= 0 && tot < 0 && !above) {
+            tot = crossing() * binning - toa;
+        }
+    }
+
+    LOG(DEBUG) << "Pixel " << pixel_charge.getPixel().getIndex() << ": charge "
+               << Units::display(pixel_charge.getCharge(), "e") << ", amplitude " << Units::display(amplitude, "mV");
+    if(output_plots_) {
+        h_amplitude->Fill(static_cast<double>(Units::convert(amplitude, "mV")));
+    }
+
+    if(toa < 0) {
+        LOG(DEBUG) << "Below threshold of " << Units::display(threshold, "mV");
+        return;
+    }
+    if(tot < 0) {
+        tot = static_cast<double>(waveform.size()) * binning - toa;
+        LOG(DEBUG) << "Signal above threshold until the end of the integration time";
+    }
+    LOG(DEBUG) << "ToA " << Units::display(toa, {"ns", "ps"}) << ", ToT " << Units::display(tot, {"ns", "ps"});
+    if(output_plots_) {
+        h_toa->Fill(static_cast<double>(Units::convert(toa, "ns")));
+        h_tot->Fill(static_cast<double>(Units::convert(tot, "ns")));
+    }
+
+    // Convert to clock cycles if requested
+    if(clock_bin_toa_ > 0) {
+        toa = std::ceil(toa / clock_bin_toa_);
+    }
+    if(clock_bin_tot_ > 0) {
+        tot = std::ceil(tot / clock_bin_tot_);
+    }
+
+    // Link the pixel charge or only its Monte-Carlo particles depending on the requested history
+    hits.emplace_back(pixel_charge.getPixel(),
+                      toa,
+                      tot,
+                      (mc_truth_ != MCTruthLevel::NONE ? &pixel_charge : nullptr),
+                      mc_truth_ == MCTruthLevel::FULL);
+}
+
+void PulseDigitizerModule::finalize() {
+    if(output_plots_) {
+        // Write histograms
+        LOG(TRACE) << "Writing output plots to file";
+        h_amplitude->Write();
+        h_toa->Write();
+        h_tot->Write();
+    }
+
+    LOG(INFO) << "Digitized " << total_hits_ << " pixel hits in total";
+}
+
+void PulseDigitizerModule::storeState(std::ostream& state) {
+    state << random_generator_ << " " << total_hits_;
+}
+
+void PulseDigitizerModule::restoreState(std::istream& state) {
+    state >> random_generator_ >> total_hits_;
+}
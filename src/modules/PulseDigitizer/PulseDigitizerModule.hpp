@@ -0,0 +1,138 @@
+/**
+ * @file
+ * @brief Definition of pulse digitization module applying a front-end transfer function
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_PULSE_DIGITIZER_MODULE_H
+#define ALLPIX_PULSE_DIGITIZER_MODULE_H
+
+#include <complex>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <TH1D.h>
+
+#include "core/config/Configuration.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/PixelCharge.hpp"
+#include "objects/PixelHit.hpp"
+
+#include "FFTPlan.hpp"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to simulate the front-end response to induced current pulses
+     * @note This module supports parallelization
+     *
+     * The pulses of all pixels are convolved with the impulse response of the front-end, either a charge-sensitive
+     * amplifier with optional CR-RC shaper or a response read from file. The convolution is performed with fast Fourier
+     * transforms, where the transform plan and the spectrum of the response are only calculated once for the binning of the
+     * pulses. Two pixel pulses are transformed at once as real and imaginary part of a single complex transform. Time of
+     * arrival and time over threshold are extracted from the shaped waveform.
+     */
+    class PulseDigitizerModule : public Module {
+    public:
+        /**
+         * @brief Constructor for this detector-specific module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param detector Pointer to the detector for this module instance
+         */
+        PulseDigitizerModule(Configuration& config, Messenger* messenger, std::shared_ptr<Detector> detector);
+
+        /**
+         * @brief Read the impulse response and initialize optional ROOT histograms
+         */
+        void init() override;
+
+        /**
+         * @brief Shape the pixel pulses and extract time of arrival and time over threshold
+         */
+        void run(unsigned int) override;
+
+        /**
+         * @brief Finalize and write optional histograms
+         */
+        void finalize() override;
+
+        /**
+         * @brief Store the state of the random number generator and the hit statistics in a checkpoint
+         */
+        void storeState(std::ostream& state) override;
+
+        /**
+         * @brief Restore the state of the random number generator and the hit statistics from a checkpoint
+         */
+        void restoreState(std::istream& state) override;
+
+    private:
+        /**
+         * @brief Calculate the impulse response of the front-end, normalized to a maximum of one
+         * @param binning Time binning of the response
+         * @param bins Number of bins of the response
+         * @return Sampled impulse response
+         */
+        std::vector<double> impulse_response(double binning, size_t bins) const;
+
+        /**
+         * @brief Prepare the transform plan and response spectrum for the given pulse binning
+         * @param binning Time binning of the pulses
+         */
+        void prepare_plan(double binning);
+
+        /**
+         * @brief Extract the hit information from a shaped waveform
+         * @param pixel_charge Pixel charge the waveform belongs to
+         * @param waveform Shaped waveform, modified if noise is added
+         * @param hits List of hits to add a hit to if the threshold is crossed
+         */
+        void digitize(const PixelCharge& pixel_charge, std::vector<double>& waveform, std::vector<PixelHit>& hits);
+
+        std::mt19937_64 random_generator_;
+
+        Messenger* messenger_;
+
+        // Input message with the charges on the pixels
+        std::shared_ptr<PixelChargeMessage> pixel_message_;
+
+        // Front-end parameters
+        std::string model_;
+        double amplification_{};
+        double integration_time_{};
+        double threshold_{};
+        double polarity_{};
+        double sigma_noise_{};
+        double clock_bin_toa_{};
+        double clock_bin_tot_{};
+        std::vector<std::pair<double, double>> response_table_;
+
+        // Depth of the stored history
+        MCTruthLevel mc_truth_{};
+
+        // Transform plan and response spectrum, reused as long as the pulse binning does not change
+        std::unique_ptr<FFTPlan> plan_;
+        std::vector<std::complex<double>> response_spectrum_;
+        std::vector<std::complex<double>> buffer_;
+        double plan_binning_{};
+        size_t integration_bins_{};
+
+        // Statistics
+        unsigned long long total_hits_{};
+
+        // Output histograms
+        bool output_plots_{};
+        TH1D *h_amplitude{}, *h_toa{}, *h_tot{};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_PULSE_DIGITIZER_MODULE_H */
@@ -39,8 +39,14 @@ PulseTransferModule::PulseTransferModule(Configuration& config,
     output_plots_ = config_.get<bool>("output_plots");
     output_pulsegraphs_ = config_.get<bool>("output_pulsegraphs");
     timestep_ = config_.get<double>("timestep");
+    mc_truth_ = getMCTruthLevel();
 
     messenger_->bindSingle(this, &PulseTransferModule::message_, MsgFlags::REQUIRED);
+
+    // Histograms accumulate over the whole run and are not stored in checkpoints
+    if(!output_plots_) {
+        enable_checkpoints();
+    }
 }
 
 void PulseTransferModule::init() {
@@ -86,8 +92,9 @@ void PulseTransferModule::run(unsigned int event_num) {
             }
 
             // Find the nearest pixel
-            auto xpixel = static_cast<int>(std::round(position.x() / model->getPixelSize().x()));
-            auto ypixel = static_cast<int>(std::round(position.y() / model->getPixelSize().y()));
+            auto nearest_pixel = detector_->getPixelIndex(position);
+            auto xpixel = nearest_pixel.first;
+            auto ypixel = nearest_pixel.second;
 
             // Ignore if out of pixel grid
             if(!detector_->isWithinPixelGrid(xpixel, ypixel)) {
@@ -205,8 +212,13 @@ void PulseTransferModule::run(unsigned int event_num) {
         }
         LOG(DEBUG) << "Charge on pixel " << index << " has " << pixel_charge_map[index].size() << " ancestors";
 
-        // Store the pulse:
-        pixel_charges.emplace_back(detector_->getPixel(index), std::move(pulse), pixel_charge_map[index]);
+        // Store the pulse, linking the propagated charges or only their Monte-Carlo particles depending on the history
+        if(mc_truth_ == MCTruthLevel::NONE) {
+            pixel_charges.emplace_back(detector_->getPixel(index), std::move(pulse));
+        } else {
+            pixel_charges.emplace_back(
+                detector_->getPixel(index), std::move(pulse), pixel_charge_map[index], mc_truth_ == MCTruthLevel::FULL);
+        }
     }
 
     // Create a new message with pixel pulses and dispatch:
@@ -54,6 +54,7 @@ namespace allpix {
     private:
         bool output_plots_{}, output_pulsegraphs_{};
         double timestep_{};
+        MCTruthLevel mc_truth_{};
 
         // General module members
         std::shared_ptr<Detector> detector_;
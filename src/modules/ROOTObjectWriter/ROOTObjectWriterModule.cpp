@@ -9,7 +9,9 @@
 
 #include "ROOTObjectWriterModule.hpp"
 
+#include <cstdio>
 #include <fstream>
+#include <iomanip>
 #include <string>
 #include <utility>
 
@@ -30,6 +32,9 @@ ROOTObjectWriterModule::ROOTObjectWriterModule(Configuration& config, Messenger*
     : Module(config), geo_mgr_(geo_mgr) {
     // Bind to all messages
     messenger->registerListener(this, &ROOTObjectWriterModule::receive);
+
+    // The trees are stored at every checkpoint and continued when the run is resumed
+    enable_checkpoints();
 }
 /**
  * @note Objects cannot be stored in smart pointers due to internal ROOT logic
@@ -42,11 +47,64 @@ ROOTObjectWriterModule::~ROOTObjectWriterModule() {
 }
 
 void ROOTObjectWriterModule::init() {
-    // Create output file
-    output_file_name_ =
-        createOutputFile(allpix::add_file_extension(config_.get<std::string>("file_name", "data"), "root"), true);
-    output_file_ = std::make_unique<TFile>(output_file_name_.c_str(), "RECREATE");
-    output_file_->cd();
+    checkpoints_ = (getConfigManager()->getGlobalConfiguration().get<unsigned int>("checkpoint_interval", 0u) > 0);
+
+    if(resume_) {
+        // Move the output file of the interrupted run aside, it might contain data written after the last checkpoint
+        auto checkpoint_file_name = output_file_name_ + ".checkpoint";
+        if(std::rename(output_file_name_.c_str(), checkpoint_file_name.c_str()) != 0) {
+            throw ModuleError("Cannot move output file " + output_file_name_ + " to resume the run");
+        }
+        auto checkpoint_file = std::make_unique<TFile>(checkpoint_file_name.c_str(), "READ");
+        if(checkpoint_file->IsZombie()) {
+            throw ModuleError("Cannot reopen output file " + checkpoint_file_name + " to resume the run");
+        }
+        output_file_ = std::make_unique<TFile>(output_file_name_.c_str(), "RECREATE");
+
+        // Rebuild the trees stored at the checkpoint with exactly the events of the checkpoint, branches are attached
+        // when their objects are received again
+        for(auto& tree_name : resume_trees_) {
+            TTree* tree = nullptr;
+            checkpoint_file->GetObject(tree_name.c_str(), tree);
+            if(tree == nullptr) {
+                throw ModuleError("Output file " + output_file_name_ + " does not contain the tree " + tree_name +
+                                  " stored in the checkpoint");
+            }
+            if(tree->GetEntries() < last_event_) {
+                throw ModuleError("Tree " + tree_name + " in output file " + output_file_name_ + " contains " +
+                                  std::to_string(tree->GetEntries()) + " events instead of " +
+                                  std::to_string(last_event_) + " events stored in the checkpoint");
+            }
+
+            output_file_->cd();
+            auto* resumed_tree = tree->CloneTree(last_event_);
+            for(auto* branch : *resumed_tree->GetListOfBranches()) {
+                // Let ROOT fill empty records for branches without objects until they are attached again
+                static_cast<TBranch*>(branch)->SetAddress(nullptr);
+            }
+            if(checkpoints_) {
+                resumed_tree->SetAutoSave(0);
+            }
+            trees_.emplace(tree_name, std::unique_ptr<TTree>(resumed_tree));
+        }
+
+        // Drop the file of the interrupted run, including the baskets and metadata written after the checkpoint
+        checkpoint_file->Close();
+        checkpoint_file.reset();
+        try {
+            allpix::remove_file(checkpoint_file_name);
+        } catch(std::invalid_argument&) {
+            LOG(WARNING) << "Cannot remove output file " << checkpoint_file_name << " of the interrupted run";
+        }
+        output_file_->cd();
+        LOG(INFO) << "Continuing output file " << output_file_name_ << " after " << last_event_ << " events";
+    } else {
+        // Create output file
+        output_file_name_ =
+            createOutputFile(allpix::add_file_extension(config_.get<std::string>("file_name", "data"), "root"), true);
+        output_file_ = std::make_unique<TFile>(output_file_name_.c_str(), "RECREATE");
+        output_file_->cd();
+    }
 
     // Read include and exclude list
     if(config_.has("include") && config_.has("exclude")) {
@@ -116,6 +174,9 @@ void ROOTObjectWriterModule::receive(std::shared_ptr<BaseMessage> message, std::
                     trees_.emplace(
                         class_name,
                         std::make_unique<TTree>(class_name.c_str(), (std::string("Tree of ") + class_name).c_str()));
+                    if(checkpoints_) {
+                        trees_[class_name]->SetAutoSave(0);
+                    }
                 }
 
                 std::string branch_name = detector_name.empty() ? "global" : detector_name;
@@ -124,22 +185,30 @@ void ROOTObjectWriterModule::receive(std::shared_ptr<BaseMessage> message, std::
                     branch_name += message_name;
                 }
 
-                trees_[class_name]->Bronch(
-                    branch_name.c_str(), (std::string("std::vector<") + cls->GetName() + "*>").c_str(), addr);
-
-                // Prefill new tree or new branch with empty records for all events that were missed since the start
-                if(last_event_ > 0) {
-                    if(new_tree) {
-                        LOG(DEBUG) << "Pre-filling new tree of " << class_name << " with " << last_event_ << " empty events";
-                        for(unsigned int i = 0; i < last_event_; ++i) {
-                            trees_[class_name]->Fill();
-                        }
-                    } else {
-                        LOG(DEBUG) << "Pre-filling new branch " << branch_name << " of " << class_name << " with "
-                                   << last_event_ << " empty events";
-                        auto* branch = trees_[class_name]->GetBranch(branch_name.c_str());
-                        for(unsigned int i = 0; i < last_event_; ++i) {
-                            branch->Fill();
+                if(!new_tree && trees_[class_name]->GetBranch(branch_name.c_str()) != nullptr) {
+                    // Attach to the branch of a resumed data file, which already holds records for all previous events
+                    LOG(DEBUG) << "Continuing branch " << branch_name << " of " << class_name << " after " << last_event_
+                               << " events";
+                    trees_[class_name]->SetBranchAddress(branch_name.c_str(), static_cast<void*>(addr));
+                } else {
+                    trees_[class_name]->Bronch(
+                        branch_name.c_str(), (std::string("std::vector<") + cls->GetName() + "*>").c_str(), addr);
+
+                    // Prefill new tree or new branch with empty records for all events that were missed since the start
+                    if(last_event_ > 0) {
+                        if(new_tree) {
+                            LOG(DEBUG) << "Pre-filling new tree of " << class_name << " with " << last_event_
+                                       << " empty events";
+                            for(unsigned int i = 0; i < last_event_; ++i) {
+                                trees_[class_name]->Fill();
+                            }
+                        } else {
+                            LOG(DEBUG) << "Pre-filling new branch " << branch_name << " of " << class_name << " with "
+                                       << last_event_ << " empty events";
+                            auto* branch = trees_[class_name]->GetBranch(branch_name.c_str());
+                            for(unsigned int i = 0; i < last_event_; ++i) {
+                                branch->Fill();
+                            }
                         }
                     }
                 }
@@ -166,6 +235,14 @@ void ROOTObjectWriterModule::run(unsigned int event) {
     // Save last event number for trees created later
     last_event_ = event;
 
+    // Fill the members and references which are only calculated on demand for all objects of the event. The filled members
+    // equal the values calculated on demand, such that other modules reading the objects are not affected
+    for(auto& message : keep_messages_) {
+        for(Object& object : message->getObjectArray()) {
+            object.materialize();
+        }
+    }
+
     // Fill the tree with the current received messages
     for(auto& tree : trees_) {
         tree.second->Fill();
@@ -264,10 +341,39 @@ void ROOTObjectWriterModule::finalize() {
         }
     }
 
-    // Finish writing to output file
-    output_file_->Write();
+    // Finish writing to output file, replacing the trees saved at the last checkpoint
+    output_file_->Write(nullptr, checkpoints_ ? TObject::kOverwrite : 0);
 
     // Print statistics
     LOG(STATUS) << "Wrote " << write_cnt_ << " objects to " << branch_count << " branches in file:" << std::endl
                 << output_file_name_;
 }
+
+/**
+ * The trees and the directory of the file are saved, such that the file can be reopened with all events up to the
+ * checkpoint even if the run is killed without finalizing. Automatic saving of the trees in between is disabled when
+ * checkpoints are enabled, since it would store events beyond the last checkpoint.
+ */
+void ROOTObjectWriterModule::storeState(std::ostream& state) {
+    for(auto& tree : trees_) {
+        tree.second->AutoSave("SaveSelf FlushBaskets");
+    }
+    output_file_->SaveSelf();
+    output_file_->Flush();
+
+    state << std::quoted(output_file_name_) << " " << last_event_ << " " << write_cnt_ << " " << trees_.size();
+    for(auto& tree : trees_) {
+        state << " " << std::quoted(tree.first);
+    }
+}
+
+void ROOTObjectWriterModule::restoreState(std::istream& state) {
+    size_t trees = 0;
+    state >> std::quoted(output_file_name_) >> last_event_ >> write_cnt_ >> trees;
+    for(size_t i = 0; i < trees && state; ++i) {
+        std::string tree_name;
+        state >> std::quoted(tree_name);
+        resume_trees_.push_back(tree_name);
+    }
+    resume_ = true;
+}
@@ -64,6 +64,16 @@ namespace allpix {
          */
         void finalize() override;
 
+        /**
+         * @brief Flush all trees to the data file and store the position of the output in a checkpoint
+         */
+        void storeState(std::ostream& state) override;
+
+        /**
+         * @brief Restore the position of the output from a checkpoint to continue writing to the existing data file
+         */
+        void restoreState(std::istream& state) override;
+
     private:
         GeometryManager* geo_mgr_;
 
@@ -78,6 +88,12 @@ namespace allpix {
         // Last event processed
         unsigned int last_event_{0};
 
+        // Trees are only saved to the file at checkpoints, such that they match the event of the last checkpoint
+        bool checkpoints_{};
+        // Trees to continue in the existing data file when resuming from a checkpoint
+        bool resume_{};
+        std::vector<std::string> resume_trees_;
+
         // List of trees that are stored in data file
         std::map<std::string, std::unique_ptr<TTree>> trees_;
 
@@ -22,6 +22,7 @@
 #include "core/utils/log.h"
 #include "core/utils/unit.h"
 #include "tools/ROOT.h"
+#include "tools/charge_transfer.h"
 
 #include "objects/PixelCharge.hpp"
 
@@ -48,9 +49,15 @@ SimpleTransferModule::SimpleTransferModule(Configuration& config, Messenger* mes
 
     // Cache flag for output plots:
     output_plots_ = config_.get<bool>("output_plots");
+    mc_truth_ = getMCTruthLevel();
 
     // Require propagated deposits for single detector
     messenger->bindSingle(this, &SimpleTransferModule::propagated_message_, MsgFlags::REQUIRED);
+
+    // Histograms accumulate over the whole run and are not stored in checkpoints
+    if(!output_plots_) {
+        enable_checkpoints();
+    }
 }
 
 void SimpleTransferModule::init() {
@@ -78,80 +85,33 @@ void SimpleTransferModule::init() {
 void SimpleTransferModule::run(unsigned int) {
     // Find corresponding pixels for all propagated charges
     LOG(TRACE) << "Transferring charges to pixels";
-    unsigned int transferred_charges_count = 0;
-    std::map<Pixel::Index, std::vector<const PropagatedCharge*>> pixel_map;
-    for(auto& propagated_charge : propagated_message_->getData()) {
-        auto position = propagated_charge.getLocalPosition();
-        // Ignore if outside depth range of implant
-        // FIXME This logic should be improved
-        if(std::fabs(position.z() - (model_->getSensorCenter().z() + model_->getSensorSize().z() / 2.0)) >
-           config_.get<double>("max_depth_distance")) {
-            LOG(TRACE) << "Skipping set of " << propagated_charge.getCharge() << " propagated charges at "
-                       << Units::display(propagated_charge.getLocalPosition(), {"mm", "um"})
-                       << " because their local position is not in implant range";
-            continue;
-        }
-
-        // Find the nearest pixel
-        auto xpixel = static_cast<int>(std::round(position.x() / model_->getPixelSize().x()));
-        auto ypixel = static_cast<int>(std::round(position.y() / model_->getPixelSize().y()));
-
-        // Ignore if out of pixel grid
-        if(!detector_->isWithinPixelGrid(xpixel, ypixel)) {
-            LOG(TRACE) << "Skipping set of " << propagated_charge.getCharge() << " propagated charges at "
-                       << Units::display(propagated_charge.getLocalPosition(), {"mm", "um"})
-                       << " because their nearest pixel (" << xpixel << "," << ypixel << ") is outside the grid";
-            continue;
-        }
+    auto pixel_map = transfer_charges_to_pixels(*detector_,
+                                                propagated_message_->getData(),
+                                                config_.get<double>("max_depth_distance"),
+                                                config_.get<bool>("collect_from_implant"));
 
-        // Ignore if outside the implant region:
-        if(config_.get<bool>("collect_from_implant") && !detector_->isWithinImplant(position)) {
-            LOG(TRACE) << "Skipping set of " << propagated_charge.getCharge() << " propagated charges at "
-                       << Units::display(propagated_charge.getLocalPosition(), {"mm", "um"})
-                       << " because it is outside the pixel implant.";
-            continue;
-        }
-
-        Pixel::Index pixel_index(static_cast<unsigned int>(xpixel), static_cast<unsigned int>(ypixel));
-
-        // Update statistics
-        unique_pixels_.insert(pixel_index);
-        transferred_charges_count += propagated_charge.getCharge();
-
-        if(output_plots_) {
-            drift_time_histo->Fill(propagated_charge.getEventTime(), propagated_charge.getCharge());
+    // Update statistics
+    unsigned int transferred_charges_count = 0;
+    for(auto& pixel_index_charge : pixel_map) {
+        unique_pixels_.insert(pixel_index_charge.first);
+        for(auto& propagated_charge : pixel_index_charge.second) {
+            transferred_charges_count += propagated_charge->getCharge();
+            if(output_plots_) {
+                drift_time_histo->Fill(propagated_charge->getEventTime(), propagated_charge->getCharge());
+            }
         }
-
-        LOG(TRACE) << "Set of " << propagated_charge.getCharge() << " propagated charges at "
-                   << Units::display(propagated_charge.getLocalPosition(), {"mm", "um"}) << " brought to pixel "
-                   << pixel_index;
-
-        // Add the pixel the list of hit pixels
-        pixel_map[pixel_index].emplace_back(&propagated_charge);
     }
 
     // Create pixel charges
     LOG(TRACE) << "Combining charges at same pixel";
-    std::vector<PixelCharge> pixel_charges;
-    for(auto& pixel_index_charge : pixel_map) {
-        unsigned int charge = 0;
-        for(auto& propagated_charge : pixel_index_charge.second) {
-            charge += propagated_charge->getCharge();
-        }
-
-        // Get pixel object from detector
-        auto pixel = detector_->getPixel(pixel_index_charge.first.x(), pixel_index_charge.first.y());
-
-        pixel_charges.emplace_back(pixel, charge, pixel_index_charge.second);
-        LOG(DEBUG) << "Set of " << charge << " charges combined at " << pixel.getIndex();
-    }
+    auto pixel_charges = combine_pixel_charges(*detector_, pixel_map, mc_truth_);
 
     // Writing summary and update statistics
     LOG(INFO) << "Transferred " << transferred_charges_count << " charges to " << pixel_map.size() << " pixels";
     total_transferred_charges_ += transferred_charges_count;
 
     // Dispatch message of pixel charges
-    auto pixel_message = std::make_shared<PixelChargeMessage>(pixel_charges, detector_);
+    auto pixel_message = std::make_shared<PixelChargeMessage>(std::move(pixel_charges), detector_);
     messenger_->dispatchMessage(this, pixel_message);
 }
 
@@ -164,3 +124,20 @@ void SimpleTransferModule::finalize() {
         drift_time_histo->Write();
     }
 }
+
+void SimpleTransferModule::storeState(std::ostream& state) {
+    state << total_transferred_charges_ << " " << unique_pixels_.size();
+    for(auto& index : unique_pixels_) {
+        state << " " << index.x() << " " << index.y();
+    }
+}
+
+void SimpleTransferModule::restoreState(std::istream& state) {
+    size_t pixels = 0;
+    state >> total_transferred_charges_ >> pixels;
+    for(size_t i = 0; i < pixels && state; ++i) {
+        unsigned int x = 0, y = 0;
+        state >> x >> y;
+        unique_pixels_.emplace(x, y);
+    }
+}
@@ -58,6 +58,16 @@ namespace allpix {
          */
         void finalize() override;
 
+        /**
+         * @brief Store the transfer statistics in a checkpoint
+         */
+        void storeState(std::ostream& state) override;
+
+        /**
+         * @brief Restore the transfer statistics from a checkpoint
+         */
+        void restoreState(std::istream& state) override;
+
     private:
         Messenger* messenger_;
         std::shared_ptr<Detector> detector_;
@@ -71,6 +81,9 @@ namespace allpix {
         // Flag whether to store output plots:
         bool output_plots_{};
 
+        // Depth of the stored history
+        MCTruthLevel mc_truth_{};
+
         // Statistical information
         unsigned int total_transferred_charges_{};
         std::set<Pixel::Index> unique_pixels_;
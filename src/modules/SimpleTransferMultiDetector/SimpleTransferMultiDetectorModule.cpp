@@ -0,0 +1,192 @@
+/**
+ * @file
+ * @brief Implementation of multi-detector simple charge transfer module
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "SimpleTransferMultiDetectorModule.hpp"
+
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "core/config/exceptions.h"
+#include "core/utils/log.h"
+#include "core/utils/unit.h"
+#include "tools/ROOT.h"
+#include "tools/charge_transfer.h"
+
+using namespace allpix;
+
+SimpleTransferMultiDetectorModule::SimpleTransferMultiDetectorModule(Configuration& config,
+                                                                     Messenger* messenger,
+                                                                     std::vector<std::shared_ptr<Detector>> detectors)
+    : Module(config, std::move(detectors)), messenger_(messenger) {
+    // Set default value for the maximum depth distance to transfer
+    config_.setDefault("max_depth_distance", Units::get(5.0, "um"));
+
+    // By default, collect from the full sensor surface, not the implant region
+    config_.setDefault("collect_from_implant", false);
+
+    // Plotting parameters
+    config_.setDefault<bool>("output_plots", false);
+    config_.setDefault<double>("output_plots_step", Units::get(0.1, "ns"));
+    config_.setDefault<double>("output_plots_range", Units::get(100, "ns"));
+
+    // Cache configuration parameters used for every event
+    max_depth_distance_ = config_.get<double>("max_depth_distance");
+    collect_from_implant_ = config_.get<bool>("collect_from_implant");
+    output_plots_ = config_.get<bool>("output_plots");
+    mc_truth_ = getMCTruthLevel();
+
+    // Require propagated deposits for at least one of the detectors
+    messenger->bindMulti(this, &SimpleTransferMultiDetectorModule::propagated_messages_, MsgFlags::REQUIRED);
+}
+
+void SimpleTransferMultiDetectorModule::init() {
+    LOG(INFO) << "Transferring charges for " << getDetectors().size() << " detectors in one instantiation";
+
+    for(auto& detector : getDetectors()) {
+        if(collect_from_implant_) {
+            if(detector->getElectricFieldType() == FieldType::LINEAR) {
+                throw ModuleError("Charge collection from implant region should not be used with linear electric fields "
+                                  "(detector " +
+                                  detector->getName() + ").");
+            }
+            LOG(INFO) << "Collecting charges from implants with size "
+                      << Units::display(detector->getModel()->getImplantSize(), {"um"}) << " for detector "
+                      << detector->getName();
+        }
+
+        if(output_plots_) {
+            auto time_bins =
+                static_cast<int>(config_.get<double>("output_plots_range") / config_.get<double>("output_plots_step"));
+            auto name = "drift_time_histo_" + detector->getName();
+            auto title = "Charge carrier arrival time for " + detector->getName() + ";t[ns];charge carriers";
+            drift_time_histos_[detector->getName()] = new TH1D(
+                name.c_str(), title.c_str(), time_bins, 0., config_.get<double>("output_plots_range"));
+        }
+    }
+}
+
+void SimpleTransferMultiDetectorModule::run(unsigned int) {
+    // Submit one task per detector and help executing them
+    auto& pool = getThreadPool();
+    std::vector<std::future<Transfer>> transfers;
+    for(auto& message : propagated_messages_) {
+        transfers.push_back(pool.submit(
+            this, [this](const std::shared_ptr<PropagatedChargeMessage>& msg) { return transfer(msg); }, message));
+    }
+    pool.execute(this);
+
+    // Wait for all tasks, propagate exceptions and dispatch the pixel charges in the order of the detectors
+    unsigned int transferred_charges_count = 0;
+    for(auto& result : transfers) {
+        transferred_charges_count += dispatch(result.get());
+    }
+
+    LOG(INFO) << "Transferred " << transferred_charges_count << " charges in " << propagated_messages_.size()
+              << " detectors";
+    total_transferred_charges_ += transferred_charges_count;
+}
+
+/**
+ * The detectors of all events of the batch are transferred in one set of tasks, such that the thread pool only has to be
+ * synchronized once per batch instead of once per event. The pixel charges are dispatched for every event afterwards.
+ */
+void SimpleTransferMultiDetectorModule::runBatch(unsigned int first_event, unsigned int events) {
+    // Submit one task per detector and event, keeping the messages of every event after releasing them
+    auto& pool = getThreadPool();
+    std::vector<std::vector<std::future<Transfer>>> transfers(events);
+    for(unsigned int i = 0; i < events; ++i) {
+        if(receive_batch_event(i)) {
+            for(auto& message : propagated_messages_) {
+                transfers[i].push_back(pool.submit(
+                    this, [this](const std::shared_ptr<PropagatedChargeMessage>& msg) { return transfer(msg); }, message));
+            }
+        }
+        release_batch_event();
+    }
+    pool.execute(this);
+
+    // Wait for all tasks and dispatch the pixel charges of every event in the order of the detectors
+    for(unsigned int i = 0; i < events; ++i) {
+        select_batch_event(i);
+        unsigned int transferred_charges_count = 0;
+        for(auto& result : transfers[i]) {
+            transferred_charges_count += dispatch(result.get());
+        }
+
+        LOG(INFO) << "Transferred " << transferred_charges_count << " charges in " << transfers[i].size()
+                  << " detectors in event " << (first_event + i);
+        total_transferred_charges_ += transferred_charges_count;
+    }
+}
+
+/**
+ * The transfer only reads the module state, such that tasks of the same detector in different events of a batch can run
+ * concurrently. The statistics are collected in the result and merged by the module thread.
+ */
+SimpleTransferMultiDetectorModule::Transfer
+SimpleTransferMultiDetectorModule::transfer(const std::shared_ptr<PropagatedChargeMessage>& message) const {
+    auto detector = message->getDetector();
+
+    // Find corresponding pixels for all propagated charges
+    auto pixel_map = transfer_charges_to_pixels(*detector, message->getData(), max_depth_distance_, collect_from_implant_);
+
+    // Count the transferred charges and record their arrival times
+    Transfer transferred;
+    for(auto& pixel_index_charge : pixel_map) {
+        for(auto& propagated_charge : pixel_index_charge.second) {
+            transferred.charges += propagated_charge->getCharge();
+            if(output_plots_) {
+                transferred.arrival_times.emplace_back(propagated_charge->getEventTime(), propagated_charge->getCharge());
+            }
+        }
+    }
+
+    // Create pixel charges
+    auto pixel_charges = combine_pixel_charges(*detector, pixel_map, mc_truth_);
+    LOG(DEBUG) << "Transferred " << transferred.charges << " charges to " << pixel_map.size() << " pixels in detector "
+               << detector->getName();
+
+    // Create the message of pixel charges for this detector, dispatched by the calling module thread
+    transferred.message = std::make_shared<PixelChargeMessage>(std::move(pixel_charges), detector);
+    return transferred;
+}
+
+unsigned int SimpleTransferMultiDetectorModule::dispatch(const Transfer& transferred) {
+    auto name = transferred.message->getDetector()->getName();
+
+    // Update statistics
+    auto& unique_pixels = unique_pixels_[name];
+    for(auto& pixel_charge : transferred.message->getData()) {
+        unique_pixels.insert(pixel_charge.getPixel().getIndex());
+    }
+    for(auto& arrival_time : transferred.arrival_times) {
+        drift_time_histos_.at(name)->Fill(arrival_time.first, arrival_time.second);
+    }
+
+    messenger_->dispatchMessage(this, transferred.message);
+    return transferred.charges;
+}
+
+void SimpleTransferMultiDetectorModule::finalize() {
+    // Print statistics
+    size_t unique_pixels = 0;
+    for(auto& detector_pixels : unique_pixels_) {
+        unique_pixels += detector_pixels.second.size();
+    }
+    LOG(INFO) << "Transferred total of " << total_transferred_charges_ << " charges to " << unique_pixels
+              << " different pixels in " << getDetectors().size() << " detectors";
+
+    if(output_plots_) {
+        for(auto& histo : drift_time_histos_) {
+            histo.second->Write();
+        }
+    }
+}
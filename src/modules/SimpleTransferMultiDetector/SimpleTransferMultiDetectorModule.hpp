@@ -0,0 +1,117 @@
+/**
+ * @file
+ * @brief Definition of multi-detector simple charge transfer module
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <TH1D.h>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/Pixel.hpp"
+#include "objects/PixelCharge.hpp"
+#include "objects/PropagatedCharge.hpp"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module that directly converts propagated charges to charges on a pixel for many detectors at once
+     *
+     * Multi-detector version of the SimpleTransferModule: a single instantiation receives the propagated charges of all its
+     * detectors and transfers them in parallel tasks, one per detector. The pixel charges are dispatched in a separate
+     * message for every detector.
+     */
+    class SimpleTransferMultiDetectorModule : public Module {
+    public:
+        /**
+         * @brief Constructor for this multi-detector module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param detectors List of all detectors handled by this module instance
+         */
+        SimpleTransferMultiDetectorModule(Configuration& config,
+                                          Messenger* messenger,
+                                          std::vector<std::shared_ptr<Detector>> detectors);
+
+        /**
+         * @brief Initialize - check for field configuration and implants of all detectors
+         */
+        void init() override;
+
+        /**
+         * @brief Transfer the propagated charges of all detectors to their pixels
+         */
+        void run(unsigned int) override;
+
+        /**
+         * @brief Transfer the propagated charges of all detectors in all events of a batch to their pixels
+         * @param first_event Number of the first event of the batch
+         * @param events Number of events in the batch
+         */
+        void runBatch(unsigned int first_event, unsigned int events) override;
+
+        /**
+         * @brief Display statistical summary
+         */
+        void finalize() override;
+
+    private:
+        /**
+         * @brief Result of the transfer of a single detector
+         */
+        struct Transfer {
+            // Message of pixel charges of the detector
+            std::shared_ptr<PixelChargeMessage> message;
+            // Number of charges transferred
+            unsigned int charges{};
+            // Arrival times of the transferred charges together with their charge, only filled for output plots
+            std::vector<std::pair<double, unsigned int>> arrival_times;
+        };
+
+        /**
+         * @brief Transfer the propagated charges of a single detector to its pixels
+         * @param message Message with the propagated charges of the detector
+         * @return Pixel charges of the detector, number of transferred charges and their arrival times
+         */
+        Transfer transfer(const std::shared_ptr<PropagatedChargeMessage>& message) const;
+
+        /**
+         * @brief Add the result of a transfer to the statistics of its detector and dispatch its pixel charges
+         * @param transferred Result of the transfer of a single detector
+         * @return Number of transferred charges
+         */
+        unsigned int dispatch(const Transfer& transferred);
+
+        Messenger* messenger_;
+
+        // Messages containing the propagated charges of all detectors
+        std::vector<std::shared_ptr<PropagatedChargeMessage>> propagated_messages_;
+
+        // Cached configuration parameters
+        double max_depth_distance_{};
+        bool collect_from_implant_{};
+        bool output_plots_{};
+        MCTruthLevel mc_truth_{};
+
+        // Per-detector histograms and statistics, only updated by the module thread after the transfer tasks finished
+        std::map<std::string, TH1D*> drift_time_histos_;
+        std::map<std::string, std::set<Pixel::Index>> unique_pixels_;
+
+        // Statistical information
+        std::atomic<unsigned int> total_transferred_charges_{};
+    };
+} // namespace allpix
@@ -9,9 +9,13 @@
 
 #include "TextWriterModule.hpp"
 
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
+#include <iomanip>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <TBranchElement.h>
 #include <TClass.h>
@@ -29,6 +33,9 @@ using namespace allpix;
 TextWriterModule::TextWriterModule(Configuration& config, Messenger* messenger, GeometryManager*) : Module(config) {
     // Bind to all messages
     messenger->registerListener(this, &TextWriterModule::receive);
+
+    // The output file is continued after the last checkpoint when the run is resumed
+    enable_checkpoints();
 }
 /**
  * @note Objects cannot be stored in smart pointers due to internal ROOT logic
@@ -41,12 +48,44 @@ TextWriterModule::~TextWriterModule() {
 }
 
 void TextWriterModule::init() {
-    // Create output file
-    output_file_name_ =
-        createOutputFile(allpix::add_file_extension(config_.get<std::string>("file_name", "data"), "txt"), true);
-    output_file_ = std::make_unique<std::ofstream>(output_file_name_);
+    if(resume_) {
+        // Move the output file of the interrupted run aside, it might contain data written after the last checkpoint
+        auto checkpoint_file_name = output_file_name_ + ".checkpoint";
+        if(std::rename(output_file_name_.c_str(), checkpoint_file_name.c_str()) != 0) {
+            throw ModuleError("Cannot move output file " + output_file_name_ + " to resume the run");
+        }
+        std::ifstream checkpoint_file(checkpoint_file_name, std::ios::binary);
+        output_file_ = std::make_unique<std::ofstream>(output_file_name_, std::ios::binary);
+
+        // Copy the data written up to the checkpoint to a new output file
+        std::vector<char> buffer(1 << 16);
+        auto remaining = resume_position_;
+        while(remaining > 0 && checkpoint_file.good()) {
+            checkpoint_file.read(buffer.data(), std::min(remaining, static_cast<long long>(buffer.size())));
+            output_file_->write(buffer.data(), checkpoint_file.gcount());
+            remaining -= checkpoint_file.gcount();
+        }
+        if(remaining > 0 || !output_file_->good()) {
+            throw ModuleError("Cannot copy the " + std::to_string(resume_position_) + " bytes of the checkpoint from " +
+                              checkpoint_file_name + " to the resumed output file");
+        }
 
-    *output_file_ << "# Allpix Squared ASCII data - https://cern.ch/allpix-squared" << std::endl << std::endl;
+        // Drop the file of the interrupted run, including the data written after the checkpoint
+        checkpoint_file.close();
+        try {
+            allpix::remove_file(checkpoint_file_name);
+        } catch(std::invalid_argument&) {
+            LOG(WARNING) << "Cannot remove output file " << checkpoint_file_name << " of the interrupted run";
+        }
+        LOG(INFO) << "Continuing output file " << output_file_name_ << " after " << resume_position_ << " bytes";
+    } else {
+        // Create output file
+        output_file_name_ =
+            createOutputFile(allpix::add_file_extension(config_.get<std::string>("file_name", "data"), "txt"), true);
+        output_file_ = std::make_unique<std::ofstream>(output_file_name_);
+
+        *output_file_ << "# Allpix Squared ASCII data - https://cern.ch/allpix-squared" << std::endl << std::endl;
+    }
 
     // Read include and exclude list
     if(config_.has("include") && config_.has("exclude")) {
@@ -141,3 +180,14 @@ void TextWriterModule::finalize() {
     LOG(STATUS) << "Wrote " << write_cnt_ << " objects from " << msg_cnt_ << " messages to file:" << std::endl
                 << output_file_name_;
 }
+
+void TextWriterModule::storeState(std::ostream& state) {
+    output_file_->flush();
+    state << std::quoted(output_file_name_) << " " << static_cast<long long>(output_file_->tellp()) << " " << write_cnt_
+          << " " << msg_cnt_;
+}
+
+void TextWriterModule::restoreState(std::istream& state) {
+    state >> std::quoted(output_file_name_) >> resume_position_ >> write_cnt_ >> msg_cnt_;
+    resume_ = true;
+}
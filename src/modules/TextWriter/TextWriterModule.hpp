@@ -60,6 +60,16 @@ namespace allpix {
          */
         void finalize() override;
 
+        /**
+         * @brief Flush the output file and store its position and the statistics in a checkpoint
+         */
+        void storeState(std::ostream& state) override;
+
+        /**
+         * @brief Restore the position of the output file and the statistics from a checkpoint
+         */
+        void restoreState(std::istream& state) override;
+
     private:
         // Object names to include or exclude from writing
         std::set<std::string> include_;
@@ -69,6 +79,10 @@ namespace allpix {
         std::string output_file_name_{};
         std::unique_ptr<std::ofstream> output_file_;
 
+        // Resume the output file of an interrupted run, which had the given size at its last checkpoint
+        bool resume_{false};
+        long long resume_position_{};
+
         // List of messages to keep so they can be stored in the tree
         std::vector<std::shared_ptr<BaseMessage>> keep_messages_;
         // List of objects of a particular type, bound to a specific detector and having a particular name
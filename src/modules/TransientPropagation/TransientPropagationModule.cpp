@@ -9,11 +9,13 @@
 
 #include "TransientPropagationModule.hpp"
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <random>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <Eigen/Core>
 
@@ -45,24 +47,49 @@ TransientPropagationModule::TransientPropagationModule(Configuration& config,
 
     // Set default value for config variables
     config_.setDefault<double>("timestep", Units::get(0.01, "ns"));
+    config_.setDefault<double>("timestep_min", config_.get<double>("timestep"));
+    config_.setDefault<double>("timestep_max", config_.get<double>("timestep"));
+    config_.setDefault<double>("spatial_precision", Units::get(0.25, "nm"));
     config_.setDefault<double>("integration_time", Units::get(25, "ns"));
     config_.setDefault<unsigned int>("charge_per_step", 10);
     config_.setDefault<double>("temperature", 293.15);
     config_.setDefault<bool>("output_plots", false);
     config_.setDefault<XYVectorInt>("induction_matrix", XYVectorInt(3, 3));
     config_.setDefault<bool>("ignore_magnetic_field", false);
+    config_.setDefault<bool>("precompute_velocities", false);
+    config_.setDefault<bool>("precompute_weighting_potential", false);
+    config_.setDefaultArray<size_t>("weighting_potential_bins", {50, 50, 100});
 
     // Copy some variables from configuration to avoid lookups:
     temperature_ = config_.get<double>("temperature");
     timestep_ = config_.get<double>("timestep");
+    timestep_min_ = config_.get<double>("timestep_min");
+    timestep_max_ = config_.get<double>("timestep_max");
+    target_spatial_precision_ = config_.get<double>("spatial_precision");
     integration_time_ = config_.get<double>("integration_time");
     matrix_ = config_.get<XYVectorInt>("induction_matrix");
 
+    if(timestep_ <= 0) {
+        throw InvalidValueError(config_, "timestep", "Time step has to be positive.");
+    }
+    if(timestep_min_ <= 0 || timestep_min_ > timestep_max_) {
+        throw InvalidValueError(
+            config_, "timestep_min", "Minimum time step has to be positive and not larger than the maximum time step.");
+    }
+    if(timestep_min_ < timestep_max_) {
+        LOG(INFO) << "Adapting the time step between " << Units::display(timestep_min_, {"ps", "ns"}) << " and "
+                  << Units::display(timestep_max_, {"ps", "ns"}) << ", pulses are binned in steps of "
+                  << Units::display(timestep_, {"ps", "ns"});
+    }
+
     if(matrix_.x() % 2 == 0 || matrix_.y() % 2 == 0) {
         throw InvalidValueError(config_, "induction_matrix", "Odd number of pixels in x and y required.");
     }
 
     output_plots_ = config_.get<bool>("output_plots");
+    precompute_velocities_ = config_.get<bool>("precompute_velocities");
+    precompute_weighting_potential_ = config_.get<bool>("precompute_weighting_potential");
+    mc_truth_ = getMCTruthLevel();
 
     // Parameterization variables from https://doi.org/10.1016/0038-1101(77)90054-5 (section 5.2)
     electron_Vm_ = Units::get(1.53e9 * std::pow(temperature_, -0.87), "cm/s");
@@ -79,6 +106,11 @@ TransientPropagationModule::TransientPropagationModule(Configuration& config,
     // http://www.ioffe.ru/SVA/NSM/Semicond/Si/electric.html) FIXME
     electron_Hall_ = 1.15;
     hole_Hall_ = 0.9;
+
+    // Histograms accumulate over the whole run and are not stored in checkpoints
+    if(!output_plots_) {
+        enable_checkpoints();
+    }
 }
 
 void TransientPropagationModule::init() {
@@ -106,8 +138,56 @@ void TransientPropagationModule::init() {
             LOG(WARNING) << "A magnetic field is switched on, but is set to be ignored for this module.";
         } else {
             LOG(DEBUG) << "This detector sees a magnetic field.";
-            magnetic_field_ = detector_->getMagneticField();
+            // Constant fields are cached, field grids are looked up at the current position in every integration step
+            magnetic_field_grid_ = (detector_->getMagneticFieldType() == FieldType::GRID);
+            magnetic_field_ = detector_->getMagneticField(model_->getSensorCenter());
+        }
+    }
+
+    // Precompute drift velocity and mobility of both charge carrier types from the electric field
+    if(precompute_velocities_) {
+        if(!detector->hasElectricField()) {
+            LOG(WARNING) << "No electric field available, drift velocities are not precomputed";
+            precompute_velocities_ = false;
+        } else if(has_magnetic_field_ && magnetic_field_grid_) {
+            LOG(WARNING) << "Drift velocities cannot be precomputed for magnetic field grids";
+            precompute_velocities_ = false;
+        } else {
+            auto threads = getWorkerCount();
+            auto bfield_mag2 = (has_magnetic_field_ ? magnetic_field_.Mag2() : 0.);
+            for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+                // In magnetic fields, only the drift along the electric field is stored, the Lorentz terms are added during
+                // propagation from the mobility since they do not commute with the unfolding of symmetric field grids
+                auto hall = (type == CarrierType::ELECTRON ? electron_Hall_ : hole_Hall_);
+                std::function<ROOT::Math::XYZVector(const ROOT::Math::XYZVector&)> velocity =
+                    [this, type, hall, bfield_mag2](const ROOT::Math::XYZVector& efield) {
+                        auto mob = carrier_mobility(type, std::sqrt(efield.Mag2()));
+                        return static_cast<int>(type) * mob * efield / (1 + mob * mob * hall * hall * bfield_mag2);
+                    };
+                std::function<double(const ROOT::Math::XYZVector&)> mobility =
+                    [this, type](const ROOT::Math::XYZVector& efield) {
+                        return carrier_mobility(type, std::sqrt(efield.Mag2()));
+                    };
+
+                velocity_fields_[type] = detector->deriveElectricField<ROOT::Math::XYZVector, 3>(velocity, threads);
+                mobility_fields_[type] = detector->deriveElectricField<double, 1>(mobility, threads);
+            }
+            LOG(INFO) << "Precomputed drift velocity and mobility of electrons and holes";
+        }
+    }
+
+    // Tabulate the weighting potential of the induction matrix to look up all pixels at once
+    if(precompute_weighting_potential_) {
+        auto bins = config_.getArray<size_t>("weighting_potential_bins");
+        if(bins.size() != 3 || std::find(bins.begin(), bins.end(), static_cast<size_t>(0)) != bins.end()) {
+            throw InvalidValueError(
+                config_, "weighting_potential_bins", "three non-zero numbers of bins in x, y and z required");
         }
+        auto threads = getWorkerCount();
+        weighting_potential_ =
+            detector_->tabulateWeightingPotential({{matrix_.x(), matrix_.y()}}, {{bins[0], bins[1], bins[2]}}, threads);
+        LOG(INFO) << "Precomputed weighting potential for induction matrix of " << matrix_.x() << "x" << matrix_.y()
+                  << " pixels";
     }
 
     if(output_plots_) {
@@ -176,14 +256,14 @@ void TransientPropagationModule::run(unsigned int) {
             std::map<Pixel::Index, Pulse> px_map;
             auto prop_pair = propagate(position, deposit.getType(), charge_per_step, px_map);
 
-            // Create a new propagated charge and add it to the list
-            auto global_position = detector_->getGlobalPosition(prop_pair.first);
+            // Create a new propagated charge and add it to the list, the global position is only calculated on demand
             PropagatedCharge propagated_charge(prop_pair.first,
-                                               global_position,
+                                               detector_->getLocalToGlobalTransform(),
                                                deposit.getType(),
                                                px_map,
                                                deposit.getEventTime() + prop_pair.second,
-                                               &deposit);
+                                               &deposit,
+                                               mc_truth_ == MCTruthLevel::FULL);
 
             LOG(DEBUG) << " Propagated " << charge_per_step << " to " << Units::display(prop_pair.first, {"mm", "um"})
                        << " in " << Units::display(prop_pair.second, "ns") << " time, induced "
@@ -204,6 +284,23 @@ void TransientPropagationModule::run(unsigned int) {
     messenger_->dispatchMessage(this, propagated_charge_message);
 }
 
+/**
+ * The mobility is computed from the parameterization of https://doi.org/10.1016/0038-1101(77)90054-5.
+ * NOTE This function is typically the most frequently executed part of the framework and therefore the bottleneck
+ */
+double TransientPropagationModule::carrier_mobility(const CarrierType& type, double efield_mag) const {
+    // Compute carrier mobility from constants and electric field magnitude
+    double numerator, denominator;
+    if(type == CarrierType::ELECTRON) {
+        numerator = electron_Vm_ / electron_Ec_;
+        denominator = std::pow(1. + std::pow(efield_mag / electron_Ec_, electron_Beta_), 1.0 / electron_Beta_);
+    } else {
+        numerator = hole_Vm_ / hole_Ec_;
+        denominator = std::pow(1. + std::pow(efield_mag / hole_Ec_, hole_Beta_), 1.0 / hole_Beta_);
+    }
+    return numerator / denominator;
+}
+
 /**
  * Propagation is simulated using a parameterization for the electron mobility. This is used to calculate the electron
  * velocity at every point with help of the electric field map of the detector. A Runge-Kutta integration is applied in
@@ -217,24 +314,17 @@ std::pair<ROOT::Math::XYZPoint, double> TransientPropagationModule::propagate(co
     // Create a runge kutta solver using the electric field as step function
     Eigen::Vector3d position(pos.x(), pos.y(), pos.z());
 
-    // Define a lambda function to compute the carrier mobility
-    // NOTE This function is typically the most frequently executed part of the framework and therefore the bottleneck
-    auto carrier_mobility = [&](double efield_mag) {
-        // Compute carrier mobility from constants and electric field magnitude
-        double numerator, denominator;
-        if(type == CarrierType::ELECTRON) {
-            numerator = electron_Vm_ / electron_Ec_;
-            denominator = std::pow(1. + std::pow(efield_mag / electron_Ec_, electron_Beta_), 1.0 / electron_Beta_);
-        } else {
-            numerator = hole_Vm_ / hole_Ec_;
-            denominator = std::pow(1. + std::pow(efield_mag / hole_Ec_, hole_Beta_), 1.0 / hole_Beta_);
-        }
-        return numerator / denominator;
-    };
+    // Precomputed drift velocity and mobility of this carrier type, if available
+    const DetectorField<ROOT::Math::XYZVector, 3>* velocity_field = nullptr;
+    const DetectorField<double, 1>* mobility_field = nullptr;
+    if(precompute_velocities_) {
+        velocity_field = &velocity_fields_.at(type);
+        mobility_field = &mobility_fields_.at(type);
+    }
 
     // Define a function to compute the diffusion
-    auto carrier_diffusion = [&](double efield_mag, double timestep) -> Eigen::Vector3d {
-        double diffusion_constant = boltzmann_kT_ * carrier_mobility(efield_mag);
+    auto carrier_diffusion = [&](double mobility, double timestep) -> Eigen::Vector3d {
+        double diffusion_constant = boltzmann_kT_ * mobility;
         double diffusion_std_dev = std::sqrt(2. * diffusion_constant * timestep);
 
         // Compute the independent diffusion in three
@@ -252,7 +342,7 @@ std::pair<ROOT::Math::XYZPoint, double> TransientPropagationModule::propagate(co
         auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
         Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
 
-        return static_cast<int>(type) * carrier_mobility(efield.norm()) * efield;
+        return static_cast<int>(type) * carrier_mobility(type, efield.norm()) * efield;
     };
 
     std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_withB =
@@ -260,10 +350,11 @@ std::pair<ROOT::Math::XYZPoint, double> TransientPropagationModule::propagate(co
         auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
         Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
 
-        Eigen::Vector3d velocity;
-        Eigen::Vector3d bfield(magnetic_field_.x(), magnetic_field_.y(), magnetic_field_.z());
+        auto raw_bfield = (magnetic_field_grid_ ? detector_->getMagneticField(static_cast<ROOT::Math::XYZPoint>(cur_pos))
+                                                : magnetic_field_);
+        Eigen::Vector3d bfield(raw_bfield.x(), raw_bfield.y(), raw_bfield.z());
 
-        auto mob = carrier_mobility(efield.norm());
+        auto mob = carrier_mobility(type, efield.norm());
         auto exb = efield.cross(bfield);
 
         Eigen::Vector3d term1;
@@ -276,31 +367,93 @@ std::pair<ROOT::Math::XYZPoint, double> TransientPropagationModule::propagate(co
         return static_cast<int>(type) * mob * (efield + term1 + term2) / rnorm;
     };
 
-    // Create the runge kutta solver with an RKF5 tableau
+    // Define lambda functions to read the precomputed velocity, adding the Lorentz terms for a constant magnetic field
+    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_precomputed_noB =
+        [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        auto raw_velocity = velocity_field->get(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        return Eigen::Vector3d(raw_velocity.x(), raw_velocity.y(), raw_velocity.z());
+    };
+
+    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_precomputed_withB =
+        [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        auto raw_velocity = velocity_field->get(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        Eigen::Vector3d drift(raw_velocity.x(), raw_velocity.y(), raw_velocity.z());
+        Eigen::Vector3d bfield(magnetic_field_.x(), magnetic_field_.y(), magnetic_field_.z());
+
+        double hallFactor = (type == CarrierType::ELECTRON ? electron_Hall_ : hole_Hall_);
+        auto hall_mob = hallFactor * mobility_field->get(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        return drift + static_cast<int>(type) * hall_mob * drift.cross(bfield) +
+               hall_mob * hall_mob * drift.dot(bfield) * bfield;
+    };
+
+    // Create the runge kutta solver with an RKF5 tableau, using different velocity calculators depending on the magnetic
+    // field and the availability of precomputed velocities
+    auto& carrier_velocity_precomputed =
+        (has_magnetic_field_ ? carrier_velocity_precomputed_withB : carrier_velocity_precomputed_noB);
+    auto& carrier_velocity_direct = (has_magnetic_field_ ? carrier_velocity_withB : carrier_velocity_noB);
+    auto& carrier_velocity = (velocity_field != nullptr ? carrier_velocity_precomputed : carrier_velocity_direct);
     auto runge_kutta = make_runge_kutta(
-        tableau::RK5, (has_magnetic_field_ ? carrier_velocity_withB : carrier_velocity_noB), timestep_, position);
+        tableau::RK5, carrier_velocity, std::min(std::max(timestep_, timestep_min_), timestep_max_), position);
+
+    // Fractions of the charge induced in the current step falling into the individual pulse bins
+    std::vector<std::pair<double, double>> bin_fractions;
 
     // Continue propagation until the deposit is outside the sensor
     Eigen::Vector3d last_position = position;
+    double last_time = 0;
     bool within_sensor = true;
     while(within_sensor && runge_kutta.getTime() < integration_time_) {
         // Save previous position and time
         last_position = position;
+        last_time = runge_kutta.getTime();
 
         // Execute a Runge Kutta step
         auto step = runge_kutta.step();
 
-        // Get the current result
+        // Get the current result and timestep
+        auto timestep = runge_kutta.getTimeStep();
         position = runge_kutta.getValue();
 
-        // Get electric field at current position and fall back to empty field if it does not exist
-        auto efield = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(position));
+        // Get mobility at current position, either precomputed or from the electric field
+        double mobility = 0;
+        if(mobility_field != nullptr) {
+            // Outside the domain of the field the grid returns zero, where the zero-field mobility applies
+            mobility = mobility_field->get(static_cast<ROOT::Math::XYZPoint>(position));
+            if(mobility <= 0) {
+                mobility = carrier_mobility(type, 0);
+            }
+        } else {
+            // Get electric field at current position and fall back to empty field if it does not exist
+            auto efield = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(position));
+            mobility = carrier_mobility(type, std::sqrt(efield.Mag2()));
+        }
 
         // Apply diffusion step
-        auto diffusion = carrier_diffusion(std::sqrt(efield.Mag2()), timestep_);
+        auto diffusion = carrier_diffusion(mobility, timestep);
         position += diffusion;
         runge_kutta.setValue(position);
 
+        // Adapt step size to match target precision
+        double uncertainty = step.error.norm();
+
+        // Lower timestep when reaching the sensor edge
+        if(std::fabs(model_->getSensorSize().z() / 2.0 - position.z()) < 2 * step.value.z()) {
+            timestep *= 0.75;
+        } else {
+            if(uncertainty > target_spatial_precision_) {
+                timestep *= 0.75;
+            } else if(2 * uncertainty < target_spatial_precision_) {
+                timestep *= 1.5;
+            }
+        }
+        // Limit the timestep to certain minimum and maximum step sizes
+        if(timestep > timestep_max_) {
+            timestep = timestep_max_;
+        } else if(timestep < timestep_min_) {
+            timestep = timestep_min_;
+        }
+        runge_kutta.setTimeStep(timestep);
+
         // Update step length histogram
         if(output_plots_) {
             step_length_histo_->Fill(static_cast<double>(Units::convert(step.value.norm(), "um")));
@@ -338,14 +491,47 @@ std::pair<ROOT::Math::XYZPoint, double> TransientPropagationModule::propagate(co
         }
 
         // Find the nearest pixel
-        auto xpixel = static_cast<int>(std::round(position.x() / model_->getPixelSize().x()));
-        auto ypixel = static_cast<int>(std::round(position.y() / model_->getPixelSize().y()));
+        auto nearest_pixel = detector_->getPixelIndex(static_cast<ROOT::Math::XYZPoint>(position));
+        auto xpixel = nearest_pixel.first;
+        auto ypixel = nearest_pixel.second;
         LOG(TRACE) << "Moving carriers below pixel "
                    << Pixel::Index(static_cast<unsigned int>(xpixel), static_cast<unsigned int>(ypixel)) << " from "
                    << Units::display(static_cast<ROOT::Math::XYZPoint>(last_position), {"um", "mm"}) << " to "
                    << Units::display(static_cast<ROOT::Math::XYZPoint>(position), {"um", "mm"}) << ", "
                    << Units::display(runge_kutta.getTime(), "ns");
 
+        // Distribute the charge induced in this step over the pulse bins covered by the step, assuming a constant current
+        // during the step. Pulse bin n holds the charge induced in the time interval ((n-1)*timestep, n*timestep], such that
+        // steps of exactly one bin width fill a single bin. A small tolerance absorbs the rounding of the accumulated time.
+        bin_fractions.clear();
+        auto time = runge_kutta.getTime();
+        auto first_bin = std::floor(last_time / timestep_ + 1e-6) + 1;
+        auto last_bin = std::max(std::ceil(time / timestep_ - 1e-6), first_bin);
+        double total_overlap = 0;
+        for(auto bin = first_bin; bin <= last_bin; ++bin) {
+            auto overlap = std::min(time, bin * timestep_) - std::max(last_time, (bin - 1) * timestep_);
+            if(overlap > 0) {
+                bin_fractions.emplace_back(bin * timestep_, overlap);
+                total_overlap += overlap;
+            }
+        }
+        if(bin_fractions.empty()) {
+            bin_fractions.emplace_back(last_bin * timestep_, 1.);
+            total_overlap = 1.;
+        }
+        for(auto& bin_fraction : bin_fractions) {
+            bin_fraction.second /= total_overlap;
+        }
+
+        // Look up the precomputed weighting potential of all pixels at once, if available. The previous position can be in
+        // the cell of a different pixel, then the weighting potential is looked up for every pixel individually.
+        const double* ramo_matrix = nullptr;
+        const double* last_ramo_matrix = nullptr;
+        if(weighting_potential_.isValid()) {
+            ramo_matrix = weighting_potential_.get(static_cast<ROOT::Math::XYZPoint>(position), nearest_pixel);
+            last_ramo_matrix = weighting_potential_.get(static_cast<ROOT::Math::XYZPoint>(last_position), nearest_pixel);
+        }
+
         // Loop over NxN pixels:
         for(int x = xpixel - matrix_.x() / 2; x <= xpixel + matrix_.x() / 2; x++) {
             for(int y = ypixel - matrix_.y() / 2; y <= ypixel + matrix_.y() / 2; y++) {
@@ -356,9 +542,16 @@ std::pair<ROOT::Math::XYZPoint, double> TransientPropagationModule::propagate(co
                 }
 
                 Pixel::Index pixel_index(static_cast<unsigned int>(x), static_cast<unsigned int>(y));
-                auto ramo = detector_->getWeightingPotential(static_cast<ROOT::Math::XYZPoint>(position), pixel_index);
+                auto matrix_index =
+                    static_cast<size_t>((x - xpixel + matrix_.x() / 2) * matrix_.y() + (y - ypixel + matrix_.y() / 2));
+                auto ramo =
+                    (ramo_matrix != nullptr
+                         ? ramo_matrix[matrix_index]
+                         : detector_->getWeightingPotential(static_cast<ROOT::Math::XYZPoint>(position), pixel_index));
                 auto last_ramo =
-                    detector_->getWeightingPotential(static_cast<ROOT::Math::XYZPoint>(last_position), pixel_index);
+                    (last_ramo_matrix != nullptr
+                         ? last_ramo_matrix[matrix_index]
+                         : detector_->getWeightingPotential(static_cast<ROOT::Math::XYZPoint>(last_position), pixel_index));
 
                 // Induced charge on electrode is q_int = q * (phi(x1) - phi(x0))
                 auto induced = charge * (ramo - last_ramo) * (-static_cast<std::underlying_type<CarrierType>::type>(type));
@@ -367,7 +560,9 @@ std::pair<ROOT::Math::XYZPoint, double> TransientPropagationModule::propagate(co
 
                 // Create pulse if it doesn't exist. Store induced charge in the returned pulse iterator
                 auto pixel_map_iterator = pixel_map.emplace(pixel_index, Pulse(timestep_));
-                pixel_map_iterator.first->second.addCharge(induced, runge_kutta.getTime());
+                for(const auto& bin_fraction : bin_fractions) {
+                    pixel_map_iterator.first->second.addCharge(induced * bin_fraction.second, bin_fraction.first);
+                }
 
                 if(output_plots_) {
                     potential_difference_->Fill(std::fabs(ramo - last_ramo));
@@ -396,3 +591,11 @@ void TransientPropagationModule::finalize() {
         induced_charge_h_histo_->Write();
     }
 }
+
+void TransientPropagationModule::storeState(std::ostream& state) {
+    state << random_generator_;
+}
+
+void TransientPropagationModule::restoreState(std::istream& state) {
+    state >> random_generator_;
+}
@@ -7,6 +7,7 @@
  * Intergovernmental Organization or submit itself to any jurisdiction.
  */
 
+#include <map>
 #include <string>
 
 #include <Math/DisplacementVector2D.h>
@@ -14,6 +15,7 @@
 #include <TH1D.h>
 
 #include "core/config/Configuration.hpp"
+#include "core/geometry/DetectorField.hpp"
 #include "core/geometry/DetectorModel.hpp"
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Module.hpp"
@@ -57,6 +59,16 @@ namespace allpix {
          */
         void finalize() override;
 
+        /**
+         * @brief Store the state of the random number generator in a checkpoint
+         */
+        void storeState(std::ostream& state) override;
+
+        /**
+         * @brief Restore the state of the random number generator from a checkpoint
+         */
+        void restoreState(std::istream& state) override;
+
     private:
         // General module members
         std::shared_ptr<const Detector> detector_;
@@ -78,12 +90,22 @@ namespace allpix {
                                                           const unsigned int charge,
                                                           std::map<Pixel::Index, Pulse>& pixel_map);
 
+        /**
+         * @brief Compute the mobility of a charge carrier from the magnitude of the electric field
+         * @param type Type of the charge carrier
+         * @param efield_mag Magnitude of the electric field
+         * @return Mobility of the charge carrier
+         */
+        double carrier_mobility(const CarrierType& type, double efield_mag) const;
+
         // Random generator for this module
         std::mt19937_64 random_generator_;
 
         // Local copies of configuration parameters to avoid costly lookup:
-        double temperature_{}, timestep_{}, integration_time_{};
+        double temperature_{}, timestep_{}, timestep_min_{}, timestep_max_{}, integration_time_{};
+        double target_spatial_precision_{};
         bool output_plots_{};
+        MCTruthLevel mc_truth_{};
         ROOT::Math::DisplacementVector2D<ROOT::Math::Cartesian2D<int>> matrix_;
 
         // Precalculated values for electron and hole mobility
@@ -103,8 +125,18 @@ namespace allpix {
 
         // Magnetic field
         bool has_magnetic_field_;
+        bool magnetic_field_grid_{};
         ROOT::Math::XYZVector magnetic_field_;
 
+        // Drift velocity and mobility of the charge carriers precomputed from the electric field
+        bool precompute_velocities_{};
+        std::map<CarrierType, DetectorField<ROOT::Math::XYZVector, 3>> velocity_fields_;
+        std::map<CarrierType, DetectorField<double, 1>> mobility_fields_;
+
+        // Weighting potential of the induction matrix tabulated on a grid aligned to the pixel pitch
+        bool precompute_weighting_potential_{};
+        NeighbourhoodField weighting_potential_;
+
         // Output plots
         TH1D *potential_difference_, *induced_charge_histo_, *induced_charge_e_histo_, *induced_charge_h_histo_;
         TH1D* step_length_histo_;
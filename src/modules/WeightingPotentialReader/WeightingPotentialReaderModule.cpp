@@ -37,6 +37,9 @@ WeightingPotentialReaderModule::WeightingPotentialReaderModule(Configuration& co
     if(model == "init" || model == "apf") {
         config_.set("model", "mesh");
     }
+
+    // The field is set up again when a run is continued from a checkpoint
+    enable_checkpoints();
 }
 
 void WeightingPotentialReaderModule::init() {
@@ -56,7 +59,9 @@ void WeightingPotentialReaderModule::init() {
                                              field_data.getDimensions(),
                                              std::array<double, 2>{{field_data.getSize()[0], field_data.getSize()[1]}},
                                              std::array<double, 2>{{0, 0}},
-                                             thickness_domain);
+                                             thickness_domain,
+                                             field_data.getSymmetry(),
+                                             field_data.getBlocks());
     } else if(field_model == "pad") {
         LOG(TRACE) << "Adding weighting potential from pad in plane condenser";
 
@@ -204,7 +209,7 @@ FieldData<double> WeightingPotentialReaderModule::read_field(std::pair<double, d
         LOG(TRACE) << "Fetching weighting potential from init file";
 
         // Get field from file
-        auto field_data = field_parser_.getByFileName(config_.getPath("file_name", true));
+        auto field_data = field_parser_.getByFileName(config_.getPath("file_name", true), "", getWorkerCount());
 
         // Check maximum/minimum values of the potential:
         auto elements = std::minmax_element(field_data.getData()->begin(), field_data.getData()->end());
@@ -237,6 +242,14 @@ FieldData<double> WeightingPotentialReaderModule::read_field(std::pair<double, d
 
         LOG(INFO) << "Set weighting field with " << field_data.getDimensions()[0] << "x" << field_data.getDimensions()[1]
                   << "x" << field_data.getDimensions()[2] << " cells";
+        if(field_data.getSymmetry() != FieldSymmetry::NONE) {
+            LOG(INFO) << "Weighting potential is stored folded with " << symmetry_to_string(field_data.getSymmetry())
+                      << " symmetry";
+        }
+        if(field_data.getBlocks().isAdaptive()) {
+            LOG(INFO) << "Weighting potential is stored with adaptive resolution in blocks of "
+                      << field_data.getBlocks().size << " cells";
+        }
 
         // Return the field data
         return field_data;
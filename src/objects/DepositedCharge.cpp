@@ -23,13 +23,23 @@ DepositedCharge::DepositedCharge(ROOT::Math::XYZPoint local_position,
     setMCParticle(mc_particle);
 }
 
+DepositedCharge::DepositedCharge(ROOT::Math::XYZPoint local_position,
+                                 const ROOT::Math::Transform3D& local_to_global,
+                                 CarrierType type,
+                                 unsigned int charge,
+                                 double event_time,
+                                 const MCParticle* mc_particle)
+    : SensorCharge(std::move(local_position), local_to_global, type, charge, event_time) {
+    setMCParticle(mc_particle);
+}
+
 /**
  * @throws MissingReferenceException If the pointed object is not in scope
  *
- * Object is stored as TRef and can only be accessed if pointed object is in scope
+ * Object is linked directly within the event and stored as TRef, it can only be accessed if pointed object is in scope
  */
 const MCParticle* DepositedCharge::getMCParticle() const {
-    auto mc_particle = dynamic_cast<MCParticle*>(mc_particle_.GetObject());
+    auto mc_particle = resolve_link(mc_particle_ptr_, mc_particle_);
     if(mc_particle == nullptr) {
         throw MissingReferenceException(typeid(*this), typeid(MCParticle));
     }
@@ -37,7 +47,12 @@ const MCParticle* DepositedCharge::getMCParticle() const {
 }
 
 void DepositedCharge::setMCParticle(const MCParticle* mc_particle) {
-    mc_particle_ = const_cast<MCParticle*>(mc_particle); // NOLINT
+    mc_particle_ptr_ = mc_particle;
+}
+
+void DepositedCharge::materialize() {
+    SensorCharge::materialize();
+    store_link(mc_particle_ptr_, mc_particle_);
 }
 
 void DepositedCharge::print(std::ostream& out) const {
@@ -40,6 +40,23 @@ namespace allpix {
                         double event_time,
                         const MCParticle* mc_particle = nullptr);
 
+        /**
+         * @brief Construct a charge deposit, calculating the global position only on demand
+         * @param local_position Local position of the deposit in the sensor
+         * @param local_to_global Transformation from the local frame of the sensor to the global frame
+         * @param type Type of the carrier
+         * @param charge Total charge of the deposit
+         * @param event_time Time of deposition after event start
+         * @param mc_particle Optional pointer to related MC particle
+         * @warning Only a reference to the transformation is kept, which therefore has to outlive the object
+         */
+        DepositedCharge(ROOT::Math::XYZPoint local_position,
+                        const ROOT::Math::Transform3D& local_to_global,
+                        CarrierType type,
+                        unsigned int charge,
+                        double event_time,
+                        const MCParticle* mc_particle = nullptr);
+
         /**
          * @brief Get related Monte-Carlo particle
          * @return Pointer to possible Monte-Carlo particle
@@ -59,6 +76,11 @@ namespace allpix {
          */
         void print(std::ostream& out) const override;
 
+        /**
+         * @brief Store the global position and the reference to the Monte-Carlo particle
+         */
+        void materialize() override;
+
         /**
          * @brief ROOT class definition
          */
@@ -70,6 +92,7 @@ namespace allpix {
 
     private:
         TRef mc_particle_;
+        const MCParticle* mc_particle_ptr_{nullptr}; //! Direct link to the Monte-Carlo particle within the event
     };
 
     /**
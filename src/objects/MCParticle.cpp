@@ -27,18 +27,36 @@ MCParticle::MCParticle(ROOT::Math::XYZPoint local_start_point,
     setTrack(nullptr);
 }
 
+MCParticle::MCParticle(ROOT::Math::XYZPoint local_start_point,
+                       ROOT::Math::XYZPoint local_end_point,
+                       const ROOT::Math::Transform3D& local_to_global,
+                       int particle_id,
+                       double time)
+    : local_start_point_(std::move(local_start_point)), local_end_point_(std::move(local_end_point)),
+      local_to_global_(&local_to_global), particle_id_(particle_id), time_(time) {
+    setParent(nullptr);
+    setTrack(nullptr);
+}
+
 ROOT::Math::XYZPoint MCParticle::getLocalStartPoint() const {
     return local_start_point_;
 }
 ROOT::Math::XYZPoint MCParticle::getGlobalStartPoint() const {
-    return global_start_point_;
+    return (local_to_global_ != nullptr ? (*local_to_global_)(local_start_point_) : global_start_point_);
 }
 
 ROOT::Math::XYZPoint MCParticle::getLocalEndPoint() const {
     return local_end_point_;
 }
 ROOT::Math::XYZPoint MCParticle::getGlobalEndPoint() const {
-    return global_end_point_;
+    return (local_to_global_ != nullptr ? (*local_to_global_)(local_end_point_) : global_end_point_);
+}
+
+void MCParticle::materialize() {
+    global_start_point_ = getGlobalStartPoint();
+    global_end_point_ = getGlobalEndPoint();
+    store_link(parent_ptr_, parent_);
+    store_link(track_ptr_, track_);
 }
 
 ROOT::Math::XYZPoint MCParticle::getLocalReferencePoint() const {
@@ -66,25 +84,25 @@ double MCParticle::getTime() const {
 }
 
 void MCParticle::setParent(const MCParticle* mc_particle) {
-    parent_ = const_cast<MCParticle*>(mc_particle); // NOLINT
+    parent_ptr_ = mc_particle;
 }
 
 /**
- * Object is stored as TRef and can only be accessed if pointed object is in scope
+ * Object is linked directly within the event and stored as TRef, it can only be accessed if pointed object is in scope
  */
 const MCParticle* MCParticle::getParent() const {
-    return dynamic_cast<MCParticle*>(parent_.GetObject());
+    return resolve_link(parent_ptr_, parent_);
 }
 
 void MCParticle::setTrack(const MCTrack* mc_track) {
-    track_ = const_cast<MCTrack*>(mc_track); // NOLINT
+    track_ptr_ = mc_track;
 }
 
 /**
- * Object is stored as TRef and can only be accessed if pointed object is in scope
+ * Object is linked directly within the event and stored as TRef, it can only be accessed if pointed object is in scope
  */
 const MCTrack* MCParticle::getTrack() const {
-    return dynamic_cast<MCTrack*>(track_.GetObject());
+    return resolve_link(track_ptr_, track_);
 }
 
 void MCParticle::print(std::ostream& out) const {
@@ -95,6 +113,8 @@ void MCParticle::print(std::ostream& out) const {
 
     auto track = getTrack();
     auto parent = getParent();
+    auto global_start_point = getGlobalStartPoint();
+    auto global_end_point = getGlobalEndPoint();
 
     auto title = std::stringstream();
     title << "--- Printing MCParticle information (" << this << ") ";
@@ -107,15 +127,15 @@ void MCParticle::print(std::ostream& out) const {
         << std::setw(small_gap) << " mm |" << std::setw(med_gap) << local_start_point_.Z() << std::setw(small_gap)
         << " mm  \n"
         << std::left << std::setw(big_gap) << "Global start point:" << std::right << std::setw(med_gap)
-        << global_start_point_.X() << std::setw(small_gap) << " mm |" << std::setw(med_gap) << global_start_point_.Y()
-        << std::setw(small_gap) << " mm |" << std::setw(med_gap) << global_start_point_.Z() << std::setw(small_gap)
+        << global_start_point.X() << std::setw(small_gap) << " mm |" << std::setw(med_gap) << global_start_point.Y()
+        << std::setw(small_gap) << " mm |" << std::setw(med_gap) << global_start_point.Z() << std::setw(small_gap)
         << " mm  \n"
         << std::left << std::setw(big_gap) << "Local end point:" << std::right << std::setw(med_gap) << local_end_point_.X()
         << std::setw(small_gap) << " mm |" << std::setw(med_gap) << local_end_point_.Y() << std::setw(small_gap) << " mm |"
         << std::setw(med_gap) << local_end_point_.Z() << std::setw(small_gap) << " mm  \n"
         << std::left << std::setw(big_gap) << "Global end point:" << std::right << std::setw(med_gap)
-        << global_end_point_.X() << std::setw(small_gap) << " mm |" << std::setw(med_gap) << global_end_point_.Y()
-        << std::setw(small_gap) << " mm |" << std::setw(med_gap) << global_end_point_.Z() << std::setw(small_gap)
+        << global_end_point.X() << std::setw(small_gap) << " mm |" << std::setw(med_gap) << global_end_point.Y()
+        << std::setw(small_gap) << " mm |" << std::setw(med_gap) << global_end_point.Z() << std::setw(small_gap)
         << " mm  \n"
         << std::left << std::setw(big_gap) << "Linked parent:";
     if(parent != nullptr) {
@@ -11,6 +11,7 @@
 #define ALLPIX_MC_PARTICLE_H
 
 #include <Math/Point3D.h>
+#include <Math/Transform3D.h>
 #include <TRef.h>
 
 #include "MCTrack.hpp"
@@ -38,6 +39,21 @@ namespace allpix {
                    int particle_id,
                    double time);
 
+        /**
+         * @brief Construct a Monte-Carlo particle, calculating the global points only on demand
+         * @param local_start_point Entry point of the particle in the sensor in local coordinates
+         * @param local_end_point Exit point of the particle in the sensor in local coordinates
+         * @param local_to_global Transformation from the local frame of the sensor to the global frame
+         * @param particle_id PDG id for this particle type
+         * @param time The arrival time of the particle in the sensor
+         * @warning Only a reference to the transformation is kept, which therefore has to outlive the object
+         */
+        MCParticle(ROOT::Math::XYZPoint local_start_point,
+                   ROOT::Math::XYZPoint local_end_point,
+                   const ROOT::Math::Transform3D& local_to_global,
+                   int particle_id,
+                   double time);
+
         /**
          * @brief Get the entry point of the particle in local coordinates
          * @return Particle entry point
@@ -120,17 +136,27 @@ namespace allpix {
          */
         void print(std::ostream& out) const override;
 
+        /**
+         * @brief Store the global entry and exit points if they are calculated on demand and the references to the parent
+         * and the track
+         */
+        void materialize() override;
+
     private:
         ROOT::Math::XYZPoint local_start_point_{};
+        // Filled by materialize() if calculated on demand, kept such that files are usable without the detector geometry
         ROOT::Math::XYZPoint global_start_point_{};
         ROOT::Math::XYZPoint local_end_point_{};
         ROOT::Math::XYZPoint global_end_point_{};
+        const ROOT::Math::Transform3D* local_to_global_{nullptr}; //! Transformation for global points on demand
 
         int particle_id_{};
         double time_{};
 
         TRef parent_;
         TRef track_;
+        const MCParticle* parent_ptr_{nullptr}; //! Direct link to the parent particle within the event
+        const MCTrack* track_ptr_{nullptr};     //! Direct link to the track within the event
     };
 
     /**
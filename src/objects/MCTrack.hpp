@@ -126,6 +126,11 @@ namespace allpix {
          */
         void print(std::ostream& out) const override;
 
+        /**
+         * @brief Store the reference to the parent track
+         */
+        void materialize() override;
+
         /**
          * @brief ROOT class definition
          */
@@ -151,6 +156,7 @@ namespace allpix {
         double final_tot_E_{};
 
         TRef parent_;
+        const MCTrack* parent_ptr_{nullptr}; //! Direct link to the parent track within the event
     };
 
     /**
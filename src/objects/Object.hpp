@@ -16,6 +16,7 @@
 #define ALLPIX_OBJECT_H
 
 #include <iostream>
+#include <vector>
 
 #include <TObject.h>
 #include <TRef.h>
@@ -61,7 +62,86 @@ namespace allpix {
          */
         ClassDefOverride(Object, 2);
 
+        /**
+         * @brief Fill the members of the object which are only calculated on demand in memory
+         *
+         * Called by writers before storing the object, such that the stored members are complete. This includes the
+         * persistent references of the links to other objects, which are only kept as direct pointers in memory. Does
+         * nothing if not overloaded.
+         */
+        virtual void materialize() {}
+
     protected:
+        /**
+         * @brief Resolve a link to another object
+         * @param pointer Direct pointer to the linked object, only set for links created in the current process
+         * @param reference Persistent reference to the linked object, only set for links stored in or read from file
+         * @return Pointer to the linked object or a null pointer if the object is not in scope
+         *
+         * Links between objects of an event are resolved through the direct pointer in constant time, without a lookup in
+         * the object table of ROOT. The persistent reference is only used for objects read back from file.
+         */
+        template <typename T> static const T* resolve_link(const T* pointer, const TRef& reference) {
+            if(pointer != nullptr) {
+                return pointer;
+            }
+            if(!reference.IsValid()) {
+                return nullptr;
+            }
+            return dynamic_cast<const T*>(reference.GetObject());
+        }
+
+        /**
+         * @brief Build the persistent reference of a link from its direct pointer before the object is stored
+         * @param pointer Direct pointer to the linked object
+         * @param reference Persistent reference to set
+         *
+         * Links without a direct pointer, such as links of objects read from file, keep their existing reference.
+         */
+        static void store_link(const TObject* pointer, TRef& reference) {
+            if(pointer != nullptr) {
+                reference = const_cast<TObject*>(pointer); // NOLINT
+            }
+        }
+
+        /**
+         * @brief Resolve a list of links to other objects
+         * @param pointers Direct pointers to the linked objects, only set for links created in the current process
+         * @param references Persistent references to the linked objects, used if no direct pointers are set
+         * @return Pointers to the linked objects, containing a null pointer for every object not in scope
+         */
+        template <typename T>
+        static std::vector<const T*> resolve_links(const std::vector<const T*>& pointers,
+                                                   const std::vector<TRef>& references) {
+            if(!pointers.empty() || references.empty()) {
+                return pointers;
+            }
+            std::vector<const T*> objects;
+            objects.reserve(references.size());
+            for(auto& reference : references) {
+                objects.push_back(resolve_link(static_cast<const T*>(nullptr), reference));
+            }
+            return objects;
+        }
+
+        /**
+         * @brief Build the persistent references of a list of links from their direct pointers before the object is stored
+         * @param pointers Direct pointers to the linked objects
+         * @param references Persistent references to set
+         *
+         * Lists without direct pointers, such as lists of objects read from file, keep their existing references.
+         */
+        template <typename T>
+        static void store_links(const std::vector<const T*>& pointers, std::vector<TRef>& references) {
+            if(pointers.empty()) {
+                return;
+            }
+            references.resize(pointers.size());
+            for(size_t i = 0; i < pointers.size(); ++i) {
+                store_link(pointers[i], references[i]);
+            }
+        }
+
         /**
          * @brief Print an ASCII representation of this Object to the given stream
          * @param out Stream to print to
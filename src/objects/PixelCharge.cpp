@@ -14,18 +14,22 @@
 
 using namespace allpix;
 
-PixelCharge::PixelCharge(Pixel pixel, unsigned int charge, const std::vector<const PropagatedCharge*>& propagated_charges)
+PixelCharge::PixelCharge(Pixel pixel,
+                         unsigned int charge,
+                         const std::vector<const PropagatedCharge*>& propagated_charges,
+                         bool link_propagated_charges)
     : pixel_(std::move(pixel)), charge_(charge) {
-    // Unique set of MC particles
-    std::set<TRef> unique_particles;
-    // Store all propagated charges and their MC particles
-    for(auto& propagated_charge : propagated_charges) {
-        propagated_charges_.push_back(const_cast<PropagatedCharge*>(propagated_charge)); // NOLINT
-        unique_particles.insert(propagated_charge->mc_particle_);
+    if(link_propagated_charges) {
+        propagated_charges_ptr_ = propagated_charges;
     }
-    // Store the MC particle references
-    for(auto& mc_particle : unique_particles) {
-        mc_particles_.push_back(mc_particle);
+
+    // Store the unique set of MC particles of all propagated charges, in the order of their first appearance
+    std::set<const MCParticle*> unique_particles;
+    for(auto& propagated_charge : propagated_charges) {
+        auto mc_particle = resolve_link(propagated_charge->mc_particle_ptr_, propagated_charge->mc_particle_);
+        if(mc_particle != nullptr && unique_particles.insert(mc_particle).second) {
+            mc_particles_ptr_.push_back(mc_particle);
+        }
     }
 
     // No pulse provided, set full charge in first bin:
@@ -33,8 +37,14 @@ PixelCharge::PixelCharge(Pixel pixel, unsigned int charge, const std::vector<con
 }
 
 // WARNING PixelCharge always returns a positive "collected" charge...
-PixelCharge::PixelCharge(Pixel pixel, Pulse pulse, const std::vector<const PropagatedCharge*>& propagated_charges)
-    : PixelCharge(std::move(pixel), static_cast<unsigned int>(std::abs(pulse.getCharge())), propagated_charges) {
+PixelCharge::PixelCharge(Pixel pixel,
+                         Pulse pulse,
+                         const std::vector<const PropagatedCharge*>& propagated_charges,
+                         bool link_propagated_charges)
+    : PixelCharge(std::move(pixel),
+                  static_cast<unsigned int>(std::abs(pulse.getCharge())),
+                  propagated_charges,
+                  link_propagated_charges) {
     pulse_ = std::move(pulse);
 }
 
@@ -57,16 +67,15 @@ const Pulse& PixelCharge::getPulse() const {
 /**
  * @throws MissingReferenceException If the pointed object is not in scope
  *
- * Objects are stored as vector of TRef and can only be accessed if pointed objects are in scope
+ * Objects are linked directly within the event and stored as vector of TRef, they can only be accessed if pointed objects
+ * are in scope
  */
 std::vector<const PropagatedCharge*> PixelCharge::getPropagatedCharges() const {
-    // FIXME: This is not very efficient unfortunately
-    std::vector<const PropagatedCharge*> propagated_charges;
-    for(auto& propagated_charge : propagated_charges_) {
-        if(!propagated_charge.IsValid() || propagated_charge.GetObject() == nullptr) {
+    auto propagated_charges = resolve_links(propagated_charges_ptr_, propagated_charges_);
+    for(auto& propagated_charge : propagated_charges) {
+        if(propagated_charge == nullptr) {
             throw MissingReferenceException(typeid(*this), typeid(PropagatedCharge));
         }
-        propagated_charges.emplace_back(dynamic_cast<PropagatedCharge*>(propagated_charge.GetObject()));
     }
     return propagated_charges;
 }
@@ -77,19 +86,20 @@ std::vector<const PropagatedCharge*> PixelCharge::getPropagatedCharges() const {
  * MCParticles can only be fetched if the full history of objects are in scope and stored
  */
 std::vector<const MCParticle*> PixelCharge::getMCParticles() const {
-
-    std::vector<const MCParticle*> mc_particles;
-    for(auto& mc_particle : mc_particles_) {
-        if(!mc_particle.IsValid() || mc_particle.GetObject() == nullptr) {
+    auto mc_particles = resolve_links(mc_particles_ptr_, mc_particles_);
+    for(auto& mc_particle : mc_particles) {
+        if(mc_particle == nullptr) {
             throw MissingReferenceException(typeid(*this), typeid(MCParticle));
         }
-        mc_particles.emplace_back(dynamic_cast<MCParticle*>(mc_particle.GetObject()));
     }
-
-    // Return as a vector of mc particles
     return mc_particles;
 }
 
+void PixelCharge::materialize() {
+    store_links(propagated_charges_ptr_, propagated_charges_);
+    store_links(mc_particles_ptr_, mc_particles_);
+}
+
 void PixelCharge::print(std::ostream& out) const {
     auto local_center_location = pixel_.getLocalCenter();
     auto global_center_location = pixel_.getGlobalCenter();
@@ -34,20 +34,24 @@ namespace allpix {
          * @param pixel Object holding the information of the pixel
          * @param charge Amount of charge stored at this pixel
          * @param propagated_charges Optional pointer to the related propagated charges
+         * @param link_propagated_charges False if only the Monte-Carlo particles of the propagated charges should be linked
          */
         PixelCharge(Pixel pixel,
                     unsigned int charge,
-                    const std::vector<const PropagatedCharge*>& propagated_charges = std::vector<const PropagatedCharge*>());
+                    const std::vector<const PropagatedCharge*>& propagated_charges = std::vector<const PropagatedCharge*>(),
+                    bool link_propagated_charges = true);
 
         /**
          * @brief Construct a set of charges at a pixel
          * @param pixel Object holding the information of the pixel
          * @param pulse Pulse of induced or collected charges
          * @param propagated_charges Optional pointer to the related propagated charges
+         * @param link_propagated_charges False if only the Monte-Carlo particles of the propagated charges should be linked
          */
         PixelCharge(Pixel pixel,
                     Pulse pulse,
-                    const std::vector<const PropagatedCharge*>& propagated_charges = std::vector<const PropagatedCharge*>());
+                    const std::vector<const PropagatedCharge*>& propagated_charges = std::vector<const PropagatedCharge*>(),
+                    bool link_propagated_charges = true);
 
         /**
          * @brief Get the pixel containing the charges
@@ -88,6 +92,11 @@ namespace allpix {
          */
         void print(std::ostream& out) const override;
 
+        /**
+         * @brief Store the references to the propagated charges and the Monte-Carlo particles
+         */
+        void materialize() override;
+
         /**
          * @brief ROOT class definition
          */
@@ -104,6 +113,10 @@ namespace allpix {
 
         std::vector<TRef> propagated_charges_;
         std::vector<TRef> mc_particles_;
+
+        // Direct links to the related objects within the event, in the same order as the references
+        std::vector<const PropagatedCharge*> propagated_charges_ptr_; //! Direct links to the propagated charges
+        std::vector<const MCParticle*> mc_particles_ptr_;             //! Direct links to the Monte-Carlo particles
     };
 
     /**
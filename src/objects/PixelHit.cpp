@@ -9,25 +9,22 @@
 
 #include "PixelHit.hpp"
 
-#include <set>
-
 #include "DepositedCharge.hpp"
 #include "PropagatedCharge.hpp"
 #include "exceptions.h"
 
 using namespace allpix;
 
-PixelHit::PixelHit(Pixel pixel, double time, double signal, const PixelCharge* pixel_charge)
+PixelHit::PixelHit(Pixel pixel, double time, double signal, const PixelCharge* pixel_charge, bool link_pixel_charge)
     : pixel_(std::move(pixel)), time_(time), signal_(signal) {
-    pixel_charge_ = const_cast<PixelCharge*>(pixel_charge); // NOLINT
-    // Get the unique set of MC particles
-    std::set<TRef> unique_particles;
-    for(auto& mc_particle : pixel_charge->mc_particles_) {
-        unique_particles.insert(mc_particle);
+    if(link_pixel_charge) {
+        pixel_charge_ptr_ = pixel_charge;
     }
-    // Store the MC particle references
-    for(auto& mc_particle : unique_particles) {
-        mc_particles_.push_back(mc_particle);
+
+    // Take over the unique set of MC particles of the pixel charge
+    if(pixel_charge != nullptr) {
+        mc_particles_ptr_ = pixel_charge->mc_particles_ptr_;
+        mc_particles_ = pixel_charge->mc_particles_;
     }
 }
 
@@ -42,10 +39,10 @@ Pixel::Index PixelHit::getIndex() const {
 /**
  * @throws MissingReferenceException If the pointed object is not in scope
  *
- * Object is stored as TRef and can only be accessed if pointed object is in scope
+ * Object is linked directly within the event and stored as TRef, it can only be accessed if pointed object is in scope
  */
 const PixelCharge* PixelHit::getPixelCharge() const {
-    auto pixel_charge = dynamic_cast<PixelCharge*>(pixel_charge_.GetObject());
+    auto pixel_charge = resolve_link(pixel_charge_ptr_, pixel_charge_);
     if(pixel_charge == nullptr) {
         throw MissingReferenceException(typeid(*this), typeid(PixelCharge));
     }
@@ -58,16 +55,12 @@ const PixelCharge* PixelHit::getPixelCharge() const {
  * MCParticles can only be fetched if the full history of objects are in scope and stored
  */
 std::vector<const MCParticle*> PixelHit::getMCParticles() const {
-
-    std::vector<const MCParticle*> mc_particles;
-    for(auto& mc_particle : mc_particles_) {
-        if(!mc_particle.IsValid() || mc_particle.GetObject() == nullptr) {
+    auto mc_particles = resolve_links(mc_particles_ptr_, mc_particles_);
+    for(auto& mc_particle : mc_particles) {
+        if(mc_particle == nullptr) {
             throw MissingReferenceException(typeid(*this), typeid(MCParticle));
         }
-        mc_particles.emplace_back(dynamic_cast<MCParticle*>(mc_particle.GetObject()));
     }
-
-    // Return as a vector of mc particles
     return mc_particles;
 }
 
@@ -78,12 +71,7 @@ std::vector<const MCParticle*> PixelHit::getMCParticles() const {
  */
 std::vector<const MCParticle*> PixelHit::getPrimaryMCParticles() const {
     std::vector<const MCParticle*> primary_particles;
-    for(auto& mc_particle : mc_particles_) {
-        if(!mc_particle.IsValid() || mc_particle.GetObject() == nullptr) {
-            throw MissingReferenceException(typeid(*this), typeid(MCParticle));
-        }
-        auto particle = dynamic_cast<MCParticle*>(mc_particle.GetObject());
-
+    for(auto& particle : getMCParticles()) {
         // Check for possible parents:
         if(particle->getParent() != nullptr) {
             continue;
@@ -95,6 +83,11 @@ std::vector<const MCParticle*> PixelHit::getPrimaryMCParticles() const {
     return primary_particles;
 }
 
+void PixelHit::materialize() {
+    store_link(pixel_charge_ptr_, pixel_charge_);
+    store_links(mc_particles_ptr_, mc_particles_);
+}
+
 void PixelHit::print(std::ostream& out) const {
     out << "PixelHit " << this->getIndex().X() << ", " << this->getIndex().Y() << ", " << this->getSignal() << ", "
         << this->getTime();
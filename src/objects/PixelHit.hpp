@@ -33,8 +33,13 @@ namespace allpix {
          * @param time Timing of the occurrence of the hit
          * @param signal Signal data produced by the digitizer
          * @param pixel_charge Optional pointer to the related pixel charge
+         * @param link_pixel_charge False if only the Monte-Carlo particles of the pixel charge should be linked
          */
-        PixelHit(Pixel pixel, double time, double signal, const PixelCharge* pixel_charge = nullptr);
+        PixelHit(Pixel pixel,
+                 double time,
+                 double signal,
+                 const PixelCharge* pixel_charge = nullptr,
+                 bool link_pixel_charge = true);
 
         /**
          * @brief Get the pixel hit
@@ -79,6 +84,11 @@ namespace allpix {
          */
         void print(std::ostream& out) const override;
 
+        /**
+         * @brief Store the references to the pixel charge and the Monte-Carlo particles
+         */
+        void materialize() override;
+
         /**
          * @brief ROOT class definition
          */
@@ -95,6 +105,10 @@ namespace allpix {
 
         TRef pixel_charge_;
         std::vector<TRef> mc_particles_;
+
+        // Direct links to the related objects within the event
+        const PixelCharge* pixel_charge_ptr_{nullptr};    //! Direct link to the pixel charge
+        std::vector<const MCParticle*> mc_particles_ptr_; //! Direct links to the Monte-Carlo particles
     };
 
     /**
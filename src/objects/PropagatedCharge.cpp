@@ -20,10 +20,14 @@ PropagatedCharge::PropagatedCharge(ROOT::Math::XYZPoint local_position,
                                    CarrierType type,
                                    unsigned int charge,
                                    double event_time,
-                                   const DepositedCharge* deposited_charge)
+                                   const DepositedCharge* deposited_charge,
+                                   bool link_deposited_charge)
     : SensorCharge(std::move(local_position), std::move(global_position), type, charge, event_time) {
-    deposited_charge_ = const_cast<DepositedCharge*>(deposited_charge); // NOLINT
+    if(link_deposited_charge) {
+        deposited_charge_ptr_ = deposited_charge;
+    }
     if(deposited_charge != nullptr) {
+        mc_particle_ptr_ = deposited_charge->mc_particle_ptr_;
         mc_particle_ = deposited_charge->mc_particle_;
     }
 }
@@ -33,7 +37,8 @@ PropagatedCharge::PropagatedCharge(ROOT::Math::XYZPoint local_position,
                                    CarrierType type,
                                    std::map<Pixel::Index, Pulse> pulses,
                                    double event_time,
-                                   const DepositedCharge* deposited_charge)
+                                   const DepositedCharge* deposited_charge,
+                                   bool link_deposited_charge)
     : PropagatedCharge(std::move(local_position),
                        std::move(global_position),
                        type,
@@ -44,17 +49,57 @@ PropagatedCharge::PropagatedCharge(ROOT::Math::XYZPoint local_position,
                                            return prev + static_cast<unsigned int>(std::abs(elem.second.getCharge()));
                                        }),
                        event_time,
-                       deposited_charge) {
+                       deposited_charge,
+                       link_deposited_charge) {
+    pulses_ = std::move(pulses);
+}
+
+PropagatedCharge::PropagatedCharge(ROOT::Math::XYZPoint local_position,
+                                   const ROOT::Math::Transform3D& local_to_global,
+                                   CarrierType type,
+                                   unsigned int charge,
+                                   double event_time,
+                                   const DepositedCharge* deposited_charge,
+                                   bool link_deposited_charge)
+    : SensorCharge(std::move(local_position), local_to_global, type, charge, event_time) {
+    if(link_deposited_charge) {
+        deposited_charge_ptr_ = deposited_charge;
+    }
+    if(deposited_charge != nullptr) {
+        mc_particle_ptr_ = deposited_charge->mc_particle_ptr_;
+        mc_particle_ = deposited_charge->mc_particle_;
+    }
+}
+
+PropagatedCharge::PropagatedCharge(ROOT::Math::XYZPoint local_position,
+                                   const ROOT::Math::Transform3D& local_to_global,
+                                   CarrierType type,
+                                   std::map<Pixel::Index, Pulse> pulses,
+                                   double event_time,
+                                   const DepositedCharge* deposited_charge,
+                                   bool link_deposited_charge)
+    : PropagatedCharge(std::move(local_position),
+                       local_to_global,
+                       type,
+                       std::accumulate(pulses.begin(),
+                                       pulses.end(),
+                                       0u,
+                                       [](const unsigned int prev, const auto& elem) {
+                                           return prev + static_cast<unsigned int>(std::abs(elem.second.getCharge()));
+                                       }),
+                       event_time,
+                       deposited_charge,
+                       link_deposited_charge) {
     pulses_ = std::move(pulses);
 }
 
 /**
  * @throws MissingReferenceException If the pointed object is not in scope
  *
- * Object is stored as TRef and can only be accessed if pointed object is in scope
+ * Object is linked directly within the event and stored as TRef, it can only be accessed if pointed object is in scope
  */
 const DepositedCharge* PropagatedCharge::getDepositedCharge() const {
-    auto deposited_charge = dynamic_cast<DepositedCharge*>(deposited_charge_.GetObject());
+    auto deposited_charge = resolve_link(deposited_charge_ptr_, deposited_charge_);
     if(deposited_charge == nullptr) {
         throw MissingReferenceException(typeid(*this), typeid(DepositedCharge));
     }
@@ -64,10 +109,10 @@ const DepositedCharge* PropagatedCharge::getDepositedCharge() const {
 /**
  * @throws MissingReferenceException If the pointed object is not in scope
  *
- * Object is stored as TRef and can only be accessed if pointed object is in scope
+ * Object is linked directly within the event and stored as TRef, it can only be accessed if pointed object is in scope
  */
 const MCParticle* PropagatedCharge::getMCParticle() const {
-    auto mc_particle = dynamic_cast<MCParticle*>(mc_particle_.GetObject());
+    auto mc_particle = resolve_link(mc_particle_ptr_, mc_particle_);
     if(mc_particle == nullptr) {
         throw MissingReferenceException(typeid(*this), typeid(MCParticle));
     }
@@ -78,6 +123,12 @@ std::map<Pixel::Index, Pulse> PropagatedCharge::getPulses() const {
     return pulses_;
 }
 
+void PropagatedCharge::materialize() {
+    SensorCharge::materialize();
+    store_link(deposited_charge_ptr_, deposited_charge_);
+    store_link(mc_particle_ptr_, mc_particle_);
+}
+
 void PropagatedCharge::print(std::ostream& out) const {
     out << "--- Propagated charge information\n";
     SensorCharge::print(out);
@@ -35,13 +35,15 @@ namespace allpix {
          * @param charge Total charge propagated
          * @param event_time Total time of propagation arrival after event start
          * @param deposited_charge Optional pointer to related deposited charge
+         * @param link_deposited_charge False if only the Monte-Carlo particle of the deposited charge should be linked
          */
         PropagatedCharge(ROOT::Math::XYZPoint local_position,
                          ROOT::Math::XYZPoint global_position,
                          CarrierType type,
                          unsigned int charge,
                          double event_time,
-                         const DepositedCharge* deposited_charge = nullptr);
+                         const DepositedCharge* deposited_charge = nullptr,
+                         bool link_deposited_charge = true);
 
         /**
          * @brief Construct a set of propagated charges
@@ -51,13 +53,53 @@ namespace allpix {
          * @param pulses Map of pulses induced at electrodes identified by their index
          * @param event_time Total time of propagation arrival after event start
          * @param deposited_charge Optional pointer to related deposited charge
+         * @param link_deposited_charge False if only the Monte-Carlo particle of the deposited charge should be linked
          */
         PropagatedCharge(ROOT::Math::XYZPoint local_position,
                          ROOT::Math::XYZPoint global_position,
                          CarrierType type,
                          std::map<Pixel::Index, Pulse> pulses,
                          double event_time,
-                         const DepositedCharge* deposited_charge = nullptr);
+                         const DepositedCharge* deposited_charge = nullptr,
+                         bool link_deposited_charge = true);
+
+        /**
+         * @brief Construct a set of propagated charges, calculating the global position only on demand
+         * @param local_position Local position of the propagated set of charges in the sensor
+         * @param local_to_global Transformation from the local frame of the sensor to the global frame
+         * @param type Type of the carrier to propagate
+         * @param charge Total charge propagated
+         * @param event_time Total time of propagation arrival after event start
+         * @param deposited_charge Optional pointer to related deposited charge
+         * @param link_deposited_charge False if only the Monte-Carlo particle of the deposited charge should be linked
+         * @warning Only a reference to the transformation is kept, which therefore has to outlive the object
+         */
+        PropagatedCharge(ROOT::Math::XYZPoint local_position,
+                         const ROOT::Math::Transform3D& local_to_global,
+                         CarrierType type,
+                         unsigned int charge,
+                         double event_time,
+                         const DepositedCharge* deposited_charge = nullptr,
+                         bool link_deposited_charge = true);
+
+        /**
+         * @brief Construct a set of propagated charges, calculating the global position only on demand
+         * @param local_position Local position of the propagated set of charges in the sensor
+         * @param local_to_global Transformation from the local frame of the sensor to the global frame
+         * @param type Type of the carrier to propagate
+         * @param pulses Map of pulses induced at electrodes identified by their index
+         * @param event_time Total time of propagation arrival after event start
+         * @param deposited_charge Optional pointer to related deposited charge
+         * @param link_deposited_charge False if only the Monte-Carlo particle of the deposited charge should be linked
+         * @warning Only a reference to the transformation is kept, which therefore has to outlive the object
+         */
+        PropagatedCharge(ROOT::Math::XYZPoint local_position,
+                         const ROOT::Math::Transform3D& local_to_global,
+                         CarrierType type,
+                         std::map<Pixel::Index, Pulse> pulses,
+                         double event_time,
+                         const DepositedCharge* deposited_charge = nullptr,
+                         bool link_deposited_charge = true);
 
         /**
          * @brief Get related deposited charge
@@ -83,6 +125,11 @@ namespace allpix {
          */
         void print(std::ostream& out) const override;
 
+        /**
+         * @brief Store the global position and the references to the deposited charge and the Monte-Carlo particle
+         */
+        void materialize() override;
+
         /**
          * @brief ROOT class definition
          */
@@ -96,6 +143,10 @@ namespace allpix {
         TRef deposited_charge_;
         TRef mc_particle_{nullptr};
         std::map<Pixel::Index, Pulse> pulses_;
+
+        // Direct links to the related objects within the event
+        const DepositedCharge* deposited_charge_ptr_{nullptr}; //! Direct link to the deposited charge
+        const MCParticle* mc_particle_ptr_{nullptr};           //! Direct link to the Monte-Carlo particle
     };
 
     /**
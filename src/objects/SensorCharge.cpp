@@ -19,12 +19,24 @@ SensorCharge::SensorCharge(ROOT::Math::XYZPoint local_position,
     : local_position_(std::move(local_position)), global_position_(std::move(global_position)), type_(type), charge_(charge),
       event_time_(event_time) {}
 
+SensorCharge::SensorCharge(ROOT::Math::XYZPoint local_position,
+                           const ROOT::Math::Transform3D& local_to_global,
+                           CarrierType type,
+                           unsigned int charge,
+                           double event_time)
+    : local_position_(std::move(local_position)), local_to_global_(&local_to_global), type_(type), charge_(charge),
+      event_time_(event_time) {}
+
 ROOT::Math::XYZPoint SensorCharge::getLocalPosition() const {
     return local_position_;
 }
 
+/**
+ * The global position is only calculated when requested if the object has been created with the transformation of the
+ * sensor, which saves the transformation for all objects whose global position is never used.
+ */
 ROOT::Math::XYZPoint SensorCharge::getGlobalPosition() const {
-    return global_position_;
+    return (local_to_global_ != nullptr ? (*local_to_global_)(local_position_) : global_position_);
 }
 
 CarrierType SensorCharge::getType() const {
@@ -39,10 +51,15 @@ double SensorCharge::getEventTime() const {
     return event_time_;
 }
 
+void SensorCharge::materialize() {
+    global_position_ = getGlobalPosition();
+}
+
 void SensorCharge::print(std::ostream& out) const {
+    auto global_position = getGlobalPosition();
     out << "Type: " << (type_ == CarrierType::ELECTRON ? "\"e\"" : "\"h\"") << "\nCharge: " << charge_ << " e"
         << "\nLocal Position: (" << local_position_.X() << ", " << local_position_.Y() << ", " << local_position_.Z()
         << ") mm\n"
-        << "Global Position: (" << global_position_.X() << ", " << global_position_.Y() << ", " << global_position_.Z()
+        << "Global Position: (" << global_position.X() << ", " << global_position.Y() << ", " << global_position.Z()
         << ") mm\n";
 }
@@ -11,6 +11,7 @@
 #define ALLPIX_SENSOR_CHARGE_H
 
 #include <Math/Point3D.h>
+#include <Math/Transform3D.h>
 
 #include "Object.hpp"
 
@@ -46,6 +47,21 @@ namespace allpix {
                      unsigned int charge,
                      double event_time);
 
+        /**
+         * @brief Construct a set of charges in a sensor, calculating the global position only on demand
+         * @param local_position Local position of the set of charges in the sensor
+         * @param local_to_global Transformation from the local frame of the sensor to the global frame
+         * @param type Type of the carrier
+         * @param charge Total charge at position
+         * @param event_time Total time after event start
+         * @warning Only a reference to the transformation is kept, which therefore has to outlive the object
+         */
+        SensorCharge(ROOT::Math::XYZPoint local_position,
+                     const ROOT::Math::Transform3D& local_to_global,
+                     CarrierType type,
+                     unsigned int charge,
+                     double event_time);
+
         /**
          * @brief Get local position of the set of charges in the sensor
          * @return Local position of charges
@@ -54,6 +70,7 @@ namespace allpix {
 
         /**
          * @brief Get the global position of the set of charges in the sensor
+         * @return Global position of charges, calculated from the local position if not stored
          */
         ROOT::Math::XYZPoint getGlobalPosition() const;
 
@@ -78,6 +95,11 @@ namespace allpix {
          */
         void print(std::ostream& out) const override;
 
+        /**
+         * @brief Store the global position if it is calculated on demand
+         */
+        void materialize() override;
+
         /**
          * @brief ROOT class definition
          */
@@ -89,7 +111,9 @@ namespace allpix {
 
     private:
         ROOT::Math::XYZPoint local_position_;
+        // Filled by materialize() if calculated on demand, kept such that files are usable without the detector geometry
         ROOT::Math::XYZPoint global_position_;
+        const ROOT::Math::Transform3D* local_to_global_{nullptr}; //! Transformation for global position on demand
 
         CarrierType type_{};
         unsigned int charge_{};
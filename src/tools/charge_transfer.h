@@ -0,0 +1,125 @@
+/**
+ * @file
+ * @brief Utility to transfer propagated charges to the nearest pixels of a detector
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_CHARGE_TRANSFER_H
+#define ALLPIX_CHARGE_TRANSFER_H
+
+#include <cmath>
+#include <map>
+#include <vector>
+
+#include "core/geometry/Detector.hpp"
+#include "core/module/Module.hpp"
+#include "core/utils/log.h"
+#include "core/utils/unit.h"
+
+#include "objects/Pixel.hpp"
+#include "objects/PixelCharge.hpp"
+#include "objects/PropagatedCharge.hpp"
+
+namespace allpix {
+
+    /**
+     * @brief Map of pixel indices to the propagated charges collected by the respective pixel
+     */
+    using PixelChargeMap = std::map<Pixel::Index, std::vector<const PropagatedCharge*>>;
+
+    /**
+     * @brief Assign propagated charges to the nearest pixel of a detector
+     * @param detector             Detector the charges have been propagated in
+     * @param propagated_charges   Propagated charges to transfer
+     * @param max_depth_distance   Maximum distance from the implant side of the sensor for a charge to be considered
+     * @param collect_from_implant Only consider charges within the implant region instead of the full pixel surface
+     * @return Map of all hit pixels to the propagated charges they collected
+     *
+     * Propagated charges outside the depth range of the implants, outside the pixel grid or, if requested, outside the
+     * implant region are ignored.
+     */
+    inline PixelChargeMap transfer_charges_to_pixels(const Detector& detector,
+                                                     const std::vector<PropagatedCharge>& propagated_charges,
+                                                     double max_depth_distance,
+                                                     bool collect_from_implant) {
+        auto model = detector.getModel();
+        auto implant_z = model->getSensorCenter().z() + model->getSensorSize().z() / 2.0;
+
+        PixelChargeMap pixel_map;
+        for(auto& propagated_charge : propagated_charges) {
+            auto position = propagated_charge.getLocalPosition();
+            // Ignore if outside depth range of implant
+            // FIXME This logic should be improved
+            if(std::fabs(position.z() - implant_z) > max_depth_distance) {
+                LOG(TRACE) << "Skipping set of " << propagated_charge.getCharge() << " propagated charges at "
+                           << Units::display(position, {"mm", "um"})
+                           << " because their local position is not in implant range";
+                continue;
+            }
+
+            // Find the nearest pixel
+            auto nearest_pixel = detector.getPixelIndex(position);
+            auto xpixel = nearest_pixel.first;
+            auto ypixel = nearest_pixel.second;
+
+            // Ignore if out of pixel grid
+            if(!detector.isWithinPixelGrid(xpixel, ypixel)) {
+                LOG(TRACE) << "Skipping set of " << propagated_charge.getCharge() << " propagated charges at "
+                           << Units::display(position, {"mm", "um"}) << " because their nearest pixel (" << xpixel << ","
+                           << ypixel << ") is outside the grid";
+                continue;
+            }
+
+            // Ignore if outside the implant region:
+            if(collect_from_implant && !detector.isWithinImplant(position)) {
+                LOG(TRACE) << "Skipping set of " << propagated_charge.getCharge() << " propagated charges at "
+                           << Units::display(position, {"mm", "um"}) << " because it is outside the pixel implant.";
+                continue;
+            }
+
+            Pixel::Index pixel_index(static_cast<unsigned int>(xpixel), static_cast<unsigned int>(ypixel));
+            LOG(TRACE) << "Set of " << propagated_charge.getCharge() << " propagated charges at "
+                       << Units::display(position, {"mm", "um"}) << " brought to pixel " << pixel_index;
+
+            // Add the pixel the list of hit pixels
+            pixel_map[pixel_index].emplace_back(&propagated_charge);
+        }
+        return pixel_map;
+    }
+
+    /**
+     * @brief Combine the propagated charges collected by every pixel into pixel charges
+     * @param detector  Detector the pixels belong to
+     * @param pixel_map Map of hit pixels to the propagated charges they collected
+     * @param mc_truth  Depth of the stored history, deciding whether propagated charges or only their particles are linked
+     * @return Pixel charges of all hit pixels
+     */
+    inline std::vector<PixelCharge>
+    combine_pixel_charges(const Detector& detector, const PixelChargeMap& pixel_map, MCTruthLevel mc_truth) {
+        std::vector<PixelCharge> pixel_charges;
+        for(auto& pixel_index_charge : pixel_map) {
+            unsigned int charge = 0;
+            for(auto& propagated_charge : pixel_index_charge.second) {
+                charge += propagated_charge->getCharge();
+            }
+
+            // Get pixel object from detector
+            auto pixel = detector.getPixel(pixel_index_charge.first.x(), pixel_index_charge.first.y());
+
+            // Link the propagated charges or only their Monte-Carlo particles, depending on the requested history
+            if(mc_truth == MCTruthLevel::NONE) {
+                pixel_charges.emplace_back(pixel, charge);
+            } else {
+                pixel_charges.emplace_back(pixel, charge, pixel_index_charge.second, mc_truth == MCTruthLevel::FULL);
+            }
+            LOG(DEBUG) << "Set of " << charge << " charges combined at " << pixel.getIndex() << " in detector "
+                       << detector.getName();
+        }
+        return pixel_charges;
+    }
+} // namespace allpix
+
+#endif /* ALLPIX_CHARGE_TRANSFER_H */
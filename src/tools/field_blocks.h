@@ -0,0 +1,191 @@
+/**
+ * @file
+ * @brief Definition of block-structured adaptive field grids storing regions of slowly varying fields at lower resolution
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_FIELD_BLOCKS_H
+#define ALLPIX_FIELD_BLOCKS_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "tools/field_symmetry.h"
+
+namespace allpix {
+
+    /**
+     * @brief Block structure of an adaptive field grid
+     *
+     * The stored part of the grid is divided into cubic blocks of a fixed number of bins along each axis, which has to be a
+     * power of two. Every block is stored at its own coarsening level, where each level halves the resolution of the block
+     * along all axes. A cell of a block at level l thus covers 2^l bins along each axis and holds a single field value. The
+     * blocks are ordered like the bins of a regular grid, with the block index along z running fastest, and the cells
+     * within a block are ordered the same way. Blocks at the upper grid edges only cover the remaining bins.
+     *
+     * Regular grids are described by a block size of zero and no levels.
+     */
+    struct FieldBlocks {
+        std::uint32_t size{};               ///< Number of bins per block along each axis, zero for regular grids
+        std::vector<std::uint8_t> levels{}; ///< Coarsening level of every block
+
+        /**
+         * @brief Check if the grid is stored with adaptive resolution
+         * @return True if the grid is block-structured, false for regular grids
+         */
+        bool isAdaptive() const { return size != 0; }
+
+        template <class Archive> void serialize(Archive& archive) { archive(size, levels); }
+    };
+
+    /**
+     * @brief Position of a single block in the flat field vector, calculated from the block structure
+     */
+    struct FieldBlockLayout {
+        size_t offset{};               ///< Index of the first value of the block in the flat field vector
+        unsigned int level{};          ///< Coarsening level of the block
+        std::array<size_t, 3> cells{}; ///< Number of cells of the block along x, y and z
+    };
+
+    /**
+     * @brief Calculate the number of blocks along each axis
+     * @param dimensions Number of stored bins in x, y and z
+     * @param block_size Number of bins per block along each axis
+     * @return Number of blocks in x, y and z
+     */
+    inline std::array<size_t, 3> field_block_counts(const std::array<size_t, 3>& dimensions, size_t block_size) {
+        return {{(dimensions[0] + block_size - 1) / block_size,
+                 (dimensions[1] + block_size - 1) / block_size,
+                 (dimensions[2] + block_size - 1) / block_size}};
+    }
+
+    /**
+     * @brief Calculate the position of all blocks in the flat field vector
+     * @param dimensions Number of stored bins in x, y and z
+     * @param blocks     Block structure of the grid
+     * @param n          Number of components per field point
+     * @return Layout of every block, in the order of the blocks
+     * @throws std::invalid_argument If the block size is not a power of two, the number of levels does not match the number
+     * of blocks or any level exceeds the block size
+     */
+    inline std::vector<FieldBlockLayout>
+    field_block_layout(const std::array<size_t, 3>& dimensions, const FieldBlocks& blocks, size_t n) {
+        size_t block_size = blocks.size;
+        if(block_size == 0 || (block_size & (block_size - 1)) != 0) {
+            throw std::invalid_argument("block size of adaptive field grid is not a power of two");
+        }
+        auto counts = field_block_counts(dimensions, block_size);
+        if(blocks.levels.size() != counts[0] * counts[1] * counts[2]) {
+            throw std::invalid_argument("number of block levels does not match the number of blocks");
+        }
+
+        std::vector<FieldBlockLayout> layout(blocks.levels.size());
+        size_t offset = 0, block = 0;
+        for(size_t bx = 0; bx < counts[0]; ++bx) {
+            for(size_t by = 0; by < counts[1]; ++by) {
+                for(size_t bz = 0; bz < counts[2]; ++bz, ++block) {
+                    auto level = blocks.levels[block];
+                    if((size_t(1) << level) > block_size) {
+                        throw std::invalid_argument("coarsening level of block exceeds the block size");
+                    }
+
+                    // Cells of blocks at the upper grid edges only cover the remaining bins
+                    std::array<size_t, 3> start{{bx * block_size, by * block_size, bz * block_size}};
+                    auto& entry = layout[block];
+                    for(size_t i = 0; i < 3; ++i) {
+                        auto extent = std::min(block_size, dimensions[i] - start[i]);
+                        entry.cells[i] = (extent + (size_t(1) << level) - 1) >> level;
+                    }
+                    entry.offset = offset;
+                    entry.level = level;
+                    offset += entry.cells[0] * entry.cells[1] * entry.cells[2] * n;
+                }
+            }
+        }
+        return layout;
+    }
+
+    /**
+     * @brief Calculate the number of values stored for an adaptive grid
+     * @param layout Layout of all blocks of the grid
+     * @param n      Number of components per field point
+     * @return Size of the flat field vector
+     */
+    inline size_t field_block_values(const std::vector<FieldBlockLayout>& layout, size_t n) {
+        if(layout.empty()) {
+            return 0;
+        }
+        const auto& last = layout.back();
+        return last.offset + last.cells[0] * last.cells[1] * last.cells[2] * n;
+    }
+
+    /**
+     * @brief Calculate the binary logarithm of the block size
+     * @param block_size Number of bins per block along each axis, a power of two
+     * @return Number of bits to shift a bin index by to obtain the block index
+     */
+    inline unsigned int field_block_shift(size_t block_size) {
+        unsigned int shift = 0;
+        while((size_t(1) << (shift + 1)) <= block_size) {
+            ++shift;
+        }
+        return shift;
+    }
+
+    /**
+     * @brief Calculate the number of values stored for a field grid
+     * @param dimensions Number of bins of the full grid in x, y and z
+     * @param symmetry   Symmetry of the field
+     * @param blocks     Block structure of the grid, regular grids have no blocks
+     * @param n          Number of components per field point
+     * @return Expected size of the flat field vector
+     * @throws std::invalid_argument If an octant-folded grid is adaptive or the block structure is invalid
+     */
+    inline size_t field_grid_values(const std::array<size_t, 3>& dimensions,
+                                    FieldSymmetry symmetry,
+                                    const FieldBlocks& blocks,
+                                    size_t n) {
+        if(!blocks.isAdaptive()) {
+            return symmetry_grid_points(dimensions, symmetry) * n;
+        }
+        if(symmetry == FieldSymmetry::OCTANT) {
+            throw std::invalid_argument("adaptive grids are not supported for octant-folded fields");
+        }
+        return field_block_values(field_block_layout(symmetry_folded_dimensions(dimensions, symmetry), blocks, n), n);
+    }
+
+    /**
+     * @brief Calculate the index of the first component of a bin in the flat field vector of an adaptive grid
+     * @param layout      Layout of all blocks of the grid
+     * @param counts      Number of blocks in x, y and z
+     * @param block_shift Binary logarithm of the block size
+     * @param x           Index of the stored bin in x
+     * @param y           Index of the stored bin in y
+     * @param z           Index of the stored bin in z
+     * @param n           Number of components per field point
+     * @return Index of the value of the cell containing the bin
+     */
+    inline size_t field_block_index(const std::vector<FieldBlockLayout>& layout,
+                                    const std::array<size_t, 3>& counts,
+                                    unsigned int block_shift,
+                                    size_t x,
+                                    size_t y,
+                                    size_t z,
+                                    size_t n) {
+        const auto& block = layout[((x >> block_shift) * counts[1] + (y >> block_shift)) * counts[2] + (z >> block_shift)];
+        auto mask = (size_t(1) << block_shift) - 1;
+        auto cx = (x & mask) >> block.level;
+        auto cy = (y & mask) >> block.level;
+        auto cz = (z & mask) >> block.level;
+        return block.offset + ((cx * block.cells[1] + cy) * block.cells[2] + cz) * n;
+    }
+} // namespace allpix
+
+#endif /* ALLPIX_FIELD_BLOCKS_H */
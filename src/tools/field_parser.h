@@ -11,24 +11,40 @@
 #define ALLPIX_FIELD_PARSER_H
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <thread>
+
+#ifdef ALLPIX_APF_COMPRESSION
+#include <zlib.h>
+#endif
 
 #include "core/utils/file.h"
 #include "core/utils/log.h"
 #include "core/utils/unit.h"
+#include "tools/field_blocks.h"
+#include "tools/field_symmetry.h"
 
 #include <cereal/archives/portable_binary.hpp>
 
 #include <cereal/types/array.hpp>
+#include <cereal/types/common.hpp>
 #include <cereal/types/memory.hpp>
 #include <cereal/types/string.hpp>
 #include <cereal/types/vector.hpp>
 #include <utility>
 
 // Mime type version for APF files
-#define APF_MIME_TYPE_VERSION 1
+#define APF_MIME_TYPE_VERSION 4
+// Number of field values per independently compressed chunk of APF files
+#define APF_CHUNK_VALUES 1048576
 
 namespace allpix {
 
@@ -50,11 +66,134 @@ namespace allpix {
         APF,         ///< Binary Allpix Squared format serialized using the cereal library
     };
 
+    /**
+     * @brief Compression of the field data stored in APF files
+     */
+    enum class FieldCompression : std::uint32_t {
+        NONE = 0, ///< Field data is stored uncompressed
+        ZLIB = 1, ///< Field data is stored in independently deflate-compressed chunks
+    };
+
+    /**
+     * @brief Chunk of compressed field data, covering a contiguous range of the flat field vector
+     */
+    struct FieldDataChunk {
+        std::uint64_t first{};           ///< Index of the first value of the chunk in the flat field vector
+        std::uint64_t count{};           ///< Number of values in the chunk
+        std::vector<std::uint8_t> bytes; ///< Compressed byte planes of the values
+
+        template <class Archive> void serialize(Archive& archive) { archive(first, count, bytes); }
+    };
+
+    /**
+     * @brief Execute a task for a number of work items in parallel
+     * @param items   Number of work items
+     * @param threads Maximum number of threads to use, at least one thread is used
+     * @param task    Task to execute for every work item, called with the index of the item
+     * @throws The first exception thrown by any of the tasks
+     */
+    inline void run_parallel(size_t items, unsigned int threads, const std::function<void(size_t)>& task) {
+        auto workers_count = std::min<size_t>(items, std::max(1u, threads));
+
+        std::atomic<size_t> next{0};
+        std::vector<std::exception_ptr> errors(workers_count);
+        std::vector<std::thread> workers;
+        for(size_t t = 0; t < workers_count; t++) {
+            workers.emplace_back([&, t]() {
+                try {
+                    for(size_t item = next++; item < items; item = next++) {
+                        task(item);
+                    }
+                } catch(...) {
+                    errors[t] = std::current_exception();
+                }
+            });
+        }
+        for(auto& worker : workers) {
+            worker.join();
+        }
+        for(auto& error : errors) {
+            if(error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+#ifdef ALLPIX_APF_COMPRESSION
+    /**
+     * @brief Compress a range of field values into a chunk
+     * @param values        Pointer to the first value of the chunk
+     * @param first         Index of the first value in the flat field vector
+     * @param count         Number of values in the chunk
+     * @param mantissa_bits Number of mantissa bits to keep, values are rounded to this precision if below 52
+     * @return Compressed chunk
+     *
+     * The values are split into byte planes independent of the platform endianness before compression, grouping the sign
+     * and exponent bytes of all values which greatly improves the compression ratio.
+     */
+    inline FieldDataChunk
+    compress_field_chunk(const double* values, std::uint64_t first, std::uint64_t count, unsigned int mantissa_bits) {
+        std::vector<std::uint8_t> planes(count * sizeof(double));
+        for(std::uint64_t i = 0; i < count; i++) {
+            std::uint64_t bits;
+            std::memcpy(&bits, &values[i], sizeof(double));
+
+            // Round to the requested precision unless the value is infinite or not a number:
+            if(mantissa_bits < 52 && ((bits >> 52) & 0x7FF) != 0x7FF) {
+                auto drop = 52 - mantissa_bits;
+                bits += (std::uint64_t(1) << (drop - 1));
+                bits &= ~((std::uint64_t(1) << drop) - 1);
+            }
+            for(size_t b = 0; b < sizeof(double); b++) {
+                planes[b * count + i] = static_cast<std::uint8_t>(bits >> (8 * b));
+            }
+        }
+
+        FieldDataChunk chunk;
+        chunk.first = first;
+        chunk.count = count;
+        auto length = compressBound(planes.size());
+        chunk.bytes.resize(length);
+        if(compress2(chunk.bytes.data(), &length, planes.data(), planes.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+            throw std::runtime_error("failed to compress field data");
+        }
+        chunk.bytes.resize(length);
+        return chunk;
+    }
+
+    /**
+     * @brief Decompress a chunk of field values
+     * @param chunk  Compressed chunk
+     * @param values Pointer to the position of the first value of the chunk in the flat field vector
+     */
+    inline void decompress_field_chunk(const FieldDataChunk& chunk, double* values) {
+        std::vector<std::uint8_t> planes(chunk.count * sizeof(double));
+        uLongf length = planes.size();
+        if(uncompress(planes.data(), &length, chunk.bytes.data(), chunk.bytes.size()) != Z_OK ||
+           length != planes.size()) {
+            throw std::runtime_error("corrupted field data chunk");
+        }
+
+        for(std::uint64_t i = 0; i < chunk.count; i++) {
+            std::uint64_t bits = 0;
+            for(size_t b = 0; b < sizeof(double); b++) {
+                bits |= static_cast<std::uint64_t>(planes[b * chunk.count + i]) << (8 * b);
+            }
+            std::memcpy(&values[i], &bits, sizeof(double));
+        }
+    }
+#endif
+
     /**
      * Class to hold raw, three-dimensional field data with N components, containing
      * * The actual field data as shared pointer to vector
      * * An array specifying the number of bins in each dimension
      * * An array containing the physical extent of the field in each dimension, as specified in the file
+     * * The symmetry of the field, defining which fraction of the field is stored
+     * * The block structure of adaptive grids, storing slowly varying regions of the field at lower resolution
+     *
+     * For folded fields, the dimensions and size always refer to the full field, only the data is reduced to the stored
+     * part. For adaptive grids, the dimensions refer to the finest resolution.
      */
     template <typename T = double> class FieldData {
     public:
@@ -69,12 +208,17 @@ namespace allpix {
          * @param dimensions Number of bins of the field in each coordinate
          * @param size       Physical extent of the field in each dimension, given in internal units
          * @param data       Shared pointer to the flat field data
+         * @param symmetry   Symmetry of the field, defaults to no symmetry, i.e. the full field is stored
+         * @param blocks     Block structure of adaptive grids, defaults to a regular grid
          */
         FieldData(std::string header,
                   std::array<size_t, 3> dimensions,
                   std::array<T, 3> size,
-                  std::shared_ptr<std::vector<T>> data)
-            : header_(std::move(header)), dimensions_(dimensions), size_(size), data_(std::move(data)){};
+                  std::shared_ptr<std::vector<T>> data,
+                  FieldSymmetry symmetry = FieldSymmetry::NONE,
+                  FieldBlocks blocks = FieldBlocks())
+            : header_(std::move(header)), dimensions_(dimensions), size_(size), data_(std::move(data)), symmetry_(symmetry),
+              blocks_(std::move(blocks)){};
 
         /**
          * @brief Function to obtain the header (human readbale content description) of the field data
@@ -100,6 +244,54 @@ namespace allpix {
          */
         std::shared_ptr<std::vector<T>> getData() const { return data_; }
 
+        /**
+         * @brief Member to get the symmetry of the field, defining which fraction of the field unit cell is stored
+         * @return symmetry of the field
+         */
+        FieldSymmetry getSymmetry() const { return symmetry_; }
+
+        /**
+         * @brief Member to get the block structure of adaptive grids
+         * @return block structure of the grid, without blocks for regular grids
+         */
+        const FieldBlocks& getBlocks() const { return blocks_; }
+
+        /**
+         * @brief Set the compression used when serializing the field data into APF files
+         * @param compression   Compression of the field data
+         * @param mantissa_bits Number of mantissa bits to keep, values are rounded to this precision if below 52
+         */
+        void setCompression(FieldCompression compression, unsigned int mantissa_bits = 52) {
+            if(mantissa_bits < 1 || mantissa_bits > 52) {
+                throw std::invalid_argument("number of mantissa bits must be between 1 and 52");
+            }
+#ifndef ALLPIX_APF_COMPRESSION
+            if(compression != FieldCompression::NONE) {
+                throw std::invalid_argument("compressed field data requires a build with zlib");
+            }
+#endif
+            compression_ = compression;
+            mantissa_bits_ = mantissa_bits;
+        }
+
+        /**
+         * @brief Set the number of threads used to (de-)compress the field data when serializing it
+         * @param threads Maximum number of threads
+         */
+        void setThreads(unsigned int threads) { threads_ = threads; }
+
+        /**
+         * @brief Member to get the compression of the field data, as read from file or configured for writing
+         * @return compression of the field data
+         */
+        FieldCompression getCompression() const { return compression_; }
+
+        /**
+         * @brief Member to get the number of mantissa bits the field values are stored with
+         * @return number of mantissa bits, 52 for full double precision
+         */
+        unsigned int getMantissaBits() const { return mantissa_bits_; }
+
         /**
          * @brief get the dimensionality of the configured field in the x-y plane, e.g whether it is defined in 1D, 2D or 3D.
          * @return Dimensionality of the field
@@ -116,21 +308,99 @@ namespace allpix {
         std::array<size_t, 3> dimensions_{};
         std::array<T, 3> size_{};
         std::shared_ptr<std::vector<T>> data_;
+        FieldSymmetry symmetry_{FieldSymmetry::NONE};
+        FieldBlocks blocks_;
+        FieldCompression compression_{FieldCompression::NONE};
+        std::uint32_t mantissa_bits_{52};
+        unsigned int threads_{std::max(std::thread::hardware_concurrency(), 1u)};
 
         friend class cereal::access;
 
-        // Versioned serialization function:
-        template <class Archive> void serialize(Archive& archive, std::uint32_t const version) {
-            // For now, we only know one version of this file type:
-            if(version != 1) {
+        // Versioned serialization functions, always writing the latest version:
+        template <class Archive> void save(Archive& archive, std::uint32_t const) const {
+            archive(header_);
+            archive(dimensions_);
+            archive(size_);
+            archive(symmetry_);
+            archive(blocks_);
+            archive(compression_);
+            if(compression_ == FieldCompression::NONE) {
+                archive(data_);
+                return;
+            }
+
+#ifdef ALLPIX_APF_COMPRESSION
+            // Compress independent chunks of the field data in parallel:
+            std::vector<FieldDataChunk> chunks((data_->size() + APF_CHUNK_VALUES - 1) / APF_CHUNK_VALUES);
+            run_parallel(chunks.size(), threads_, [&](size_t i) {
+                auto first = i * APF_CHUNK_VALUES;
+                auto count = std::min<size_t>(APF_CHUNK_VALUES, data_->size() - first);
+                chunks[i] = compress_field_chunk(data_->data() + first, first, count, mantissa_bits_);
+            });
+            archive(mantissa_bits_);
+            archive(static_cast<std::uint64_t>(data_->size()));
+            archive(chunks);
+#else
+            throw std::runtime_error("compressed field data requires a build with zlib");
+#endif
+        }
+        template <class Archive> void load(Archive& archive, std::uint32_t const version) {
+            // Version 1 files do not contain symmetry information, version 2 files are not compressed, version 3 files
+            // only contain regular grids:
+            if(version < 1 || version > 4) {
                 throw std::runtime_error("unknown format version " + std::to_string(version));
             }
 
-            // (De-) Serialize the data:
             archive(header_);
             archive(dimensions_);
             archive(size_);
-            archive(data_);
+            if(version < 3) {
+                archive(data_);
+                if(version == 2) {
+                    archive(symmetry_);
+                }
+                return;
+            }
+
+            archive(symmetry_);
+            if(version > 3) {
+                archive(blocks_);
+            }
+            archive(compression_);
+            if(compression_ == FieldCompression::NONE) {
+                archive(data_);
+                return;
+            } else if(compression_ != FieldCompression::ZLIB) {
+                throw std::runtime_error("unknown field data compression");
+            }
+
+#ifdef ALLPIX_APF_COMPRESSION
+            // Read the chunk index and decompress all chunks in parallel:
+            std::uint64_t values = 0;
+            std::vector<FieldDataChunk> chunks;
+            archive(mantissa_bits_);
+            archive(values);
+            archive(chunks);
+
+            // The chunks have to cover all values of the field without gaps or overlaps:
+            std::uint64_t covered = 0;
+            for(auto& chunk : chunks) {
+                if(chunk.first != covered || chunk.count > values - covered) {
+                    throw std::runtime_error("field data chunks do not match field size");
+                }
+                covered += chunk.count;
+            }
+            if(covered != values) {
+                throw std::runtime_error("field data chunks do not cover the full field, file truncated");
+            }
+
+            data_ = std::make_shared<std::vector<T>>(values);
+            run_parallel(chunks.size(), threads_, [&](size_t i) {
+                decompress_field_chunk(chunks[i], data_->data() + chunks[i].first);
+            });
+#else
+            throw std::runtime_error("compressed field data requires a build with zlib");
+#endif
         }
     };
 } // namespace allpix
@@ -143,7 +413,7 @@ namespace cereal {
             static std::uint32_t registerVersion() {
                 ::cereal::detail::StaticObject<Versions>::getInstance().mapping.emplace(
                     std::type_index(typeid(allpix::FieldData<T>)).hash_code(), APF_MIME_TYPE_VERSION);
-                return 3;
+                return APF_MIME_TYPE_VERSION;
             }
             static void unused() { (void)version; } // NOLINT
         };                                          /* end Version */
@@ -154,6 +424,196 @@ namespace cereal {
 
 namespace allpix {
 
+    /**
+     * @brief Store a regular field grid with adaptive resolution
+     * @param field_data Field data with a regular grid
+     * @param n          Number of components per field point
+     * @param block_size Number of bins per block along each axis, has to be a power of two
+     * @param tolerance  Maximum deviation of the stored field from every bin of the regular grid, relative to the magnitude
+     *                   of the field in this bin
+     * @param threads    Maximum number of threads used to coarsen the blocks in parallel
+     * @return Field data with a block-structured grid
+     * @throws std::invalid_argument If the grid is already adaptive or octant-folded, or the block size is invalid
+     *
+     * Every block is stored at the coarsest level for which the cell values, averaged over the bins they cover, deviate from
+     * none of these bins by more than the tolerance times the field magnitude of the bin. Regions of slowly varying field
+     * are thereby stored with few values, while the full resolution is kept where the field changes rapidly compared to its
+     * local strength, e.g. close to the electrodes. Bins without field are only coarsened with equally empty neighbours.
+     */
+    template <typename T>
+    FieldData<T> coarsen_field_data(const FieldData<T>& field_data,
+                                    size_t n,
+                                    std::uint32_t block_size,
+                                    double tolerance,
+                                    unsigned int threads = std::max(std::thread::hardware_concurrency(), 1u)) {
+        if(field_data.getBlocks().isAdaptive()) {
+            throw std::invalid_argument("field grid is already adaptive");
+        }
+        if(field_data.getSymmetry() == FieldSymmetry::OCTANT) {
+            throw std::invalid_argument("adaptive grids are not supported for octant-folded fields");
+        }
+        if(block_size < 2 || (block_size & (block_size - 1)) != 0) {
+            throw std::invalid_argument("block size has to be a power of two larger than one");
+        }
+
+        auto dimensions = symmetry_folded_dimensions(field_data.getDimensions(), field_data.getSymmetry());
+        const auto& data = *field_data.getData();
+
+        auto counts = field_block_counts(dimensions, block_size);
+        auto max_level = field_block_shift(block_size);
+        FieldBlocks blocks;
+        blocks.size = block_size;
+        blocks.levels.resize(counts[0] * counts[1] * counts[2]);
+        std::vector<std::vector<T>> block_data(blocks.levels.size());
+
+        run_parallel(blocks.levels.size(), threads, [&](size_t block) {
+            std::array<size_t, 3> index{
+                {block / (counts[1] * counts[2]), (block / counts[2]) % counts[1], block % counts[2]}};
+            std::array<size_t, 3> start{}, extent{};
+            for(size_t i = 0; i < 3; ++i) {
+                start[i] = index[i] * block_size;
+                extent[i] = std::min<size_t>(block_size, dimensions[i] - start[i]);
+            }
+
+            // Apply a function to all bins of the block covered by a cell, providing the index of their first component
+            auto for_cell_bins = [&](unsigned int level,
+                                     const std::array<size_t, 3>& cell,
+                                     const std::function<void(size_t)>& fn) {
+                for(size_t x = cell[0] << level; x < std::min(extent[0], (cell[0] + 1) << level); ++x) {
+                    for(size_t y = cell[1] << level; y < std::min(extent[1], (cell[1] + 1) << level); ++y) {
+                        for(size_t z = cell[2] << level; z < std::min(extent[2], (cell[2] + 1) << level); ++z) {
+                            fn((((start[0] + x) * dimensions[1] + start[1] + y) * dimensions[2] + start[2] + z) * n);
+                        }
+                    }
+                }
+            };
+
+            // Try the levels from the coarsest one until the deviation is within the tolerance
+            for(auto level = max_level;; --level) {
+                std::array<size_t, 3> cells{};
+                for(size_t i = 0; i < 3; ++i) {
+                    cells[i] = (extent[i] + (size_t(1) << level) - 1) >> level;
+                }
+
+                std::vector<T> values(cells[0] * cells[1] * cells[2] * n);
+                bool accepted = true;
+                std::array<size_t, 3> cell{};
+                for(cell[0] = 0; cell[0] < cells[0] && accepted; ++cell[0]) {
+                    for(cell[1] = 0; cell[1] < cells[1] && accepted; ++cell[1]) {
+                        for(cell[2] = 0; cell[2] < cells[2] && accepted; ++cell[2]) {
+                            auto* value = &values[((cell[0] * cells[1] + cell[1]) * cells[2] + cell[2]) * n];
+                            size_t bins = 0;
+                            for_cell_bins(level, cell, [&](size_t bin) {
+                                for(size_t c = 0; c < n; ++c) {
+                                    value[c] += data[bin + c];
+                                }
+                                ++bins;
+                            });
+                            for(size_t c = 0; c < n; ++c) {
+                                value[c] /= static_cast<T>(bins);
+                            }
+                            for_cell_bins(level, cell, [&](size_t bin) {
+                                T magnitude2 = 0, deviation2 = 0;
+                                for(size_t c = 0; c < n; ++c) {
+                                    magnitude2 += data[bin + c] * data[bin + c];
+                                    deviation2 += (data[bin + c] - value[c]) * (data[bin + c] - value[c]);
+                                }
+                                accepted = accepted && deviation2 <= tolerance * tolerance * magnitude2;
+                            });
+                        }
+                    }
+                }
+
+                if(accepted || level == 0) {
+                    blocks.levels[block] = static_cast<std::uint8_t>(level);
+                    block_data[block] = std::move(values);
+                    return;
+                }
+            }
+        });
+
+        auto coarse_data = std::make_shared<std::vector<T>>();
+        for(auto& values : block_data) {
+            coarse_data->insert(coarse_data->end(), values.begin(), values.end());
+        }
+        return FieldData<T>(field_data.getHeader(),
+                            field_data.getDimensions(),
+                            field_data.getSize(),
+                            coarse_data,
+                            field_data.getSymmetry(),
+                            blocks);
+    }
+
+    /**
+     * @brief Expand an adaptive field grid to a regular grid at its finest resolution
+     * @param field_data Field data with a regular or block-structured grid
+     * @param n          Number of components per field point
+     * @return Field data with a regular grid, the field data itself if it already is regular
+     */
+    template <typename T> FieldData<T> refine_field_data(const FieldData<T>& field_data, size_t n) {
+        if(!field_data.getBlocks().isAdaptive()) {
+            return field_data;
+        }
+
+        auto dimensions = symmetry_folded_dimensions(field_data.getDimensions(), field_data.getSymmetry());
+        auto layout = field_block_layout(dimensions, field_data.getBlocks(), n);
+        auto counts = field_block_counts(dimensions, field_data.getBlocks().size);
+        auto shift = field_block_shift(field_data.getBlocks().size);
+        const auto& data = *field_data.getData();
+
+        auto regular_data = std::make_shared<std::vector<T>>(dimensions[0] * dimensions[1] * dimensions[2] * n);
+        auto* bin = regular_data->data();
+        for(size_t x = 0; x < dimensions[0]; ++x) {
+            for(size_t y = 0; y < dimensions[1]; ++y) {
+                for(size_t z = 0; z < dimensions[2]; ++z, bin += n) {
+                    std::copy_n(&data[field_block_index(layout, counts, shift, x, y, z, n)], n, bin);
+                }
+            }
+        }
+        return FieldData<T>(field_data.getHeader(),
+                            field_data.getDimensions(),
+                            field_data.getSize(),
+                            regular_data,
+                            field_data.getSymmetry());
+    }
+
+    /**
+     * @brief Calculate the largest deviation of the lookups in an adaptive field grid from the original regular grid
+     * @param regular  Field data with the regular grid
+     * @param adaptive Field data with the adaptive grid
+     * @param n        Number of components per field point
+     * @return Largest deviation of any bin, relative to the magnitude of the field in this bin
+     * @throws std::invalid_argument If the grids do not have the same dimensions and symmetry
+     *
+     * The adaptive grid is read through the same block lookup as the detector fields. Bins without field are only counted if
+     * the adaptive grid does not reproduce them exactly, in which case the deviation is infinite.
+     */
+    template <typename T>
+    double adaptive_field_deviation(const FieldData<T>& regular, const FieldData<T>& adaptive, size_t n) {
+        if(regular.getDimensions() != adaptive.getDimensions() || regular.getSymmetry() != adaptive.getSymmetry()) {
+            throw std::invalid_argument("adaptive field grid does not match the regular grid");
+        }
+
+        auto regular_data = refine_field_data(regular, n).getData();
+        auto lookup_data = refine_field_data(adaptive, n).getData();
+        const auto& data = *regular_data;
+        const auto& lookup = *lookup_data;
+        double max_deviation = 0;
+        for(size_t bin = 0; bin < data.size(); bin += n) {
+            double magnitude2 = 0, deviation2 = 0;
+            for(size_t c = 0; c < n; ++c) {
+                magnitude2 += static_cast<double>(data[bin + c] * data[bin + c]);
+                deviation2 += static_cast<double>((data[bin + c] - lookup[bin + c]) * (data[bin + c] - lookup[bin + c]));
+            }
+            if(deviation2 > 0) {
+                max_deviation = std::max(max_deviation,
+                                         magnitude2 > 0 ? std::sqrt(deviation2 / magnitude2)
+                                                        : std::numeric_limits<double>::infinity());
+            }
+        }
+        return max_deviation;
+    }
+
     /**
      * @brief Class to parse Allpix Squared field data from files
      *
@@ -178,11 +638,14 @@ namespace allpix {
          * @brief Parse a file and retrieve the field data.
          * @param file_name  File name (as canonical path) of the input file to be parsed
          * @param units      Optional units to convert the field from after reading from file. Only used by some formats.
+         * @param threads    Maximum number of threads used to decompress the field data. Only used by compressed APF files.
          * @return           Field data object read from file or internal cache
          *
          * The type of the field data file to be read is deducted automatically from the file content
          */
-        FieldData<T> getByFileName(const std::string& file_name, const std::string& units = std::string()) {
+        FieldData<T> getByFileName(const std::string& file_name,
+                                   const std::string& units = std::string(),
+                                   unsigned int threads = std::max(std::thread::hardware_concurrency(), 1u)) {
             // Search in cache (NOTE: the path reached here is always a canonical name)
             auto iter = field_map_.find(file_name);
             if(iter != field_map_.end()) {
@@ -205,7 +668,7 @@ namespace allpix {
                 if(!units.empty()) {
                     LOG(DEBUG) << "Units will be ignored, APF file content is interpreted in internal units.";
                 }
-                return parse_apf_file(file_name);
+                return parse_apf_file(file_name, threads);
             default:
                 throw std::runtime_error("unknown file format");
             }
@@ -228,10 +691,12 @@ namespace allpix {
          * units, i.e. all values stored in APF files are given framework-internal base units. This includes the field data
          * itself as well as the field size.
          * @param file_name  File name (as canonical path) of the input file to be parsed
+         * @param threads    Maximum number of threads used to decompress the field data
          */
-        FieldData<T> parse_apf_file(const std::string& file_name) {
+        FieldData<T> parse_apf_file(const std::string& file_name, unsigned int threads) {
             std::ifstream file(file_name, std::ios::binary);
             FieldData<double> field_data;
+            field_data.setThreads(threads);
 
             // Parse the file with cereal, add manual scope to ensure flushing:
             {
@@ -241,9 +706,13 @@ namespace allpix {
 
             // Check that we have the right number of vector entries
             auto dimensions = field_data.getDimensions();
-            if(field_data.getData()->size() != dimensions[0] * dimensions[1] * dimensions[2] * N_) {
+            if(field_data.getData()->size() !=
+               field_grid_values(dimensions, field_data.getSymmetry(), field_data.getBlocks(), N_)) {
                 throw std::runtime_error("invalid data");
             }
+            if(field_data.getSymmetry() == FieldSymmetry::OCTANT && dimensions[0] != dimensions[1]) {
+                throw std::runtime_error("octant-folded field requires equal number of bins in x and y");
+            }
 
             return field_data;
         }
@@ -373,6 +842,22 @@ namespace allpix {
         };
         ~FieldWriter() = default;
 
+        /**
+         * @brief Configure the compression of field data written to APF files
+         * @param compression   Compression of the field data
+         * @param mantissa_bits Number of mantissa bits to keep, values are rounded to this precision if below 52
+         */
+        void setCompression(FieldCompression compression, unsigned int mantissa_bits = 52) {
+            compression_ = compression;
+            mantissa_bits_ = mantissa_bits;
+        }
+
+        /**
+         * @brief Configure the number of threads used to compress field data written to APF files
+         * @param threads Maximum number of threads
+         */
+        void setThreads(unsigned int threads) { threads_ = threads; }
+
         /**
          * @brief Write the field to a file
          * @param field_data Field data object to store
@@ -385,16 +870,22 @@ namespace allpix {
                        const FileType& file_type,
                        const std::string& units = std::string()) {
             auto dimensions = field_data.getDimensions();
-            if(field_data.getData()->size() != N_ * dimensions[0] * dimensions[1] * dimensions[2]) {
+            if(field_data.getData()->size() !=
+               field_grid_values(dimensions, field_data.getSymmetry(), field_data.getBlocks(), N_)) {
                 throw std::runtime_error("invalid field dimensions");
             }
 
             switch(file_type) {
             case FileType::INIT:
+                // The INIT format has no means to declare a field symmetry:
+                if(field_data.getSymmetry() != FieldSymmetry::NONE) {
+                    throw std::runtime_error("folded fields cannot be stored in INIT format, unfold the field first");
+                }
                 if(units.empty()) {
                     LOG(WARNING) << "No field units provided, writing field data in internal units.";
                 }
-                write_init_file(field_data, file_name, units);
+                // The INIT format only stores regular grids, adaptive grids are written at their finest resolution:
+                write_init_file(refine_field_data(field_data, N_), file_name, units);
                 break;
             case FileType::APF:
                 if(!units.empty()) {
@@ -418,9 +909,14 @@ namespace allpix {
         void write_apf_file(const FieldData<T>& field_data, const std::string& file_name) {
             std::ofstream file(file_name, std::ios::binary);
 
+            // Apply the configured compression to a shallow copy of the field data:
+            auto compressed_data = field_data;
+            compressed_data.setCompression(compression_, mantissa_bits_);
+            compressed_data.setThreads(threads_);
+
             // Write the file with cereal:
             cereal::PortableBinaryOutputArchive archive(file);
-            archive(field_data);
+            archive(compressed_data);
         }
 
         /**
@@ -480,6 +976,9 @@ namespace allpix {
         }
 
         size_t N_;
+        FieldCompression compression_{FieldCompression::NONE};
+        unsigned int mantissa_bits_{52};
+        unsigned int threads_{std::max(std::thread::hardware_concurrency(), 1u)};
     };
 } // namespace allpix
 
@@ -0,0 +1,135 @@
+/**
+ * @file
+ * @brief Definition of symmetries of field grids which allow storing only a fraction of the field
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_FIELD_SYMMETRY_H
+#define ALLPIX_FIELD_SYMMETRY_H
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <stdexcept>
+#include <string>
+
+namespace allpix {
+
+    /**
+     * @brief Symmetry of a field grid, defining which fraction of the field unit cell is stored
+     *
+     * Folded grids only store the part of the field with non-negative coordinates relative to the field center along the
+     * mirrored axes, the remaining parts are obtained by mirroring. Vector field components along a mirrored axis change
+     * their sign. The octant symmetry additionally requires the field to be invariant under exchange of the x and y axes,
+     * and only the part with x >= y is stored.
+     *
+     * The bin dimensions always refer to the full grid. Along a mirrored axis with n bins, the (n + 1) / 2 bins starting
+     * from bin n / 2 are stored, i.e. for an odd number of bins the central bin is included.
+     */
+    enum class FieldSymmetry {
+        NONE = 0, ///< No symmetry, the full field unit cell is stored
+        MIRROR_X, ///< Mirror symmetry in x, only the half with x >= 0 is stored
+        MIRROR_Y, ///< Mirror symmetry in y, only the half with y >= 0 is stored
+        QUADRANT, ///< Mirror symmetry in x and y, only the quadrant with x >= 0 and y >= 0 is stored
+        OCTANT,   ///< Quadrant symmetry plus exchange of x and y, only the octant with x >= y >= 0 is stored
+    };
+
+    /**
+     * @brief Check whether a field symmetry folds the field along the x axis
+     * @param symmetry Symmetry of the field
+     * @return True if only the half with x >= 0 is stored
+     */
+    inline bool symmetry_mirrors_x(FieldSymmetry symmetry) {
+        return symmetry == FieldSymmetry::MIRROR_X || symmetry == FieldSymmetry::QUADRANT ||
+               symmetry == FieldSymmetry::OCTANT;
+    }
+
+    /**
+     * @brief Check whether a field symmetry folds the field along the y axis
+     * @param symmetry Symmetry of the field
+     * @return True if only the half with y >= 0 is stored
+     */
+    inline bool symmetry_mirrors_y(FieldSymmetry symmetry) {
+        return symmetry == FieldSymmetry::MIRROR_Y || symmetry == FieldSymmetry::QUADRANT ||
+               symmetry == FieldSymmetry::OCTANT;
+    }
+
+    /**
+     * @brief Calculate the number of bins stored along the x and y axes of a folded grid
+     * @param dimensions Number of bins of the full grid in x, y and z
+     * @param symmetry   Symmetry of the field
+     * @return Number of stored bins in x, y and z
+     */
+    inline std::array<size_t, 3> symmetry_folded_dimensions(const std::array<size_t, 3>& dimensions,
+                                                            FieldSymmetry symmetry) {
+        return {{symmetry_mirrors_x(symmetry) ? (dimensions[0] + 1) / 2 : dimensions[0],
+                 symmetry_mirrors_y(symmetry) ? (dimensions[1] + 1) / 2 : dimensions[1],
+                 dimensions[2]}};
+    }
+
+    /**
+     * @brief Calculate the number of field points stored for a folded grid
+     * @param dimensions Number of bins of the full grid in x, y and z
+     * @param symmetry   Symmetry of the field
+     * @return Number of field points, i.e. the size of the flat field vector divided by the number of components
+     *
+     * Octant-folded grids store only the triangle with x >= y of the quadrant grid, i.e. n(n+1)/2 columns for n stored
+     * bins in x and y.
+     */
+    inline size_t symmetry_grid_points(const std::array<size_t, 3>& dimensions, FieldSymmetry symmetry) {
+        auto folded = symmetry_folded_dimensions(dimensions, symmetry);
+        if(symmetry == FieldSymmetry::OCTANT) {
+            return folded[0] * (folded[0] + 1) / 2 * folded[2];
+        }
+        return folded[0] * folded[1] * folded[2];
+    }
+
+    /**
+     * @brief Convert a field symmetry to its human-readable name
+     * @param symmetry Symmetry of the field
+     * @return Lower-case name of the symmetry
+     */
+    inline std::string symmetry_to_string(FieldSymmetry symmetry) {
+        switch(symmetry) {
+        case FieldSymmetry::MIRROR_X:
+            return "mirror_x";
+        case FieldSymmetry::MIRROR_Y:
+            return "mirror_y";
+        case FieldSymmetry::QUADRANT:
+            return "quadrant";
+        case FieldSymmetry::OCTANT:
+            return "octant";
+        default:
+            return "none";
+        }
+    }
+
+    /**
+     * @brief Convert the name of a field symmetry to the symmetry
+     * @param name Name of the symmetry, case-insensitive
+     * @return Symmetry of the field
+     * @throws std::invalid_argument If the name does not correspond to any known symmetry
+     */
+    inline FieldSymmetry symmetry_from_string(std::string name) {
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if(name == "none") {
+            return FieldSymmetry::NONE;
+        } else if(name == "mirror_x") {
+            return FieldSymmetry::MIRROR_X;
+        } else if(name == "mirror_y") {
+            return FieldSymmetry::MIRROR_Y;
+        } else if(name == "quadrant") {
+            return FieldSymmetry::QUADRANT;
+        } else if(name == "octant") {
+            return FieldSymmetry::OCTANT;
+        }
+        throw std::invalid_argument("unknown field symmetry \"" + name +
+                                    "\", should be 'none', 'mirror_x', 'mirror_y', 'quadrant' or 'octant'");
+    }
+} // namespace allpix
+
+#endif /* ALLPIX_FIELD_SYMMETRY_H */
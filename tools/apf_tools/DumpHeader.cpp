@@ -20,6 +20,16 @@ template <typename T> static void print_info(allpix::FieldData<T> field_data, si
               << std::endl;
     std::cout << "Dimensions: " << field_data.getDimensions()[0] << " x " << field_data.getDimensions()[1] << " x "
               << field_data.getDimensions()[2] << " cells" << std::endl;
+    std::cout << "Symmetry:   " << symmetry_to_string(field_data.getSymmetry()) << std::endl;
+    if(field_data.getBlocks().isAdaptive()) {
+        std::cout << "Resolution: adaptive, blocks of " << field_data.getBlocks().size << " cells" << std::endl;
+    }
+    if(field_data.getCompression() == FieldCompression::ZLIB) {
+        std::cout << "Storage:    zlib-compressed chunks of " << APF_CHUNK_VALUES << " values, "
+                  << field_data.getMantissaBits() << " mantissa bits" << std::endl;
+    } else {
+        std::cout << "Storage:    uncompressed" << std::endl;
+    }
     std::cout << "Field vector with " << field_data.getData()->size() << " entries" << std::endl;
 
     if(n > 0) {
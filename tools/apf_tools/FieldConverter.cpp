@@ -38,6 +38,12 @@ int main(int argc, const char* argv[]) {
     std::string file_output;
     std::string units;
     bool scalar = false;
+    bool compress = false;
+    bool precision = false;
+    unsigned int mantissa_bits = 52;
+    double adaptive_tolerance = 0;
+    unsigned int block_size = 4;
+    bool regular = false;
     for(int i = 1; i < argc; i++) {
         if(strcmp(argv[i], "-h") == 0) {
             print_help = true;
@@ -60,6 +66,17 @@ int main(int argc, const char* argv[]) {
             units = std::string(argv[++i]);
         } else if(strcmp(argv[i], "--scalar") == 0) {
             scalar = true;
+        } else if(strcmp(argv[i], "--compress") == 0) {
+            compress = true;
+        } else if(strcmp(argv[i], "--precision") == 0 && (i + 1 < argc)) {
+            mantissa_bits = static_cast<unsigned int>(std::atoi(argv[++i]));
+            precision = true;
+        } else if(strcmp(argv[i], "--adaptive") == 0 && (i + 1 < argc)) {
+            adaptive_tolerance = std::atof(argv[++i]);
+        } else if(strcmp(argv[i], "--block_size") == 0 && (i + 1 < argc)) {
+            block_size = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else if(strcmp(argv[i], "--regular") == 0) {
+            regular = true;
         } else {
             LOG(ERROR) << "Unrecognized command line argument \"" << argv[i] << "\"";
             print_help = true;
@@ -80,6 +97,16 @@ int main(int argc, const char* argv[]) {
         std::cout << "  --units <units>  units the field is provided in" << std::endl << std::endl;
         std::cout << "Options:" << std::endl;
         std::cout << "  --scalar         Convert scalar field. Default is vector field" << std::endl;
+        std::cout << "  --compress       Store APF field data in compressed chunks" << std::endl;
+        std::cout << "  --precision <N>  Round values to N mantissa bits, 1 to 52, requires --compress. Defaults to 52"
+                  << std::endl;
+        std::cout << "                   (full double precision), 23 corresponds to single precision" << std::endl;
+        std::cout << "  --adaptive <T>   Store APF field data with adaptive resolution, coarsening blocks in which the"
+                  << std::endl;
+        std::cout << "                   field deviates by at most a fraction T of its local magnitude" << std::endl;
+        std::cout << "  --block_size <N> Number of bins per block of adaptive grids, power of two. Defaults to 4"
+                  << std::endl;
+        std::cout << "  --regular        Expand APF field data with adaptive resolution to a regular grid" << std::endl;
         std::cout << std::endl;
         std::cout << "For more help, please see <https://cern.ch/allpix-squared>" << std::endl;
         return return_code;
@@ -88,10 +115,39 @@ int main(int argc, const char* argv[]) {
     try {
         FieldQuantity quantity = (scalar ? FieldQuantity::SCALAR : FieldQuantity::VECTOR);
 
+        // Values are only rounded when compressing, a precision without compression would silently be ignored:
+        if(precision && !compress) {
+            throw std::invalid_argument("reduced precision is only supported together with compression");
+        }
+
         FieldParser<double> field_parser(quantity);
         LOG(STATUS) << "Reading input file from " << file_input;
         auto field_data = field_parser.getByFileName(file_input, units);
         FieldWriter<double> field_writer(quantity);
+        if(compress) {
+            if(format_to != FileType::APF) {
+                throw std::invalid_argument("compression is only supported for the APF format");
+            }
+            field_writer.setCompression(FieldCompression::ZLIB, mantissa_bits);
+        }
+        if(regular) {
+            if(adaptive_tolerance > 0) {
+                throw std::invalid_argument("adaptive resolution cannot be combined with a regular grid");
+            }
+            field_data = refine_field_data(field_data, static_cast<size_t>(quantity));
+        }
+        if(adaptive_tolerance > 0) {
+            if(format_to != FileType::APF) {
+                throw std::invalid_argument("adaptive resolution is only supported for the APF format");
+            }
+            auto adaptive_data =
+                coarsen_field_data(field_data, static_cast<size_t>(quantity), block_size, adaptive_tolerance);
+            LOG(STATUS) << "Adaptive grid stores " << adaptive_data.getData()->size() << " of "
+                        << field_data.getData()->size() << " values, lookups deviate by at most "
+                        << adaptive_field_deviation(field_data, adaptive_data, static_cast<size_t>(quantity))
+                        << " of the local field";
+            field_data = adaptive_data;
+        }
         LOG(STATUS) << "Writing output file to " << file_output;
         field_writer.writeFile(field_data, file_output, format_to, (format_to == FileType::INIT ? units : ""));
     } catch(std::exception& e) {
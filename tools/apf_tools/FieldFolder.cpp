@@ -0,0 +1,296 @@
+/**
+ * @file
+ * @brief Tool to fold APF field files to their symmetric fraction and to validate the declared symmetry
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "core/utils/log.h"
+#include "tools/field_parser.h"
+#include "tools/units.h"
+
+using namespace allpix;
+
+using FieldValue = std::array<double, 3>;
+
+/**
+ * @brief Apply a symmetry transformation to a field vector, scalar fields remain unchanged
+ * @param value   Field value to transform
+ * @param n       Number of components per field point
+ * @param flip_x  Invert the x component
+ * @param flip_y  Invert the y component
+ * @param swap_xy Exchange x and y components before inverting
+ * @return Transformed field value
+ */
+static FieldValue transform_value(FieldValue value, size_t n, bool flip_x, bool flip_y, bool swap_xy) {
+    if(n == 3) {
+        if(swap_xy) {
+            std::swap(value[0], value[1]);
+        }
+        value[0] = (flip_x ? -value[0] : value[0]);
+        value[1] = (flip_y ? -value[1] : value[1]);
+    }
+    return value;
+}
+
+/**
+ * @brief Obtain the field value at a bin of the full (unfolded) grid from a possibly folded field
+ * @param field_data Field data with arbitrary symmetry
+ * @param n          Number of components per field point
+ * @param i          Bin index in x of the full grid
+ * @param j          Bin index in y of the full grid
+ * @param k          Bin index in z
+ * @return Field value with components mirrored and exchanged according to the symmetry
+ */
+static FieldValue unfolded_value(const FieldData<double>& field_data, size_t n, size_t i, size_t j, size_t k) {
+    auto symmetry = field_data.getSymmetry();
+    auto full = field_data.getDimensions();
+    auto dimensions = symmetry_folded_dimensions(full, symmetry);
+
+    // Mirror bins before the center of folded axes onto their stored partner
+    bool flip_x = false, flip_y = false, swap_xy = false;
+    if(symmetry_mirrors_x(symmetry)) {
+        flip_x = (i < full[0] / 2);
+        i = (flip_x ? full[0] - 1 - i : i) - full[0] / 2;
+    }
+    if(symmetry_mirrors_y(symmetry)) {
+        flip_y = (j < full[1] / 2);
+        j = (flip_y ? full[1] - 1 - j : j) - full[1] / 2;
+    }
+
+    size_t column = 0;
+    if(symmetry == FieldSymmetry::OCTANT) {
+        swap_xy = (j > i);
+        if(swap_xy) {
+            std::swap(i, j);
+        }
+        column = i * (i + 1) / 2 + j;
+    } else {
+        column = i * dimensions[1] + j;
+    }
+
+    FieldValue value{};
+    for(size_t c = 0; c < n; c++) {
+        value[c] = field_data.getData()->at((column * dimensions[2] + k) * n + c);
+    }
+
+    return transform_value(value, n, flip_x, flip_y, swap_xy);
+}
+
+/**
+ * @brief Main function running the application
+ */
+int main(int argc, const char* argv[]) {
+
+    // Register the default set of units with this executable:
+    register_units();
+
+    // Add cout as the default logging stream
+    Log::addStream(std::cout);
+
+    // If no arguments are provided, print the help:
+    bool print_help = false;
+    int return_code = 0;
+    if(argc == 1) {
+        print_help = true;
+        return_code = 1;
+    }
+
+    // Parse arguments
+    std::string file_input;
+    std::string file_output;
+    std::string units;
+    std::string symmetry_name;
+    double tolerance = 1e-3;
+    bool scalar = false;
+    bool check_only = false;
+    bool force = false;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-h") == 0) {
+            print_help = true;
+        } else if(strcmp(argv[i], "-v") == 0 && (i + 1 < argc)) {
+            try {
+                LogLevel log_level = Log::getLevelFromString(std::string(argv[++i]));
+                Log::setReportingLevel(log_level);
+            } catch(std::invalid_argument& e) {
+                LOG(ERROR) << "Invalid verbosity level \"" << std::string(argv[i]) << "\", ignoring overwrite";
+            }
+        } else if(strcmp(argv[i], "--input") == 0 && (i + 1 < argc)) {
+            file_input = std::string(argv[++i]);
+        } else if(strcmp(argv[i], "--output") == 0 && (i + 1 < argc)) {
+            file_output = std::string(argv[++i]);
+        } else if(strcmp(argv[i], "--symmetry") == 0 && (i + 1 < argc)) {
+            symmetry_name = std::string(argv[++i]);
+        } else if(strcmp(argv[i], "--tolerance") == 0 && (i + 1 < argc)) {
+            tolerance = std::atof(argv[++i]);
+        } else if(strcmp(argv[i], "--units") == 0 && (i + 1 < argc)) {
+            units = std::string(argv[++i]);
+        } else if(strcmp(argv[i], "--scalar") == 0) {
+            scalar = true;
+        } else if(strcmp(argv[i], "--check") == 0) {
+            check_only = true;
+        } else if(strcmp(argv[i], "--force") == 0) {
+            force = true;
+        } else {
+            LOG(ERROR) << "Unrecognized command line argument \"" << argv[i] << "\"";
+            print_help = true;
+            return_code = 1;
+        }
+    }
+
+    // Print help if requested or no arguments given
+    if(print_help || file_input.empty() || symmetry_name.empty() || (!check_only && file_output.empty())) {
+        std::cout << "Allpix Squared APF Field Folding Tool" << std::endl;
+        std::cout << std::endl;
+        std::cout << "Usage: apf_fold <parameters>" << std::endl;
+        std::cout << std::endl;
+        std::cout << "Parameters:" << std::endl;
+        std::cout << "  --input <file>       input field file, INIT or APF format" << std::endl;
+        std::cout << "  --output <file>      output APF field file, not required with --check" << std::endl;
+        std::cout << "  --symmetry <name>    symmetry to fold the field with: none, mirror_x, mirror_y, quadrant or octant"
+                  << std::endl;
+        std::cout << "                       'none' unfolds a folded input field" << std::endl << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  --check              only validate the symmetry of the field, do not write output" << std::endl;
+        std::cout << "  --tolerance <value>  maximum deviation from the symmetry relative to the largest field value"
+                  << std::endl;
+        std::cout << "                       Defaults to 1e-3" << std::endl;
+        std::cout << "  --force              write the folded field even if the symmetry validation fails" << std::endl;
+        std::cout << "  --units <units>      units the field is provided in, only used for INIT input files" << std::endl;
+        std::cout << "  --scalar             fold scalar field. Default is vector field" << std::endl;
+        std::cout << std::endl;
+        std::cout << "For more help, please see <https://cern.ch/allpix-squared>" << std::endl;
+        return (print_help ? return_code : 1);
+    }
+
+    try {
+        auto symmetry = symmetry_from_string(symmetry_name);
+        FieldQuantity quantity = (scalar ? FieldQuantity::SCALAR : FieldQuantity::VECTOR);
+        auto n = static_cast<size_t>(quantity);
+
+        FieldParser<double> field_parser(quantity);
+        LOG(STATUS) << "Reading input file from " << file_input;
+        auto field_data = refine_field_data(field_parser.getByFileName(file_input, units), n);
+
+        // Dimensions always refer to the full field grid, also for folded input fields:
+        auto full = field_data.getDimensions();
+        LOG(INFO) << "Input field has " << symmetry_to_string(field_data.getSymmetry()) << " symmetry, full grid with "
+                  << full[0] << "x" << full[1] << "x" << full[2] << " cells";
+
+        // Check that the grid can be folded with the requested symmetry
+        if(symmetry == FieldSymmetry::OCTANT &&
+           (full[0] != full[1] || std::fabs(field_data.getSize()[0] - field_data.getSize()[1]) > 1e-9)) {
+            throw std::invalid_argument("octant folding requires identical binning and size in x and y");
+        }
+
+        // Validate the symmetry by comparing every field point with its mirrored partners:
+        double max_value = 0, max_deviation = 0;
+        for(size_t i = 0; i < full[0]; i++) {
+            LOG_PROGRESS(INFO, "validate") << "Validating field symmetry: " << (100 * i / full[0]) << "%";
+            for(size_t j = 0; j < full[1]; j++) {
+                for(size_t k = 0; k < full[2]; k++) {
+                    auto value = unfolded_value(field_data, n, i, j, k);
+                    std::vector<std::pair<FieldValue, FieldValue>> partners;
+                    if(symmetry_mirrors_x(symmetry)) {
+                        partners.emplace_back(unfolded_value(field_data, n, full[0] - 1 - i, j, k),
+                                              transform_value(value, n, true, false, false));
+                    }
+                    if(symmetry_mirrors_y(symmetry)) {
+                        partners.emplace_back(unfolded_value(field_data, n, i, full[1] - 1 - j, k),
+                                              transform_value(value, n, false, true, false));
+                    }
+                    if(symmetry == FieldSymmetry::OCTANT) {
+                        partners.emplace_back(unfolded_value(field_data, n, j, i, k),
+                                              transform_value(value, n, false, false, true));
+                    }
+
+                    for(size_t c = 0; c < n; c++) {
+                        max_value = std::max(max_value, std::fabs(value[c]));
+                        for(auto& partner : partners) {
+                            max_deviation = std::max(max_deviation, std::fabs(partner.first[c] - partner.second[c]));
+                        }
+                    }
+                }
+            }
+        }
+        LOG_PROGRESS(INFO, "validate") << "Validating field symmetry: finished.";
+
+        auto relative_deviation = (max_value > 0 ? max_deviation / max_value : 0.);
+        LOG(STATUS) << "Maximum deviation from " << symmetry_to_string(symmetry) << " symmetry is " << relative_deviation
+                    << " relative to the largest field value";
+        if(relative_deviation > tolerance) {
+            LOG(ERROR) << "Field is not compatible with " << symmetry_to_string(symmetry) << " symmetry within tolerance "
+                       << tolerance;
+            return_code = 1;
+            if(!force) {
+                return return_code;
+            }
+        }
+
+        if(check_only) {
+            return return_code;
+        }
+
+        // Fold the field by averaging each stored point over all its symmetry partners
+        auto folded = symmetry_folded_dimensions(full, symmetry);
+        auto data = std::make_shared<std::vector<double>>(symmetry_grid_points(full, symmetry) * n);
+
+        size_t column = 0;
+        for(size_t i_f = 0; i_f < folded[0]; i_f++) {
+            auto j_max = (symmetry == FieldSymmetry::OCTANT ? i_f + 1 : folded[1]);
+            for(size_t j_f = 0; j_f < j_max; j_f++, column++) {
+                auto i = (symmetry_mirrors_x(symmetry) ? full[0] / 2 + i_f : i_f);
+                auto j = (symmetry_mirrors_y(symmetry) ? full[1] / 2 + j_f : j_f);
+
+                for(size_t k = 0; k < full[2]; k++) {
+                    FieldValue sum{};
+                    size_t partners = 0;
+                    for(int swap_xy = 0; swap_xy <= (symmetry == FieldSymmetry::OCTANT ? 1 : 0); swap_xy++) {
+                        for(int flip_x = 0; flip_x <= (symmetry_mirrors_x(symmetry) ? 1 : 0); flip_x++) {
+                            for(int flip_y = 0; flip_y <= (symmetry_mirrors_y(symmetry) ? 1 : 0); flip_y++) {
+                                auto pi = (swap_xy != 0 ? j : i);
+                                auto pj = (swap_xy != 0 ? i : j);
+                                pi = (flip_x != 0 ? full[0] - 1 - pi : pi);
+                                pj = (flip_y != 0 ? full[1] - 1 - pj : pj);
+
+                                // Transform the partner value back into the stored frame
+                                auto value = transform_value(
+                                    unfolded_value(field_data, n, pi, pj, k), n, flip_x != 0, flip_y != 0, false);
+                                value = transform_value(value, n, false, false, swap_xy != 0);
+                                for(size_t c = 0; c < n; c++) {
+                                    sum[c] += value[c];
+                                }
+                                partners++;
+                            }
+                        }
+                    }
+
+                    for(size_t c = 0; c < n; c++) {
+                        (*data)[(column * full[2] + k) * n + c] = sum[c] / static_cast<double>(partners);
+                    }
+                }
+            }
+        }
+
+        FieldData<double> folded_data(field_data.getHeader(), full, field_data.getSize(), data, symmetry);
+        LOG(STATUS) << "Folded field to " << folded[0] << "x" << folded[1] << "x" << folded[2] << " stored cells with "
+                    << symmetry_to_string(symmetry) << " symmetry, storing " << data->size() << " instead of "
+                    << full[0] * full[1] * full[2] * n << " values";
+
+        FieldWriter<double> field_writer(quantity);
+        LOG(STATUS) << "Writing output file to " << file_output;
+        field_writer.writeFile(folded_data, file_output, FileType::APF);
+    } catch(std::exception& e) {
+        LOG(FATAL) << "Fatal internal error" << std::endl << e.what() << std::endl << "Cannot continue.";
+        return_code = 127;
+    }
+
+    return return_code;
+}
@@ -178,6 +178,8 @@ int main(int argc, char** argv) {
     }
 
     const auto mesh_tree = config.get<bool>("mesh_tree", false);
+    const auto adaptive_tolerance = config.get<double>("adaptive_tolerance", 0.);
+    const auto adaptive_block_size = config.get<unsigned int>("adaptive_block_size", 4);
 
     // NOTE: this stream should be available for the duration of the logging
     std::ofstream log_file;
@@ -533,9 +535,23 @@ int main(int argc, char** argv) {
     }
 
     allpix::FieldData<double> field_data(header, gridsize, size, data);
+    if(adaptive_tolerance > 0) {
+        if(file_type == FileType::APF) {
+            auto adaptive_data = allpix::coarsen_field_data(
+                field_data, static_cast<size_t>(quantity), adaptive_block_size, adaptive_tolerance, num_threads);
+            LOG(STATUS) << "Adaptive grid stores " << adaptive_data.getData()->size() << " of " << data->size()
+                        << " values, lookups deviate by at most "
+                        << allpix::adaptive_field_deviation(field_data, adaptive_data, static_cast<size_t>(quantity))
+                        << " of the local field";
+            field_data = adaptive_data;
+        } else {
+            LOG(WARNING) << "Adaptive resolution is only supported for the APF format, writing regular grid";
+        }
+    }
     std::string init_file_name = init_file_prefix + "_" + observable + (file_type == FileType::INIT ? ".init" : ".apf");
 
     allpix::FieldWriter<double> field_writer(quantity);
+    field_writer.setThreads(num_threads);
     field_writer.writeFile(field_data, init_file_name, file_type, (file_type == FileType::INIT ? units : ""));
     LOG(STATUS) << "New mesh written to file \"" << init_file_name << "\"";
 
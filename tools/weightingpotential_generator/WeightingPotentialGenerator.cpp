@@ -1,3 +1,7 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <csignal>
 #include <fstream>
 
@@ -57,12 +61,18 @@ int main(int argc, char** argv) {
     XYVectorInt matrix(3, 3);
     XYZVectorInt binning;
     auto file_type = allpix::FileType::APF;
+    double tolerance = 1e-6;
+    bool fold = false;
 
     for(int i = 1; i < argc; i++) {
         if(strcmp(argv[i], "-h") == 0) {
             print_help = true;
         } else if(strcmp(argv[i], "--init") == 0) {
             file_type = allpix::FileType::INIT;
+        } else if(strcmp(argv[i], "--fold") == 0) {
+            fold = true;
+        } else if(strcmp(argv[i], "--tolerance") == 0 && (i + 1 < argc)) {
+            tolerance = std::atof(argv[++i]);
         } else if(strcmp(argv[i], "--binning") == 0 && (i + 1 < argc)) {
             binning = allpix::from_string<XYZVectorInt>(std::string(argv[++i]));
         } else if(strcmp(argv[i], "--matrix") == 0 && (i + 1 < argc)) {
@@ -88,6 +98,13 @@ int main(int argc, char** argv) {
     // Set log level:
     allpix::Log::setReportingLevel(log_level);
 
+    // Folded potentials can only be stored in APF files:
+    if(fold && file_type == allpix::FileType::INIT) {
+        LOG(ERROR) << "Folded potentials cannot be stored in the INIT format";
+        print_help = true;
+        return_code = 1;
+    }
+
     // Print help if requested or no arguments given
     if(print_help) {
         std::cerr << "Usage: generate_potential --model <file_name> [<options>]" << std::endl;
@@ -102,6 +119,10 @@ int main(int argc, char** argv) {
         std::cout << "\t --output  <file name>   Name of the file the potential should be stored in" << std::endl;
         std::cout << "\t --init                  Switch to enable writing the potential in the INIT format instead of APF"
                   << std::endl;
+        std::cout << "\t --fold                  Only store one quadrant of the potential in the APF file" << std::endl;
+        std::cout << "\t --tolerance <value>     Estimated remainder at which the series expansion is truncated "
+                     "(default 1e-6)"
+                  << std::endl;
         std::cout << "\t -v <level>              verbosity level (default reporiting level is INFO)" << std::endl;
         std::cout << "\t -h                      print this help text" << std::endl;
 
@@ -144,56 +165,101 @@ int main(int argc, char** argv) {
     LOG(INFO) << "Output file: " << output_file_name;
     auto start = std::chrono::system_clock::now();
 
+    // The potential of the centered pad is mirror-symmetric in x and y, so only one quadrant of the grid is calculated.
+    // For an odd number of bins, the quadrant includes the central bin.
+    std::array<size_t, 3> gridsize{{binning.x(), binning.y(), binning.z()}};
+    auto quadrant = allpix::symmetry_folded_dimensions(gridsize, allpix::FieldSymmetry::QUADRANT);
+    auto start_x = binning.x() / 2;
+    auto start_y = binning.y() / 2;
+
     // Start potential generation on many threads:
     auto num_threads = std::max(std::thread::hardware_concurrency(), 1u);
-    LOG(STATUS) << "Starting weighting potential generation with " << num_threads << " threads.";
-    auto weighting_potential = std::make_shared<std::vector<double>>();
+    LOG(STATUS) << "Starting weighting potential generation of " << quadrant[0] << "x" << quadrant[1]
+                << " quadrant columns with " << num_threads << " threads.";
+
+    // Bin centers along z, transformed into the coordinate system with the sensor between d/2 < z < -d/2:
+    auto d = thickness_domain.second - thickness_domain.first;
+    std::vector<double> local_z(binning.z());
+    for(size_t index_z = 0; index_z < binning.z(); index_z++) {
+        auto z = fieldsize.z() / static_cast<double>(binning.z()) * (static_cast<double>(index_z) + 0.5) - fieldsize.z() / 2;
+        local_z[index_z] = -z + thickness_domain.second;
+    }
 
+    const size_t max_terms = 10000;
+    std::atomic<size_t> total_terms{0};
     auto generate_section = [&](size_t index_x) {
         allpix::Log::setReportingLevel(log_level);
 
-        auto potential = [implant, thickness_domain](const ROOT::Math::XYZPoint& pos) {
-            // Calculate values of the "f" function
-            auto f = [implant](double x, double y, double u) {
-                // Calculate arctan fractions
-                auto arctan = [](double a, double b, double c) {
-                    return std::atan(a * b / c / std::sqrt(a * a + b * b + c * c));
-                };
-
-                // Shift the x and y coordinates by plus/minus half the implant size:
-                double x1 = x - implant.x() / 2;
-                double x2 = x + implant.x() / 2;
-                double y1 = y - implant.y() / 2;
-                double y2 = y + implant.y() / 2;
-
-                // Calculate arctan sum and return
-                return arctan(x1, y1, u) + arctan(x2, y2, u) - arctan(x1, y2, u) - arctan(x2, y1, u);
+        auto x = fieldsize.x() / static_cast<double>(binning.x()) * (static_cast<double>(index_x) + 0.5) - fieldsize.x() / 2;
+
+        std::vector<double> slice;
+        slice.reserve(quadrant[1] * binning.z());
+        std::vector<double> sum(binning.z());
+        for(size_t index_y = start_y; index_y < binning.y(); index_y++) {
+            auto y =
+                fieldsize.y() / static_cast<double>(binning.y()) * (static_cast<double>(index_y) + 0.5) - fieldsize.y() / 2;
+
+            // Shift the x and y coordinates by plus/minus half the implant size and precompute the four arctan terms of
+            // the "f" function, which then only depend on the depth u:
+            std::array<double, 2> xs{{x - implant.x() / 2, x + implant.x() / 2}};
+            std::array<double, 2> ys{{y - implant.y() / 2, y + implant.y() / 2}};
+            std::array<double, 4> ab{{xs[0] * ys[0], xs[1] * ys[1], xs[0] * ys[1], xs[1] * ys[0]}};
+            std::array<double, 4> r2{{xs[0] * xs[0] + ys[0] * ys[0],
+                                      xs[1] * xs[1] + ys[1] * ys[1],
+                                      xs[0] * xs[0] + ys[1] * ys[1],
+                                      xs[1] * xs[1] + ys[0] * ys[0]}};
+            auto f = [&ab, &r2](double u) {
+                return std::atan(ab[0] / u / std::sqrt(r2[0] + u * u)) + std::atan(ab[1] / u / std::sqrt(r2[1] + u * u)) -
+                       std::atan(ab[2] / u / std::sqrt(r2[2] + u * u)) - std::atan(ab[3] / u / std::sqrt(r2[3] + u * u));
             };
 
-            // Transform into coordinate system with sensor between d/2 < z < -d/2:
-            auto d = thickness_domain.second - thickness_domain.first;
-            auto local_z = -pos.z() + thickness_domain.second;
+            // Calculate the series expansion for all z positions at once. The terms fall off with the third power of n,
+            // the series is truncated once the estimated remainder n * |term| is below tolerance for all positions or the
+            // maximum number of terms is reached:
+            std::fill(sum.begin(), sum.end(), 0.);
+            size_t n = 1;
+            for(; n < max_terms; n++) {
+                auto shift = 2 * static_cast<double>(n) * d;
+                double max_term = 0;
+                for(size_t index_z = 0; index_z < local_z.size(); index_z++) {
+                    auto term = f(shift - local_z[index_z]) - f(shift + local_z[index_z]);
+                    sum[index_z] += term;
+                    max_term = std::max(max_term, std::fabs(term));
+                }
+                if(max_term * static_cast<double>(n) < tolerance) {
+                    break;
+                }
+            }
+            total_terms += n;
 
-            // Calculate the series expansion
-            double sum = 0;
-            for(int n = 1; n <= 100; n++) {
-                sum += f(pos.x(), pos.y(), 2 * n * d - local_z) - f(pos.x(), pos.y(), 2 * n * d + local_z);
+            for(size_t index_z = 0; index_z < local_z.size(); index_z++) {
+                slice.push_back(1 / (2 * M_PI) * (f(local_z[index_z]) - sum[index_z]));
             }
+        }
+        return slice;
+    };
 
-            return (1 / (2 * M_PI) * (f(pos.x(), pos.y(), local_z) - sum));
-        };
+    // Fill either the quadrant only or mirror it into the full grid:
+    auto weighting_potential = std::make_shared<std::vector<double>>(
+        allpix::symmetry_grid_points(gridsize, fold ? allpix::FieldSymmetry::QUADRANT : allpix::FieldSymmetry::NONE));
+    auto store_slice = [&](size_t index_x, const std::vector<double>& slice) {
+        for(size_t qy = 0; qy < quadrant[1]; qy++) {
+            auto begin = slice.begin() + static_cast<std::ptrdiff_t>(qy * binning.z());
+            auto end = begin + static_cast<std::ptrdiff_t>(binning.z());
+            if(fold) {
+                auto offset = ((index_x - start_x) * quadrant[1] + qy) * binning.z();
+                std::copy(begin, end, weighting_potential->begin() + static_cast<std::ptrdiff_t>(offset));
+                continue;
+            }
 
-        std::vector<double> slice;
-        for(size_t index_y = 1; index_y <= binning.y(); index_y++) {
-            for(size_t index_z = 1; index_z <= binning.z(); index_z++) {
-                auto pos = ROOT::Math::XYZPoint(
-                    fieldsize.x() / static_cast<double>(binning.x()) * static_cast<double>(index_x) - fieldsize.x() / 2,
-                    fieldsize.y() / static_cast<double>(binning.y()) * static_cast<double>(index_y) - fieldsize.y() / 2,
-                    fieldsize.z() / static_cast<double>(binning.z()) * static_cast<double>(index_z) - fieldsize.z() / 2);
-                slice.push_back(potential(pos));
+            auto index_y = start_y + qy;
+            for(auto mx : {index_x, binning.x() - 1 - index_x}) {
+                for(auto my : {index_y, binning.y() - 1 - index_y}) {
+                    auto offset = (mx * binning.y() + my) * binning.z();
+                    std::copy(begin, end, weighting_potential->begin() + static_cast<std::ptrdiff_t>(offset));
+                }
             }
         }
-        return slice;
     };
 
     try {
@@ -208,18 +274,23 @@ int main(int argc, char** argv) {
         ThreadPool pool(num_threads, init_function);
         std::vector<std::future<std::vector<double>>> wp_futures;
 
-        // Loop over x coordinate, add tasks for each coordinate to the queue
-        for(size_t x = 1; x <= binning.x(); x++) {
+        // Loop over the x coordinates of the quadrant, add tasks for each coordinate to the queue
+        for(size_t x = start_x; x < binning.x(); x++) {
             wp_futures.push_back(pool.submit(generate_section, x));
         }
 
-        // Merge the result vectors:
-        unsigned int slices_done = 0;
+        // Merge the result vectors and estimate the remaining time from the throughput so far:
+        size_t slices_done = 0;
         for(auto& wp_future : wp_futures) {
-            auto slice = wp_future.get();
-            weighting_potential->insert(weighting_potential->end(), slice.begin(), slice.end());
-            LOG_PROGRESS(INFO, "generation") << "Generating potential: " << (100 * slices_done / wp_futures.size()) << "%";
+            store_slice(start_x + slices_done, wp_future.get());
             slices_done++;
+
+            auto elapsed = std::chrono::duration<double>(std::chrono::system_clock::now() - start).count();
+            auto remaining =
+                elapsed / static_cast<double>(slices_done) * static_cast<double>(wp_futures.size() - slices_done);
+            LOG_PROGRESS(INFO, "generation")
+                << "Generating potential: " << (100 * slices_done / wp_futures.size()) << "%, about "
+                << static_cast<long>(std::ceil(remaining)) << " seconds remaining";
         }
         LOG_PROGRESS(INFO, "generation") << "Generating potential: 100%";
         pool.destroy();
@@ -229,6 +300,9 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    LOG(INFO) << "Series expansion truncated after "
+              << static_cast<double>(total_terms) / static_cast<double>(quadrant[0] * quadrant[1]) << " terms on average";
+
     auto end = std::chrono::system_clock::now();
     auto elapsed_seconds = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
     LOG(INFO) << "Weighting potential generated in " << elapsed_seconds << " seconds.";
@@ -236,9 +310,12 @@ int main(int argc, char** argv) {
     // Prepare header and auxiliary information:
     std::string header = "Allpix Squared " + std::string(ALLPIX_PROJECT_VERSION) + " Weighting Potential Generator";
     std::array<double, 3> size{{fieldsize.x(), fieldsize.y(), fieldsize.z()}};
-    std::array<size_t, 3> gridsize{{binning.x(), binning.y(), binning.z()}};
 
-    allpix::FieldData<double> field_data(header, gridsize, size, weighting_potential);
+    allpix::FieldData<double> field_data(header,
+                                         gridsize,
+                                         size,
+                                         weighting_potential,
+                                         fold ? allpix::FieldSymmetry::QUADRANT : allpix::FieldSymmetry::NONE);
     allpix::FieldWriter<double> field_writer(allpix::FieldQuantity::SCALAR);
     field_writer.writeFile(field_data, output_file_name, file_type);
 